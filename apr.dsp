@@ -156,6 +156,10 @@ SOURCE=.\buckets\apr_brigade.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\buckets\apr_brigade_zstream.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\buckets\apr_buckets.c
 # End Source File
 # Begin Source File
@@ -196,6 +200,10 @@ SOURCE=.\buckets\apr_buckets_refcount.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\buckets\apr_buckets_sharedbuf.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\buckets\apr_buckets_simple.c
 # End Source File
 # Begin Source File
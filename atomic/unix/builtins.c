@@ -26,7 +26,11 @@
 
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p)
 {
+#if defined(NEED_ATOMICS_GENERIC64) || defined(NEED_ATOMICS_GENERIC128)
+    return apr__atomic_generic64_init(p);
+#else
     return APR_SUCCESS;
+#endif
 }
 
 APR_DECLARE(apr_uint32_t) apr_atomic_read32(volatile apr_uint32_t *mem)
@@ -111,6 +115,101 @@ APR_DECLARE(apr_uint32_t) apr_atomic_xchg32(volatile apr_uint32_t *mem, apr_uint
 #endif
 }
 
+APR_DECLARE(apr_uint32_t) apr_atomic_or32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return __atomic_fetch_or(mem, val, __ATOMIC_SEQ_CST);
+#else
+    return __sync_fetch_and_or(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_and32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return __atomic_fetch_and(mem, val, __ATOMIC_SEQ_CST);
+#else
+    return __sync_fetch_and_and(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_xor32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return __atomic_fetch_xor(mem, val, __ATOMIC_SEQ_CST);
+#else
+    return __sync_fetch_and_xor(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return ATOMIC_LOAD_EX(mem, order);
+#else
+    return apr_atomic_read32(mem);
+#endif
+}
+
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    ATOMIC_STORE_EX(mem, val, order);
+#else
+    apr_atomic_set32(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return ATOMIC_FETCH_ADD_EX(mem, val, order);
+#else
+    return __sync_fetch_and_add(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    ATOMIC_CAS_EX(mem, &cmp, val, order);
+    return cmp;
+#else
+    return __sync_val_compare_and_swap(mem, cmp, val);
+#endif
+}
+
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    switch (order) {
+    case APR_ATOMIC_RELAXED:
+        break;
+    case APR_ATOMIC_ACQUIRE:
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        break;
+    case APR_ATOMIC_RELEASE:
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        break;
+    case APR_ATOMIC_ACQ_REL:
+        __atomic_thread_fence(__ATOMIC_ACQ_REL);
+        break;
+    default:
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        break;
+    }
+#else
+    if (order != APR_ATOMIC_RELAXED) {
+        __sync_synchronize();
+    }
+#endif
+}
+
 APR_DECLARE(void*) apr_atomic_casptr(void *volatile *mem, void *ptr, const void *cmp)
 {
 #if HAVE__ATOMIC_BUILTINS
@@ -106,4 +106,102 @@ APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint
 #endif
 }
 
+APR_DECLARE(apr_uint64_t) apr_atomic_or64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return __atomic_fetch_or(mem, val, __ATOMIC_SEQ_CST);
+#else
+    return __sync_fetch_and_or(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_and64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return __atomic_fetch_and(mem, val, __ATOMIC_SEQ_CST);
+#else
+    return __sync_fetch_and_and(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xor64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return __atomic_fetch_xor(mem, val, __ATOMIC_SEQ_CST);
+#else
+    return __sync_fetch_and_xor(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return ATOMIC_LOAD_EX(mem, order);
+#else
+    return apr_atomic_read64(mem);
+#endif
+}
+
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    ATOMIC_STORE_EX(mem, val, order);
+#else
+    apr_atomic_set64(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    return ATOMIC_FETCH_ADD_EX(mem, val, order);
+#else
+    return __sync_fetch_and_add(mem, val);
+#endif
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order)
+{
+#if HAVE__ATOMIC_BUILTINS
+    ATOMIC_CAS_EX(mem, &cmp, val, order);
+    return cmp;
+#else
+    return __sync_val_compare_and_swap(mem, cmp, val);
+#endif
+}
+
+#ifdef USE_ATOMICS_BUILTINS128
+
+/* GCC would call libatomic for a 16-byte __atomic_compare_exchange(), and
+ * inlines __sync_*_compare_and_swap() on __int128 only with -mcx16, so
+ * cmpxchg16b is issued directly (every x86_64 but the very first ones has
+ * it).
+ */
+APR_DECLARE(int) apr_atomic_cas128(volatile apr_atomic_uint128_t *mem,
+                                   apr_atomic_uint128_t *cmp,
+                                   const apr_atomic_uint128_t *with)
+{
+    unsigned char ok;
+
+    __asm__ __volatile__("lock; cmpxchg16b %1\n\t"
+                         "sete %0"
+                         : "=q" (ok), "+m" (*mem),
+                           "+a" (cmp->lo), "+d" (cmp->hi)
+                         : "b" (with->lo), "c" (with->hi)
+                         : "cc", "memory");
+    return ok;
+}
+
+APR_DECLARE(int) apr_atomic_cas128_is_lock_free(void)
+{
+    return 1;
+}
+
+#endif /* USE_ATOMICS_BUILTINS128 */
+
 #endif /* USE_ATOMICS_BUILTINS64 */
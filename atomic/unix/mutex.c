@@ -175,6 +175,83 @@ APR_DECLARE(apr_uint32_t) apr_atomic_xchg32(volatile apr_uint32_t *mem, apr_uint
     return prev;
 }
 
+APR_DECLARE(apr_uint32_t) apr_atomic_or32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+    apr_uint32_t old_value;
+    DECLARE_MUTEX_LOCKED(mutex, mem);
+
+    old_value = *mem;
+    *mem |= val;
+
+    MUTEX_UNLOCK(mutex);
+
+    return old_value;
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_and32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+    apr_uint32_t old_value;
+    DECLARE_MUTEX_LOCKED(mutex, mem);
+
+    old_value = *mem;
+    *mem &= val;
+
+    MUTEX_UNLOCK(mutex);
+
+    return old_value;
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_xor32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+    apr_uint32_t old_value;
+    DECLARE_MUTEX_LOCKED(mutex, mem);
+
+    old_value = *mem;
+    *mem ^= val;
+
+    MUTEX_UNLOCK(mutex);
+
+    return old_value;
+}
+
+/* The mutexes order everything, whatever the order asked for */
+
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order)
+{
+    return apr_atomic_read32(mem);
+}
+
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order)
+{
+    apr_atomic_set32(mem, val);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add32(mem, val);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas32(mem, with, cmp);
+}
+
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+#if APR_HAS_THREADS
+    /* Taking and releasing a mutex is a full barrier */
+    if (order != APR_ATOMIC_RELAXED) {
+        DECLARE_MUTEX_LOCKED(mutex, NULL);
+        MUTEX_UNLOCK(mutex);
+    }
+#endif
+}
+
 APR_DECLARE(void*) apr_atomic_casptr(void *volatile *mem, void *with, const void *cmp)
 {
     void *prev;
@@ -204,3 +281,82 @@ APR_DECLARE(void*) apr_atomic_xchgptr(void *volatile *mem, void *with)
 }
 
 #endif /* USE_ATOMICS_GENERIC */
+
+#ifdef NEED_ATOMICS_GENERIC_EXT
+
+/* The native implementation has no such operations, build them on the
+ * ones it has; they are all full barriers.
+ */
+
+APR_DECLARE(apr_uint32_t) apr_atomic_or32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+    apr_uint32_t old_value, prev;
+
+    for (old_value = *mem;; old_value = prev) {
+        prev = apr_atomic_cas32(mem, old_value | val, old_value);
+        if (prev == old_value) {
+            return old_value;
+        }
+    }
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_and32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+    apr_uint32_t old_value, prev;
+
+    for (old_value = *mem;; old_value = prev) {
+        prev = apr_atomic_cas32(mem, old_value & val, old_value);
+        if (prev == old_value) {
+            return old_value;
+        }
+    }
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_xor32(volatile apr_uint32_t *mem, apr_uint32_t val)
+{
+    apr_uint32_t old_value, prev;
+
+    for (old_value = *mem;; old_value = prev) {
+        prev = apr_atomic_cas32(mem, old_value ^ val, old_value);
+        if (prev == old_value) {
+            return old_value;
+        }
+    }
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order)
+{
+    return apr_atomic_read32(mem);
+}
+
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order)
+{
+    apr_atomic_set32(mem, val);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add32(mem, val);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas32(mem, with, cmp);
+}
+
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+    static volatile apr_uint32_t dummy;
+
+    /* The native exchange is a full barrier */
+    if (order != APR_ATOMIC_RELAXED) {
+        apr_atomic_xchg32(&dummy, 0);
+    }
+}
+
+#endif /* NEED_ATOMICS_GENERIC_EXT */
@@ -17,7 +17,8 @@
 #include "apr_arch_atomic.h"
 #include "apr_thread_mutex.h"
 
-#if defined(USE_ATOMICS_GENERIC) || defined (NEED_ATOMICS_GENERIC64)
+#if defined(USE_ATOMICS_GENERIC) || defined (NEED_ATOMICS_GENERIC64) \
+    || defined(NEED_ATOMICS_GENERIC128)
 
 #include <stdlib.h>
 
@@ -94,6 +95,8 @@ apr_status_t apr__atomic_generic64_init(apr_pool_t *p)
 
 #endif /* APR_HAS_THREADS */
 
+#if defined(USE_ATOMICS_GENERIC) || defined (NEED_ATOMICS_GENERIC64)
+
 APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem)
 {
     return *mem;
@@ -175,4 +178,104 @@ APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint
     return prev;
 }
 
-#endif /* USE_ATOMICS_GENERIC64 */
+
+APR_DECLARE(apr_uint64_t) apr_atomic_or64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t old_value;
+    DECLARE_MUTEX_LOCKED(mutex, mem);
+
+    old_value = *mem;
+    *mem |= val;
+
+    MUTEX_UNLOCK(mutex);
+
+    return old_value;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_and64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t old_value;
+    DECLARE_MUTEX_LOCKED(mutex, mem);
+
+    old_value = *mem;
+    *mem &= val;
+
+    MUTEX_UNLOCK(mutex);
+
+    return old_value;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xor64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t old_value;
+    DECLARE_MUTEX_LOCKED(mutex, mem);
+
+    old_value = *mem;
+    *mem ^= val;
+
+    MUTEX_UNLOCK(mutex);
+
+    return old_value;
+}
+
+/* The mutexes order everything, whatever the order asked for */
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order)
+{
+    return apr_atomic_read64(mem);
+}
+
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order)
+{
+    apr_atomic_set64(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add64(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas64(mem, with, cmp);
+}
+
+#endif /* USE_ATOMICS_GENERIC || NEED_ATOMICS_GENERIC64 */
+
+#ifdef NEED_ATOMICS_GENERIC128
+
+APR_DECLARE(int) apr_atomic_cas128(volatile apr_atomic_uint128_t *mem,
+                                   apr_atomic_uint128_t *cmp,
+                                   const apr_atomic_uint128_t *with)
+{
+    int swapped;
+    DECLARE_MUTEX_LOCKED(mutex, (volatile apr_uint64_t *)mem);
+
+    swapped = (mem->lo == cmp->lo && mem->hi == cmp->hi);
+    if (swapped) {
+        mem->lo = with->lo;
+        mem->hi = with->hi;
+    }
+    else {
+        cmp->lo = mem->lo;
+        cmp->hi = mem->hi;
+    }
+
+    MUTEX_UNLOCK(mutex);
+
+    return swapped;
+}
+
+APR_DECLARE(int) apr_atomic_cas128_is_lock_free(void)
+{
+    return 0;
+}
+
+#endif /* NEED_ATOMICS_GENERIC128 */
+
+#endif /* USE_ATOMICS_GENERIC || NEED_ATOMICS_GENERIC64 || NEED_ATOMICS_GENERIC128 */
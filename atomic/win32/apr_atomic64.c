@@ -80,3 +80,91 @@ APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint
 {
     return InterlockedExchange64((volatile LONG64 *)mem, val);
 }
+
+APR_DECLARE(apr_uint64_t) apr_atomic_or64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    return InterlockedOr64((volatile LONG64 *)mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_and64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    return InterlockedAnd64((volatile LONG64 *)mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xor64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    return InterlockedXor64((volatile LONG64 *)mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order)
+{
+    return apr_atomic_read64(mem);
+}
+
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order)
+{
+    apr_atomic_set64(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add64(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas64(mem, with, cmp);
+}
+
+#if defined(_WIN64)
+
+APR_DECLARE(int) apr_atomic_cas128(volatile apr_atomic_uint128_t *mem,
+                                   apr_atomic_uint128_t *cmp,
+                                   const apr_atomic_uint128_t *with)
+{
+    return InterlockedCompareExchange128((volatile LONG64 *)mem,
+                                         (LONG64)with->hi, (LONG64)with->lo,
+                                         (LONG64 *)cmp);
+}
+
+APR_DECLARE(int) apr_atomic_cas128_is_lock_free(void)
+{
+    return 1;
+}
+
+#else
+
+static SRWLOCK cas128_lock = SRWLOCK_INIT;
+
+APR_DECLARE(int) apr_atomic_cas128(volatile apr_atomic_uint128_t *mem,
+                                   apr_atomic_uint128_t *cmp,
+                                   const apr_atomic_uint128_t *with)
+{
+    int swapped;
+
+    AcquireSRWLockExclusive(&cas128_lock);
+    swapped = (mem->lo == cmp->lo && mem->hi == cmp->hi);
+    if (swapped) {
+        mem->lo = with->lo;
+        mem->hi = with->hi;
+    }
+    else {
+        cmp->lo = mem->lo;
+        cmp->hi = mem->hi;
+    }
+    ReleaseSRWLockExclusive(&cas128_lock);
+
+    return swapped;
+}
+
+APR_DECLARE(int) apr_atomic_cas128_is_lock_free(void)
+{
+    return 0;
+}
+
+#endif /* _WIN64 */
@@ -387,303 +387,303 @@ APR_DECLARE(apr_status_t) apr_brigade_split_line(apr_bucket_brigade *bbOut,
     return APR_SUCCESS;
 }
 
-#if !APR_HAVE_MEMMEM
-static const void *
-memmem(const void *_hay, size_t hay_len, const void *needle, size_t needle_len)
+/* The state of a boundary search, which goes on across the buckets and
+ * the calls with the Knuth-Morris-Pratt automaton: the bytes which match
+ * the start of the boundary at the end of what was scanned are held at the
+ * front of bbIn, and never scanned again.
+ */
+struct apr_brigade_boundary_t {
+    const char *boundary;
+    apr_size_t len;
+    /* border[i]: length of the longest proper prefix of the first i bytes
+     * of the boundary which is also a suffix of them */
+    apr_size_t *border;
+    apr_size_t matched;
+};
+
+static void boundary_init(apr_brigade_boundary_t *bd, const char *boundary,
+                          apr_size_t len, apr_size_t *border)
 {
-    if (hay_len < needle_len || !needle_len || !hay_len) {
-        return NULL;
+    apr_size_t i, k = 0;
+
+    bd->boundary = boundary;
+    bd->len = len;
+    bd->border = border;
+    bd->matched = 0;
+
+    border[0] = border[1] = 0;
+    for (i = 1; i < len; i++) {
+        while (k && boundary[i] != boundary[k]) {
+            k = border[k];
+        }
+        if (boundary[i] == boundary[k]) {
+            k++;
+        }
+        border[i + 1] = k;
     }
-    else {
-        apr_size_t len = hay_len - needle_len + 1;
-        const apr_byte_t *hay = (apr_byte_t *)_hay;
-        const apr_byte_t *end = hay + hay_len;
+}
 
-        while ((hay = memchr(hay, *(char *)needle, len))) {
-            len = (apr_size_t)(end - hay) - needle_len + 1;
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOUNDARY_SSE2 1
+#endif
 
-            if (memcmp(hay, needle, needle_len) == 0 ) {
-                break;
+/* Find where the boundary starts in str, whole or cut by the end of str,
+ * and return its offset, or len if it is not there. Where SSE2 is
+ * available, 16 positions are filtered at once on the first and last
+ * bytes of the boundary. When too many candidates fail, *unsure is set and
+ * the offset returned is where to go on byte by byte, so that the search
+ * stays linear.
+ */
+static apr_size_t boundary_find(const char *str, apr_size_t len,
+                                const char *boundary, apr_size_t blen,
+                                int *unsure)
+{
+    const char *s = str, *end = str + len;
+    apr_size_t budget = 16 + len / blen;
+
+#ifdef BOUNDARY_SSE2
+    if (blen >= 2 && len >= blen + 15) {
+        const __m128i first = _mm_set1_epi8(boundary[0]);
+        const __m128i last = _mm_set1_epi8(boundary[blen - 1]);
+        const char *stop = end - (blen - 1) - 16;
+
+        for (; s <= stop; s += 16) {
+            __m128i f = _mm_loadu_si128((const __m128i *)s);
+            __m128i l = _mm_loadu_si128((const __m128i *)(s + blen - 1));
+            unsigned int mask = _mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(f, first),
+                                  _mm_cmpeq_epi8(l, last)));
+            const char *c;
+
+            for (c = s; mask; mask >>= 1, c++) {
+                if (!(mask & 1)) {
+                    continue;
+                }
+                if (!memcmp(c + 1, boundary + 1, blen - 2)) {
+                    return c - str;
+                }
+                if (!--budget) {
+                    *unsure = 1;
+                    return c - str;
+                }
             }
-
-            --len;
-            ++hay;
         }
+    }
+#endif
+
+    while (s < end && (s = memchr(s, boundary[0], end - s))) {
+        apr_size_t n = (apr_size_t)(end - s) < blen ? end - s : blen;
 
-        return hay;
+        if (!memcmp(s, boundary, n)) {
+            return s - str;
+        }
+        if (!--budget) {
+            *unsure = 1;
+            return s - str;
+        }
+        s++;
     }
+    return len;
 }
-#endif
 
-APR_DECLARE(apr_status_t) apr_brigade_split_boundary(apr_bucket_brigade *bbOut,
-                                                     apr_bucket_brigade *bbIn,
-                                                     apr_read_type_e block,
-                                                     const char *boundary,
-                                                     apr_size_t boundary_len,
-                                                     apr_off_t maxbytes)
+/* Move the first nbytes of bbIn to bbOut */
+static apr_status_t boundary_pass(apr_bucket_brigade *bbOut,
+                                  apr_bucket_brigade *bbIn, apr_off_t nbytes)
 {
-    apr_off_t outbytes = 0;
-    apr_size_t ignore = 0;
+    apr_bucket *after, *e;
+    apr_status_t rv;
 
-    if (!boundary || !boundary[0]) {
-        return APR_EINVAL;
+    rv = apr_brigade_partition(bbIn, nbytes, &after);
+    if (rv != APR_SUCCESS) {
+        return rv;
     }
-
-    if (APR_BUCKETS_STRING == boundary_len) {
-        boundary_len = strlen(boundary);
+    while ((e = APR_BRIGADE_FIRST(bbIn)) != after) {
+        APR_BUCKET_REMOVE(e);
+        APR_BRIGADE_INSERT_TAIL(bbOut, e);
     }
+    return APR_SUCCESS;
+}
 
-    /*
-     * While the call describes itself as searching for a boundary string,
-     * what we actually do is search for anything that is definitely not
-     * a boundary string, and allow that not-boundary data to pass through.
-     *
-     * If we find data that might be a boundary, we try read more data in
-     * until we know for sure.
-     */
-    while (!APR_BRIGADE_EMPTY(bbIn)) {
+/* With hold, a partial match at the end of bbIn is kept there for the
+ * next call, otherwise it is passed as the rest.
+ */
+static apr_status_t boundary_split(apr_bucket_brigade *bbOut,
+                                   apr_bucket_brigade *bbIn,
+                                   apr_read_type_e block,
+                                   apr_brigade_boundary_t *bd,
+                                   apr_off_t maxbytes, int hold)
+{
+    const char *boundary = bd->boundary;
+    apr_size_t blen = bd->len;
+    apr_size_t m = bd->matched;
+    apr_off_t outbytes = 0;
+    apr_bucket *e;
+    apr_status_t rv;
 
-        const char *pos;
+    /* The partial match of the previous call was scanned already */
+    rv = apr_brigade_partition(bbIn, m, &e);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+
+    while (e != APR_BRIGADE_SENTINEL(bbIn)) {
         const char *str;
-        apr_bucket *e, *next, *prev;
-        apr_size_t inbytes = 0;
-        apr_size_t len;
-        apr_status_t rv;
+        apr_size_t len, off = 0;
+        apr_bucket *next;
+        int unsure = 0;
 
         /* We didn't find a boundary within the maximum line length. */
         if (outbytes >= maxbytes) {
+            bd->matched = m;
             return APR_INCOMPLETE;
         }
 
-        e = APR_BRIGADE_FIRST(bbIn);
-
         /* We hit a metadata bucket, stop and let the caller handle it */
         if (APR_BUCKET_IS_METADATA(e)) {
-            return APR_INCOMPLETE;
+            bd->matched = 0;
+            rv = boundary_pass(bbOut, bbIn, m);
+            return rv != APR_SUCCESS ? rv : APR_INCOMPLETE;
         }
 
         rv = apr_bucket_read(e, &str, &len, block);
-
         if (rv != APR_SUCCESS) {
+            bd->matched = m;
             return rv;
         }
 
-        inbytes += len;
-
-        /*
-         * Fast path.
-         *
-         * If we have at least one boundary worth of data, do an optimised
-         * substring search for the boundary, and split quickly if found.
-         */
-        if ((len - ignore) >= boundary_len) {
-
-            apr_size_t off;
-            apr_size_t leftover;
-
-            pos = memmem(str + ignore, len - ignore, boundary, boundary_len);
-
-            /* definitely found it, we leave */
-            if (pos != NULL) {
-
-                off = pos - str;
-
-                /* everything up to the boundary */
-                if (off) {
-
-                    apr_bucket_split(e, off);
-                    APR_BUCKET_REMOVE(e);
-                    APR_BRIGADE_INSERT_TAIL(bbOut, e);
-
-                    e = APR_BRIGADE_FIRST(bbIn);
+        while (off < len && m < blen) {
+            if (!m && !unsure) {
+                off += boundary_find(str + off, len - off, boundary, blen,
+                                     &unsure);
+                if (off < len && !unsure) {
+                    m = len - off < blen ? len - off : blen;
+                    off += m;
                 }
-
-                /* cut out the boundary */
-                apr_bucket_split(e, boundary_len);
-                apr_bucket_delete(e);
-
-                return APR_SUCCESS;
             }
+            else {
+                char c = str[off++];
 
-            /* any partial matches at the end? */
-            leftover = boundary_len - 1;
-            off = (len - leftover);
-
-            while (leftover) {
-                if (!memcmp(str + off, boundary, leftover)) {
-
-                    if (off) {
-
-                        apr_bucket_split(e, off);
-                        APR_BUCKET_REMOVE(e);
-                        APR_BRIGADE_INSERT_TAIL(bbOut, e);
-                        ignore = 0;
-
-                        e = APR_BRIGADE_FIRST(bbIn);
-                    }
-
-                    outbytes += off;
-                    inbytes -= off;
-
-                    goto skip;
+                while (m && boundary[m] != c) {
+                    m = bd->border[m];
                 }
-                off++;
-                leftover--;
-            }
-
-            APR_BUCKET_REMOVE(e);
-            APR_BRIGADE_INSERT_TAIL(bbOut, e);
-            ignore = 0;
-
-            outbytes += len;
-
-            continue;
-
-        }
-
-        /*
-         * Slow path.
-         *
-         * We need to read ahead at least one boundary worth of data so
-         * we can search across the bucket edges.
-         */
-        else {
-
-            apr_size_t off = ignore;
-
-            len -= ignore;
-
-            /* find all definite non matches */
-            while (len) {
-                if (!memcmp(str + off, boundary, len)) {
-
-                    if (off) {
-
-                        apr_bucket_split(e, off);
-                        APR_BUCKET_REMOVE(e);
-                        APR_BRIGADE_INSERT_TAIL(bbOut, e);
-                        ignore = 0;
-
-                        outbytes += off;
-
-                        e = APR_BRIGADE_FIRST(bbIn);
-                    }
-
-                    inbytes -= off;
-
-                    goto skip;
+                if (boundary[m] == c) {
+                    m++;
                 }
-                off++;
-                len--;
             }
-
-            APR_BUCKET_REMOVE(e);
-            APR_BRIGADE_INSERT_TAIL(bbOut, e);
-            ignore = 0;
-
-            outbytes += off;
-
-            continue;
-
         }
 
-        /*
-         * If we reach skip, it means the bucket in e is:
-         *
-         * - shorter than the boundary
-         * - matches the boundary up to the bucket length
-         * - might match more buckets
-         *
-         * Read further buckets and check whether the boundary matches all
-         * the way to the end. If so, we have a match. If no match, shave off
-         * one byte and continue round to try again.
-         */
-skip:
-
-        for (next = APR_BUCKET_NEXT(e);
-                inbytes < boundary_len && next != APR_BRIGADE_SENTINEL(bbIn);
-                next = APR_BUCKET_NEXT(next)) {
-
-            const char *str;
-            apr_size_t off;
-            apr_size_t len;
-
-            rv = apr_bucket_read(next, &str, &len, block);
+        if (m == blen) {
+            apr_size_t held = (apr_size_t)bd->matched;
 
+            /* Everything before the boundary, then cut the boundary out */
+            if (off < len) {
+                apr_bucket_split(e, off);
+            }
+            next = APR_BUCKET_NEXT(e);
+            rv = boundary_pass(bbOut, bbIn, held + off - blen);
             if (rv != APR_SUCCESS) {
                 return rv;
             }
+            while ((e = APR_BRIGADE_FIRST(bbIn)) != next) {
+                apr_bucket_delete(e);
+            }
+            bd->matched = 0;
+            return APR_SUCCESS;
+        }
 
-            off = boundary_len - inbytes;
-
-            if (len > off) {
-
-                /* not a match, bail out */
-                if (memcmp(str, boundary + inbytes, off)) {
-                    break;
-                }
-
-                /* a match! remove the boundary and return */
-                apr_bucket_split(next, off);
-
-                e = APR_BUCKET_NEXT(next);
-
-                for (prev = APR_BRIGADE_FIRST(bbIn);
-                        prev != e;
-                        prev = APR_BRIGADE_FIRST(bbIn)) {
-
-                    apr_bucket_delete(prev);
-
-                }
-
-                return APR_SUCCESS;
+        /* All but the partial match can go */
+        next = APR_BUCKET_NEXT(e);
+        rv = boundary_pass(bbOut, bbIn, bd->matched + len - m);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+        outbytes += bd->matched + len - m;
+        bd->matched = m;
+        e = next;
+    }
 
-            }
-            if (len == off) {
+    if (!hold && m) {
+        bd->matched = 0;
+        rv = boundary_pass(bbOut, bbIn, m);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+    }
+    return APR_INCOMPLETE;
+}
 
-                /* not a match, bail out */
-                if (memcmp(str, boundary + inbytes, off)) {
-                    break;
-                }
+APR_DECLARE(apr_status_t) apr_brigade_split_boundary(apr_bucket_brigade *bbOut,
+                                                     apr_bucket_brigade *bbIn,
+                                                     apr_read_type_e block,
+                                                     const char *boundary,
+                                                     apr_size_t boundary_len,
+                                                     apr_off_t maxbytes)
+{
+    apr_brigade_boundary_t bd;
+    apr_size_t *border;
+    apr_status_t rv;
 
-                /* a match! remove the boundary and return */
-                e = APR_BUCKET_NEXT(next);
+    if (!boundary || !boundary[0]) {
+        return APR_EINVAL;
+    }
 
-                for (prev = APR_BRIGADE_FIRST(bbIn);
-                        prev != e;
-                        prev = APR_BRIGADE_FIRST(bbIn)) {
+    if (APR_BUCKETS_STRING == boundary_len) {
+        boundary_len = strlen(boundary);
+    }
 
-                    apr_bucket_delete(prev);
+    border = apr_bucket_alloc((boundary_len + 1) * sizeof(apr_size_t),
+                              bbIn->bucket_alloc);
+    if (!border) {
+        return APR_ENOMEM;
+    }
+    boundary_init(&bd, boundary, boundary_len, border);
 
-                }
+    rv = boundary_split(bbOut, bbIn, block, &bd, maxbytes, 0);
 
-                return APR_SUCCESS;
+    apr_bucket_free(border);
+    return rv;
+}
 
-            }
-            else if (len) {
+APR_DECLARE(apr_status_t) apr_brigade_boundary_create(
+                                             apr_brigade_boundary_t **bd,
+                                             const char *boundary,
+                                             apr_size_t boundary_len,
+                                             apr_pool_t *p)
+{
+    apr_brigade_boundary_t *new_bd;
 
-                /* not a match, bail out */
-                if (memcmp(str, boundary + inbytes, len)) {
-                    break;
-                }
+    if (!boundary || !boundary[0]) {
+        return APR_EINVAL;
+    }
 
-                /* still hope for a match */
-                inbytes += len;
-            }
+    if (APR_BUCKETS_STRING == boundary_len) {
+        boundary_len = strlen(boundary);
+    }
 
-        }
+    new_bd = apr_palloc(p, sizeof(*new_bd));
+    boundary_init(new_bd, apr_pmemdup(p, boundary, boundary_len),
+                  boundary_len,
+                  apr_palloc(p, (boundary_len + 1) * sizeof(apr_size_t)));
 
-        /*
-         * If we reach this point, the bucket e did not match the boundary
-         * in the subsequent buckets.
-         *
-         * Bump one byte off, and loop round to search again.
-         */
-        ignore++;
+    *bd = new_bd;
+    return APR_SUCCESS;
+}
 
-    }
+APR_DECLARE(apr_status_t) apr_brigade_split_boundary_ex(
+                                             apr_bucket_brigade *bbOut,
+                                             apr_bucket_brigade *bbIn,
+                                             apr_read_type_e block,
+                                             apr_brigade_boundary_t *bd,
+                                             apr_off_t maxbytes)
+{
+    return boundary_split(bbOut, bbIn, block, bd, maxbytes, 1);
+}
 
-    return APR_INCOMPLETE;
+APR_DECLARE(void) apr_brigade_boundary_reset(apr_brigade_boundary_t *bd)
+{
+    bd->matched = 0;
 }
 
 
@@ -719,6 +719,258 @@ APR_DECLARE(apr_status_t) apr_brigade_to_iovec(apr_bucket_brigade *b,
     return APR_SUCCESS;
 }
 
+/* Remove the first 'len' bytes of a brigade, along with the metadata
+ * buckets which follow them */
+static void brigade_consume(apr_bucket_brigade *bb, apr_size_t len)
+{
+    while (!APR_BRIGADE_EMPTY(bb)) {
+        apr_bucket *e = APR_BRIGADE_FIRST(bb);
+
+        if (e->length > len) {
+            if (len) {
+                apr_bucket_split(e, len);
+                apr_bucket_delete(e);
+            }
+            break;
+        }
+        len -= e->length;
+        apr_bucket_delete(e);
+    }
+}
+
+/* The buckets of a zero-copy send, kept until the kernel is done with
+ * their data */
+typedef struct brigade_zerocopy_t {
+    APR_RING_HEAD(brigade_zerocopy_list, apr_bucket) list;
+} brigade_zerocopy_t;
+
+static void brigade_zerocopy_done(void *ctx, int copied)
+{
+    brigade_zerocopy_t *zc = ctx;
+
+    while (!APR_RING_EMPTY(&zc->list, apr_bucket, link)) {
+        apr_bucket *e = APR_RING_FIRST(&zc->list);
+
+        APR_BUCKET_REMOVE(e);
+        apr_bucket_destroy(e);
+    }
+    apr_bucket_free(zc);
+}
+
+/* Like brigade_consume(), but keeping the data buckets */
+static void brigade_zerocopy_hold(apr_bucket_brigade *bb, apr_size_t len,
+                                  brigade_zerocopy_t *zc)
+{
+    while (!APR_BRIGADE_EMPTY(bb)) {
+        apr_bucket *e = APR_BRIGADE_FIRST(bb);
+
+        if (e->length > len) {
+            if (!len) {
+                break;
+            }
+            apr_bucket_split(e, len);
+        }
+        len -= e->length;
+        APR_BUCKET_REMOVE(e);
+        if (APR_BUCKET_IS_METADATA(e)) {
+            apr_bucket_destroy(e);
+        }
+        else {
+            APR_RING_INSERT_TAIL(&zc->list, e, apr_bucket, link);
+        }
+    }
+}
+
+/* Whether the data of the bucket lives as long as the bucket */
+#if APR_HAS_MMAP
+#define BRIGADE_ZEROCOPY_BUCKET(e) \
+    (APR_BUCKET_IS_HEAP(e) || APR_BUCKET_IS_SHAREDBUF(e) \
+     || APR_BUCKET_IS_IMMORTAL(e) || APR_BUCKET_IS_MMAP(e))
+#else
+#define BRIGADE_ZEROCOPY_BUCKET(e) \
+    (APR_BUCKET_IS_HEAP(e) || APR_BUCKET_IS_SHAREDBUF(e) \
+     || APR_BUCKET_IS_IMMORTAL(e))
+#endif
+
+/* The batches of apr_brigade_send() are bounded both in iovecs and in
+ * bytes read into memory, so that a large file is not read at once */
+#define BRIGADE_SEND_MAX_IOVEC 64
+#define BRIGADE_SEND_MAX_BYTES (256 * 1024)
+/* Small files are cheaper to copy than to sendfile() */
+#define BRIGADE_SEND_MIN_SENDFILE 256
+/* Small writes are cheaper to copy than to track their completion */
+#define BRIGADE_SEND_MIN_ZEROCOPY (16 * 1024)
+
+APR_DECLARE(apr_status_t) apr_brigade_send(apr_socket_t *sock,
+                                           apr_bucket_brigade *bb,
+                                           apr_int32_t flags,
+                                           apr_size_t *sent)
+{
+    struct iovec vec[BRIGADE_SEND_MAX_IOVEC];
+    int max_vec = APR_MAX_IOVEC_SIZE < BRIGADE_SEND_MAX_IOVEC
+                  ? APR_MAX_IOVEC_SIZE : BRIGADE_SEND_MAX_IOVEC;
+    apr_status_t rv = APR_SUCCESS, read_rv = APR_SUCCESS;
+    int splice = !(flags & APR_BRIGADE_SEND_NOSPLICE);
+    int zerocopy = (flags & APR_BRIGADE_SEND_ZEROCOPY) != 0;
+    apr_size_t len;
+
+    if (zerocopy) {
+        /* Release what the previous zero-copy sends are done with */
+        apr_socket_zerocopy_reap(sock, NULL);
+    }
+
+    /* What a previous splice could not send goes first */
+    len = 0;
+    rv = apr_socket_splice(sock, NULL, &len);
+    *sent = len;
+    if (rv != APR_SUCCESS && rv != APR_ENOTIMPL) {
+        return rv;
+    }
+
+    while (!APR_BRIGADE_EMPTY(bb)) {
+        apr_bucket *e, *file_bucket = NULL, *splice_bucket = NULL;
+        apr_size_t total = 0;
+        int nvec = 0, nheaders = 0, owned = 1;
+
+        for (e = APR_BRIGADE_FIRST(bb);
+             e != APR_BRIGADE_SENTINEL(bb) && nvec < max_vec
+                 && total < BRIGADE_SEND_MAX_BYTES;
+             e = APR_BUCKET_NEXT(e)) {
+            const char *data;
+
+            if (APR_BUCKET_IS_METADATA(e)) {
+                continue;
+            }
+            if (e->length == (apr_size_t)-1 && (nvec || file_bucket)) {
+                /* Send what precedes before blocking */
+                break;
+            }
+            if (splice && (APR_BUCKET_IS_SOCKET(e) || APR_BUCKET_IS_PIPE(e))) {
+                /* Moved in kernel space rather than read */
+                splice_bucket = e;
+                break;
+            }
+#if APR_HAS_SENDFILE
+            if (APR_BUCKET_IS_FILE(e)
+                    && !(flags & APR_BRIGADE_SEND_NOSENDFILE)
+                    && e->length >= BRIGADE_SEND_MIN_SENDFILE
+                    && (apr_file_flags_get(((apr_bucket_file *)e->data)->fd)
+                        & APR_FOPEN_SENDFILE_ENABLED)) {
+                if (file_bucket) {
+                    break;
+                }
+                /* What precedes it becomes the headers */
+                file_bucket = e;
+                nheaders = nvec;
+                continue;
+            }
+#endif
+            read_rv = apr_bucket_read(e, &data, &len, APR_BLOCK_READ);
+            if (read_rv != APR_SUCCESS) {
+                break;
+            }
+            if (len) {
+                vec[nvec].iov_base = (void *)data;
+                vec[nvec].iov_len = len;
+                nvec++;
+                total += len;
+                owned = owned && BRIGADE_ZEROCOPY_BUCKET(e);
+            }
+        }
+        if (read_rv != APR_SUCCESS && !nvec && !file_bucket) {
+            return read_rv;
+        }
+
+        if (splice_bucket) {
+            len = 0;
+            if (APR_BUCKET_IS_SOCKET(splice_bucket)) {
+                rv = apr_socket_splice(sock, splice_bucket->data, &len);
+            }
+            else {
+                rv = apr_socket_splice_file(sock, splice_bucket->data, &len);
+            }
+            *sent += len;
+            if (rv == APR_ENOTIMPL) {
+                /* Read it then */
+                splice = 0;
+                continue;
+            }
+            /* Drop the metadata before it */
+            brigade_consume(bb, 0);
+            if (rv == APR_EOF) {
+                if (APR_BUCKET_IS_PIPE(splice_bucket)) {
+                    apr_file_close(splice_bucket->data);
+                }
+                apr_bucket_delete(splice_bucket);
+                continue;
+            }
+            if (rv != APR_SUCCESS) {
+                return rv;
+            }
+            continue;
+        }
+
+        if (file_bucket) {
+#if APR_HAS_SENDFILE
+            apr_bucket_file *a = file_bucket->data;
+            apr_off_t offset = file_bucket->start;
+            apr_hdtr_t hdtr;
+
+            hdtr.headers = vec;
+            hdtr.numheaders = nheaders;
+            hdtr.trailers = vec + nheaders;
+            hdtr.numtrailers = nvec - nheaders;
+            len = file_bucket->length;
+            rv = apr_socket_sendfile(sock, a->fd, &hdtr, &offset, &len, 0);
+#endif
+        }
+        else if (nvec) {
+            if (zerocopy && owned && total >= BRIGADE_SEND_MIN_ZEROCOPY) {
+                brigade_zerocopy_t *zc;
+
+                zc = apr_bucket_alloc(sizeof(*zc), bb->bucket_alloc);
+                APR_RING_INIT(&zc->list, apr_bucket, link);
+                rv = apr_socket_sendv_zerocopy(sock, vec, nvec, &len,
+                                               brigade_zerocopy_done, zc);
+                if (rv == APR_SUCCESS && len) {
+                    /* Kept until the kernel is done with them */
+                    *sent += len;
+                    brigade_zerocopy_hold(bb, len, zc);
+                    if (read_rv != APR_SUCCESS) {
+                        return read_rv;
+                    }
+                    continue;
+                }
+                apr_bucket_free(zc);
+                if (rv == APR_ENOTIMPL) {
+                    zerocopy = 0;
+                }
+                if (APR_STATUS_IS_EAGAIN(rv) || APR_STATUS_IS_TIMEUP(rv)) {
+                    return rv;
+                }
+                /* Copied then, e.g. when too many sends are pending */
+            }
+            rv = apr_socket_sendv(sock, vec, nvec, &len);
+        }
+        else {
+            /* Nothing but metadata */
+            rv = APR_SUCCESS;
+            len = 0;
+        }
+
+        *sent += len;
+        brigade_consume(bb, len);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+        if (read_rv != APR_SUCCESS) {
+            return read_rv;
+        }
+    }
+
+    return APR_SUCCESS;
+}
+
 APR_DECLARE(apr_status_t) apr_brigade_vputstrs(apr_bucket_brigade *b, 
                                                apr_brigade_flush flush,
                                                void *ctx,
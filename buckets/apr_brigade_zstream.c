@@ -0,0 +1,486 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_buckets.h"
+#include "apr_errno.h"
+#include "apr_time.h"
+
+#if APU_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#if APU_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#if APU_HAVE_ZLIB || APU_HAVE_ZSTD
+
+/* The output buffers, as those of apr_brigade_write() */
+#define ZSTREAM_BUF_SIZE APR_BUCKET_BUFF_SIZE
+
+/* What the codec is asked to output, besides consuming the input */
+typedef enum {
+    ZSTREAM_RUN,
+    ZSTREAM_FLUSH,
+    ZSTREAM_FINISH
+} zstream_mode_e;
+
+struct apr_brigade_zstream_t {
+    apr_bucket_alloc_t *list;
+    apr_zstream_format_e format;
+    int compress;
+    int ended;                  /* the end of the stream was output/met */
+    char *buf;                  /* the output buffer being filled */
+    apr_size_t used;
+    apr_brigade_zstream_stats_t stats;
+    /* Consumes what it can of the input, the output going to the free
+     * space of the buffer; *done is set once the input is consumed and
+     * the output asked by the mode is in the buffer. */
+    apr_status_t (*step)(apr_brigade_zstream_t *zs, const char **in,
+                         apr_size_t *inlen, zstream_mode_e mode, int *done);
+    union {
+#if APU_HAVE_ZLIB
+        z_stream zlib;
+#endif
+#if APU_HAVE_ZSTD
+        ZSTD_CCtx *zstd_c;
+        ZSTD_DCtx *zstd_d;
+#endif
+    } u;
+};
+
+#if APU_HAVE_ZLIB
+
+static apr_status_t zlib_step(apr_brigade_zstream_t *zs, const char **in,
+                              apr_size_t *inlen, zstream_mode_e mode,
+                              int *done)
+{
+    z_stream *strm = &zs->u.zlib;
+    uInt avail_in = *inlen > 0x40000000 ? 0x40000000 : (uInt)*inlen;
+    int zrv;
+
+    strm->next_in = (Bytef *)*in;
+    strm->avail_in = avail_in;
+    strm->next_out = (Bytef *)zs->buf + zs->used;
+    strm->avail_out = (uInt)(ZSTREAM_BUF_SIZE - zs->used);
+
+    if (zs->compress) {
+        zrv = deflate(strm, mode == ZSTREAM_FINISH ? Z_FINISH
+                          : mode == ZSTREAM_FLUSH ? Z_SYNC_FLUSH
+                          : Z_NO_FLUSH);
+    }
+    else {
+        zrv = inflate(strm, Z_NO_FLUSH);
+    }
+
+    *in += avail_in - strm->avail_in;
+    *inlen -= avail_in - strm->avail_in;
+    zs->used = ZSTREAM_BUF_SIZE - strm->avail_out;
+
+    switch (zrv) {
+    case Z_STREAM_END:
+        zs->ended = 1;
+        break;
+    case Z_OK:
+    case Z_BUF_ERROR:           /* no progress possible, not fatal */
+        break;
+    case Z_MEM_ERROR:
+        return APR_ENOMEM;
+    case Z_DATA_ERROR:
+    case Z_NEED_DICT:
+        return APR_BADCH;
+    default:
+        return APR_EGENERAL;
+    }
+
+    /* Full output buffers may leave more to output */
+    if (mode == ZSTREAM_FINISH) {
+        *done = zs->ended;
+    }
+    else {
+        *done = (zs->ended || !*inlen) && strm->avail_out;
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t zlib_cleanup(void *data)
+{
+    apr_brigade_zstream_t *zs = data;
+
+    if (zs->compress) {
+        deflateEnd(&zs->u.zlib);
+    }
+    else {
+        inflateEnd(&zs->u.zlib);
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t zlib_init(apr_brigade_zstream_t *zs, int level,
+                              apr_pool_t *p)
+{
+    /* Windows of 32KB, with the gzip header and trailer for 16 more */
+    int bits = zs->format == APR_ZSTREAM_GZIP ? 15 + 16 : 15;
+    int zrv;
+
+    if (zs->compress) {
+        zrv = deflateInit2(&zs->u.zlib, level < 0 ? Z_DEFAULT_COMPRESSION
+                                                  : level,
+                           Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY);
+    }
+    else {
+        zrv = inflateInit2(&zs->u.zlib, bits);
+    }
+    if (zrv != Z_OK) {
+        return zrv == Z_MEM_ERROR ? APR_ENOMEM : APR_EINVAL;
+    }
+
+    zs->step = zlib_step;
+    apr_pool_cleanup_register(p, zs, zlib_cleanup, apr_pool_cleanup_null);
+    return APR_SUCCESS;
+}
+
+#endif /* APU_HAVE_ZLIB */
+
+#if APU_HAVE_ZSTD
+
+static apr_status_t zstd_step(apr_brigade_zstream_t *zs, const char **in,
+                              apr_size_t *inlen, zstream_mode_e mode,
+                              int *done)
+{
+    ZSTD_inBuffer zin;
+    ZSTD_outBuffer zout;
+    size_t zrv;
+
+    zin.src = *in;
+    zin.size = *inlen;
+    zin.pos = 0;
+    zout.dst = zs->buf;
+    zout.size = ZSTREAM_BUF_SIZE;
+    zout.pos = zs->used;
+
+    if (zs->compress) {
+        zrv = ZSTD_compressStream2(zs->u.zstd_c, &zout, &zin,
+                                   mode == ZSTREAM_FINISH ? ZSTD_e_end
+                                   : mode == ZSTREAM_FLUSH ? ZSTD_e_flush
+                                   : ZSTD_e_continue);
+    }
+    else if (zs->ended) {
+        zin.pos = zin.size;
+        zrv = 1;
+    }
+    else {
+        zrv = ZSTD_decompressStream(zs->u.zstd_d, &zout, &zin);
+    }
+    if (ZSTD_isError(zrv)) {
+        return zs->compress ? APR_EGENERAL : APR_BADCH;
+    }
+
+    *in += zin.pos;
+    *inlen -= zin.pos;
+    zs->used = zout.pos;
+
+    if (zs->compress) {
+        /* Zero once the flush or the end is fully output */
+        if (mode == ZSTREAM_RUN) {
+            *done = !*inlen;
+        }
+        else {
+            *done = !zrv && !*inlen;
+            if (*done && mode == ZSTREAM_FINISH) {
+                zs->ended = 1;
+            }
+        }
+    }
+    else {
+        if (!zrv) {
+            zs->ended = 1;
+        }
+        *done = (zs->ended || !*inlen) && zout.pos < zout.size;
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t zstd_cleanup(void *data)
+{
+    apr_brigade_zstream_t *zs = data;
+
+    if (zs->compress) {
+        ZSTD_freeCCtx(zs->u.zstd_c);
+    }
+    else {
+        ZSTD_freeDCtx(zs->u.zstd_d);
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t zstd_init(apr_brigade_zstream_t *zs, int level,
+                              apr_pool_t *p)
+{
+    if (zs->compress) {
+        zs->u.zstd_c = ZSTD_createCCtx();
+        if (!zs->u.zstd_c) {
+            return APR_ENOMEM;
+        }
+        if (ZSTD_isError(ZSTD_CCtx_setParameter(zs->u.zstd_c,
+                                   ZSTD_c_compressionLevel,
+                                   level < 0 ? ZSTD_CLEVEL_DEFAULT : level))) {
+            ZSTD_freeCCtx(zs->u.zstd_c);
+            return APR_EINVAL;
+        }
+    }
+    else {
+        zs->u.zstd_d = ZSTD_createDCtx();
+        if (!zs->u.zstd_d) {
+            return APR_ENOMEM;
+        }
+    }
+
+    zs->step = zstd_step;
+    apr_pool_cleanup_register(p, zs, zstd_cleanup, apr_pool_cleanup_null);
+    return APR_SUCCESS;
+}
+
+#endif /* APU_HAVE_ZSTD */
+
+static apr_status_t zstream_buf_cleanup(void *data)
+{
+    apr_brigade_zstream_t *zs = data;
+
+    if (zs->buf) {
+        apr_bucket_free(zs->buf);
+        zs->buf = NULL;
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t zstream_create(apr_brigade_zstream_t **zs,
+                                   apr_zstream_format_e format,
+                                   int compress, int level,
+                                   apr_bucket_alloc_t *list, apr_pool_t *p)
+{
+    apr_brigade_zstream_t *new_zs;
+    apr_status_t rv;
+
+    new_zs = apr_pcalloc(p, sizeof(*new_zs));
+    new_zs->list = list;
+    new_zs->format = format;
+    new_zs->compress = compress;
+
+    switch (format) {
+#if APU_HAVE_ZLIB
+    case APR_ZSTREAM_DEFLATE:
+    case APR_ZSTREAM_GZIP:
+        rv = zlib_init(new_zs, level, p);
+        break;
+#endif
+#if APU_HAVE_ZSTD
+    case APR_ZSTREAM_ZSTD:
+        rv = zstd_init(new_zs, level, p);
+        break;
+#endif
+    default:
+        rv = APR_ENOTIMPL;
+    }
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+
+    /* Run before the codec's cleanup, and before the bucket allocator's
+     * if it comes from the same pool */
+    apr_pool_cleanup_register(p, new_zs, zstream_buf_cleanup,
+                              apr_pool_cleanup_null);
+
+    *zs = new_zs;
+    return APR_SUCCESS;
+}
+
+static void zstream_emit(apr_brigade_zstream_t *zs, apr_bucket_brigade *bb)
+{
+    if (zs->used) {
+        apr_bucket *e = apr_bucket_heap_create(zs->buf, zs->used,
+                                               apr_bucket_free, zs->list);
+
+        APR_BRIGADE_INSERT_TAIL(bb, e);
+        zs->stats.bytes_out += zs->used;
+        zs->buf = NULL;
+        zs->used = 0;
+    }
+}
+
+/* Feed the codec until it is done with the input and the mode */
+static apr_status_t zstream_run(apr_brigade_zstream_t *zs,
+                                apr_bucket_brigade *bb,
+                                const char *data, apr_size_t len,
+                                zstream_mode_e mode)
+{
+    apr_time_t start = apr_time_now();
+    apr_status_t rv = APR_SUCCESS;
+    int done = 0;
+
+    zs->stats.bytes_in += len;
+    while (!done) {
+        if (!zs->buf) {
+            zs->buf = apr_bucket_alloc(ZSTREAM_BUF_SIZE, zs->list);
+            if (!zs->buf) {
+                rv = APR_ENOMEM;
+                break;
+            }
+        }
+        rv = zs->step(zs, &data, &len, mode, &done);
+        if (rv != APR_SUCCESS) {
+            break;
+        }
+        if (zs->used == ZSTREAM_BUF_SIZE) {
+            zstream_emit(zs, bb);
+        }
+    }
+
+    zs->stats.time += apr_time_now() - start;
+    return rv;
+}
+
+APR_DECLARE(apr_status_t) apr_brigade_zstream_compress_create(
+                                             apr_brigade_zstream_t **zs,
+                                             apr_zstream_format_e format,
+                                             int level,
+                                             apr_bucket_alloc_t *list,
+                                             apr_pool_t *p)
+{
+    return zstream_create(zs, format, 1, level, list, p);
+}
+
+APR_DECLARE(apr_status_t) apr_brigade_zstream_decompress_create(
+                                             apr_brigade_zstream_t **zs,
+                                             apr_zstream_format_e format,
+                                             apr_bucket_alloc_t *list,
+                                             apr_pool_t *p)
+{
+    return zstream_create(zs, format, 0, 0, list, p);
+}
+
+APR_DECLARE(apr_status_t) apr_brigade_zstream_process(
+                                             apr_brigade_zstream_t *zs,
+                                             apr_bucket_brigade *bbOut,
+                                             apr_bucket_brigade *bbIn,
+                                             apr_read_type_e block)
+{
+    apr_status_t rv = APR_SUCCESS;
+
+    while (!APR_BRIGADE_EMPTY(bbIn)) {
+        apr_bucket *e = APR_BRIGADE_FIRST(bbIn);
+
+        if (APR_BUCKET_IS_EOS(e)) {
+            if (zs->compress) {
+                rv = zstream_run(zs, bbOut, NULL, 0, ZSTREAM_FINISH);
+            }
+            else if (!zs->ended) {
+                rv = APR_EINCOMPLETE;
+            }
+            if (rv != APR_SUCCESS) {
+                break;
+            }
+            zstream_emit(zs, bbOut);
+            APR_BUCKET_REMOVE(e);
+            APR_BRIGADE_INSERT_TAIL(bbOut, e);
+            return APR_SUCCESS;
+        }
+        else if (APR_BUCKET_IS_FLUSH(e)) {
+            if (zs->compress && !zs->ended) {
+                rv = zstream_run(zs, bbOut, NULL, 0, ZSTREAM_FLUSH);
+                if (rv != APR_SUCCESS) {
+                    break;
+                }
+            }
+            zstream_emit(zs, bbOut);
+            APR_BUCKET_REMOVE(e);
+            APR_BRIGADE_INSERT_TAIL(bbOut, e);
+        }
+        else if (APR_BUCKET_IS_METADATA(e)) {
+            APR_BUCKET_REMOVE(e);
+            APR_BRIGADE_INSERT_TAIL(bbOut, e);
+        }
+        else {
+            const char *data;
+            apr_size_t len;
+
+            rv = apr_bucket_read(e, &data, &len, block);
+            if (rv != APR_SUCCESS) {
+                break;
+            }
+            if (len) {
+                rv = zstream_run(zs, bbOut, data, len, ZSTREAM_RUN);
+                if (rv != APR_SUCCESS) {
+                    break;
+                }
+            }
+            apr_bucket_delete(e);
+        }
+    }
+
+    if (!zs->compress) {
+        zstream_emit(zs, bbOut);
+    }
+    return rv;
+}
+
+APR_DECLARE(void) apr_brigade_zstream_stats_get(apr_brigade_zstream_t *zs,
+                                             apr_brigade_zstream_stats_t *stats)
+{
+    *stats = zs->stats;
+}
+
+#else /* APU_HAVE_ZLIB || APU_HAVE_ZSTD */
+
+struct apr_brigade_zstream_t {
+    apr_brigade_zstream_stats_t stats;
+};
+
+APR_DECLARE(apr_status_t) apr_brigade_zstream_compress_create(
+                                             apr_brigade_zstream_t **zs,
+                                             apr_zstream_format_e format,
+                                             int level,
+                                             apr_bucket_alloc_t *list,
+                                             apr_pool_t *p)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_brigade_zstream_decompress_create(
+                                             apr_brigade_zstream_t **zs,
+                                             apr_zstream_format_e format,
+                                             apr_bucket_alloc_t *list,
+                                             apr_pool_t *p)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_brigade_zstream_process(
+                                             apr_brigade_zstream_t *zs,
+                                             apr_bucket_brigade *bbOut,
+                                             apr_bucket_brigade *bbIn,
+                                             apr_read_type_e block)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(void) apr_brigade_zstream_stats_get(apr_brigade_zstream_t *zs,
+                                             apr_brigade_zstream_stats_t *stats)
+{
+    *stats = zs->stats;
+}
+
+#endif /* APU_HAVE_ZLIB || APU_HAVE_ZSTD */
@@ -19,6 +19,12 @@
 #include "apr_buckets.h"
 #include "apr_allocator.h"
 #include "apr_support.h"
+#if APR_HAS_THREADS
+#include "apr_atomic.h"
+#include "apr_portable.h"
+#include "apr_thread_mutex.h"
+#include "apr_thread_proc.h"
+#endif
 
 #define ALLOC_AMT (8192 - APR_MEMNODE_T_SIZE)
 
@@ -40,8 +46,135 @@ struct apr_bucket_alloc_t {
     apr_allocator_t *allocator;
     node_header_t *freelist;
     apr_memnode_t *blocks;
+    apr_size_t read_size;         /* adaptive size of the SOCKET/PIPE reads */
+    apr_size_t read_min;
+    apr_size_t read_max;
+    int read_flags;
+#if APR_HAS_THREADS
+    /* A threadsafe allocator only finds the cache of the calling thread,
+     * a plain allocator which the thread alone allocates from.  The nodes
+     * freed by other threads are pushed to the remote_free stack of their
+     * cache, which its owner takes back when it allocates. */
+    apr_threadkey_t *cache_key;
+    apr_thread_mutex_t *lock;         /* protects the lists of caches */
+    apr_bucket_alloc_t *caches;
+    apr_bucket_alloc_t *abandoned;    /* caches of the exited threads */
+    /* For a cache */
+    apr_bucket_alloc_t *front;
+    apr_bucket_alloc_t *next;
+    apr_bucket_alloc_t *next_abandoned;
+    apr_os_thread_t owner;            /* meaningful only while owned */
+    volatile apr_uint32_t owned;
+    void *volatile remote_free;
+#endif
 };
 
+static APR_INLINE void node_free(apr_bucket_alloc_t *list,
+                                 node_header_t *node);
+
+#if APR_HAS_THREADS
+
+static void remote_free_drain(apr_bucket_alloc_t *cache)
+{
+    node_header_t *node = apr_atomic_xchgptr(&cache->remote_free, NULL);
+
+    while (node) {
+        node_header_t *next = node->next;
+
+        node_free(cache, node);
+        node = next;
+    }
+}
+
+static void remote_free_push(apr_bucket_alloc_t *cache, node_header_t *node)
+{
+    void *head;
+
+    /* The owner takes the whole stack at once, so there is no ABA */
+    do {
+        head = cache->remote_free;
+        node->next = head;
+    } while (apr_atomic_casptr(&cache->remote_free, node, head) != head);
+}
+
+/* Called on the exit of a thread, for the next one to adopt the cache */
+static void cache_abandon(void *data)
+{
+    apr_bucket_alloc_t *cache = data, *front = cache->front;
+
+    apr_thread_mutex_lock(front->lock);
+    /* The id of the exited thread may be reused by another one, which must
+     * not take it for its own cache */
+    apr_atomic_set32(&cache->owned, 0);
+    cache->next_abandoned = front->abandoned;
+    front->abandoned = cache;
+    apr_thread_mutex_unlock(front->lock);
+}
+
+static apr_bucket_alloc_t *cache_get(apr_bucket_alloc_t *front)
+{
+    apr_bucket_alloc_t *cache;
+    void *data;
+
+    apr_threadkey_private_get(&data, front->cache_key);
+    if (data) {
+        return data;
+    }
+
+    apr_thread_mutex_lock(front->lock);
+    if ((cache = front->abandoned)) {
+        front->abandoned = cache->next_abandoned;
+    }
+    else {
+        apr_allocator_t *allocator;
+
+        if (apr_allocator_create(&allocator) != APR_SUCCESS) {
+            apr_thread_mutex_unlock(front->lock);
+            return NULL;
+        }
+        cache = apr_bucket_alloc_create_ex(allocator);
+        if (!cache) {
+            apr_allocator_destroy(allocator);
+            apr_thread_mutex_unlock(front->lock);
+            return NULL;
+        }
+        cache->front = front;
+        cache->next = front->caches;
+        front->caches = cache;
+    }
+    cache->owner = apr_os_thread_current();
+    apr_atomic_set32(&cache->owned, 1);
+    apr_thread_mutex_unlock(front->lock);
+
+    apr_threadkey_private_set(cache, front->cache_key);
+    return cache;
+}
+
+#endif /* APR_HAS_THREADS */
+
+static void caches_destroy(apr_bucket_alloc_t *list)
+{
+#if APR_HAS_THREADS
+    apr_bucket_alloc_t *cache, *next;
+
+    if (!list->cache_key) {
+        return;
+    }
+    apr_threadkey_private_delete(list->cache_key);
+    list->cache_key = NULL;
+
+    for (cache = list->caches; cache; cache = next) {
+        apr_allocator_t *allocator = cache->allocator;
+
+        next = cache->next;
+        remote_free_drain(cache);
+        apr_allocator_free(allocator, cache->blocks);
+        apr_allocator_destroy(allocator);
+    }
+    list->caches = list->abandoned = NULL;
+#endif
+}
+
 static apr_status_t alloc_cleanup(void *data)
 {
     apr_bucket_alloc_t *list = data;
@@ -55,6 +188,7 @@ static apr_status_t alloc_cleanup(void *data)
     }
 #endif
 
+    caches_destroy(list);
     apr_allocator_free(list->allocator, list->blocks);
 
 #if APR_POOL_DEBUG
@@ -96,6 +230,26 @@ APR_DECLARE_NONSTD(apr_bucket_alloc_t *) apr_bucket_alloc_create(apr_pool_t *p)
     return list;
 }
 
+APR_DECLARE_NONSTD(apr_bucket_alloc_t *) apr_bucket_alloc_create_threadsafe(
+                                             apr_pool_t *p)
+{
+    apr_bucket_alloc_t *list = apr_bucket_alloc_create(p);
+
+#if APR_HAS_THREADS
+    if (apr_thread_mutex_create(&list->lock, APR_THREAD_MUTEX_DEFAULT,
+                                p) != APR_SUCCESS
+            || apr_threadkey_private_create(&list->cache_key, cache_abandon,
+                                            p) != APR_SUCCESS) {
+        apr_abortfunc_t fn = apr_pool_abort_get(p);
+        if (fn)
+            (fn)(APR_ENOMEM);
+        abort();
+    }
+#endif
+
+    return list;
+}
+
 APR_DECLARE_NONSTD(apr_bucket_alloc_t *) apr_bucket_alloc_create_ex(
                                              apr_allocator_t *allocator)
 {
@@ -111,6 +265,17 @@ APR_DECLARE_NONSTD(apr_bucket_alloc_t *) apr_bucket_alloc_create_ex(
     list->allocator = allocator;
     list->freelist = NULL;
     list->blocks = block;
+    list->read_size = list->read_min = APR_BUCKET_BUFF_SIZE;
+    list->read_max = APR_BUCKET_READ_SIZE_MAX;
+    list->read_flags = 0;
+#if APR_HAS_THREADS
+    list->cache_key = NULL;
+    list->lock = NULL;
+    list->caches = list->abandoned = NULL;
+    list->front = list->next = list->next_abandoned = NULL;
+    list->owned = 0;
+    list->remote_free = NULL;
+#endif
     block->first_avail += APR_ALIGN_DEFAULT(sizeof(*list));
     APR_VALGRIND_NOACCESS(block->first_avail,
                           block->endp - block->first_avail);
@@ -123,6 +288,7 @@ APR_DECLARE_NONSTD(void) apr_bucket_alloc_destroy(apr_bucket_alloc_t *list)
         apr_pool_cleanup_kill(list->pool, list, alloc_cleanup);
     }
 
+    caches_destroy(list);
     apr_allocator_free(list->allocator, list->blocks);
 
 #if APR_POOL_DEBUG
@@ -152,14 +318,110 @@ APR_DECLARE_NONSTD(apr_size_t) apr_bucket_alloc_aligned_floor(apr_bucket_alloc_t
     return size;
 }
 
+APR_DECLARE_NONSTD(void) apr_bucket_alloc_read_size_set(apr_bucket_alloc_t *list,
+                                                        apr_size_t min,
+                                                        apr_size_t max,
+                                                        int flags)
+{
+    list->read_min = min ? min : APR_BUCKET_BUFF_SIZE;
+    list->read_max = max ? max : APR_BUCKET_READ_SIZE_MAX;
+    if (list->read_max < list->read_min) {
+        list->read_max = list->read_min;
+    }
+    list->read_size = list->read_min;
+    list->read_flags = flags;
+}
+
+/* The adaptive read size of the calling thread, NULL if it has none.  With
+ * a threadsafe allocator it lives in the thread's cache, and adapts within
+ * the limits set on the allocator.
+ */
+static apr_size_t *read_size_of(apr_bucket_alloc_t *list)
+{
+#if APR_HAS_THREADS
+    if (list->cache_key) {
+        apr_bucket_alloc_t *cache = cache_get(list);
+
+        if (!cache) {
+            return NULL;
+        }
+        if (cache->read_size < list->read_min
+                || cache->read_size > list->read_max) {
+            cache->read_size = list->read_min;
+        }
+        return &cache->read_size;
+    }
+#endif
+    return &list->read_size;
+}
+
+APR_DECLARE_NONSTD(apr_size_t) apr_bucket_alloc_read_size_get(apr_bucket_alloc_t *list,
+                                                              apr_size_t *chunk)
+{
+    apr_size_t *read_size = read_size_of(list);
+    apr_size_t size, min, want;
+
+    want = read_size ? *read_size : list->read_min;
+    if (!chunk || !(list->read_flags & APR_BUCKET_READ_READV)) {
+        size = apr_bucket_alloc_aligned_floor(list, want);
+        if (chunk) {
+            *chunk = size;
+        }
+        return size;
+    }
+
+    /* As many buffers of the minimum size as needed to reach the read size */
+    min = apr_bucket_alloc_aligned_floor(list, list->read_min);
+    *chunk = min;
+    return min * ((want + list->read_min - 1) / list->read_min);
+}
+
+APR_DECLARE_NONSTD(void) apr_bucket_alloc_read_update(apr_bucket_alloc_t *list,
+                                                      apr_size_t asked,
+                                                      apr_size_t got)
+{
+    apr_size_t *read_size = read_size_of(list);
+
+    if (!read_size) {
+        return;
+    }
+    if (got >= asked) {
+        if (*read_size < list->read_max) {
+            *read_size *= 2;
+            if (*read_size > list->read_max) {
+                *read_size = list->read_max;
+            }
+        }
+    }
+    else if (got <= asked / 2 && *read_size > list->read_min) {
+        *read_size /= 2;
+        if (*read_size < list->read_min) {
+            *read_size = list->read_min;
+        }
+    }
+}
+
 APR_DECLARE_NONSTD(void *) apr_bucket_alloc(apr_size_t in_size,
                                             apr_bucket_alloc_t *list)
 {
     node_header_t *node;
-    apr_memnode_t *active = list->blocks;
+    apr_memnode_t *active;
     char *endp;
     apr_size_t size;
 
+#if APR_HAS_THREADS
+    if (list->cache_key) {
+        list = cache_get(list);
+        if (!list) {
+            return NULL;
+        }
+    }
+    if (list->remote_free) {
+        remote_free_drain(list);
+    }
+#endif
+
+    active = list->blocks;
     size = in_size + SIZEOF_NODE_HEADER_T;
     if (size <= SMALL_NODE_SIZE) {
         if (list->freelist) {
@@ -223,18 +485,32 @@ static void check_not_already_free(node_header_t *node)
 #define check_not_already_free(node)
 #endif
 
-APR_DECLARE_NONSTD(void) apr_bucket_free(void *mem)
+static APR_INLINE void node_free(apr_bucket_alloc_t *list, node_header_t *node)
 {
-    node_header_t *node = (node_header_t *)((char *)mem - SIZEOF_NODE_HEADER_T);
-    apr_bucket_alloc_t *list = node->alloc;
-
     if (node->size == SMALL_NODE_SIZE) {
         check_not_already_free(node);
         node->next = list->freelist;
         list->freelist = node;
-        APR_VALGRIND_NOACCESS(mem, SMALL_NODE_SIZE - SIZEOF_NODE_HEADER_T);
+        APR_VALGRIND_NOACCESS((char *)node + SIZEOF_NODE_HEADER_T,
+                              SMALL_NODE_SIZE - SIZEOF_NODE_HEADER_T);
     }
     else {
         apr_allocator_free(list->allocator, node->memnode);
     }
 }
+
+APR_DECLARE_NONSTD(void) apr_bucket_free(void *mem)
+{
+    node_header_t *node = (node_header_t *)((char *)mem - SIZEOF_NODE_HEADER_T);
+    apr_bucket_alloc_t *list = node->alloc;
+
+#if APR_HAS_THREADS
+    if (list->front && !(apr_atomic_read32(&list->owned)
+                         && apr_os_thread_equal(list->owner,
+                                                apr_os_thread_current()))) {
+        remote_free_push(list, node);
+        return;
+    }
+#endif
+    node_free(list, node);
+}
@@ -18,11 +18,15 @@
 
 #if APR_HAS_MMAP
 
+/* How far beyond the data being read the next pages are requested */
+#define MMAP_READAHEAD_WINDOW (256 * 1024)
+
 static apr_status_t mmap_bucket_read(apr_bucket *b, const char **str, 
                                      apr_size_t *length, apr_read_type_e block)
 {
     apr_bucket_mmap *m = b->data;
     apr_status_t ok;
+    apr_off_t end;
     void *addr;
    
     if (!m->mmap) {
@@ -34,6 +38,28 @@ static apr_status_t mmap_bucket_read(apr_bucket *b, const char **str,
     if (ok != APR_SUCCESS) {
         return ok;
     }
+
+    /* Have the pages of this bucket and of the next window read in while
+     * the consumer goes through the data, rather than faulting on each.
+     * They are requested a window at a time, when the reads get within
+     * half a window of the end of the previous request, so the buckets
+     * split off the mmap share one call per window.
+     */
+    end = b->start + b->length;
+    if (end + MMAP_READAHEAD_WINDOW / 2 > m->readahead
+            && m->readahead < (apr_off_t)m->mmap->size) {
+        apr_off_t from = m->readahead > b->start ? m->readahead : b->start;
+
+        end = (end > m->readahead ? end : m->readahead)
+              + MMAP_READAHEAD_WINDOW;
+        if (end > (apr_off_t)m->mmap->size) {
+            end = m->mmap->size;
+        }
+        apr_mmap_advise(m->mmap, from, (apr_size_t)(end - from),
+                        APR_MMAP_ADVISE_WILLNEED);
+        m->readahead = end;
+    }
+
     *str = addr;
     *length = b->length;
     return APR_SUCCESS;
@@ -76,6 +102,7 @@ APR_DECLARE(apr_bucket *) apr_bucket_mmap_make(apr_bucket *b, apr_mmap_t *mm,
 
     m = apr_bucket_alloc(sizeof(*m), b->list);
     m->mmap = mm;
+    m->readahead = 0;
 
     apr_pool_cleanup_register(mm->cntxt, m, mmap_bucket_cleanup,
                               apr_pool_cleanup_null);
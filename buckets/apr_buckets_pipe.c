@@ -21,6 +21,7 @@ static apr_status_t pipe_bucket_read(apr_bucket *a, const char **str,
 {
     apr_file_t *p = a->data;
     char *buf;
+    apr_size_t size;
     apr_status_t rv;
     apr_interval_time_t timeout;
 
@@ -30,7 +31,7 @@ static apr_status_t pipe_bucket_read(apr_bucket *a, const char **str,
     }
 
     *str = NULL;
-    *len = APR_BUCKET_BUFF_SIZE;
+    *len = size = apr_bucket_alloc_read_size_get(a->list, NULL);
     buf = apr_bucket_alloc(*len, a->list); /* XXX: check for failure? */
 
     rv = apr_file_read(p, buf, len);
@@ -43,6 +44,7 @@ static apr_status_t pipe_bucket_read(apr_bucket *a, const char **str,
         apr_bucket_free(buf);
         return rv;
     }
+    apr_bucket_alloc_read_update(a->list, size, *len);
     /*
      * If there's more to read we have to keep the rest of the pipe
      * for later.  Otherwise, we'll close the pipe.
@@ -60,7 +62,7 @@ static apr_status_t pipe_bucket_read(apr_bucket *a, const char **str,
         /* Change the current bucket to refer to what we read */
         a = apr_bucket_heap_make(a, buf, *len, apr_bucket_free);
         h = a->data;
-        h->alloc_len = APR_BUCKET_BUFF_SIZE; /* note the real buffer size */
+        h->alloc_len = size; /* note the real buffer size */
         *str = buf;
         APR_BUCKET_INSERT_AFTER(a, apr_bucket_pipe_create(p, a->list));
     }
@@ -15,6 +15,7 @@
  */
 
 #include "apr_buckets.h"
+#include "apr_atomic.h"
 
 APR_DECLARE_NONSTD(apr_status_t) apr_bucket_shared_split(apr_bucket *a,
                                                          apr_size_t point)
@@ -61,3 +62,50 @@ APR_DECLARE(apr_bucket *) apr_bucket_shared_make(apr_bucket *b, void *data,
 
     return b;
 }
+
+APR_DECLARE_NONSTD(apr_status_t) apr_bucket_atomic_shared_split(apr_bucket *a,
+                                                                apr_size_t point)
+{
+    apr_bucket_atomic_refcount *r = a->data;
+    apr_status_t rv;
+
+    if ((rv = apr_bucket_simple_split(a, point)) != APR_SUCCESS) {
+        return rv;
+    }
+    apr_atomic_inc32(&r->refcount);
+
+    return APR_SUCCESS;
+}
+
+APR_DECLARE_NONSTD(apr_status_t) apr_bucket_atomic_shared_copy(apr_bucket *a,
+                                                               apr_bucket **b)
+{
+    apr_bucket_atomic_refcount *r = a->data;
+
+    apr_atomic_inc32(&r->refcount);
+
+    return apr_bucket_simple_copy(a, b);
+}
+
+APR_DECLARE(int) apr_bucket_atomic_shared_destroy(void *data)
+{
+    apr_bucket_atomic_refcount *r = data;
+
+    return !apr_atomic_dec32(&r->refcount);
+}
+
+APR_DECLARE(apr_bucket *) apr_bucket_atomic_shared_make(apr_bucket *b,
+                                                        void *data,
+                                                        apr_off_t start,
+                                                        apr_size_t length)
+{
+    apr_bucket_atomic_refcount *r = data;
+
+    b->data   = r;
+    b->start  = start;
+    b->length = length;
+    /* caller initializes the type field */
+    apr_atomic_set32(&r->refcount, 1);
+
+    return b;
+}
@@ -0,0 +1,133 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_buckets.h"
+#include "apr_atomic.h"
+#define APR_WANT_MEMFUNC
+#include "apr_want.h"
+
+#if APR_HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+/* The shared structure and data are malloc()ed rather than taken from the
+ * bucket allocator, which is not thread-safe: the last bucket may be
+ * destroyed by any thread. */
+
+static apr_status_t sharedbuf_bucket_read(apr_bucket *b, const char **str,
+                                          apr_size_t *len,
+                                          apr_read_type_e block)
+{
+    apr_bucket_sharedbuf *s = b->data;
+
+    *str = s->base + b->start;
+    *len = b->length;
+    return APR_SUCCESS;
+}
+
+static void sharedbuf_bucket_destroy(void *data)
+{
+    apr_bucket_sharedbuf *s = data;
+
+    if (apr_bucket_atomic_shared_destroy(s)) {
+        if (s->free_func) {
+            (*s->free_func)((void *)s->base);
+        }
+        free(s);
+    }
+}
+
+APR_DECLARE(apr_bucket *) apr_bucket_sharedbuf_make(apr_bucket *b,
+                                                    const char *buf,
+                                                    apr_size_t length,
+                                                    void (*free_func)(void *data))
+{
+    apr_bucket_sharedbuf *s;
+
+    if (!free_func) {
+        /* The copy follows the structure */
+        s = malloc(APR_ALIGN_DEFAULT(sizeof(*s)) + length);
+        if (s == NULL) {
+            return NULL;
+        }
+        s->base = (char *)s + APR_ALIGN_DEFAULT(sizeof(*s));
+        memcpy((char *)s->base, buf, length);
+    }
+    else {
+        s = malloc(sizeof(*s));
+        if (s == NULL) {
+            return NULL;
+        }
+        s->base = buf;
+    }
+    s->alloc_len = length;
+    s->free_func = free_func;
+
+    b = apr_bucket_atomic_shared_make(b, s, 0, length);
+    b->type = &apr_bucket_type_sharedbuf;
+
+    return b;
+}
+
+APR_DECLARE(apr_bucket *) apr_bucket_sharedbuf_create(const char *buf,
+                                                      apr_size_t length,
+                                                      void (*free_func)(void *data),
+                                                      apr_bucket_alloc_t *list)
+{
+    apr_bucket *b = apr_bucket_alloc(sizeof(*b), list);
+
+    APR_BUCKET_INIT(b);
+    b->free = apr_bucket_free;
+    b->list = list;
+    return apr_bucket_sharedbuf_make(b, buf, length, free_func);
+}
+
+APR_DECLARE(apr_status_t) apr_bucket_sharedbuf_copy_to(apr_bucket *a,
+                                                       apr_bucket_alloc_t *list,
+                                                       apr_bucket **b)
+{
+    apr_bucket_sharedbuf *s = a->data;
+    apr_bucket *c;
+
+    if (!APR_BUCKET_IS_SHAREDBUF(a)) {
+        return APR_EINVAL;
+    }
+    c = apr_bucket_alloc(sizeof(*c), list);
+    if (c == NULL) {
+        return APR_ENOMEM;
+    }
+    apr_atomic_inc32(&s->refcount.refcount);
+
+    APR_BUCKET_INIT(c);
+    c->type = a->type;
+    c->length = a->length;
+    c->start = a->start;
+    c->data = s;
+    c->free = apr_bucket_free;
+    c->list = list;
+
+    *b = c;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE_DATA const apr_bucket_type_t apr_bucket_type_sharedbuf = {
+    "SHAREDBUF", 5, APR_BUCKET_DATA,
+    sharedbuf_bucket_destroy,
+    sharedbuf_bucket_read,
+    apr_bucket_setaside_noop,
+    apr_bucket_atomic_shared_split,
+    apr_bucket_atomic_shared_copy
+};
@@ -16,33 +16,63 @@
 
 #include "apr_buckets.h"
 
+/* Most buffers a read is scattered into, with APR_BUCKET_READ_READV */
+#define SOCKET_READV_MAX 16
+
 static apr_status_t socket_bucket_read(apr_bucket *a, const char **str,
                                        apr_size_t *len, apr_read_type_e block)
 {
     apr_socket_t *p = a->data;
-    char *buf;
+    apr_bucket_alloc_t *list = a->list;
+    struct iovec vec[SOCKET_READV_MAX];
+    apr_size_t size, chunk, remaining;
+    apr_int32_t nvec, i;
     apr_status_t rv;
     apr_interval_time_t timeout;
 
+    *str = NULL;
+    size = apr_bucket_alloc_read_size_get(list, &chunk);
+    nvec = (apr_int32_t)(size / chunk);
+    if (nvec > SOCKET_READV_MAX) {
+        nvec = SOCKET_READV_MAX;
+    }
+    for (i = 0; i < nvec; i++) {
+        vec[i].iov_base = apr_bucket_alloc(chunk, list);
+        if (!vec[i].iov_base) {
+            while (i--) {
+                apr_bucket_free(vec[i].iov_base);
+            }
+            return APR_ENOMEM;
+        }
+        vec[i].iov_len = chunk;
+    }
+    size = chunk * nvec;
+
     if (block == APR_NONBLOCK_READ) {
         apr_socket_timeout_get(p, &timeout);
         apr_socket_timeout_set(p, 0);
     }
 
-    *str = NULL;
-    *len = APR_BUCKET_BUFF_SIZE;
-    buf = apr_bucket_alloc(*len, a->list); /* XXX: check for failure? */
-
-    rv = apr_socket_recv(p, buf, len);
+    *len = size;
+    if (nvec == 1) {
+        rv = apr_socket_recv(p, vec[0].iov_base, len);
+    }
+    else {
+        rv = apr_socket_recvv(p, vec, nvec, len);
+    }
 
     if (block == APR_NONBLOCK_READ) {
         apr_socket_timeout_set(p, timeout);
     }
 
     if (rv != APR_SUCCESS && rv != APR_EOF) {
-        apr_bucket_free(buf);
+        for (i = 0; i < nvec; i++) {
+            apr_bucket_free(vec[i].iov_base);
+        }
         return rv;
     }
+    apr_bucket_alloc_read_update(list, size, *len);
+
     /*
      * If there's more to read we have to keep the rest of the socket
      * for later. XXX: Note that more complicated bucket types that
@@ -60,15 +90,37 @@ static apr_status_t socket_bucket_read(apr_bucket *a, const char **str,
      */
     if (*len > 0) {
         apr_bucket_heap *h;
-        /* Change the current bucket to refer to what we read */
-        a = apr_bucket_heap_make(a, buf, *len, apr_bucket_free);
+
+        /* Change the current bucket to refer to what we read, and add a
+         * heap bucket for each of the other buffers filled */
+        remaining = *len;
+        *len = remaining < chunk ? remaining : chunk;
+        a = apr_bucket_heap_make(a, vec[0].iov_base, *len, apr_bucket_free);
         h = a->data;
-        h->alloc_len = APR_BUCKET_BUFF_SIZE; /* note the real buffer size */
-        *str = buf;
-        APR_BUCKET_INSERT_AFTER(a, apr_bucket_socket_create(p, a->list));
+        h->alloc_len = chunk; /* note the real buffer size */
+        *str = vec[0].iov_base;
+        remaining -= *len;
+        for (i = 1; i < nvec; i++) {
+            if (remaining) {
+                apr_size_t n = remaining < chunk ? remaining : chunk;
+                apr_bucket *b = apr_bucket_heap_create(vec[i].iov_base, n,
+                                                       apr_bucket_free, list);
+                h = b->data;
+                h->alloc_len = chunk;
+                APR_BUCKET_INSERT_AFTER(a, b);
+                a = b;
+                remaining -= n;
+            }
+            else {
+                apr_bucket_free(vec[i].iov_base);
+            }
+        }
+        APR_BUCKET_INSERT_AFTER(a, apr_bucket_socket_create(p, list));
     }
     else {
-        apr_bucket_free(buf);
+        for (i = 0; i < nvec; i++) {
+            apr_bucket_free(vec[i].iov_base);
+        }
         a = apr_bucket_immortal_make(a, "", 0);
         *str = a->data;
     }
@@ -244,6 +244,21 @@ if test "$apr_cv_mutex_recursive" = "yes"; then
 fi
 ])
 
+dnl Check for adaptive (spin then block) mutex support
+AC_DEFUN([APR_CHECK_PTHREAD_ADAPTIVE_MUTEX], [
+  AC_CACHE_CHECK([for adaptive mutex support], [apr_cv_mutex_adaptive],
+[AC_TRY_COMPILE([#include <sys/types.h>
+#include <pthread.h>], [
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+], [apr_cv_mutex_adaptive=yes], [apr_cv_mutex_adaptive=no])])
+
+if test "$apr_cv_mutex_adaptive" = "yes"; then
+   AC_DEFINE([HAVE_PTHREAD_MUTEX_ADAPTIVE_NP], 1,
+             [Define if adaptive pthread mutexes are available])
+fi
+])
+
 dnl Check for robust process-shared mutex support
 AC_DEFUN([APR_CHECK_PTHREAD_ROBUST_SHARED_MUTEX], [
 AC_CACHE_CHECK([for robust cross-process mutex support], 
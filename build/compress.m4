@@ -0,0 +1,76 @@
+dnl -------------------------------------------------------- -*- autoconf -*-
+dnl Licensed to the Apache Software Foundation (ASF) under one or more
+dnl contributor license agreements.  See the NOTICE file distributed with
+dnl this work for additional information regarding copyright ownership.
+dnl The ASF licenses this file to You under the Apache License, Version 2.0
+dnl (the "License"); you may not use this file except in compliance with
+dnl the License.  You may obtain a copy of the License at
+dnl
+dnl     http://www.apache.org/licenses/LICENSE-2.0
+dnl
+dnl Unless required by applicable law or agreed to in writing, software
+dnl distributed under the License is distributed on an "AS IS" BASIS,
+dnl WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+dnl See the License for the specific language governing permissions and
+dnl limitations under the License.
+
+dnl
+dnl Compression libraries of the brigade streams
+dnl
+
+dnl
+dnl APU_CHECK_COMPRESS: look for the compression libraries and headers
+dnl
+AC_DEFUN([APU_CHECK_COMPRESS], [
+  APU_CHECK_COMPRESS_LIB([zlib], [z], [zlib.h], [deflate])
+  APU_CHECK_COMPRESS_LIB([zstd], [zstd], [zstd.h], [ZSTD_compressStream2])
+
+  AC_SUBST(apu_have_zlib)
+  AC_SUBST(apu_have_zstd)
+])
+dnl
+
+dnl
+dnl APU_CHECK_COMPRESS_LIB(name, lib, header, function)
+dnl
+dnl  Enabled with --with-name[=DIR], which fails if the library is not
+dnl  found; sets apu_have_name.
+dnl
+AC_DEFUN([APU_CHECK_COMPRESS_LIB], [
+  apu_have_$1=0
+
+  AC_ARG_WITH([$1],
+  [APR_HELP_STRING([--with-$1=DIR], [enable $1 compression of the brigades])],
+  [
+    if test "$withval" != "no"; then
+      $1_have_headers=0
+      $1_have_libs=0
+
+      old_cppflags="$CPPFLAGS"
+      old_ldflags="$LDFLAGS"
+      if test "$withval" != "yes"; then
+        AC_MSG_NOTICE(checking for $1 in $withval)
+        APR_ADDTO(CPPFLAGS, [-I$withval/include])
+        APR_ADDTO(LDFLAGS, [-L$withval/lib])
+      fi
+
+      AC_CHECK_HEADERS($3, [$1_have_headers=1])
+      AC_CHECK_LIB($2, $4, [$1_have_libs=1])
+      if test "$$1_have_headers" = "0" || test "$$1_have_libs" = "0"; then
+        AC_ERROR([$1 was requested but could not be found])
+      fi
+      apu_have_$1=1
+
+      CPPFLAGS="$old_cppflags"
+      LDFLAGS="$old_ldflags"
+      if test "$withval" != "yes"; then
+        APR_ADDTO(INCLUDES, [-I$withval/include])
+        APR_ADDTO(LDFLAGS, [-L$withval/lib])
+        APR_ADDTO(APRUTIL_LDFLAGS, [-L$withval/lib])
+      fi
+      APR_ADDTO(APRUTIL_LIBS, [-l$2])
+      APR_ADDTO(APRUTIL_EXPORT_LIBS, [-l$2])
+    fi
+  ])
+])
+dnl
@@ -34,6 +34,16 @@ APR_DECLARE(apr_status_t) apr_file_buffer_set(apr_file_t *file,
             return rv;
         }
     }
+#if APR_HAS_MMAP
+    if (file->flags & APR_FOPEN_MMAP_READ) {
+        /* Read through the given buffer from now on */
+        rv = apr_file_mmap_stop_locked(file);
+        if (rv != APR_SUCCESS) {
+            file_unlock(file);
+            return rv;
+        }
+    }
+#endif
         
     file->buffer = buffer;
     file->bufsize = bufsize;
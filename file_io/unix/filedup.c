@@ -89,8 +89,20 @@ static apr_status_t file_dup(apr_file_t **new_file,
      * got one.
      */
     if ((*new_file)->buffered && !(*new_file)->buffer) {
-        (*new_file)->buffer = apr_palloc(p, old_file->bufsize);
-        (*new_file)->bufsize = old_file->bufsize;
+        apr_size_t bufsize = old_file->bufsize;
+
+#if APR_HAS_MMAP
+        /* A file read through mapped windows has no buffer, but the
+         * target of apr_file_dup2() keeps its own flags so it needs one.
+         */
+        if (which_dup == 2 && (old_file->flags & APR_FOPEN_MMAP_READ)) {
+            bufsize = APR_FILE_DEFAULT_BUFSIZE;
+        }
+#endif
+        if (bufsize) {
+            (*new_file)->buffer = apr_palloc(p, bufsize);
+            (*new_file)->bufsize = bufsize;
+        }
     }
 
     /* this is the way dup() works */
@@ -158,6 +170,20 @@ APR_DECLARE(apr_status_t) apr_file_setaside(apr_file_t **new_file,
 {
     *new_file = (apr_file_t *)apr_pmemdup(p, old_file, sizeof(apr_file_t));
     (*new_file)->pool = p;
+#if APR_HAS_MMAP
+    if (old_file->flags & APR_FOPEN_MMAP_READ) {
+        /* The window belongs to the old pool, map a new one when read */
+        (*new_file)->filePtr = old_file->filePtr - old_file->dataRead
+                             + old_file->bufpos;
+        (*new_file)->bufpos = (*new_file)->dataRead = 0;
+        (*new_file)->mmap_pool = NULL;
+        old_file->bufpos = old_file->dataRead = 0;
+        if (old_file->mmap_pool) {
+            apr_pool_destroy(old_file->mmap_pool);
+            old_file->mmap_pool = NULL;
+        }
+    }
+#endif
     if (old_file->buffered) {
         (*new_file)->buffer = apr_palloc(p, old_file->bufsize);
         (*new_file)->bufsize = old_file->bufsize;
@@ -77,6 +77,12 @@ apr_status_t apr_unix_file_cleanup(void *thefile)
     if (file->buffered) {
         flush_rv = apr_file_flush(file);
     }
+#if APR_HAS_MMAP
+    if (file->mmap_pool) {
+        apr_pool_destroy(file->mmap_pool);
+        file->mmap_pool = NULL;
+    }
+#endif
 
     rv = file_cleanup(file, 0);
 
@@ -161,7 +167,8 @@ APR_DECLARE(apr_status_t) apr_file_open(apr_file_t **new,
 #endif
 
 #if APR_HAS_THREADS
-    if ((flag & APR_FOPEN_BUFFERED) && (flag & APR_FOPEN_XTHREAD)) {
+    if ((flag & (APR_FOPEN_BUFFERED | APR_FOPEN_MMAP_READ))
+            && (flag & APR_FOPEN_XTHREAD)) {
         rv = apr_thread_mutex_create(&thlock,
                                      APR_THREAD_MUTEX_DEFAULT, pool);
         if (rv) {
@@ -224,6 +231,25 @@ APR_DECLARE(apr_status_t) apr_file_open(apr_file_t **new,
         (*new)->buffer = NULL;
     }
 
+    if (flag & APR_FOPEN_MMAP_READ) {
+#if APR_HAS_MMAP
+        struct_stat info;
+
+        /* Only regular files opened for reading can be mapped, the read
+         * buffer will be the mapped window */
+        if (!(flag & APR_FOPEN_WRITE) && fstat(fd, &info) == 0
+                && S_ISREG(info.st_mode)) {
+            (*new)->buffered = 1;
+            (*new)->buffer = NULL;
+            (*new)->bufsize = 0;
+        }
+        else
+#endif
+        {
+            (*new)->flags &= ~APR_FOPEN_MMAP_READ;
+        }
+    }
+
 #if APR_HAS_THREADS
     (*new)->thlock = thlock;
 #endif
@@ -321,7 +347,7 @@ APR_DECLARE(apr_status_t) apr_os_file_put(apr_file_t **file,
     (*file)->timeout = -1;
     (*file)->ungetchar = -1; /* no char avail */
     (*file)->filedes = *dafile;
-    (*file)->flags = flags | APR_FOPEN_NOCLEANUP;
+    (*file)->flags = (flags | APR_FOPEN_NOCLEANUP) & ~APR_FOPEN_MMAP_READ;
     (*file)->buffered = (flags & APR_FOPEN_BUFFERED) > 0;
 
 #ifndef WAITIO_USES_POLL
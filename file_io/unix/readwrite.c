@@ -20,6 +20,8 @@
 #include "apr_support.h"
 #include "apr_time.h"
 #include "apr_file_info.h"
+#include "apr_mmap.h"
+#include "apr_portable.h"
 
 /* The only case where we don't use wait_for_io_or_timeout is on
  * pre-BONE BeOS, so this check should be sufficient and simpler */
@@ -27,6 +29,91 @@
 #define USE_WAIT_FOR_IO
 #endif
 
+#if APR_HAS_MMAP
+/* Map the window of the file at the current position as the read buffer,
+ * in place of reading it into the buffer.
+ */
+static apr_status_t file_mmap_fill(apr_file_t *thefile)
+{
+    apr_off_t pos = thefile->filePtr - thefile->dataRead + thefile->bufpos;
+    apr_os_file_t fd = thefile->filedes;
+    apr_file_t *alias;
+    apr_finfo_t finfo;
+    apr_mmap_t *mm;
+    apr_off_t start;
+    apr_size_t len;
+    apr_status_t rv;
+
+    /* The size is checked each time, the file may grow */
+    rv = apr_file_info_get_locked(&finfo, APR_FINFO_SIZE, thefile);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    if (pos >= finfo.size) {
+        return APR_EOF;
+    }
+    start = pos & ~(apr_off_t)(APR_FILE_MMAP_WINDOW - 1);
+    len = (finfo.size - start < APR_FILE_MMAP_WINDOW)
+        ? (apr_size_t)(finfo.size - start) : APR_FILE_MMAP_WINDOW;
+
+    thefile->buffer = NULL;
+    thefile->bufpos = thefile->dataRead = 0;
+    thefile->filePtr = pos;
+    if (thefile->mmap_pool) {
+        apr_pool_clear(thefile->mmap_pool);
+    }
+    else {
+        rv = apr_pool_create(&thefile->mmap_pool, thefile->pool);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+    }
+
+    /* apr_mmap_create() does not take buffered files */
+    rv = apr_os_file_put(&alias, &fd, APR_FOPEN_READ, thefile->mmap_pool);
+    if (rv == APR_SUCCESS) {
+        rv = apr_mmap_create(&mm, alias, start, len, APR_MMAP_READ,
+                             thefile->mmap_pool);
+    }
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    apr_mmap_advise(mm, 0, len, APR_MMAP_ADVISE_SEQUENTIAL);
+
+    /* Keep the file offset at the end of the buffer, as read() would */
+    if (lseek(fd, start + len, SEEK_SET) == -1) {
+        return errno;
+    }
+    thefile->buffer = mm->mm;
+    thefile->bufpos = (apr_size_t)(pos - start);
+    thefile->dataRead = len;
+    thefile->filePtr = start + len;
+
+    return APR_SUCCESS;
+}
+
+/* Stop reading the file through mapped windows */
+apr_status_t apr_file_mmap_stop_locked(apr_file_t *thefile)
+{
+    apr_off_t pos = thefile->filePtr - thefile->dataRead + thefile->bufpos;
+
+    thefile->flags &= ~APR_FOPEN_MMAP_READ;
+    if (thefile->mmap_pool) {
+        apr_pool_destroy(thefile->mmap_pool);
+        thefile->mmap_pool = NULL;
+    }
+    thefile->buffer = NULL;
+    thefile->bufsize = 0;
+    thefile->bufpos = thefile->dataRead = 0;
+
+    if (lseek(thefile->filedes, pos, SEEK_SET) == -1) {
+        return errno;
+    }
+    thefile->filePtr = pos;
+    return APR_SUCCESS;
+}
+#endif
+
 static apr_status_t file_read_buffered(apr_file_t *thefile, void *buf,
                                        apr_size_t *nbytes)
 {
@@ -54,8 +141,30 @@ static apr_status_t file_read_buffered(apr_file_t *thefile, void *buf,
     }
     while (rv == 0 && size > 0) {
         if (thefile->bufpos >= thefile->dataRead) {
-            int bytesread = read(thefile->filedes, thefile->buffer, 
-                                 thefile->bufsize);
+            int bytesread;
+
+#if APR_HAS_MMAP
+            if (thefile->flags & APR_FOPEN_MMAP_READ) {
+                rv = file_mmap_fill(thefile);
+                if (rv == APR_SUCCESS) {
+                    continue;
+                }
+                if (rv == APR_EOF) {
+                    thefile->eof_hit = TRUE;
+                    break;
+                }
+                /* Not mappable after all, read() into a buffer */
+                rv = apr_file_mmap_stop_locked(thefile);
+                if (rv != APR_SUCCESS) {
+                    break;
+                }
+                thefile->buffer = apr_palloc(thefile->pool,
+                                             APR_FILE_DEFAULT_BUFSIZE);
+                thefile->bufsize = APR_FILE_DEFAULT_BUFSIZE;
+            }
+#endif
+            bytesread = read(thefile->filedes, thefile->buffer,
+                             thefile->bufsize);
             if (bytesread == 0) {
                 thefile->eof_hit = TRUE;
                 rv = APR_EOF;
@@ -232,6 +341,14 @@ APR_DECLARE(apr_status_t) apr_file_write(apr_file_t *thefile, const void *buf, a
         return rv;
     }
 
+#if APR_HAS_MMAP
+    if (thefile->flags & APR_FOPEN_MMAP_READ) {
+        /* Never opened for writing, and the buffer is read only */
+        *nbytes = 0;
+        return APR_EBADF;
+    }
+#endif
+
     if (thefile->buffered) {
         char *pos = (char *)buf;
         int blocksize;
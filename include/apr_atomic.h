@@ -46,6 +46,23 @@ extern "C" {
  */
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p);
 
+/**
+ * Memory orders of the apr_atomic_*_ex() functions and of apr_atomic_fence(),
+ * with the meaning of the C11 memory_order_* of the same name.
+ * @remark An order which does not apply to an operation is strengthened to
+ *         the nearest one which does (a release load is an acquire load, for
+ *         instance). Where the platform does not distinguish the orders,
+ *         all of them are sequentially consistent, like the functions
+ *         without the _ex suffix.
+ */
+typedef enum {
+    APR_ATOMIC_RELAXED,   /**< atomicity only, no ordering */
+    APR_ATOMIC_ACQUIRE,   /**< no later access is reordered before */
+    APR_ATOMIC_RELEASE,   /**< no earlier access is reordered after */
+    APR_ATOMIC_ACQ_REL,   /**< both APR_ATOMIC_ACQUIRE and APR_ATOMIC_RELEASE */
+    APR_ATOMIC_SEQ_CST    /**< a single total order (the default) */
+} apr_atomic_order_e;
+
 /*
  * Atomic operations on 32-bit values
  * Note: Each of these functions internally implements a memory barrier
@@ -113,6 +130,71 @@ APR_DECLARE(apr_uint32_t) apr_atomic_cas32(volatile apr_uint32_t *mem, apr_uint3
  */
 APR_DECLARE(apr_uint32_t) apr_atomic_xchg32(volatile apr_uint32_t *mem, apr_uint32_t val);
 
+/**
+ * atomically OR 'val' into an apr_uint32_t
+ * @param mem pointer to the value
+ * @param val the bits to set
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_or32(volatile apr_uint32_t *mem, apr_uint32_t val);
+
+/**
+ * atomically AND 'val' into an apr_uint32_t
+ * @param mem pointer to the value
+ * @param val the bits to keep
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_and32(volatile apr_uint32_t *mem, apr_uint32_t val);
+
+/**
+ * atomically XOR 'val' into an apr_uint32_t
+ * @param mem pointer to the value
+ * @param val the bits to flip
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_xor32(volatile apr_uint32_t *mem, apr_uint32_t val);
+
+/**
+ * atomically read an apr_uint32_t from memory, with the given memory order
+ * @param mem the pointer
+ * @param order the memory order, typically APR_ATOMIC_ACQUIRE
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                             apr_atomic_order_e order);
+
+/**
+ * atomically set an apr_uint32_t in memory, with the given memory order
+ * @param mem pointer to the object
+ * @param val value that the object will assume
+ * @param order the memory order, typically APR_ATOMIC_RELEASE
+ */
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                     apr_atomic_order_e order);
+
+/**
+ * atomically add 'val' to an apr_uint32_t, with the given memory order
+ * @param mem pointer to the object
+ * @param val amount to add
+ * @param order the memory order, typically APR_ATOMIC_RELAXED for counters
+ * @return old value pointed to by mem
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                            apr_atomic_order_e order);
+
+/**
+ * compare an apr_uint32_t's value with 'cmp', with the given memory order.
+ * If they are the same swap the value with 'with'
+ * @param mem pointer to the value
+ * @param with what to swap it with
+ * @param cmp the value to compare it to
+ * @param order the memory order of a successful swap; a failed one is
+ *        at most APR_ATOMIC_ACQUIRE
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                            apr_uint32_t cmp,
+                                            apr_atomic_order_e order);
+
 /*
  * Atomic operations on 64-bit values
  * Note: Each of these functions internally implements a memory barrier
@@ -180,6 +262,71 @@ APR_DECLARE(apr_uint64_t) apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint6
  */
 APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val);
 
+/**
+ * atomically OR 'val' into an apr_uint64_t
+ * @param mem pointer to the value
+ * @param val the bits to set
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_or64(volatile apr_uint64_t *mem, apr_uint64_t val);
+
+/**
+ * atomically AND 'val' into an apr_uint64_t
+ * @param mem pointer to the value
+ * @param val the bits to keep
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_and64(volatile apr_uint64_t *mem, apr_uint64_t val);
+
+/**
+ * atomically XOR 'val' into an apr_uint64_t
+ * @param mem pointer to the value
+ * @param val the bits to flip
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_xor64(volatile apr_uint64_t *mem, apr_uint64_t val);
+
+/**
+ * atomically read an apr_uint64_t from memory, with the given memory order
+ * @param mem the pointer
+ * @param order the memory order, typically APR_ATOMIC_ACQUIRE
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                             apr_atomic_order_e order);
+
+/**
+ * atomically set an apr_uint64_t in memory, with the given memory order
+ * @param mem pointer to the object
+ * @param val value that the object will assume
+ * @param order the memory order, typically APR_ATOMIC_RELEASE
+ */
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                     apr_atomic_order_e order);
+
+/**
+ * atomically add 'val' to an apr_uint64_t, with the given memory order
+ * @param mem pointer to the object
+ * @param val amount to add
+ * @param order the memory order, typically APR_ATOMIC_RELAXED for counters
+ * @return old value pointed to by mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                            apr_atomic_order_e order);
+
+/**
+ * compare an apr_uint64_t's value with 'cmp', with the given memory order.
+ * If they are the same swap the value with 'with'
+ * @param mem pointer to the value
+ * @param with what to swap it with
+ * @param cmp the value to compare it to
+ * @param order the memory order of a successful swap; a failed one is
+ *        at most APR_ATOMIC_ACQUIRE
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                            apr_uint64_t cmp,
+                                            apr_atomic_order_e order);
+
 /**
  * compare the pointer's value with cmp.
  * If they are the same swap the value with 'with'
@@ -198,6 +345,58 @@ APR_DECLARE(void*) apr_atomic_casptr(void *volatile *mem, void *with, const void
  */
 APR_DECLARE(void*) apr_atomic_xchgptr(void *volatile *mem, void *with);
 
+/**
+ * A 128-bit value for apr_atomic_cas128(), aligned on 16 bytes; typically
+ * a pointer and a generation count, or two pointers.
+ */
+#if defined(_MSC_VER)
+typedef __declspec(align(16)) struct apr_atomic_uint128_t {
+    apr_uint64_t lo;    /**< the low 64 bits */
+    apr_uint64_t hi;    /**< the high 64 bits */
+} apr_atomic_uint128_t;
+#else
+typedef struct apr_atomic_uint128_t {
+    apr_uint64_t lo;    /**< the low 64 bits */
+    apr_uint64_t hi;    /**< the high 64 bits */
+}
+#if defined(__GNUC__)
+__attribute__((aligned(16)))
+#endif
+apr_atomic_uint128_t;
+#endif
+
+/**
+ * compare a 128-bit value with '*cmp'.
+ * If they are the same swap the value with '*with', otherwise store the
+ * current value in '*cmp'
+ * @param mem pointer to the value, aligned on 16 bytes
+ * @param cmp the value to compare it to, and where the current value is
+ *        stored on failure
+ * @param with what to swap it with
+ * @return non-zero if the value was swapped, zero otherwise
+ * @remark The value can only be read atomically with this function, by
+ *         passing the same value for '*cmp' and '*with'.
+ * @remark This is lock-free only where apr_atomic_cas128_is_lock_free()
+ *         says so; elsewhere it is serialized by a mutex.
+ */
+APR_DECLARE(int) apr_atomic_cas128(volatile apr_atomic_uint128_t *mem,
+                                   apr_atomic_uint128_t *cmp,
+                                   const apr_atomic_uint128_t *with);
+
+/**
+ * Tell whether apr_atomic_cas128() is lock-free on this platform.
+ * @return non-zero if it is lock-free, zero otherwise
+ */
+APR_DECLARE(int) apr_atomic_cas128_is_lock_free(void);
+
+/**
+ * issue a memory fence of the given memory order
+ * @param order the memory order, APR_ATOMIC_ACQUIRE, APR_ATOMIC_RELEASE,
+ *        APR_ATOMIC_ACQ_REL or APR_ATOMIC_SEQ_CST (APR_ATOMIC_RELAXED is a
+ *        no-op)
+ */
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -53,6 +53,17 @@ extern "C" {
 /** default bucket buffer size - 8KB minus room for memory allocator headers */
 #define APR_BUCKET_BUFF_SIZE 8000
 
+/** default upper bound of the adaptive read size of SOCKET and PIPE
+ * buckets, @see apr_bucket_alloc_read_size_set()
+ */
+#define APR_BUCKET_READ_SIZE_MAX (64 * 1024)
+
+/** if passed to apr_bucket_alloc_read_size_set(), SOCKET buckets read
+ * into several buffers of the minimum size at once rather than into a
+ * single large one
+ */
+#define APR_BUCKET_READ_READV 0x1
+
 /** if passed to apr_brigade_split_boundary(), the string length will
  * be calculated
  */
@@ -517,6 +528,12 @@ typedef apr_status_t (*apr_brigade_flush)(apr_bucket_brigade *bb, void *ctx);
  * @return true or false
  */
 #define APR_BUCKET_IS_POOL(e)        ((e)->type == &apr_bucket_type_pool)
+/**
+ * Determine if a bucket is a SHAREDBUF bucket
+ * @param e The bucket to inspect
+ * @return true or false
+ */
+#define APR_BUCKET_IS_SHAREDBUF(e)   ((e)->type == &apr_bucket_type_sharedbuf)
 
 /*
  * General-purpose reference counting for the various bucket types.
@@ -541,6 +558,18 @@ struct apr_bucket_refcount {
     int          refcount;
 };
 
+/** @see apr_bucket_atomic_refcount */
+typedef struct apr_bucket_atomic_refcount apr_bucket_atomic_refcount;
+/**
+ * The same as apr_bucket_refcount, for the resources which are shared by
+ * buckets of different threads: the count is updated atomically by the
+ * apr_bucket_atomic_shared_*() functions.
+ */
+struct apr_bucket_atomic_refcount {
+    /** The number of references to this bucket */
+    volatile apr_uint32_t refcount;
+};
+
 /*  *****  Reference-counted bucket types  *****  */
 
 /** @see apr_bucket_heap */
@@ -598,6 +627,23 @@ struct apr_bucket_pool {
     apr_bucket_alloc_t *list;
 };
 
+/** @see apr_bucket_sharedbuf */
+typedef struct apr_bucket_sharedbuf apr_bucket_sharedbuf;
+/**
+ * A bucket referring to read-only data which buckets of any allocator,
+ * used by any thread, can share.
+ */
+struct apr_bucket_sharedbuf {
+    /** Number of buckets using this memory, in every allocator */
+    apr_bucket_atomic_refcount  refcount;
+    /** The start of the data */
+    const char *base;
+    /** The size of the data */
+    apr_size_t  alloc_len;
+    /** function to use to delete the data, or NULL if it was copied */
+    void (*free_func)(void *data);
+};
+
 #if APR_HAS_MMAP
 /** @see apr_bucket_mmap */
 typedef struct apr_bucket_mmap apr_bucket_mmap;
@@ -609,6 +655,8 @@ struct apr_bucket_mmap {
     apr_bucket_refcount  refcount;
     /** The mmap this sub_bucket refers to */
     apr_mmap_t *mmap;
+    /** The offset up to which reading ahead was requested */
+    apr_off_t readahead;
 };
 #endif
 
@@ -827,6 +875,71 @@ APR_DECLARE(apr_status_t) apr_brigade_split_boundary(apr_bucket_brigade *bbOut,
                                                      apr_off_t maxbytes)
                           __attribute__((nonnull(1,2)));
 
+/**
+ * The state of an incremental boundary search.
+ * @see apr_brigade_split_boundary_ex
+ */
+typedef struct apr_brigade_boundary_t apr_brigade_boundary_t;
+
+/**
+ * Create the state of an incremental boundary search, to be passed to
+ * apr_brigade_split_boundary_ex().
+ *
+ * The boundary is copied, and its search table is computed once.
+ * If the boundary is NULL or the empty string, APR_EINVAL is returned.
+ * @param bd The new boundary search.
+ * @param boundary The boundary string.
+ * @param boundary_len The length of the boundary string. If set to
+ *        APR_BUCKETS_STRING, the length will be calculated.
+ * @param p The pool to allocate from.
+ */
+APR_DECLARE(apr_status_t) apr_brigade_boundary_create(
+                                             apr_brigade_boundary_t **bd,
+                                             const char *boundary,
+                                             apr_size_t boundary_len,
+                                             apr_pool_t *p)
+                          __attribute__((nonnull(1,4)));
+
+/**
+ * Split a brigade based on the provided boundary, incrementally.
+ *
+ * This works as apr_brigade_split_boundary(), except that when bbIn is
+ * exhausted before the boundary is found, the bytes at its end which may
+ * start the boundary are kept in bbIn, and remembered by bd. The caller
+ * then appends more data to bbIn and calls again: the bytes already
+ * scanned are not scanned again, so that a body arriving in many small
+ * pieces is searched in linear time. Between the calls, the caller must
+ * only append to bbIn.
+ *
+ * The search table is computed once in bd rather than on every call,
+ * and the boundary is looked for with vector instructions where
+ * available.
+ *
+ * If a metadata bucket is found, the bytes held back are passed into
+ * bbOut along with the prior buckets, and APR_INCOMPLETE is returned.
+ * @param bbOut The bucket brigade that will have the buckets prior to the
+ *        boundary appended to.
+ * @param bbIn The input bucket brigade to search for the boundary.
+ * @param block The blocking mode to be used to split the brigade.
+ * @param bd The boundary search, from apr_brigade_boundary_create().
+ * @param maxbytes The maximum bytes to read.
+ */
+APR_DECLARE(apr_status_t) apr_brigade_split_boundary_ex(
+                                             apr_bucket_brigade *bbOut,
+                                             apr_bucket_brigade *bbIn,
+                                             apr_read_type_e block,
+                                             apr_brigade_boundary_t *bd,
+                                             apr_off_t maxbytes)
+                          __attribute__((nonnull(1,2,4)));
+
+/**
+ * Forget the partial match of a boundary search, so that it may be used
+ * with a new brigade.
+ * @param bd The boundary search.
+ */
+APR_DECLARE(void) apr_brigade_boundary_reset(apr_brigade_boundary_t *bd)
+                          __attribute__((nonnull(1)));
+
 /**
  * Create an iovec of the elements in a bucket_brigade... return number 
  * of elements used.  This is useful for writing to a file or to the
@@ -840,6 +953,157 @@ APR_DECLARE(apr_status_t) apr_brigade_to_iovec(apr_bucket_brigade *b,
                                                struct iovec *vec, int *nvec)
                           __attribute__((nonnull(1,2,3)));
 
+/** apr_brigade_send() copies the file buckets to the socket like the other
+ *  buckets, instead of using apr_socket_sendfile() */
+#define APR_BRIGADE_SEND_NOSENDFILE 0x1
+/** apr_brigade_send() reads the socket and pipe buckets into memory,
+ *  instead of using apr_socket_splice() */
+#define APR_BRIGADE_SEND_NOSPLICE   0x2
+/** apr_brigade_send() sends the large memory buckets with
+ *  apr_socket_sendv_zerocopy(), keeping them until the kernel is done */
+#define APR_BRIGADE_SEND_ZEROCOPY   0x4
+
+/**
+ * Send the contents of a bucket brigade to a socket, removing from the
+ * brigade what was sent.
+ * @param sock The socket to send to
+ * @param bb The brigade to send; on return, it contains what was not sent
+ * @param flags 0, or APR_BRIGADE_SEND_NOSENDFILE, APR_BRIGADE_SEND_NOSPLICE
+ *        and/or APR_BRIGADE_SEND_ZEROCOPY
+ * @param sent Where the number of bytes sent is stored
+ * @return APR_SUCCESS if the whole brigade was sent, otherwise the error
+ *         of the socket or of a bucket read, with the rest left in the
+ *         brigade (partially sent buckets are split). With a nonblocking
+ *         socket, APR_STATUS_IS_EAGAIN() means that the socket is full.
+ * @remark The memory buckets (and those read into memory) are sent by
+ *         batches of a few tens of iovecs with apr_socket_sendv(). Where
+ *         sendfile is available, the file buckets of files opened with
+ *         APR_FOPEN_SENDFILE_ENABLED are sent with apr_socket_sendfile(),
+ *         along with the memory buckets before and after them as headers
+ *         and trailers.
+ * @remark The buckets of unknown length (pipes, sockets) are read with
+ *         APR_BLOCK_READ once the data before them has been sent. Where
+ *         splicing is available, the SOCKET and PIPE buckets are moved to
+ *         the socket with apr_socket_splice() and apr_socket_splice_file()
+ *         instead, until their end; the data which they left pending in
+ *         the socket is sent first by the next call.
+ * @remark With APR_BRIGADE_SEND_ZEROCOPY, and the socket's APR_SO_ZEROCOPY
+ *         option set, the batches of at least 16KB of HEAP, SHAREDBUF,
+ *         IMMORTAL or MMAP buckets are sent without copying. The buckets
+ *         sent are removed from the brigade but only destroyed once the
+ *         kernel is done with them, by apr_socket_zerocopy_reap(), which
+ *         this function calls first; the bucket allocator must outlive
+ *         the sends pending. Where zero-copy sends are not supported,
+ *         the data is copied.
+ * @remark The metadata buckets are removed with the data before them.
+ */
+APR_DECLARE(apr_status_t) apr_brigade_send(apr_socket_t *sock,
+                                           apr_bucket_brigade *bb,
+                                           apr_int32_t flags,
+                                           apr_size_t *sent)
+                          __attribute__((nonnull(1,2,4)));
+
+/** The formats of the compression streams */
+typedef enum {
+    APR_ZSTREAM_DEFLATE,    /**< zlib format (RFC 1950), HTTP's "deflate" */
+    APR_ZSTREAM_GZIP,       /**< gzip format (RFC 1952) */
+    APR_ZSTREAM_ZSTD        /**< Zstandard format (RFC 8878) */
+} apr_zstream_format_e;
+
+/** The default compression level of the format */
+#define APR_ZSTREAM_LEVEL_DEFAULT (-1)
+
+/** Opaque compression or decompression stream of brigades */
+typedef struct apr_brigade_zstream_t apr_brigade_zstream_t;
+
+/** The statistics of a compression or decompression stream */
+typedef struct apr_brigade_zstream_stats_t {
+    /** The number of bytes consumed from the input brigades */
+    apr_off_t bytes_in;
+    /** The number of bytes produced in the output brigades */
+    apr_off_t bytes_out;
+    /** The time spent compressing or decompressing, so that the
+     *  throughput is bytes_in / time */
+    apr_interval_time_t time;
+} apr_brigade_zstream_stats_t;
+
+/**
+ * Create a compression stream of brigades.
+ * @param zs The new stream
+ * @param format The compression format
+ * @param level The compression level (1 to 9 with zlib, 1 to 19 with
+ *        zstd), or APR_ZSTREAM_LEVEL_DEFAULT
+ * @param list The bucket allocator of the compressed buckets
+ * @param p The pool of the stream, whose cleanup releases it
+ * @return APR_SUCCESS, or APR_ENOTIMPL if APR was built without the
+ *         library of the format (see APU_HAVE_ZLIB and APU_HAVE_ZSTD)
+ */
+APR_DECLARE(apr_status_t) apr_brigade_zstream_compress_create(
+                                             apr_brigade_zstream_t **zs,
+                                             apr_zstream_format_e format,
+                                             int level,
+                                             apr_bucket_alloc_t *list,
+                                             apr_pool_t *p)
+                          __attribute__((nonnull(1,4,5)));
+
+/**
+ * Create a decompression stream of brigades.
+ * @param zs The new stream
+ * @param format The compression format
+ * @param list The bucket allocator of the decompressed buckets
+ * @param p The pool of the stream, whose cleanup releases it
+ * @return APR_SUCCESS, or APR_ENOTIMPL if APR was built without the
+ *         library of the format
+ */
+APR_DECLARE(apr_status_t) apr_brigade_zstream_decompress_create(
+                                             apr_brigade_zstream_t **zs,
+                                             apr_zstream_format_e format,
+                                             apr_bucket_alloc_t *list,
+                                             apr_pool_t *p)
+                          __attribute__((nonnull(1,3,4)));
+
+/**
+ * Compress or decompress the buckets of a brigade into another.
+ * @param zs The stream
+ * @param bbOut The brigade to append the output to
+ * @param bbIn The brigade to consume; on return, it contains what was
+ *        not consumed
+ * @param block The blocking mode of the bucket reads
+ * @return APR_SUCCESS once bbIn is consumed, or the error of a bucket
+ *         read (e.g. APR_EAGAIN in nonblocking mode), or APR_BADCH if the
+ *         data to decompress is corrupt, or APR_EINCOMPLETE if an EOS
+ *         bucket ends it before the end of the compressed stream.
+ * @remark The data buckets are read and deleted as they are consumed,
+ *         without flattening the brigade. The output is made of heap
+ *         buckets of APR_BUCKET_BUFF_SIZE bytes allocated from the bucket
+ *         allocator of the stream, the last one being appended once full,
+ *         or on a FLUSH or EOS bucket, or at the end of the call when
+ *         decompressing.
+ * @remark A FLUSH bucket makes the compressor output all the data before
+ *         it, which can then be decompressed without the rest of the
+ *         stream; the FLUSH bucket follows in bbOut. An EOS bucket ends
+ *         the stream, and is moved to bbOut after its end; what follows
+ *         is left in bbIn. The other metadata buckets are moved to bbOut
+ *         as they are met.
+ * @remark When decompressing, the data after the end of the compressed
+ *         stream is ignored.
+ */
+APR_DECLARE(apr_status_t) apr_brigade_zstream_process(
+                                             apr_brigade_zstream_t *zs,
+                                             apr_bucket_brigade *bbOut,
+                                             apr_bucket_brigade *bbIn,
+                                             apr_read_type_e block)
+                          __attribute__((nonnull(1,2,3)));
+
+/**
+ * Get the statistics of a compression or decompression stream.
+ * @param zs The stream
+ * @param stats Where the statistics are stored
+ */
+APR_DECLARE(void) apr_brigade_zstream_stats_get(apr_brigade_zstream_t *zs,
+                                             apr_brigade_zstream_stats_t *stats)
+                          __attribute__((nonnull(1,2)));
+
 /**
  * This function writes a list of strings into a bucket brigade. 
  * @param b The bucket brigade to add to
@@ -1007,7 +1271,8 @@ APR_DECLARE(apr_bucket *) apr_brigade_insert_file(apr_bucket_brigade *bb,
  *          the bucket allocator will free large memory blocks back to the
  *          allocator when it's done with them, thereby preventing memory
  *          footprint growth that would occur if we allocated from the pool.
- * @warning The allocator must never be used by more than one thread at a time.
+ * @warning The allocator must never be used by more than one thread at a time,
+ *          see apr_bucket_alloc_create_threadsafe() otherwise.
  */
 APR_DECLARE_NONSTD(apr_bucket_alloc_t *) apr_bucket_alloc_create(apr_pool_t *p);
 
@@ -1023,6 +1288,33 @@ APR_DECLARE_NONSTD(apr_bucket_alloc_t *) apr_bucket_alloc_create_ex(
                                                  apr_allocator_t *allocator)
                                          __attribute__((nonnull(1)));
 
+/**
+ * Create a bucket allocator which can be used by several threads at once.
+ * @param p This pool's underlying apr_allocator_t is used to allocate
+ *          the bucket allocator, which is destroyed with the pool.
+ * @remark Each thread allocates from a cache of its own, created on its
+ *         first allocation with an apr_allocator_t of its own.  Memory
+ *         freed by another thread than the one which allocated it is
+ *         queued to the cache of the latter without locking, and reused by
+ *         it on its next allocation.  The brigades using this allocator
+ *         can thus be handed from a thread to another, e.g. between
+ *         workers and an I/O thread, without copying the buckets.
+ * @remark The caches of the threads which exit are adopted by the next
+ *         threads which need one; all the memory is released when the
+ *         allocator is destroyed.
+ * @remark The read size of the SOCKET and PIPE buckets adapts per thread,
+ *         @see apr_bucket_alloc_read_size_set().
+ * @remark Each such allocator uses a thread key (apr_threadkey_t) until it
+ *         is destroyed, and the system limits how many can exist at once
+ *         (PTHREAD_KEYS_MAX), so they should be few and long lived, e.g.
+ *         one per server rather than one per connection.
+ * @remark A brigade, as well as a bucket, must still not be used by two
+ *         threads at the same time.
+ */
+APR_DECLARE_NONSTD(apr_bucket_alloc_t *) apr_bucket_alloc_create_threadsafe(
+                                                 apr_pool_t *p)
+                                         __attribute__((nonnull(1)));
+
 /**
  * Destroy a bucket allocator.
  * @param list The allocator to be destroyed
@@ -1042,6 +1334,51 @@ APR_DECLARE_NONSTD(apr_size_t) apr_bucket_alloc_aligned_floor(apr_bucket_alloc_t
                                                               apr_size_t size)
                          __attribute__((nonnull(1)));
 
+/**
+ * Set the bounds of the size of the reads done by the SOCKET and PIPE
+ * buckets created with the given allocator.
+ * @param list The allocator.
+ * @param min The initial and smallest read size, zero for the default
+ *        @a APR_BUCKET_BUFF_SIZE.
+ * @param max The largest read size, zero for the default
+ *        @a APR_BUCKET_READ_SIZE_MAX.
+ * @param flags Zero or @a APR_BUCKET_READ_READV.
+ * @remark The read size doubles while the reads fill the buffers, and
+ * halves when they fill less than half of them, so that streams which
+ * deliver large amounts of data are read with fewer and larger reads.
+ * Setting @a min and @a max to the same value gives a fixed read size.
+ */
+APR_DECLARE_NONSTD(void) apr_bucket_alloc_read_size_set(apr_bucket_alloc_t *list,
+                                                        apr_size_t min,
+                                                        apr_size_t max,
+                                                        int flags)
+                         __attribute__((nonnull(1)));
+
+/**
+ * Get the size of the next read of a SOCKET or PIPE bucket.
+ * @param list The allocator.
+ * @param chunk If not NULL, receives the size of each of the buffers to
+ *        read into, which is smaller than the read size only with
+ *        @a APR_BUCKET_READ_READV.
+ * @return The read size, rounded up such that the buffers fill the memory
+ *         allocated for them (@see apr_bucket_alloc_aligned_floor).
+ */
+APR_DECLARE_NONSTD(apr_size_t) apr_bucket_alloc_read_size_get(apr_bucket_alloc_t *list,
+                                                              apr_size_t *chunk)
+                         __attribute__((nonnull(1)));
+
+/**
+ * Adapt the read size to the outcome of a read.
+ * @param list The allocator.
+ * @param asked The size which was read, as given by
+ *        apr_bucket_alloc_read_size_get().
+ * @param got The amount of data actually read.
+ */
+APR_DECLARE_NONSTD(void) apr_bucket_alloc_read_update(apr_bucket_alloc_t *list,
+                                                      apr_size_t asked,
+                                                      apr_size_t got)
+                         __attribute__((nonnull(1)));
+
 /**
  * Allocate memory for use by the buckets.
  * @param size The amount to allocate.
@@ -1283,6 +1620,12 @@ APR_DECLARE_DATA extern const apr_bucket_type_t apr_bucket_type_mmap;
  * the data is copied on to the heap.
  */
 APR_DECLARE_DATA extern const apr_bucket_type_t apr_bucket_type_pool;
+/**
+ * The SHAREDBUF bucket type.  This bucket represents read-only data on the
+ * heap, which is freed when the last bucket referring to it is destroyed,
+ * whichever its allocator and thread.
+ */
+APR_DECLARE_DATA extern const apr_bucket_type_t apr_bucket_type_sharedbuf;
 /**
  * The PIPE bucket type.  This bucket represents a pipe to another program.
  */
@@ -1391,6 +1734,55 @@ APR_DECLARE_NONSTD(apr_status_t) apr_bucket_shared_split(apr_bucket *b,
 APR_DECLARE_NONSTD(apr_status_t) apr_bucket_shared_copy(apr_bucket *a,
                                                         apr_bucket **b);
 
+/**
+ * Initialize a bucket containing reference-counted data that may be
+ * shared by the buckets of several threads, like apr_bucket_shared_make().
+ * @param b The bucket to initialize
+ * @param data A pointer to the private data structure
+ *             with the apr_bucket_atomic_refcount at the start
+ * @param start The start of the data in the bucket
+ *              relative to the private base pointer
+ * @param length The length of the data in the bucket
+ * @return The new bucket, or NULL if allocation failed
+ */
+APR_DECLARE(apr_bucket *) apr_bucket_atomic_shared_make(apr_bucket *b,
+                                                        void *data,
+                                                        apr_off_t start,
+                                                        apr_size_t length);
+
+/**
+ * Decrement atomically the refcount of the data in the bucket, like
+ * apr_bucket_shared_destroy().
+ * @param data The private data pointer from the bucket to be destroyed
+ * @return TRUE or FALSE; TRUE if the reference count is now
+ *         zero, indicating that the shared resource itself can
+ *         be destroyed by the caller.
+ */
+APR_DECLARE(int) apr_bucket_atomic_shared_destroy(void *data);
+
+/**
+ * Split a bucket into two at the given point, and increment atomically the
+ * refcount to the underlying data, like apr_bucket_shared_split().
+ * @param b The bucket to be split
+ * @param point The offset of the first byte in the new bucket
+ * @return APR_EINVAL if the point is not within the bucket;
+ *         APR_ENOMEM if allocation failed;
+ *         or APR_SUCCESS
+ */
+APR_DECLARE_NONSTD(apr_status_t) apr_bucket_atomic_shared_split(apr_bucket *b,
+                                                                apr_size_t point);
+
+/**
+ * Copy a refcounted bucket, incrementing atomically the reference count,
+ * like apr_bucket_shared_copy().
+ * @param a The bucket to copy
+ * @param b Returns a pointer to the new bucket
+ * @return APR_ENOMEM if allocation failed;
+           or APR_SUCCESS
+ */
+APR_DECLARE_NONSTD(apr_status_t) apr_bucket_atomic_shared_copy(apr_bucket *a,
+                                                               apr_bucket **b);
+
 
 /*  *****  Functions to Create Buckets of varying types  *****  */
 /*
@@ -1523,6 +1915,62 @@ APR_DECLARE(apr_bucket *) apr_bucket_heap_make(apr_bucket *b, const char *buf,
                                                void (*free_func)(void *data))
                           __attribute__((nonnull(1,2)));
 
+/**
+ * Create a bucket referring to read-only memory on the heap, which may be
+ * shared by the buckets of any allocator and thread.
+ * @param buf The buffer to insert into the bucket
+ * @param nbyte The size of the buffer to insert.
+ * @param free_func Function to use to free the data once the last bucket
+ *                  referring to it is destroyed, possibly by another
+ *                  thread; NULL indicates that the bucket should make a
+ *                  copy of the data
+ * @param list The freelist from which this bucket should be allocated
+ * @return The new bucket, or NULL if allocation failed
+ * @remark Splitting and copying SHAREDBUF buckets only increments the
+ *         reference count of the data, and so does
+ *         apr_bucket_sharedbuf_copy_to() to another allocator.  This is
+ *         meant to send the same data to many connections (cached
+ *         responses, broadcast messages), whichever thread handles them.
+ */
+APR_DECLARE(apr_bucket *) apr_bucket_sharedbuf_create(const char *buf,
+                                                      apr_size_t nbyte,
+                                                      void (*free_func)(void *data),
+                                                      apr_bucket_alloc_t *list)
+                          __attribute__((nonnull(1,4)));
+
+/**
+ * Make the bucket passed in a bucket refer to shared heap data
+ * @param b The bucket to make into a SHAREDBUF bucket
+ * @param buf The buffer to insert into the bucket
+ * @param nbyte The size of the buffer to insert.
+ * @param free_func Function to use to free the data; NULL indicates that the
+ *                  bucket should make a copy of the data
+ * @return The new bucket, or NULL if allocation failed
+ */
+APR_DECLARE(apr_bucket *) apr_bucket_sharedbuf_make(apr_bucket *b,
+                                                    const char *buf,
+                                                    apr_size_t nbyte,
+                                                    void (*free_func)(void *data))
+                          __attribute__((nonnull(1,2)));
+
+/**
+ * Copy a SHAREDBUF bucket to another bucket allocator, typically that of
+ * another thread.
+ * @param a The bucket to copy
+ * @param list The freelist from which the new bucket should be allocated
+ * @param b Returns a pointer to the new bucket, which refers to the same
+ *          data
+ * @return APR_EINVAL if @a a is not a SHAREDBUF bucket;
+ *         APR_ENOMEM if allocation failed;
+ *         or APR_SUCCESS
+ * @remark The bucket @a a must not be used concurrently by another thread,
+ *         but the other buckets referring to the data can.
+ */
+APR_DECLARE(apr_status_t) apr_bucket_sharedbuf_copy_to(apr_bucket *a,
+                                                       apr_bucket_alloc_t *list,
+                                                       apr_bucket **b)
+                          __attribute__((nonnull(1,2,3)));
+
 /**
  * Create a bucket referring to memory allocated from a pool.
  *
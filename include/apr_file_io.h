@@ -94,6 +94,10 @@ extern "C" {
 #define APR_FOPEN_NONBLOCK    0x40000 /**< Platform dependent flag to enable
                                        * non blocking file io */
 
+#define APR_FOPEN_MMAP_READ   0x80000 /**< Platform dependent flag to read
+                                       * the file through memory mapped
+                                       * windows, see WARNING below */
+
  
 
 /* backcompat */
@@ -138,6 +142,15 @@ extern "C" {
  * @def APR_FOPEN_NONBLOCK
  * @warning APR_FOPEN_NONBLOCK is not implemented on all platforms.
  * Callers should be prepared for it to fail with #APR_ENOTIMPL.
+ *
+ * @def APR_FOPEN_MMAP_READ
+ * @warning APR_FOPEN_MMAP_READ makes apr_file_read() and apr_file_gets()
+ * copy the data straight from a window of the file mapped in memory,
+ * sliding along the file, rather than through read() and the buffer.
+ * It is ignored for files opened for writing, for files other than
+ * regular ones (pipes, devices...), and on platforms without mmap;
+ * reading falls back to a plain buffer if the file cannot be mapped.
+ * Truncating the file while it is read this way may raise SIGBUS.
  */
 
 /** @} */
@@ -248,6 +261,9 @@ typedef struct apr_file_t         apr_file_t;
  * @li #APR_FOPEN_MANUAL_ROTATE  Enable Manual rotation
  * @li #APR_FOPEN_NONBLOCK       Platform dependent flag to enable
  *                               non blocking file io
+ * @li #APR_FOPEN_MMAP_READ      Platform dependent flag to read the file
+ *                               through memory mapped windows, see
+ *                               WARNING below
  * @param perm Access permissions for file.
  * @param pool The pool to use.
  * @remark If perm is #APR_FPROT_OS_DEFAULT and the file is being created,
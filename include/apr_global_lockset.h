@@ -0,0 +1,179 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APR_GLOBAL_LOCKSET_H
+#define APR_GLOBAL_LOCKSET_H
+
+/**
+ * @file apr_global_lockset.h
+ * @brief APR Striped Global Locking Routines
+ */
+
+#include "apr.h"
+#include "apr_global_mutex.h"
+#include "apr_hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @defgroup APR_GlobalLockset Striped Global Locking Routines
+ * @ingroup APR
+ * @{
+ */
+
+/** Opaque set of global locks. */
+typedef struct apr_global_lockset_t apr_global_lockset_t;
+
+/**
+ * Contention statistics of a stripe of a lock set, shared by all the
+ * processes using it.
+ */
+typedef struct apr_global_lockset_stats_t {
+    /** Number of acquisitions of the stripe */
+    apr_uint32_t acquired;
+    /** Number of acquisitions which found the stripe held */
+    apr_uint32_t contended;
+} apr_global_lockset_stats_t;
+
+/**
+ * Create a set of global locks, so that the users of a shared resource
+ * only serialize on the stripe which covers the part they access,
+ * typically selected by the hash of a key.
+ * @param lockset the memory address where the newly created lock set will
+ *        be stored.
+ * @param nlocks The number of stripes in the set.
+ * @param fname A file name to use if the lock mechanism requires one; each
+ *        stripe appends its number to it.
+ * @param mech The mechanism of the stripes, as for apr_global_mutex_create().
+ *        APR_LOCK_DEFAULT_GLOBAL avoids taking a thread mutex in addition to
+ *        the process lock where possible.
+ * @param pool the pool from which to allocate the lock set.
+ * @remark The contention statistics live in an anonymous shared memory
+ *         segment, so the lock set must be created before forking the
+ *         processes which use it; without anonymous shared memory each
+ *         process counts its own acquisitions.
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_create(
+                                              apr_global_lockset_t **lockset,
+                                              unsigned int nlocks,
+                                              const char *fname,
+                                              apr_lockmech_e mech,
+                                              apr_pool_t *pool);
+
+/**
+ * Re-open the stripes of a lock set in a new process.
+ * @param lockset The lock set to reopen.
+ * @param fname The file name given to apr_global_lockset_create().
+ * @param pool The pool to operate on.
+ * @remark This function must be called to maintain portability, even
+ *         if the underlying lock mechanism does not require it.
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_child_init(
+                                              apr_global_lockset_t **lockset,
+                                              const char *fname,
+                                              apr_pool_t *pool);
+
+/**
+ * Return the number of stripes of a lock set.
+ * @param lockset The lock set.
+ */
+APR_DECLARE(unsigned int) apr_global_lockset_count(
+                                              apr_global_lockset_t *lockset);
+
+/**
+ * Return the stripe covering the given key.
+ * @param lockset The lock set.
+ * @param key The key.
+ * @param klen The length of the key, or APR_HASH_KEY_STRING to use the
+ *        string length.
+ */
+APR_DECLARE(unsigned int) apr_global_lockset_stripe(
+                                              apr_global_lockset_t *lockset,
+                                              const void *key,
+                                              apr_ssize_t klen);
+
+/**
+ * Acquire a stripe of a lock set.
+ * @param lockset The lock set.
+ * @param stripe The stripe, as returned by apr_global_lockset_stripe().
+ * @remark A caller holding more than one stripe must acquire them in
+ *         increasing order, as apr_global_lockset_lock_all() does.
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_lock(
+                                              apr_global_lockset_t *lockset,
+                                              unsigned int stripe);
+
+/**
+ * Attempt to acquire a stripe of a lock set, returning immediately
+ * with APR_EBUSY if it is already held.
+ * @param lockset The lock set.
+ * @param stripe The stripe, as returned by apr_global_lockset_stripe().
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_trylock(
+                                              apr_global_lockset_t *lockset,
+                                              unsigned int stripe);
+
+/**
+ * Release a stripe of a lock set.
+ * @param lockset The lock set.
+ * @param stripe The stripe to release.
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_unlock(
+                                              apr_global_lockset_t *lockset,
+                                              unsigned int stripe);
+
+/**
+ * Acquire all the stripes of a lock set, for instance to maintain the
+ * whole shared resource.
+ * @param lockset The lock set.
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_lock_all(
+                                              apr_global_lockset_t *lockset);
+
+/**
+ * Release all the stripes of a lock set.
+ * @param lockset The lock set.
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_unlock_all(
+                                              apr_global_lockset_t *lockset);
+
+/**
+ * Get the contention statistics of a stripe.
+ * @param lockset The lock set.
+ * @param stripe The stripe.
+ * @param stats Where the statistics are stored.
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_stats_get(
+                                              apr_global_lockset_t *lockset,
+                                              unsigned int stripe,
+                                              apr_global_lockset_stats_t *stats);
+
+/**
+ * Destroy a lock set and all its stripes.
+ * @param lockset The lock set to destroy.
+ */
+APR_DECLARE(apr_status_t) apr_global_lockset_destroy(
+                                              apr_global_lockset_t *lockset);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* ndef APR_GLOBAL_LOCKSET_H */
@@ -66,12 +66,23 @@ typedef struct apr_global_mutex_t apr_global_mutex_t;
  *            APR_LOCK_SYSVSEM
  *            APR_LOCK_POSIXSEM
  *            APR_LOCK_PROC_PTHREAD
+ *            APR_LOCK_FUTEX
  *            APR_LOCK_DEFAULT     pick the default mechanism for the platform
  *            APR_LOCK_DEFAULT_TIMED pick the default timed mechanism
+ *            APR_LOCK_DEFAULT_GLOBAL pick the default mechanism which
+ *                            also excludes the threads of a process
  * </PRE>
  * @param pool the pool from which to allocate the mutex.
  * @warning Check APR_HAS_foo_SERIALIZE defines to see if the platform supports
  *          APR_LOCK_foo.  Only APR_LOCK_DEFAULT is portable.
+ * @remark Unless the mechanism is safe between the threads of a process
+ *         (APR_LOCK_PROC_PTHREAD or APR_LOCK_FUTEX, or any mechanism when
+ *         APR is built without threads), every lock operation also takes
+ *         an apr_thread_mutex_t.  APR_LOCK_DEFAULT_GLOBAL picks such a
+ *         mechanism when the platform has one, so that an uncontended
+ *         lock costs a single atomic operation, and falls back to
+ *         APR_LOCK_DEFAULT otherwise; apr_global_mutex_mech() tells which
+ *         mechanism was chosen.
  */
 APR_DECLARE(apr_status_t) apr_global_mutex_create(apr_global_mutex_t **mutex,
                                                   const char *fname,
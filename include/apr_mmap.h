@@ -46,6 +46,26 @@ extern "C" {
 #define APR_MMAP_READ    1
 /** MMap opened for writing */
 #define APR_MMAP_WRITE   2
+/** Fault the mapped pages in when creating the mmap */
+#define APR_MMAP_POPULATE 4
+
+/**
+ * @defgroup apr_mmap_advice Access pattern hints for apr_mmap_advise()
+ * @{
+ */
+/** No particular access pattern (the default) */
+#define APR_MMAP_ADVISE_NORMAL      0
+/** Pages will be accessed in order, read them ahead aggressively */
+#define APR_MMAP_ADVISE_SEQUENTIAL  1
+/** Pages will be accessed randomly, do not read them ahead */
+#define APR_MMAP_ADVISE_RANDOM      2
+/** Pages will be accessed soon, start reading them */
+#define APR_MMAP_ADVISE_WILLNEED    3
+/** Pages will not be accessed soon, they can be dropped */
+#define APR_MMAP_ADVISE_DONTNEED    4
+/** Back the pages with huge pages, if possible */
+#define APR_MMAP_ADVISE_HUGEPAGE    5
+/** @} */
 
 /** @see apr_mmap_t */
 typedef struct apr_mmap_t            apr_mmap_t;
@@ -124,6 +144,7 @@ struct apr_mmap_t {
  * <PRE>
  *          APR_MMAP_READ       MMap opened for reading
  *          APR_MMAP_WRITE      MMap opened for writing
+ *          APR_MMAP_POPULATE   Pages read in (prefaulted) upfront
  * </PRE>
  * @param cntxt The pool to use when creating the mmap.
  */
@@ -157,6 +178,20 @@ APR_DECLARE(apr_status_t) apr_mmap_delete(apr_mmap_t *mm);
 APR_DECLARE(apr_status_t) apr_mmap_offset(void **addr, apr_mmap_t *mm, 
                                           apr_off_t offset);
 
+/**
+ * Give the system a hint about how a range of an mmap'ed file will be
+ * accessed.
+ * @param mm The mmap'ed file.
+ * @param offset The offset of the range.
+ * @param len The length of the range, clipped to the end of the mmap.
+ * @param advice One of the APR_MMAP_ADVISE_* hints.
+ * @return APR_EINVAL if the offset is out of the mmap, APR_ENOTIMPL if
+ *         the hint is not supported on this platform.
+ */
+APR_DECLARE(apr_status_t) apr_mmap_advise(apr_mmap_t *mm, apr_off_t offset,
+                                          apr_size_t len,
+                                          apr_int32_t advice);
+
 #endif /* APR_HAS_MMAP */
 
 /** @} */
@@ -108,6 +108,17 @@ extern "C" {
 #define APR_SO_FREEBIND     131072 /**< Allow binding to addresses not owned
                                     * by any interface
                                     */
+#define APR_UDP_SEGMENT     262144 /**< Size of the datagrams that the
+                                    * sent data is cut into by the kernel
+                                    * or the NIC (UDP GSO), 0 to disable
+                                    */
+#define APR_UDP_GRO         524288 /**< Receive coalesced datagrams
+                                    * (UDP GRO)
+                                    * @see apr_socket_recvmmsg
+                                    */
+#define APR_SO_ZEROCOPY    1048576 /**< Allow zero-copy sends
+                                    * @see apr_socket_sendv_zerocopy
+                                    */
 
 /** @} */
 
@@ -612,6 +623,65 @@ APR_DECLARE(apr_status_t) apr_socket_recvfrom(apr_sockaddr_t *from,
                                               apr_socket_t *sock,
                                               apr_int32_t flags, char *buf, 
                                               apr_size_t *len);
+
+/** A datagram sent or received by a batch
+ * @see apr_socket_sendmmsg
+ * @see apr_socket_recvmmsg
+ */
+typedef struct apr_socket_msg_t {
+    /** Where to send the datagram, NULL on a connected socket; or updated
+     *  with where it was received from, unless NULL */
+    apr_sockaddr_t *addr;
+    /** The data to send, or the buffer to receive into */
+    char *buf;
+    /** The length of the data or of the buffer; updated with the number
+     *  of bytes sent or received */
+    apr_size_t len;
+    /** When receiving with APR_UDP_GRO, updated with the size of the
+     *  datagrams coalesced into buf, or zero if it holds one datagram */
+    apr_size_t segment_size;
+} apr_socket_msg_t;
+
+/**
+ * Send a batch of datagrams, with as few system calls as possible
+ * (sendmmsg() where available).
+ * @param sock The socket to send from
+ * @param msgs The datagrams to send
+ * @param nmsgs The number of datagrams
+ * @param flags The flags to use
+ * @param nsent The number of datagrams sent, the first ones of @a msgs
+ * @remark This waits according to the timeout of the socket until the
+ *         first datagram is sent; if a later one can't be sent, the
+ *         datagrams sent so far are reported with APR_SUCCESS.  Where
+ *         the batch can't be sent at once, the datagrams are sent one by
+ *         one with apr_socket_sendto() or apr_socket_send().
+ */
+APR_DECLARE(apr_status_t) apr_socket_sendmmsg(apr_socket_t *sock,
+                                              apr_socket_msg_t *msgs,
+                                              apr_size_t nmsgs,
+                                              apr_int32_t flags,
+                                              apr_size_t *nsent);
+
+/**
+ * Receive a batch of datagrams, with as few system calls as possible
+ * (recvmmsg() where available).
+ * @param sock The socket to receive from
+ * @param msgs The buffers to receive into
+ * @param nmsgs The number of buffers
+ * @param flags The flags to use
+ * @param nrecv The number of datagrams received, in the first ones of
+ *        @a msgs
+ * @remark This waits according to the timeout of the socket until the
+ *         first datagram arrives, then takes the ones already there
+ *         without waiting.  Where the batch can't be received at once,
+ *         the datagrams are received one by one with
+ *         apr_socket_recvfrom().
+ */
+APR_DECLARE(apr_status_t) apr_socket_recvmmsg(apr_socket_t *sock,
+                                              apr_socket_msg_t *msgs,
+                                              apr_size_t nmsgs,
+                                              apr_int32_t flags,
+                                              apr_size_t *nrecv);
  
 #if APR_HAS_SENDFILE || defined(DOXYGEN)
 
@@ -643,6 +713,103 @@ APR_DECLARE(apr_status_t) apr_socket_sendfile(apr_socket_t *sock,
 
 #endif /* APR_HAS_SENDFILE */
 
+/**
+ * Move data from a socket to another without copying it to user space.
+ * @param to The socket to send the data to
+ * @param from The socket to receive the data from, or NULL to only send
+ *        the data still pending from a previous call
+ * @param len On entry, the maximum number of bytes to receive, zero for
+ *        what the kernel moves at once (64KB); on exit, the number of
+ *        bytes sent to @a to
+ * @remark The data goes through a pipe which belongs to @a to.  It is
+ *         received as apr_socket_recv() would, according to the timeout
+ *         of @a from, and returns APR_EOF at the end of the stream.  It is
+ *         then sent according to the timeout of @a to; when this fails,
+ *         the error is returned and the data not sent is kept pending in
+ *         the pipe.  The pending data must be sent by the next call with
+ *         @a to before anything else is sent to it.
+ * @remark APR_ENOTIMPL is returned, with nothing received, where the
+ *         platform or the sockets do not support splicing (Linux only);
+ *         the caller then falls back to apr_socket_recv() and
+ *         apr_socket_send().
+ */
+APR_DECLARE(apr_status_t) apr_socket_splice(apr_socket_t *to,
+                                            apr_socket_t *from,
+                                            apr_size_t *len);
+
+/**
+ * Move data from a pipe or a file to a socket without copying it to user
+ * space.
+ * @param to The socket to send the data to
+ * @param from The unbuffered file or pipe to read the data from, at its
+ *        current position
+ * @param len On entry, the maximum number of bytes to read, zero for
+ *        what the kernel moves at once; on exit, the number of bytes sent
+ *        to @a to
+ * @remark This works like apr_socket_splice(), the data being read
+ *         according to the timeout of the pipe.  Regular files are better
+ *         sent with apr_socket_sendfile() where available.
+ */
+APR_DECLARE(apr_status_t) apr_socket_splice_file(apr_socket_t *to,
+                                                 apr_file_t *from,
+                                                 apr_size_t *len);
+
+/**
+ * Called when the kernel is done with the data of a zero-copy send.
+ * @param ctx The context given to apr_socket_sendv_zerocopy()
+ * @param copied Whether the kernel copied the data after all, in which
+ *        case zero-copy sends to this destination are not worth it
+ * @see apr_socket_zerocopy_reap
+ */
+typedef void (apr_socket_zerocopy_fn_t)(void *ctx, int copied);
+
+/**
+ * Send data from an iovec array without copying it to the kernel.
+ * @param sock The socket to send the data over, with the APR_SO_ZEROCOPY
+ *        option set
+ * @param vec The array of iovecs to send
+ * @param nvec The number of iovecs in the array
+ * @param len Receives the number of bytes actually written
+ * @param done Called with @a ctx once the kernel is done with the data
+ *        sent, which must not be modified nor freed until then
+ * @param ctx The context of @a done
+ * @remark This works like apr_socket_sendv(), with MSG_ZEROCOPY.  When
+ *         something is sent, @a done is registered with the socket, and
+ *         called by apr_socket_zerocopy_reap().  Nothing is registered
+ *         when an error is returned.
+ * @remark The kernel reports the completions on the error queue of the
+ *         socket, which apr_pollset_poll() and apr_poll() signal with
+ *         APR_POLLERR; apr_socket_zerocopy_reap() is then called.
+ * @remark APR_ENOTIMPL is returned, with nothing sent, where the platform
+ *         does not support it (Linux only) or APR_SO_ZEROCOPY is not set;
+ *         the caller then falls back to apr_socket_sendv().  Other errors
+ *         (such as ENOBUFS when too many sends are pending) may also be
+ *         handled by falling back.
+ */
+APR_DECLARE(apr_status_t) apr_socket_sendv_zerocopy(
+                                             apr_socket_t *sock,
+                                             const struct iovec *vec,
+                                             apr_int32_t nvec,
+                                             apr_size_t *len,
+                                             apr_socket_zerocopy_fn_t *done,
+                                             void *ctx);
+
+/**
+ * Call the callbacks of the zero-copy sends that the kernel is done with,
+ * without waiting.
+ * @param sock The socket
+ * @param pending If not NULL, receives the number of zero-copy sends
+ *        still pending
+ * @return APR_SUCCESS, or the error that the kernel reported for the
+ *         socket on its error queue
+ * @remark The callbacks of the sends still pending when the socket is
+ *         closed are never called, since the kernel may still use their
+ *         data; sends should be reaped until none is pending before
+ *         closing the socket.
+ */
+APR_DECLARE(apr_status_t) apr_socket_zerocopy_reap(apr_socket_t *sock,
+                                                   apr_size_t *pending);
+
 /**
  * Read data from a network.
  * @param sock The socket to read the data from.
@@ -665,6 +832,28 @@ APR_DECLARE(apr_status_t) apr_socket_sendfile(apr_socket_t *sock,
 APR_DECLARE(apr_status_t) apr_socket_recv(apr_socket_t *sock, 
                                    char *buf, apr_size_t *len);
 
+/**
+ * Read data from a network into multiple buffers.
+ * @param sock The socket to read the data from.
+ * @param vec The array of iovec structs to store the data in, in order
+ * @param nvec The number of iovec structs in the array
+ * @param len Receives the number of bytes actually received
+ * @remark
+ * <PRE>
+ * This functions acts like apr_socket_recv(), but scatters the data.
+ * Where the platform cannot read into several buffers at once, only the
+ * first one is filled.
+ *
+ * It is possible for both bytes to be received and an APR_EOF or
+ * other error to be returned.
+ *
+ * APR_EINTR is never returned.
+ * </PRE>
+ */
+APR_DECLARE(apr_status_t) apr_socket_recvv(apr_socket_t *sock,
+                                           struct iovec *vec,
+                                           apr_int32_t nvec, apr_size_t *len);
+
 /**
  * Wait for a socket to be ready for input or output
  * @param sock the socket to wait on
@@ -695,6 +884,12 @@ APR_DECLARE(apr_status_t) apr_socket_wait(apr_socket_t *sock,
  *            APR_SO_SNDBUF     --  Set the SendBufferSize
  *            APR_SO_RCVBUF     --  Set the ReceiveBufferSize
  *            APR_SO_FREEBIND   --  Allow binding to non-local IP address.
+ *            APR_UDP_SEGMENT   --  Set the size of the datagrams the sent
+ *                                  data is segmented into (Linux only).
+ *            APR_UDP_GRO       --  Receive datagrams coalesced by the
+ *                                  kernel (Linux only).
+ *            APR_SO_ZEROCOPY   --  Allow apr_socket_sendv_zerocopy()
+ *                                  (Linux only).
  * </PRE>
  * @param on Value for the option.
  */
@@ -754,6 +949,69 @@ APR_DECLARE(apr_status_t) apr_socket_timeout_get(apr_socket_t *sock,
 APR_DECLARE(apr_status_t) apr_socket_atmark(apr_socket_t *sock, 
                                             int *atmark);
 
+/** Kernel TLS: encrypt what is sent
+ * @see apr_socket_ktls_enable */
+#define APR_SOCKET_KTLS_TX 1
+/** Kernel TLS: decrypt what is received
+ * @see apr_socket_ktls_enable */
+#define APR_SOCKET_KTLS_RX 2
+
+/** Kernel TLS: TLS 1.2 records */
+#define APR_SOCKET_KTLS_TLS12 0x0303
+/** Kernel TLS: TLS 1.3 records */
+#define APR_SOCKET_KTLS_TLS13 0x0304
+
+/** The ciphers of kernel TLS */
+typedef enum {
+    APR_SOCKET_KTLS_AES_GCM_128,        /**< AES-128-GCM, 16 bytes key */
+    APR_SOCKET_KTLS_AES_GCM_256,        /**< AES-256-GCM, 32 bytes key */
+    APR_SOCKET_KTLS_CHACHA20_POLY1305   /**< ChaCha20-Poly1305, 32 bytes
+                                         *   key */
+} apr_socket_ktls_cipher_e;
+
+/** The state of a TLS connection in one direction, as negotiated by the
+ *  handshake */
+typedef struct apr_socket_ktls_params_t {
+    /** APR_SOCKET_KTLS_TLS12 or APR_SOCKET_KTLS_TLS13 */
+    int version;
+    /** The cipher */
+    apr_socket_ktls_cipher_e cipher;
+    /** The traffic key */
+    const unsigned char *key;
+    /** The length of the key */
+    apr_size_t key_len;
+    /** The 12 bytes of the nonce: the implicit (salt) and the explicit
+     *  parts with TLS 1.2 and AES-GCM, the static IV otherwise */
+    const unsigned char *iv;
+    /** The 8 bytes of the sequence number of the next record (big endian),
+     *  or NULL for zero */
+    const unsigned char *rec_seq;
+} apr_socket_ktls_params_t;
+
+/**
+ * Hand the encryption or the decryption of the records of a TLS
+ * connection over to the kernel.
+ * @param sock The connected TCP socket, where the TLS handshake was done
+ * @param direction APR_SOCKET_KTLS_TX or APR_SOCKET_KTLS_RX
+ * @param params The version, cipher, key and sequence number negotiated
+ *        for this direction
+ * @remark Once APR_SOCKET_KTLS_TX is set, the data given to
+ *         apr_socket_send(), apr_socket_sendv() and apr_socket_sendfile()
+ *         is sent as TLS application data records, so that files are
+ *         sent without being copied nor encrypted in user space.  Once
+ *         APR_SOCKET_KTLS_RX is set, apr_socket_recv() returns the data
+ *         of the records received, and fails on other record types.
+ * @remark The keys come from the TLS library which did the handshake;
+ *         nothing may be sent or received in user space in that
+ *         direction since.
+ * @remark APR_ENOTIMPL is returned where the platform (Linux only) or the
+ *         kernel (the tls module) does not support it, APR_EINVAL when
+ *         the key length does not match the cipher.
+ */
+APR_DECLARE(apr_status_t) apr_socket_ktls_enable(
+                                    apr_socket_t *sock, int direction,
+                                    const apr_socket_ktls_params_t *params);
+
 /**
  * Return an address associated with a socket; either the address to
  * which the socket is bound locally or the address of the peer
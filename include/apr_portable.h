@@ -140,6 +140,10 @@ struct apr_os_proc_mutex_t {
     /** Value used for POSIX semaphores serialization */
     sem_t *psem_interproc;
 #endif
+#if APR_HAS_FUTEX_SERIALIZE
+    /** Value used for futex serialization (the shared futex word) */
+    apr_uint32_t *futex_interproc;
+#endif
 };
 
 typedef int                   apr_os_file_t;        /**< native file */
@@ -50,9 +50,25 @@ typedef enum {
     APR_LOCK_PROC_PTHREAD,  /**< POSIX pthread process-based locking */
     APR_LOCK_POSIXSEM,      /**< POSIX semaphore process-based locking */
     APR_LOCK_DEFAULT,       /**< Use the default process lock */
-    APR_LOCK_DEFAULT_TIMED  /**< Use the default process timed lock */
+    APR_LOCK_DEFAULT_TIMED, /**< Use the default process timed lock */
+    APR_LOCK_FUTEX,         /**< Linux futex() based locking */
+    APR_LOCK_DEFAULT_GLOBAL /**< Use the default process lock which is
+                             *   also safe between the threads of a process */
 } apr_lockmech_e;
 
+/**
+ * Contention statistics of a process mutex, shared by all the processes
+ * using it.
+ */
+typedef struct apr_proc_mutex_stats_t {
+    /** Number of acquisitions of the mutex */
+    apr_uint32_t acquired;
+    /** Number of acquisitions which had to wait for another owner */
+    apr_uint32_t contended;
+    /** Number of acquisitions which recovered the mutex from a dead owner */
+    apr_uint32_t recovered;
+} apr_proc_mutex_stats_t;
+
 /** Opaque structure representing a process mutex. */
 typedef struct apr_proc_mutex_t apr_proc_mutex_t;
 
@@ -72,10 +88,16 @@ typedef struct apr_proc_mutex_t apr_proc_mutex_t;
  *            APR_LOCK_SYSVSEM
  *            APR_LOCK_POSIXSEM
  *            APR_LOCK_PROC_PTHREAD
+ *            APR_LOCK_FUTEX
  *            APR_LOCK_DEFAULT     pick the default mechanism for the platform
  * </PRE>
  * @param pool the pool from which to allocate the mutex.
  * @see apr_lockmech_e
+ * @remark APR_LOCK_FUTEX acquires and releases an uncontended mutex
+ *         without any system call.  It supports timed locks, and recovers
+ *         the mutex held by a thread or process that died, using the
+ *         priority inheritance futexes of Linux: the processes sharing
+ *         the mutex must be in the same PID namespace.
  * @warning Check APR_HAS_foo_SERIALIZE defines to see if the platform supports
  *          APR_LOCK_foo.  Only APR_LOCK_DEFAULT is portable.
  */
@@ -172,6 +194,16 @@ APR_DECLARE(const char *) apr_proc_mutex_name(apr_proc_mutex_t *mutex);
  */
 APR_DECLARE(const char *) apr_proc_mutex_defname(void);
 
+/**
+ * Get the contention statistics of the mutex.
+ * @param mutex the mutex to get the statistics from.
+ * @param stats where the statistics are stored.
+ * @return APR_ENOTIMPL if the mechanism of the mutex does not maintain
+ *         statistics (only APR_LOCK_FUTEX does).
+ */
+APR_DECLARE(apr_status_t) apr_proc_mutex_stats_get(apr_proc_mutex_t *mutex,
+                                                   apr_proc_mutex_stats_t *stats);
+
 /**
  * Set mutex permissions.
  */
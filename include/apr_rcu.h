@@ -0,0 +1,201 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APR_RCU_H
+#define APR_RCU_H
+
+/**
+ * @file apr_rcu.h
+ * @brief APR Sequence Locks and Read-Copy-Update
+ */
+
+#include "apr.h"
+#include "apr_pools.h"
+#include "apr_errno.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @defgroup APR_RCU Sequence Locks and Read-Copy-Update
+ * @ingroup APR
+ * Synchronization of data which is read very often and rarely modified,
+ * where the readers never take a lock nor write to shared memory.
+ * @{
+ */
+
+/** Opaque sequence lock */
+typedef struct apr_seqlock_t apr_seqlock_t;
+
+/**
+ * Create a sequence lock.
+ * @param seqlock The newly created sequence lock.
+ * @param pool The pool to allocate the lock from.
+ * @remark A sequence lock protects a small structure which is copied by
+ *         the readers: they read a sequence number, copy the structure,
+ *         and retry if the sequence number changed meanwhile. The writers
+ *         exclude each other, but never wait for the readers.
+ * <PRE>
+ *     do {
+ *         seq = apr_seqlock_read_begin(seqlock);
+ *         copy = *shared;
+ *     } while (apr_seqlock_read_retry(seqlock, seq));
+ * </PRE>
+ */
+APR_DECLARE(apr_status_t) apr_seqlock_create(apr_seqlock_t **seqlock,
+                                             apr_pool_t *pool);
+
+/**
+ * Start reading the data protected by a sequence lock, waiting for a
+ * writer in progress to finish.
+ * @param seqlock The sequence lock.
+ * @return The sequence number to pass to apr_seqlock_read_retry().
+ */
+APR_DECLARE(apr_uint32_t) apr_seqlock_read_begin(apr_seqlock_t *seqlock);
+
+/**
+ * Finish reading the data protected by a sequence lock.
+ * @param seqlock The sequence lock.
+ * @param seq The sequence number returned by apr_seqlock_read_begin().
+ * @return Non-zero if the data was modified while being read, in which
+ *         case the copy must be discarded and read again.
+ */
+APR_DECLARE(int) apr_seqlock_read_retry(apr_seqlock_t *seqlock,
+                                        apr_uint32_t seq);
+
+/**
+ * Start modifying the data protected by a sequence lock, waiting for
+ * another writer to finish.
+ * @param seqlock The sequence lock.
+ */
+APR_DECLARE(void) apr_seqlock_write_begin(apr_seqlock_t *seqlock);
+
+/**
+ * Finish modifying the data protected by a sequence lock.
+ * @param seqlock The sequence lock.
+ */
+APR_DECLARE(void) apr_seqlock_write_end(apr_seqlock_t *seqlock);
+
+/** Opaque read-copy-update domain */
+typedef struct apr_rcu_t apr_rcu_t;
+
+/** Opaque reader thread of a read-copy-update domain */
+typedef struct apr_rcu_reader_t apr_rcu_reader_t;
+
+/**
+ * Create a read-copy-update domain.
+ * @param rcu The newly created domain.
+ * @param pool The pool to allocate the domain from.
+ * @remark The writers publish a new version of the data with
+ *         apr_rcu_publish(), and retire the pool of the previous version;
+ *         the domain destroys this pool once every reader thread has
+ *         passed a quiescent point, so that none of them can still be
+ *         using the previous version. The readers only mark the read-side
+ *         critical sections, which costs them a store each, and no lock.
+ * @remark The retired pools which could not be destroyed yet are destroyed
+ *         with the pool of the domain (before its subpools).
+ */
+APR_DECLARE(apr_status_t) apr_rcu_create(apr_rcu_t **rcu, apr_pool_t *pool);
+
+/**
+ * Register the calling thread as a reader of a domain.
+ * @param reader The newly registered reader, to be used by the calling
+ *        thread only.
+ * @param rcu The domain.
+ * @param pool The pool whose cleanup unregisters the reader, typically
+ *        the pool of the thread.
+ * @remark A reader starts outside of any read-side critical section.
+ */
+APR_DECLARE(apr_status_t) apr_rcu_reader_register(apr_rcu_reader_t **reader,
+                                                  apr_rcu_t *rcu,
+                                                  apr_pool_t *pool);
+
+/**
+ * Enter a read-side critical section, in which the data obtained with
+ * apr_rcu_dereference() can be used.
+ * @param reader The reader of the calling thread.
+ * @remark Critical sections of the same reader do not nest.
+ */
+APR_DECLARE(void) apr_rcu_read_lock(apr_rcu_reader_t *reader);
+
+/**
+ * Leave a read-side critical section; the data obtained in it must not be
+ * used anymore.
+ * @param reader The reader of the calling thread.
+ */
+APR_DECLARE(void) apr_rcu_read_unlock(apr_rcu_reader_t *reader);
+
+/**
+ * Announce a quiescent point: the data obtained so far is not used
+ * anymore, but the reader stays in a read-side critical section.
+ * @param reader The reader of the calling thread.
+ * @remark This is the same as apr_rcu_read_unlock() followed by
+ *         apr_rcu_read_lock(), for threads which are always reading (a
+ *         worker would call it between two requests).
+ */
+APR_DECLARE(void) apr_rcu_quiescent(apr_rcu_reader_t *reader);
+
+/**
+ * Read a pointer published with apr_rcu_publish(), in a read-side
+ * critical section.
+ * @param ptr The location of the pointer.
+ * @return The pointer, whose target is seen fully initialized.
+ */
+APR_DECLARE(void *) apr_rcu_dereference(void *volatile *ptr);
+
+/**
+ * Publish a new version of the data, and retire the pool of the previous
+ * one.
+ * @param rcu The domain.
+ * @param ptr The location of the pointer read by the readers.
+ * @param val The new pointer, to data fully initialized.
+ * @param old_pool The pool of the data replaced, or NULL; see
+ *        apr_rcu_retire().
+ * @return The previous pointer.
+ * @remark The writers must be serialized by the caller.
+ */
+APR_DECLARE(void *) apr_rcu_publish(apr_rcu_t *rcu, void *volatile *ptr,
+                                    void *val, apr_pool_t *old_pool);
+
+/**
+ * Retire a pool, which is destroyed once every reader has passed a
+ * quiescent point.
+ * @param rcu The domain.
+ * @param pool The pool, which belongs to the domain from now on.
+ * @remark The retired pools are destroyed by apr_rcu_retire(),
+ *         apr_rcu_publish() and apr_rcu_synchronize() as soon as
+ *         possible, or with the pool of the domain; the pool must not be
+ *         destroyed by anything else, in particular it must not be a
+ *         subpool of a pool destroyed before the domain.
+ */
+APR_DECLARE(apr_status_t) apr_rcu_retire(apr_rcu_t *rcu, apr_pool_t *pool);
+
+/**
+ * Wait until every reader has passed a quiescent point, and destroy the
+ * pools retired before.
+ * @param rcu The domain.
+ * @remark This must not be called from a read-side critical section.
+ */
+APR_DECLARE(apr_status_t) apr_rcu_synchronize(apr_rcu_t *rcu);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* ! APR_RCU_H */
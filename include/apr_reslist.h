@@ -27,6 +27,7 @@
 #include "apr_pools.h"
 #include "apr_errno.h"
 #include "apr_time.h"
+#include "apr_thread_pool.h"
 
 /**
  * @defgroup APR_Util_RL Resource List Routines
@@ -59,6 +60,29 @@ typedef apr_status_t (*apr_reslist_constructor)(void **resource, void *params,
 typedef apr_status_t (*apr_reslist_destructor)(void *resource, void *params,
                                                apr_pool_t *pool);
 
+/** Number of slots in the constructor latency histogram */
+#define APR_RESLIST_LATENCY_SLOTS 32
+
+/**
+ * Statistics on the constructor calls of a resource list.
+ */
+typedef struct apr_reslist_stats_t {
+    /** Number of successful constructor calls */
+    apr_uint32_t constructed;
+    /** Number of failed constructor calls */
+    apr_uint32_t failed;
+    /** Number of constructor calls made by the maintainer */
+    apr_uint32_t maintained;
+    /** Total time spent in constructor calls */
+    apr_interval_time_t total;
+    /** Longest constructor call */
+    apr_interval_time_t max;
+    /** Latency histogram: latency[0] counts the calls which took less than
+     *  1 microsecond, latency[i] the ones which took from 2^(i-1) up to
+     *  2^i microseconds, and the last slot all the longer ones */
+    apr_uint32_t latency[APR_RESLIST_LATENCY_SLOTS];
+} apr_reslist_stats_t;
+
 /* Cleanup order modes */
 #define APR_RESLIST_CLEANUP_DEFAULT  0       /**< default pool cleanup */
 #define APR_RESLIST_CLEANUP_FIRST    1       /**< use pool pre cleanup */
@@ -153,6 +177,25 @@ APR_DECLARE(apr_status_t) apr_reslist_release(apr_reslist_t *reslist,
 APR_DECLARE(void) apr_reslist_timeout_set(apr_reslist_t *reslist,
                                           apr_interval_time_t timeout);
 
+/**
+ * Enable or disable the per-thread affinity cache of a resource list.
+ * When enabled, the last resource released by a thread is kept aside for
+ * that thread, and its next acquire gets it back without locking the
+ * list, unless it has exceeded the ttl.
+ * @param reslist The resource list.
+ * @param on Nonzero to enable the cache, zero to disable it.
+ * @remark Cached resources still count against smax and hmax; a thread
+ *         that would otherwise block on hmax takes the resource cached by
+ *         another thread, and apr_reslist_maintain() expires the cached
+ *         resources like the idle ones.  The resource cached by a thread
+ *         goes back to the list when the thread exits.
+ * @remark This function must not be called concurrently with other
+ *         operations on the list.
+ * @return APR_ENOTIMPL if APR has been compiled without thread support.
+ */
+APR_DECLARE(apr_status_t) apr_reslist_affinity_set(apr_reslist_t *reslist,
+                                                   int on);
+
 /**
  * Return the number of outstanding resources.
  * @param reslist The resource list.
@@ -176,6 +219,40 @@ APR_DECLARE(apr_status_t) apr_reslist_invalidate(apr_reslist_t *reslist,
  */
 APR_DECLARE(apr_status_t) apr_reslist_maintain(apr_reslist_t *reslist);
 
+#if APR_HAS_THREADS
+/**
+ * Have the maintenance of the resource list run in the background by a
+ * thread pool, rather than by the threads releasing resources.
+ * @param reslist The resource list.
+ * @param tp The thread pool running the maintenance, or NULL to stop the
+ *           background maintenance.
+ * @param interval If non-zero, the maintenance also runs periodically
+ *                 with this interval (in microseconds), to create the
+ *                 minimum number of available resources and expire the
+ *                 ones which exceeded the ttl.
+ * @remark The maintenance starts immediately, so that the resources
+ *         are warmed up up to the minimum.  Afterwards, whenever the
+ *         number of available resources falls below the minimum, the
+ *         missing ones are created asynchronously.  Only apr_reslist_acquire()
+ *         calls which find no available resource still call the
+ *         constructor synchronously.
+ * @remark The thread pool must outlive the resource list, or the
+ *         background maintenance must be stopped before the thread pool
+ *         is destroyed.
+ */
+APR_DECLARE(apr_status_t) apr_reslist_maintainer_set(apr_reslist_t *reslist,
+                                                     apr_thread_pool_t *tp,
+                                                     apr_interval_time_t interval);
+#endif
+
+/**
+ * Get the statistics on the constructor calls of a resource list.
+ * @param reslist The resource list.
+ * @param stats Where the statistics are stored.
+ */
+APR_DECLARE(void) apr_reslist_stats_get(apr_reslist_t *reslist,
+                                        apr_reslist_stats_t *stats);
+
 /**
  * Set reslist cleanup order.
  * @param reslist The resource list.
@@ -86,6 +86,28 @@ APR_DECLARE(apr_status_t) apr_shm_create(apr_shm_t **m,
                                * segment in the "Global" namespace on
                                * Windows.  (Ignored on other platforms.)
                                */
+#define APR_SHM_HUGEPAGES   4 /* Back the segment with huge pages: hugetlb
+                               * pages for anonymous segments when some are
+                               * reserved, transparent huge pages otherwise.
+                               * (Ignored where unsupported; see
+                               * apr_shm_pagesize_get().)
+                               */
+#define APR_SHM_PREFAULT    8 /* Fault all the pages of the segment in
+                               * before returning, so that their first
+                               * access does not.
+                               */
+#define APR_SHM_LOCK       16 /* Lock the segment in memory with mlock(),
+                               * failing if it can't be.  (Ignored on
+                               * non-Unix platforms.)
+                               */
+#define APR_SHM_NUMA_INTERLEAVE 32 /* Interleave the pages of the segment
+                                    * over the NUMA nodes allowed.  (Ignored
+                                    * where unsupported.)
+                                    */
+#define APR_SHM_NUMA_LOCAL 64 /* Allocate the pages of the segment on the
+                               * NUMA node of the thread which first
+                               * touches them.  (Ignored where unsupported.)
+                               */
 
 /**
  * Create and make accessible a shared memory segment with platform-
@@ -179,6 +201,8 @@ APR_DECLARE(apr_status_t) apr_shm_attach(apr_shm_t **m,
  * @param pool the pool from which to allocate the shared memory
  *        structure for this process.
  * @param flags mask of APR_SHM_* (defined above)
+ * @remark The page size and NUMA policy of a segment are chosen by its
+ *         creator, only APR_SHM_PREFAULT and APR_SHM_LOCK apply here.
  */
 APR_DECLARE(apr_status_t) apr_shm_attach_ex(apr_shm_t **m,
                                             const char *filename,
@@ -210,6 +234,15 @@ APR_DECLARE(void *) apr_shm_baseaddr_get(const apr_shm_t *m);
  */
 APR_DECLARE(apr_size_t) apr_shm_size_get(const apr_shm_t *m);
 
+/**
+ * Retrieve the size of the pages backing a shared memory segment.
+ * @param m The shared memory segment from which to retrieve
+ *        the page size.
+ * @remark This is the huge page size when APR_SHM_HUGEPAGES obtained
+ *         hugetlb pages; transparent huge pages are not reported.
+ */
+APR_DECLARE(apr_size_t) apr_shm_pagesize_get(const apr_shm_t *m);
+
 /**
  * Set shared memory permissions.
  */
@@ -0,0 +1,177 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APR_SHM_HASH_H
+#define APR_SHM_HASH_H
+
+/**
+ * @file apr_shm_hash.h
+ * @brief APR Shared Memory Hash Table
+ */
+
+#include "apr.h"
+#include "apr_pools.h"
+#include "apr_errno.h"
+#include "apr_time.h"
+#include "apr_shm.h"
+#include "apr_hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @defgroup APR_SHM_Hash Shared Memory Hash Table
+ * @ingroup APR
+ * @{
+ */
+
+/** Opaque shared memory hash table */
+typedef struct apr_shm_hash_t apr_shm_hash_t;
+
+/* Eviction policies, used when a bucket is full */
+#define APR_SHM_HASH_EVICT_NONE  0 /**< fail with APR_ENOSPC */
+#define APR_SHM_HASH_EVICT_LRU   1 /**< evict the least recently used entry */
+#define APR_SHM_HASH_EVICT_CLOCK 2 /**< evict an entry not used since the
+                                    *   clock hand last went by */
+
+/** Number of entries sharing a bucket (and its seqlock) */
+#define APR_SHM_HASH_BUCKET_SIZE 8
+
+/**
+ * Compute the size of the shared memory needed by a hash table.
+ * @param capacity The number of entries, rounded up to a multiple of
+ *        APR_SHM_HASH_BUCKET_SIZE.
+ * @param key_max The maximum length of a key.
+ * @param val_max The maximum length of a value.
+ */
+APR_DECLARE(apr_size_t) apr_shm_hash_size(apr_uint32_t capacity,
+                                          apr_size_t key_max,
+                                          apr_size_t val_max);
+
+/**
+ * Initialize a hash table in a shared memory segment.
+ * @param hash The newly created hash table handle.
+ * @param shm The shared memory segment, which the hash table takes as a
+ *        whole; its capacity follows from the size of the segment.
+ * @param key_max The maximum length of a key.
+ * @param val_max The maximum length of a value.
+ * @param flags One of the APR_SHM_HASH_EVICT_* policies.
+ * @param pool The pool to allocate the handle from.
+ * @remark The entries are grouped by buckets of APR_SHM_HASH_BUCKET_SIZE,
+ *         each key going to the bucket selected by its hash.  Lookups are
+ *         lock-free: they copy the entry and retry if the seqlock of the
+ *         bucket tells a writer changed it meanwhile.  Writers spin on the
+ *         seqlock of the bucket only; if a process dies while updating the
+ *         table, the next one waiting on that bucket empties it and takes
+ *         it over.
+ * @remark The table stores no pointer, so it can be attached at a
+ *         different address by other processes.
+ */
+APR_DECLARE(apr_status_t) apr_shm_hash_init(apr_shm_hash_t **hash,
+                                            apr_shm_t *shm,
+                                            apr_size_t key_max,
+                                            apr_size_t val_max,
+                                            int flags,
+                                            apr_pool_t *pool);
+
+/**
+ * Attach to a hash table initialized by another process, typically in a
+ * segment opened with apr_shm_attach().
+ * @param hash The newly created hash table handle.
+ * @param shm The shared memory segment.
+ * @param pool The pool to allocate the handle from.
+ * @return APR_EINVAL if the segment does not contain a hash table.
+ */
+APR_DECLARE(apr_status_t) apr_shm_hash_attach(apr_shm_hash_t **hash,
+                                              apr_shm_t *shm,
+                                              apr_pool_t *pool);
+
+/**
+ * Look up an entry.
+ * @param hash The hash table.
+ * @param key The key.
+ * @param klen The length of the key, or APR_HASH_KEY_STRING.
+ * @param val The buffer where the value is copied.
+ * @param vlen On input the size of the buffer, on output the length of
+ *        the value.
+ * @return APR_NOTFOUND if there is no such entry or it has expired,
+ *         APR_ENOSPC if the buffer is too small for the value (whose
+ *         length is still returned).
+ */
+APR_DECLARE(apr_status_t) apr_shm_hash_get(apr_shm_hash_t *hash,
+                                           const void *key, apr_ssize_t klen,
+                                           void *val, apr_size_t *vlen);
+
+/**
+ * Add or replace an entry.
+ * @param hash The hash table.
+ * @param key The key.
+ * @param klen The length of the key, or APR_HASH_KEY_STRING.
+ * @param val The value.
+ * @param vlen The length of the value.
+ * @param ttl If non-zero, the time in microseconds after which the entry
+ *        expires.
+ * @return APR_EINVAL if the key or value is too long (or the key empty),
+ *         APR_ENOSPC if the bucket of the key is full and the table has
+ *         no eviction policy.
+ * @remark Expired entries are reused before evicting any other one.
+ */
+APR_DECLARE(apr_status_t) apr_shm_hash_set(apr_shm_hash_t *hash,
+                                           const void *key, apr_ssize_t klen,
+                                           const void *val, apr_size_t vlen,
+                                           apr_interval_time_t ttl);
+
+/**
+ * Delete an entry.
+ * @param hash The hash table.
+ * @param key The key.
+ * @param klen The length of the key, or APR_HASH_KEY_STRING.
+ * @return APR_NOTFOUND if there is no such entry.
+ */
+APR_DECLARE(apr_status_t) apr_shm_hash_delete(apr_shm_hash_t *hash,
+                                              const void *key,
+                                              apr_ssize_t klen);
+
+/**
+ * Delete all the expired entries.
+ * @param hash The hash table.
+ * @param expired If not NULL, where the number of deleted entries is
+ *        stored.
+ */
+APR_DECLARE(apr_status_t) apr_shm_hash_expire(apr_shm_hash_t *hash,
+                                              apr_uint32_t *expired);
+
+/**
+ * Return the number of entries in a hash table, including the expired
+ * ones not deleted yet.
+ * @param hash The hash table.
+ */
+APR_DECLARE(apr_uint32_t) apr_shm_hash_count(apr_shm_hash_t *hash);
+
+/**
+ * Return the capacity of a hash table.
+ * @param hash The hash table.
+ */
+APR_DECLARE(apr_uint32_t) apr_shm_hash_capacity(apr_shm_hash_t *hash);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* ! APR_SHM_HASH_H */
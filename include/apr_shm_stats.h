@@ -0,0 +1,230 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APR_SHM_STATS_H
+#define APR_SHM_STATS_H
+
+/**
+ * @file apr_shm_stats.h
+ * @brief APR Shared Memory Statistics
+ */
+
+#include "apr.h"
+#include "apr_pools.h"
+#include "apr_errno.h"
+#include "apr_shm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @defgroup APR_SHM_Stats Shared Memory Statistics
+ * @ingroup APR
+ * @{
+ */
+
+/** Opaque statistics region */
+typedef struct apr_shm_stats_t apr_shm_stats_t;
+
+/** Opaque per-process slot of a statistics region */
+typedef struct apr_shm_stats_slot_t apr_shm_stats_slot_t;
+
+/** Maximum length of the name of a counter or histogram, including the
+ *  terminating NUL */
+#define APR_SHM_STATS_NAME_MAX 48
+
+/** The slot is updated by several threads, with atomic additions */
+#define APR_SHM_STATS_SLOT_ATOMIC 0x1
+
+/**
+ * Compute the size of the shared memory needed by a statistics region.
+ * @param nslots The number of slots, i.e. of processes (or threads) which
+ *        may update the statistics at the same time.
+ * @param max_metrics The maximum number of counters and histograms.
+ * @param max_cells The maximum number of values per slot: one for each
+ *        counter, nbounds + 2 for each histogram.
+ */
+APR_DECLARE(apr_size_t) apr_shm_stats_size(unsigned int nslots,
+                                           unsigned int max_metrics,
+                                           unsigned int max_cells);
+
+/**
+ * Initialize a statistics region in a shared memory segment.
+ * @param stats The newly created statistics handle.
+ * @param shm The shared memory segment, of at least apr_shm_stats_size().
+ * @param nslots The number of slots.
+ * @param max_metrics The maximum number of counters and histograms.
+ * @param max_cells The maximum number of values per slot.
+ * @param pool The pool to allocate the handle from.
+ * @remark Each slot has its own copy of every value, in its own cache
+ *         lines, so that updating them never contends with other slots;
+ *         the readers add up the copies of all the slots.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_create(apr_shm_stats_t **stats,
+                                               apr_shm_t *shm,
+                                               unsigned int nslots,
+                                               unsigned int max_metrics,
+                                               unsigned int max_cells,
+                                               apr_pool_t *pool);
+
+/**
+ * Attach to a statistics region initialized by another process.
+ * @param stats The newly created statistics handle.
+ * @param shm The shared memory segment.
+ * @param pool The pool to allocate the handle from.
+ * @return APR_EINVAL if the segment does not contain a statistics region.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_attach(apr_shm_stats_t **stats,
+                                               apr_shm_t *shm,
+                                               apr_pool_t *pool);
+
+/**
+ * Define a counter, or find it if it is already defined.
+ * @param stats The statistics region.
+ * @param name The name of the counter.
+ * @param id Where the identifier of the counter is stored.
+ * @return APR_EINVAL if the name is too long or already used by a
+ *         histogram, APR_ENOSPC if the region is full.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_counter_define(apr_shm_stats_t *stats,
+                                                       const char *name,
+                                                       unsigned int *id);
+
+/**
+ * Define a histogram, or find it if it is already defined.
+ * @param stats The statistics region.
+ * @param name The name of the histogram.
+ * @param bounds The inclusive upper bounds of the buckets, in increasing
+ *        order; the values above the last bound are counted in an
+ *        additional bucket.
+ * @param nbounds The number of bounds.
+ * @param id Where the identifier of the histogram is stored.
+ * @return APR_EINVAL if the name is too long or already used by a metric
+ *         of another kind, APR_ENOSPC if the region is full.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_histogram_define(
+                                                       apr_shm_stats_t *stats,
+                                                       const char *name,
+                                                       const apr_int64_t *bounds,
+                                                       unsigned int nbounds,
+                                                       unsigned int *id);
+
+/**
+ * Find a counter or histogram by name.
+ * @param stats The statistics region.
+ * @param name The name of the metric.
+ * @param id Where the identifier of the metric is stored.
+ * @return APR_NOTFOUND if there is no such metric.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_lookup(apr_shm_stats_t *stats,
+                                               const char *name,
+                                               unsigned int *id);
+
+/**
+ * Acquire a free slot of a statistics region, for the calling process.
+ * @param slot The newly acquired slot.
+ * @param stats The statistics region.
+ * @param flags APR_SHM_STATS_SLOT_ATOMIC if several threads update the
+ *        slot, zero if only one thread does.
+ * @param pool The pool whose cleanup releases the slot.
+ * @return APR_ENOSPC if all the slots are in use.
+ * @remark The values of a slot are kept when it is released, so that the
+ *         sums read include the updates of the processes which exited;
+ *         the next process to acquire the slot adds to them.
+ * @remark When no slot is free, the slot of a process which exited without
+ *         releasing it is taken over, with its values.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_slot_acquire(
+                                                apr_shm_stats_slot_t **slot,
+                                                apr_shm_stats_t *stats,
+                                                int flags,
+                                                apr_pool_t *pool);
+
+/**
+ * Release a slot, which may then be acquired by another process.
+ * @param slot The slot.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_slot_release(
+                                                apr_shm_stats_slot_t *slot);
+
+/**
+ * Add to a counter.
+ * @param slot The slot of the caller.
+ * @param id The identifier of the counter.
+ * @param delta The value to add.
+ */
+APR_DECLARE(void) apr_shm_stats_add(apr_shm_stats_slot_t *slot,
+                                    unsigned int id, apr_uint64_t delta);
+
+/**
+ * Record a value in a histogram.
+ * @param slot The slot of the caller.
+ * @param id The identifier of the histogram.
+ * @param value The value.
+ */
+APR_DECLARE(void) apr_shm_stats_record(apr_shm_stats_slot_t *slot,
+                                       unsigned int id, apr_int64_t value);
+
+/**
+ * Read a counter, summed over all the slots.
+ * @param stats The statistics region.
+ * @param id The identifier of the counter.
+ * @param value Where the value is stored.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_counter_get(apr_shm_stats_t *stats,
+                                                    unsigned int id,
+                                                    apr_uint64_t *value);
+
+/**
+ * Read a histogram, summed over all the slots.
+ * @param stats The statistics region.
+ * @param id The identifier of the histogram.
+ * @param counts Where the counts of the nbounds + 1 buckets are stored.
+ * @param sum If not NULL, where the sum of the recorded values is stored.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_histogram_get(apr_shm_stats_t *stats,
+                                                      unsigned int id,
+                                                      apr_uint64_t *counts,
+                                                      apr_int64_t *sum);
+
+/**
+ * Return the number of counters and histograms defined; their
+ * identifiers go from zero to this number excluded.
+ * @param stats The statistics region.
+ */
+APR_DECLARE(unsigned int) apr_shm_stats_count(apr_shm_stats_t *stats);
+
+/**
+ * Describe a counter or histogram.
+ * @param stats The statistics region.
+ * @param id The identifier of the metric.
+ * @param name If not NULL, where the name of the metric is stored.
+ * @param nbounds If not NULL, where the number of bounds of a histogram,
+ *        or zero for a counter, is stored.
+ */
+APR_DECLARE(apr_status_t) apr_shm_stats_info_get(apr_shm_stats_t *stats,
+                                                 unsigned int id,
+                                                 const char **name,
+                                                 unsigned int *nbounds);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* ! APR_SHM_STATS_H */
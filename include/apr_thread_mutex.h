@@ -44,6 +44,7 @@ typedef struct apr_thread_mutex_t apr_thread_mutex_t;
 #define APR_THREAD_MUTEX_NESTED   0x1   /**< enable nested (recursive) locks */
 #define APR_THREAD_MUTEX_UNNESTED 0x2   /**< disable nested locks */
 #define APR_THREAD_MUTEX_TIMED    0x4   /**< enable timed locks */
+#define APR_THREAD_MUTEX_ADAPTIVE 0x8   /**< spin briefly before blocking */
 
 /* Delayed the include to avoid a circular reference */
 #include "apr_pools.h"
@@ -58,8 +59,17 @@ typedef struct apr_thread_mutex_t apr_thread_mutex_t;
  *           APR_THREAD_MUTEX_DEFAULT   platform-optimal lock behavior.
  *           APR_THREAD_MUTEX_NESTED    enable nested (recursive) locks.
  *           APR_THREAD_MUTEX_UNNESTED  disable nested locks (non-recursive).
+ *           APR_THREAD_MUTEX_TIMED     enable timed locks.
+ *           APR_THREAD_MUTEX_ADAPTIVE  on contention, spin for a bounded
+ *                                      time before blocking in the kernel.
  * </PRE>
  * @param pool the pool from which to allocate the mutex.
+ * @remark APR_THREAD_MUTEX_ADAPTIVE suits very short critical sections,
+ * where the owner is likely to release the mutex before a waiter could
+ * even be put to sleep.  It uses the system's adaptive mutexes where
+ * available (e.g. PTHREAD_MUTEX_ADAPTIVE_NP, or a spin count on Windows),
+ * otherwise a spin with exponential backoff; it never spins on a single
+ * CPU system.
  * @warning Be cautious in using APR_THREAD_MUTEX_DEFAULT.  While this is the
  * most optimal mutex based on a given platform's performance characteristics,
  * it will behave as either a nested or an unnested lock.
@@ -41,6 +41,9 @@ extern "C" {
 /** Opaque read-write thread-safe lock. */
 typedef struct apr_thread_rwlock_t apr_thread_rwlock_t;
 
+#define APR_THREAD_RWLOCK_DEFAULT   0x0 /**< platform-optimal lock behavior */
+#define APR_THREAD_RWLOCK_BIGREADER 0x1 /**< scalable lock for read-mostly data */
+
 /**
  * Note: The following operations have undefined results: unlocking a
  * read-write lock which is not locked in the calling thread; write
@@ -59,6 +62,33 @@ typedef struct apr_thread_rwlock_t apr_thread_rwlock_t;
  */
 APR_DECLARE(apr_status_t) apr_thread_rwlock_create(apr_thread_rwlock_t **rwlock,
                                                    apr_pool_t *pool);
+
+/**
+ * Create and initialize a read-write lock that can be used to synchronize
+ * threads, with the given behavior.
+ * @param rwlock the memory address where the newly created readwrite lock
+ *        will be stored.
+ * @param flags Or'ed value of:
+ * <PRE>
+ *           APR_THREAD_RWLOCK_DEFAULT    platform-optimal lock behavior.
+ *           APR_THREAD_RWLOCK_BIGREADER  "big-reader" lock: the readers
+ *                                        are counted in per-thread slots
+ *                                        on distinct cache lines, so that
+ *                                        they do not contend with each
+ *                                        other, while the writer waits for
+ *                                        all the slots to drain.
+ * </PRE>
+ * @param pool the pool from which to allocate the mutex.
+ * @remark A big-reader lock makes the read lock and unlock scale with the
+ *         number of threads, at the expense of much more costly write
+ *         locks; it fits data which is read often and rarely modified.
+ *         Waiting writers have precedence over new readers.
+ * @remark APR_THREAD_RWLOCK_BIGREADER is ignored on platforms where it is
+ *         not supported.
+ */
+APR_DECLARE(apr_status_t) apr_thread_rwlock_create_ex(apr_thread_rwlock_t **rwlock,
+                                                      unsigned int flags,
+                                                      apr_pool_t *pool);
 /**
  * Acquire a shared-read lock on the given read-write lock. This will allow
  * multiple threads to enter the same critical section while they have acquired
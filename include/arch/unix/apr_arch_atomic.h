@@ -34,6 +34,7 @@
 #elif defined(SOLARIS2) && SOLARIS2 >= 10
 #   define USE_ATOMICS_SOLARIS
 #   define NEED_ATOMICS_GENERIC64
+#   define NEED_ATOMICS_GENERIC_EXT
 #elif defined(__GNUC__) && defined(__STRICT_ANSI__)
 /* force use of generic atomics if building e.g. with -std=c89, which
  * doesn't allow inline asm */
@@ -41,20 +42,90 @@
 #elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
 #   define USE_ATOMICS_IA32
 #   define NEED_ATOMICS_GENERIC64
+#   define NEED_ATOMICS_GENERIC_EXT
 #elif defined(__GNUC__) && (defined(__powerpc__) \
                             || defined(__PPC__) \
                             || defined(__ppc__))
 #   define USE_ATOMICS_PPC
 #   define NEED_ATOMICS_GENERIC64
+#   define NEED_ATOMICS_GENERIC_EXT
 #elif defined(__GNUC__) && (defined(__s390__) || defined(__s390x__))
 #   define USE_ATOMICS_S390
 #   define NEED_ATOMICS_GENERIC64
+#   define NEED_ATOMICS_GENERIC_EXT
 #else
 #   define USE_ATOMICS_GENERIC
 #endif
 
-#if defined(USE_ATOMICS_GENERIC) || defined (NEED_ATOMICS_GENERIC64)
+/* NEED_ATOMICS_GENERIC_EXT: the bitwise operations, the _ex variants and
+ * the fence are built on the native apr_atomic_cas32() and xchg32().
+ * NEED_ATOMICS_GENERIC128: apr_atomic_cas128() takes a mutex.
+ */
+#if defined(USE_ATOMICS_BUILTINS64) && defined(__GNUC__) \
+    && defined(__x86_64__)
+#   define USE_ATOMICS_BUILTINS128
+#else
+#   define NEED_ATOMICS_GENERIC128
+#endif
+
+#if defined(USE_ATOMICS_GENERIC) || defined (NEED_ATOMICS_GENERIC64) \
+    || defined(NEED_ATOMICS_GENERIC128)
 apr_status_t apr__atomic_generic64_init(apr_pool_t *p);
 #endif
 
+#if defined(USE_ATOMICS_BUILTINS) && HAVE__ATOMIC_BUILTINS
+/* The memory order of the __atomic builtins must be a constant for the
+ * compiler to honor it (it falls back to __ATOMIC_SEQ_CST otherwise),
+ * hence these helpers which select the builtin call by order.
+ */
+#define ATOMIC_LOAD_EX(mem, order) \
+    ((order) == APR_ATOMIC_RELAXED \
+        ? __atomic_load_n(mem, __ATOMIC_RELAXED) \
+     : (order) == APR_ATOMIC_ACQUIRE || (order) == APR_ATOMIC_RELEASE \
+            || (order) == APR_ATOMIC_ACQ_REL \
+        ? __atomic_load_n(mem, __ATOMIC_ACQUIRE) \
+     : __atomic_load_n(mem, __ATOMIC_SEQ_CST))
+
+#define ATOMIC_STORE_EX(mem, val, order) \
+    do { \
+        if ((order) == APR_ATOMIC_RELAXED) \
+            __atomic_store_n(mem, val, __ATOMIC_RELAXED); \
+        else if ((order) == APR_ATOMIC_RELEASE \
+                 || (order) == APR_ATOMIC_ACQUIRE \
+                 || (order) == APR_ATOMIC_ACQ_REL) \
+            __atomic_store_n(mem, val, __ATOMIC_RELEASE); \
+        else \
+            __atomic_store_n(mem, val, __ATOMIC_SEQ_CST); \
+    } while (0)
+
+#define ATOMIC_FETCH_ADD_EX(mem, val, order) \
+    ((order) == APR_ATOMIC_RELAXED \
+        ? __atomic_fetch_add(mem, val, __ATOMIC_RELAXED) \
+     : (order) == APR_ATOMIC_ACQUIRE \
+        ? __atomic_fetch_add(mem, val, __ATOMIC_ACQUIRE) \
+     : (order) == APR_ATOMIC_RELEASE \
+        ? __atomic_fetch_add(mem, val, __ATOMIC_RELEASE) \
+     : (order) == APR_ATOMIC_ACQ_REL \
+        ? __atomic_fetch_add(mem, val, __ATOMIC_ACQ_REL) \
+     : __atomic_fetch_add(mem, val, __ATOMIC_SEQ_CST))
+
+/* The failure order can be neither stronger than the success order nor
+ * a release */
+#define ATOMIC_CAS_EX(mem, cmp, val, order) \
+    ((order) == APR_ATOMIC_RELAXED \
+        ? __atomic_compare_exchange_n(mem, cmp, val, 0, __ATOMIC_RELAXED, \
+                                      __ATOMIC_RELAXED) \
+     : (order) == APR_ATOMIC_ACQUIRE \
+        ? __atomic_compare_exchange_n(mem, cmp, val, 0, __ATOMIC_ACQUIRE, \
+                                      __ATOMIC_ACQUIRE) \
+     : (order) == APR_ATOMIC_RELEASE \
+        ? __atomic_compare_exchange_n(mem, cmp, val, 0, __ATOMIC_RELEASE, \
+                                      __ATOMIC_RELAXED) \
+     : (order) == APR_ATOMIC_ACQ_REL \
+        ? __atomic_compare_exchange_n(mem, cmp, val, 0, __ATOMIC_ACQ_REL, \
+                                      __ATOMIC_ACQUIRE) \
+     : __atomic_compare_exchange_n(mem, cmp, val, 0, __ATOMIC_SEQ_CST, \
+                                   __ATOMIC_SEQ_CST))
+#endif
+
 #endif /* ATOMIC_H */
@@ -92,6 +92,10 @@
 /* For backwards-compat */
 #define APR_FILE_BUFSIZE  APR_FILE_DEFAULT_BUFSIZE
 
+/* The size (and alignment in the file) of the windows mapped with
+ * APR_FOPEN_MMAP_READ, a multiple of the page size */
+#define APR_FILE_MMAP_WINDOW (4 * 1024 * 1024)
+
 typedef struct apr_rotating_info_t {
     apr_finfo_t finfo;
     apr_interval_time_t timeout;
@@ -127,6 +131,10 @@ struct apr_file_t {
     struct apr_thread_mutex_t *thlock;
 #endif
     apr_rotating_info_t *rotating;
+#if APR_HAS_MMAP
+    /* With APR_FOPEN_MMAP_READ, the read buffer is a mapped window */
+    apr_pool_t *mmap_pool;    /* The pool of the current window */
+#endif
 };
 
 #if APR_HAS_THREADS
@@ -178,6 +186,9 @@ mode_t apr_unix_perms2mode(apr_fileperms_t perms);
 apr_fileperms_t apr_unix_mode2perms(mode_t mode);
 
 apr_status_t apr_file_flush_locked(apr_file_t *thefile);
+#if APR_HAS_MMAP
+apr_status_t apr_file_mmap_stop_locked(apr_file_t *thefile);
+#endif
 apr_status_t apr_file_info_get_locked(apr_finfo_t *finfo, apr_int32_t wanted,
                                       apr_file_t *thefile);
 
@@ -61,6 +61,9 @@
 #if APR_HAVE_NETINET_IN_H
 #include <netinet/in.h>
 #endif
+#ifdef HAVE_NETINET_UDP_H
+#include <netinet/udp.h>
+#endif
 #if APR_HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
@@ -93,6 +96,17 @@
 #define POLLNVAL 32
 #endif
 
+#if defined(HAVE_LINUX_ERRQUEUE_H) && defined(MSG_ZEROCOPY) \
+    && defined(SO_ZEROCOPY)
+#include <linux/errqueue.h>
+#define HAVE_ZEROCOPY 1
+#endif
+
+#if defined(HAVE_LINUX_TLS_H) && defined(TCP_ULP) && defined(SOL_TLS)
+#include <linux/tls.h>
+#define HAVE_KTLS 1
+#endif
+
 typedef struct sock_userdata_t sock_userdata_t;
 struct sock_userdata_t {
     sock_userdata_t *next;
@@ -124,6 +138,21 @@ struct apr_socket_t {
     /* if there is a timeout set, then this pollset is used */
     apr_pollset_t *pollset;
 #endif
+#ifdef HAVE_SPLICE
+    /* pipe through which apr_socket_splice() moves data to this socket,
+     * holding splice_pending bytes not sent yet */
+    int splice_pipe[2];
+    apr_size_t splice_pending;
+#endif
+#ifdef HAVE_ZEROCOPY
+    /* zero-copy sends waiting for their completion, in the order of their
+     * ids, the next send getting zerocopy_next */
+    struct zerocopy_send_t *zerocopy_sends;
+    struct zerocopy_send_t **zerocopy_last;
+    struct zerocopy_send_t *zerocopy_free;
+    apr_size_t zerocopy_pending;
+    apr_uint32_t zerocopy_next;
+#endif
 };
 
 const char *apr_inet_ntop(int af, const void *src, char *dst, apr_size_t size);
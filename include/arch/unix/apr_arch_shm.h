@@ -51,6 +51,9 @@
 #ifdef HAVE_SYS_FILE_H
 #include <sys/file.h>
 #endif
+#if defined(__linux__) && defined(HAVE_SYS_SYSCALL_H)
+#include <sys/syscall.h>
+#endif
 
 /* Not all systems seem to have MAP_FAILED defined, but it should always
  * just be (void *)-1. */
@@ -65,6 +68,7 @@ struct apr_shm_t {
     apr_size_t reqsize;  /* requested segment size */
     apr_size_t realsize; /* actual segment size */
     const char *filename;      /* NULL if anonymous */
+    apr_size_t pagesize; /* huge page size, 0 if the system's */
 #if APR_USE_SHMEM_SHMGET || APR_USE_SHMEM_SHMGET_ANON
     int shmid;          /* shmem ID returned from shmget() */
     key_t shmkey;       /* shmem key IPC_ANON or returned from ftok() */
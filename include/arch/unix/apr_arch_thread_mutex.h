@@ -33,6 +33,9 @@
 struct apr_thread_mutex_t {
     apr_pool_t *pool;
     pthread_mutex_t mutex;
+    /* Bound of the spin before blocking, for APR_THREAD_MUTEX_ADAPTIVE
+     * without PTHREAD_MUTEX_ADAPTIVE_NP */
+    int spin;
 #ifndef HAVE_PTHREAD_MUTEX_TIMEDLOCK
     apr_thread_cond_t *cond;
     int locked, num_waiters;
@@ -31,9 +31,33 @@
 #if APR_HAS_THREADS
 #ifdef HAVE_PTHREAD_RWLOCKS
 
+#if HAVE_ATOMIC_BUILTINS
+#define APR_HAS_BIGREADER_RWLOCK 1
+#else
+#define APR_HAS_BIGREADER_RWLOCK 0
+#endif
+
+/* Size of the big-reader slots, so that each one has its own cache line */
+#define APR_RWLOCK_SLOT_SIZE 64
+
+/* Reader count of a big-reader lock, one per (set of) thread(s) */
+typedef union apr_rwlock_slot_t {
+    volatile apr_uint32_t readers;
+    char pad[APR_RWLOCK_SLOT_SIZE];
+} apr_rwlock_slot_t;
+
 struct apr_thread_rwlock_t {
     apr_pool_t *pool;
     pthread_rwlock_t rwlock;
+#if APR_HAS_BIGREADER_RWLOCK
+    /* Big-reader mode, when slots is not NULL */
+    apr_rwlock_slot_t *slots;
+    apr_uint32_t slots_mask;
+    /* 0: unlocked, 1: writer waiting for the readers, 2: write locked */
+    volatile apr_uint32_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
 };
 
 #else
@@ -0,0 +1,90 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file apr_shm_private.h
+ * @brief APR-UTIL Shared Memory Structures Private
+ */
+#ifndef APR_SHM_PRIVATE_H
+#define APR_SHM_PRIVATE_H
+
+#include "apr.h"
+
+#if APR_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if APR_HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#if APR_HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup APR_Util_Shm_Private
+ * @ingroup APR_Util
+ * @{
+ */
+
+/**
+ * The id of the calling process, as stored in the owner fields of the
+ * structures shared between processes.  Never zero, which marks no owner.
+ */
+static APR_INLINE apr_uint32_t apr_shm_owner_self(void)
+{
+#if defined(WIN32)
+    return (apr_uint32_t)GetCurrentProcessId();
+#elif APR_HAVE_UNISTD_H
+    return (apr_uint32_t)getpid();
+#else
+    return 1;
+#endif
+}
+
+/**
+ * Whether the process that stored @a owner has exited.  Errs on the side
+ * of "alive" when it cannot tell, so that nothing is taken over that is
+ * still in use.
+ */
+static APR_INLINE int apr_shm_owner_dead(apr_uint32_t owner)
+{
+#if defined(WIN32)
+    HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)owner);
+    int dead;
+
+    if (!h) {
+        return GetLastError() == ERROR_INVALID_PARAMETER;
+    }
+    dead = (WaitForSingleObject(h, 0) == WAIT_OBJECT_0);
+    CloseHandle(h);
+    return dead;
+#elif APR_HAVE_SIGNAL_H && APR_HAVE_ERRNO_H && !defined(NETWARE)
+    return kill((pid_t)owner, 0) == -1 && errno == ESRCH;
+#else
+    return 0;
+#endif
+}
+
+/** @} */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APR_SHM_PRIVATE_H */
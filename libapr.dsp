@@ -187,6 +187,10 @@ SOURCE=.\buckets\apr_brigade.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\buckets\apr_brigade_zstream.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\buckets\apr_buckets.c
 # End Source File
 # Begin Source File
@@ -227,6 +231,10 @@ SOURCE=.\buckets\apr_buckets_refcount.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\buckets\apr_buckets_sharedbuf.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\buckets\apr_buckets_simple.c
 # End Source File
 # Begin Source File
@@ -770,10 +778,18 @@ SOURCE=.\util-misc\apu_dso.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\util-misc\apr_global_lockset.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\util-misc\apr_queue.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\util-misc\apr_rcu.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\util-misc\apr_reslist.c
 # End Source File
 # Begin Source File
@@ -782,6 +798,14 @@ SOURCE=.\util-misc\apr_rmm.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\util-misc\apr_shm_hash.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\util-misc\apr_shm_stats.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\util-misc\apr_thread_pool.c
 # End Source File
 # End Group
@@ -1007,6 +1031,10 @@ SOURCE=.\include\apr_getopt.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\include\apr_global_lockset.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\include\apr_global_mutex.h
 # End Source File
 # Begin Source File
@@ -1051,6 +1079,10 @@ SOURCE=.\include\apr_random.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\include\apr_rcu.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\include\apr_ring.h
 # End Source File
 # Begin Source File
@@ -1059,6 +1091,14 @@ SOURCE=.\include\apr_shm.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\include\apr_shm_hash.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\include\apr_shm_stats.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\include\apr_signal.h
 # End Source File
 # Begin Source File
@@ -47,7 +47,8 @@ APR_DECLARE(apr_status_t) apr_proc_mutex_create(apr_proc_mutex_t **mutex,
     apr_proc_mutex_t *new;
     apr_status_t stat = APR_SUCCESS;
   
-    if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_TIMED) {
+    if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_TIMED
+            && mech != APR_LOCK_DEFAULT_GLOBAL) {
         return APR_ENOTIMPL;
     }
 
@@ -181,6 +182,12 @@ APR_DECLARE(const char *) apr_proc_mutex_defname(void)
     return "beossem";
 }
 
+APR_DECLARE(apr_status_t) apr_proc_mutex_stats_get(apr_proc_mutex_t *mutex,
+                                                   apr_proc_mutex_stats_t *stats)
+{
+    return APR_ENOTIMPL;
+}
+
 APR_PERMS_SET_ENOTIMPL(proc_mutex)
 
 APR_POOL_IMPLEMENT_ACCESSOR(proc_mutex)
@@ -214,7 +221,8 @@ APR_DECLARE(apr_status_t) apr_os_proc_mutex_put_ex(apr_proc_mutex_t **pmutex,
     if (pool == NULL) {
         return APR_ENOPOOL;
     }
-    if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_TIMED) {
+    if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_TIMED
+            && mech != APR_LOCK_DEFAULT_GLOBAL) {
         return APR_ENOTIMPL;
     }
 
@@ -33,7 +33,7 @@ APR_DECLARE(apr_status_t) apr_proc_mutex_create(apr_proc_mutex_t **mutex,
     if (mech == APR_LOCK_DEFAULT_TIMED) {
         flags |= APR_THREAD_MUTEX_TIMED;
     }
-    else if (mech != APR_LOCK_DEFAULT) {
+    else if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_GLOBAL) {
         return APR_ENOTIMPL;
     }
 
@@ -119,6 +119,12 @@ APR_DECLARE(const char *) apr_proc_mutex_defname(void)
     return "netwarethread";
 }
 
+APR_DECLARE(apr_status_t) apr_proc_mutex_stats_get(apr_proc_mutex_t *mutex,
+                                                   apr_proc_mutex_stats_t *stats)
+{
+    return APR_ENOTIMPL;
+}
+
 APR_PERMS_SET_ENOTIMPL(proc_mutex)
 
 APR_POOL_IMPLEMENT_ACCESSOR(proc_mutex)
@@ -75,6 +75,12 @@ APR_DECLARE(const char *) apr_proc_mutex_defname(void)
     return "os2sem";
 }
 
+APR_DECLARE(apr_status_t) apr_proc_mutex_stats_get(apr_proc_mutex_t *mutex,
+                                                   apr_proc_mutex_stats_t *stats)
+{
+    return APR_ENOTIMPL;
+}
+
 
 APR_DECLARE(apr_status_t) apr_proc_mutex_create(apr_proc_mutex_t **mutex,
                                                 const char *fname,
@@ -85,7 +91,8 @@ APR_DECLARE(apr_status_t) apr_proc_mutex_create(apr_proc_mutex_t **mutex,
     ULONG rc;
     char *semname;
 
-    if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_TIMED) {
+    if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_TIMED
+            && mech != APR_LOCK_DEFAULT_GLOBAL) {
         return APR_ENOTIMPL;
     }
 
@@ -261,7 +268,8 @@ APR_DECLARE(apr_status_t) apr_os_proc_mutex_put_ex(apr_proc_mutex_t **pmutex,
     if (pool == NULL) {
         return APR_ENOPOOL;
     }
-    if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_TIMED) {
+    if (mech != APR_LOCK_DEFAULT && mech != APR_LOCK_DEFAULT_TIMED
+            && mech != APR_LOCK_DEFAULT_GLOBAL) {
         return APR_ENOTIMPL;
     }
 
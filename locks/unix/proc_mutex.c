@@ -40,7 +40,8 @@ static apr_status_t proc_mutex_no_child_init(apr_proc_mutex_t **mutex,
 }
 #endif    
 
-#if APR_HAS_POSIXSEM_SERIALIZE || APR_HAS_PROC_PTHREAD_SERIALIZE
+#if APR_HAS_POSIXSEM_SERIALIZE || APR_HAS_PROC_PTHREAD_SERIALIZE || \
+    APR_HAS_FUTEX_SERIALIZE
 static apr_status_t proc_mutex_no_perms_set(apr_proc_mutex_t *mutex,
                                             apr_fileperms_t perms,
                                             apr_uid_t uid,
@@ -988,6 +989,250 @@ static const apr_proc_mutex_unix_lock_methods_t mutex_proc_pthread_cond_methods
 
 #endif
 
+#if APR_HAS_FUTEX_SERIALIZE
+
+#include "apr_thread_proc.h" /* for APR_THREAD_LOCAL */
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/* The mmap()ed futex_interproc is the futex word followed by the
+ * statistics.  The word is a priority inheritance futex: it holds the
+ * thread id of the owner (zero when the mutex is unlocked), with
+ * FUTEX_WAITERS set when the release must go through the kernel.  This
+ * lets the kernel hand the mutex over to a waiter when the owner exits
+ * while holding it, and tell a later locker that the owner is gone (with
+ * ESRCH) if nobody was waiting then, even before the process is reaped.
+ *
+ * The statistics are updated by the owner only, hence without atomics.
+ */
+typedef struct {
+    apr_uint32_t word;
+    apr_proc_mutex_stats_t stats;
+} proc_futex_t;
+
+#define proc_futex_cast(m) \
+    ((proc_futex_t *)(m)->os.futex_interproc)
+
+#if APR_HAS_THREAD_LOCAL
+static APR_THREAD_LOCAL apr_uint32_t proc_futex_tid;
+static pthread_once_t proc_futex_once = PTHREAD_ONCE_INIT;
+
+static void proc_futex_atfork_child(void)
+{
+    /* The forking thread now has another id */
+    proc_futex_tid = 0;
+}
+
+static void proc_futex_atfork_register(void)
+{
+    pthread_atfork(NULL, NULL, proc_futex_atfork_child);
+}
+#endif
+
+/* The owner's id, cached so that the fast paths need no system call */
+static APR_INLINE apr_uint32_t proc_futex_gettid(void)
+{
+#if APR_HAS_THREAD_LOCAL
+    if (!proc_futex_tid) {
+        pthread_once(&proc_futex_once, proc_futex_atfork_register);
+        proc_futex_tid = (apr_uint32_t)syscall(SYS_gettid);
+    }
+    return proc_futex_tid;
+#else
+    return (apr_uint32_t)syscall(SYS_gettid);
+#endif
+}
+
+static APR_INLINE apr_uint32_t proc_futex_read(proc_futex_t *futex)
+{
+    return *(volatile apr_uint32_t *)&futex->word;
+}
+
+/* FUTEX_LOCK_PI takes an absolute CLOCK_REALTIME deadline, if any */
+static apr_status_t proc_futex_lock_pi(proc_futex_t *futex, int op,
+                                       apr_time_t deadline)
+{
+    struct timespec ts, *pts = NULL;
+
+    if (deadline) {
+        ts.tv_sec = apr_time_sec(deadline);
+        ts.tv_nsec = apr_time_usec(deadline) * 1000; /* nanoseconds */
+        pts = &ts;
+    }
+    if (syscall(SYS_futex, &futex->word, op, 0, pts, NULL, 0)) {
+        return errno;
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t proc_futex_unlock(proc_futex_t *futex)
+{
+    apr_uint32_t val = proc_futex_read(futex);
+
+    if (!(val & FUTEX_WAITERS)
+            && __sync_val_compare_and_swap(&futex->word, val, 0) == val) {
+        return APR_SUCCESS;
+    }
+    if (syscall(SYS_futex, &futex->word, FUTEX_UNLOCK_PI, 0,
+                NULL, NULL, 0) < 0) {
+        return errno;
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t proc_mutex_futex_cleanup(void *mutex_)
+{
+    apr_proc_mutex_t *mutex = mutex_;
+
+    if (mutex->curr_locked == 1) {
+        proc_futex_unlock(proc_futex_cast(mutex));
+        mutex->curr_locked = 0;
+    }
+    if (munmap(mutex->os.futex_interproc, sizeof(proc_futex_t))) {
+        return errno;
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t proc_mutex_futex_create(apr_proc_mutex_t *new_mutex,
+                                            const char *fname)
+{
+    apr_status_t rv;
+    void *addr;
+    int fd;
+
+    fd = open("/dev/zero", O_RDWR);
+    if (fd < 0) {
+        return errno;
+    }
+
+    addr = mmap(NULL, sizeof(proc_futex_t), PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        rv = errno;
+        close(fd);
+        return rv;
+    }
+    close(fd);
+
+    new_mutex->os.futex_interproc = addr;
+    new_mutex->curr_locked = 0;
+
+    apr_pool_cleanup_register(new_mutex->pool,
+                              (void *)new_mutex,
+                              apr_proc_mutex_cleanup,
+                              apr_pool_cleanup_null);
+    return APR_SUCCESS;
+}
+
+static apr_status_t proc_mutex_futex_child_init(apr_proc_mutex_t **mutex,
+                                                apr_pool_t *pool,
+                                                const char *fname)
+{
+    (*mutex)->curr_locked = 0;
+    return APR_SUCCESS;
+}
+
+static apr_status_t proc_mutex_futex_acquire_ex(apr_proc_mutex_t *mutex,
+                                                apr_interval_time_t timeout)
+{
+    proc_futex_t *futex = proc_futex_cast(mutex);
+    apr_uint32_t tid = proc_futex_gettid(), val;
+    apr_time_t deadline = 0;
+    int recovered = 0;
+
+    val = __sync_val_compare_and_swap(&futex->word, 0, tid);
+    if (val) {
+        /* A try lock too goes to the kernel, which tells whether the
+         * owner died, so that polling callers get the mutex back.
+         */
+        int op = timeout ? FUTEX_LOCK_PI : FUTEX_TRYLOCK_PI;
+        apr_status_t rv;
+
+        if (timeout > 0) {
+            deadline = apr_time_now() + timeout;
+        }
+        for (;;) {
+            rv = proc_futex_lock_pi(futex, op, deadline);
+            if (rv == APR_SUCCESS) {
+                break;
+            }
+            if (rv == ESRCH) {
+                /* The owner exited with nobody waiting for the mutex, so
+                 * take its place unless someone else did already.
+                 */
+                val = proc_futex_read(futex);
+                if ((val & FUTEX_TID_MASK)
+                        && __sync_val_compare_and_swap(&futex->word, val,
+                                               tid | (val & FUTEX_WAITERS))
+                           == val) {
+                    recovered = 1;
+                    break;
+                }
+            }
+            else if (rv == ETIMEDOUT || rv == EWOULDBLOCK) {
+                return APR_TIMEUP;
+            }
+            else if (rv == EDEADLK && timeout >= 0) {
+                /* Held by the caller, which waits no less for that */
+                if (deadline && deadline > apr_time_now()) {
+                    apr_sleep(deadline - apr_time_now());
+                }
+                return APR_TIMEUP;
+            }
+            else if (rv != EINTR) {
+                return rv;
+            }
+        }
+        futex->stats.contended++;
+        futex->stats.recovered += recovered;
+    }
+    futex->stats.acquired++;
+
+    mutex->curr_locked = 1;
+    return APR_SUCCESS;
+}
+
+static apr_status_t proc_mutex_futex_acquire(apr_proc_mutex_t *mutex)
+{
+    return proc_mutex_futex_acquire_ex(mutex, -1);
+}
+
+static apr_status_t proc_mutex_futex_tryacquire(apr_proc_mutex_t *mutex)
+{
+    apr_status_t rv = proc_mutex_futex_acquire_ex(mutex, 0);
+    return (rv == APR_TIMEUP) ? APR_EBUSY : rv;
+}
+
+static apr_status_t proc_mutex_futex_timedacquire(apr_proc_mutex_t *mutex,
+                                                  apr_interval_time_t timeout)
+{
+    return proc_mutex_futex_acquire_ex(mutex, (timeout <= 0) ? 0 : timeout);
+}
+
+static apr_status_t proc_mutex_futex_release(apr_proc_mutex_t *mutex)
+{
+    mutex->curr_locked = 0;
+    return proc_futex_unlock(proc_futex_cast(mutex));
+}
+
+static const apr_proc_mutex_unix_lock_methods_t mutex_futex_methods =
+{
+    APR_PROCESS_LOCK_MECH_IS_GLOBAL,
+    proc_mutex_futex_create,
+    proc_mutex_futex_acquire,
+    proc_mutex_futex_tryacquire,
+    proc_mutex_futex_timedacquire,
+    proc_mutex_futex_release,
+    proc_mutex_futex_cleanup,
+    proc_mutex_futex_child_init,
+    proc_mutex_no_perms_set,
+    APR_LOCK_FUTEX,
+    "futex"
+};
+
+#endif /* futex implementation */
+
 #if APR_HAS_FCNTL_SERIALIZE
 
 static struct flock proc_mutex_lock_it;
@@ -1347,6 +1592,9 @@ static apr_status_t proc_mutex_choose_method(apr_proc_mutex_t *new_mutex,
 #if APR_HAS_POSIXSEM_SERIALIZE
     new_mutex->os.psem_interproc = NULL;
 #endif
+#if APR_HAS_FUTEX_SERIALIZE
+    new_mutex->os.futex_interproc = NULL;
+#endif
 #if APR_HAS_SYSVSEM_SERIALIZE || APR_HAS_FCNTL_SERIALIZE || APR_HAS_FLOCK_SERIALIZE
     new_mutex->os.crossproc = -1;
 
@@ -1422,6 +1670,31 @@ static apr_status_t proc_mutex_choose_method(apr_proc_mutex_t *new_mutex,
         return APR_ENOTIMPL;
 #endif
         break;
+    case APR_LOCK_FUTEX:
+#if APR_HAS_FUTEX_SERIALIZE
+        new_mutex->meth = &mutex_futex_methods;
+        if (ospmutex) {
+            if (ospmutex->futex_interproc == NULL) {
+                return APR_EINVAL;
+            }
+            new_mutex->os.futex_interproc = ospmutex->futex_interproc;
+        }
+#else
+        return APR_ENOTIMPL;
+#endif
+        break;
+    case APR_LOCK_DEFAULT_GLOBAL:
+        /* A mechanism which also excludes the threads of the process,
+         * so that apr_global_mutex_t needs no apr_thread_mutex_t.
+         */
+#if APR_HAS_FUTEX_SERIALIZE
+        return proc_mutex_choose_method(new_mutex, APR_LOCK_FUTEX, ospmutex);
+#elif APR_HAS_PROC_PTHREAD_SERIALIZE
+        return proc_mutex_choose_method(new_mutex, APR_LOCK_PROC_PTHREAD,
+                                        ospmutex);
+#else
+        return proc_mutex_choose_method(new_mutex, APR_LOCK_DEFAULT, ospmutex);
+#endif
     case APR_LOCK_DEFAULT_TIMED:
 #if APR_HAS_PROC_PTHREAD_SERIALIZE \
         && (APR_USE_PROC_PTHREAD_MUTEX_COND \
@@ -1599,6 +1872,18 @@ APR_DECLARE(const char *) apr_proc_mutex_name(apr_proc_mutex_t *mutex)
     return mutex->meth->name;
 }
 
+APR_DECLARE(apr_status_t) apr_proc_mutex_stats_get(apr_proc_mutex_t *mutex,
+                                                   apr_proc_mutex_stats_t *stats)
+{
+#if APR_HAS_FUTEX_SERIALIZE
+    if (mutex->meth == &mutex_futex_methods) {
+        *stats = proc_futex_cast(mutex)->stats;
+        return APR_SUCCESS;
+    }
+#endif
+    return APR_ENOTIMPL;
+}
+
 APR_DECLARE(const char *) apr_proc_mutex_lockfile(apr_proc_mutex_t *mutex)
 {
     /* POSIX sems use the fname field but don't use a file,
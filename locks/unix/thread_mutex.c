@@ -18,8 +18,67 @@
 #define APR_WANT_MEMFUNC
 #include "apr_want.h"
 
+#if APR_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #if APR_HAS_THREADS
 
+/* Spin bound of APR_THREAD_MUTEX_ADAPTIVE mutexes, in CPU relax units,
+ * and the longest backoff between two attempts.
+ */
+#define THREAD_MUTEX_SPIN_MAX   2048
+#define THREAD_MUTEX_SPIN_DELAY 64
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define thread_mutex_relax() __asm__ __volatile__ ("pause" ::: "memory")
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define thread_mutex_relax() __asm__ __volatile__ ("yield" ::: "memory")
+#elif defined(__GNUC__)
+#define thread_mutex_relax() __asm__ __volatile__ ("" ::: "memory")
+#else
+#define thread_mutex_relax()
+#endif
+
+static int thread_mutex_spin_max(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    /* The owner can't make progress while we spin on its only CPU */
+    if (sysconf(_SC_NPROCESSORS_ONLN) == 1) {
+        return 0;
+    }
+#endif
+    return THREAD_MUTEX_SPIN_MAX;
+}
+
+/* Try to get the mutex for a bounded time, backing off exponentially
+ * between the attempts to limit the cache line traffic.
+ */
+static apr_status_t thread_mutex_spin(apr_thread_mutex_t *mutex)
+{
+    int spun = 0, delay = 1, i;
+    apr_status_t rv;
+
+    for (;;) {
+        rv = pthread_mutex_trylock(&mutex->mutex);
+#ifdef HAVE_ZOS_PTHREADS
+        if (rv) {
+            rv = errno;
+        }
+#endif
+        if (rv != EBUSY || spun >= mutex->spin) {
+            return rv;
+        }
+        for (i = 0; i < delay; i++) {
+            thread_mutex_relax();
+        }
+        spun += delay;
+        if (delay < THREAD_MUTEX_SPIN_DELAY) {
+            delay <<= 1;
+        }
+    }
+}
+
 static apr_status_t thread_mutex_cleanup(void *data)
 {
     apr_thread_mutex_t *mutex = data;
@@ -67,6 +126,27 @@ APR_DECLARE(apr_status_t) apr_thread_mutex_create(apr_thread_mutex_t **mutex,
         
         pthread_mutexattr_destroy(&mattr);
     } else
+#endif
+#if defined(HAVE_PTHREAD_MUTEX_ADAPTIVE_NP) && !defined(APR_THREAD_DEBUG)
+    if (flags & APR_THREAD_MUTEX_ADAPTIVE) {
+        pthread_mutexattr_t mattr;
+
+        rv = pthread_mutexattr_init(&mattr);
+        if (rv) return rv;
+
+        rv = pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_ADAPTIVE_NP);
+        if (rv) {
+            pthread_mutexattr_destroy(&mattr);
+            return rv;
+        }
+
+        rv = pthread_mutex_init(&new_mutex->mutex, &mattr);
+
+        pthread_mutexattr_destroy(&mattr);
+
+        /* The system spins already */
+        flags &= ~APR_THREAD_MUTEX_ADAPTIVE;
+    } else
 #endif
     {
 #if defined(APR_THREAD_DEBUG)
@@ -96,6 +176,10 @@ APR_DECLARE(apr_status_t) apr_thread_mutex_create(apr_thread_mutex_t **mutex,
         return rv;
     }
 
+    if (flags & APR_THREAD_MUTEX_ADAPTIVE) {
+        new_mutex->spin = thread_mutex_spin_max();
+    }
+
 #ifndef HAVE_PTHREAD_MUTEX_TIMEDLOCK
     if (flags & APR_THREAD_MUTEX_TIMED) {
         rv = apr_thread_cond_create(&new_mutex->cond, pool);
@@ -155,6 +239,13 @@ APR_DECLARE(apr_status_t) apr_thread_mutex_lock(apr_thread_mutex_t *mutex)
     }
 #endif
 
+    if (mutex->spin) {
+        rv = thread_mutex_spin(mutex);
+        if (rv != EBUSY) {
+            return rv;
+        }
+    }
+
     rv = pthread_mutex_lock(&mutex->mutex);
 #ifdef HAVE_ZOS_PTHREADS
     if (rv) {
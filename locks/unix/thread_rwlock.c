@@ -16,11 +16,274 @@
 
 #include "apr_arch_thread_rwlock.h"
 #include "apr_private.h"
+#include "apr_atomic.h"
+#include "apr_thread_proc.h"
+
+#if APR_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #if APR_HAS_THREADS
 
 #ifdef HAVE_PTHREAD_RWLOCKS
 
+#if APR_HAS_BIGREADER_RWLOCK
+
+/* Upper bound of the number of reader slots of a big-reader lock */
+#define BRLOCK_MAX_SLOTS 256
+
+/* Number of times a writer checks for the readers to leave before it
+ * waits for them to wake it up */
+#define BRLOCK_WRITER_SPINS 100
+
+#if HAVE__ATOMIC_BUILTINS
+#define brlock_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define brlock_fence() __sync_synchronize()
+#endif
+
+#if APR_HAS_THREAD_LOCAL
+static APR_THREAD_LOCAL apr_uint32_t reader_slot;
+static volatile apr_uint32_t reader_slot_next;
+#endif
+
+/* Index (not yet masked) of the calling thread's reader slot, which must
+ * not change between the lock and the unlock.  With thread local storage
+ * the threads get successive indexes, otherwise the thread id is hashed.
+ */
+static APR_INLINE apr_uint32_t brlock_reader_slot(void)
+{
+#if APR_HAS_THREAD_LOCAL
+    if (!reader_slot) {
+        reader_slot = apr_atomic_inc32(&reader_slot_next) | 0x80000000;
+    }
+    return reader_slot;
+#else
+    pthread_t self = pthread_self();
+    const unsigned char *c = (const unsigned char *)&self;
+    apr_uint32_t hash = 0;
+    apr_size_t i;
+
+    for (i = 0; i < sizeof(self); i++) {
+        hash = hash * 33 + c[i];
+    }
+    return hash ^ (hash >> 16);
+#endif
+}
+
+static apr_uint32_t brlock_num_slots(void)
+{
+    long ncpus = 0;
+    apr_uint32_t nslots = 2;
+
+#ifdef _SC_NPROCESSORS_ONLN
+    ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (ncpus <= 0) {
+        ncpus = 8;
+    }
+    /* Twice as many slots as CPUs limits the sharing of slots */
+    while (nslots < BRLOCK_MAX_SLOTS && nslots < (apr_uint32_t)ncpus * 2) {
+        nslots <<= 1;
+    }
+    return nslots;
+}
+
+static apr_status_t brlock_cleanup(apr_thread_rwlock_t *rwlock)
+{
+    apr_status_t stat, stat2;
+
+    stat = pthread_cond_destroy(&rwlock->cond);
+    stat2 = pthread_mutex_destroy(&rwlock->mutex);
+    return stat ? stat : stat2;
+}
+
+static apr_status_t brlock_init(apr_thread_rwlock_t *rwlock)
+{
+    apr_uint32_t nslots = brlock_num_slots();
+    char *mem;
+    apr_status_t stat;
+
+    mem = apr_pcalloc(rwlock->pool, (nslots + 1) * sizeof(apr_rwlock_slot_t));
+    rwlock->slots = (apr_rwlock_slot_t *)APR_ALIGN((apr_uintptr_t)mem,
+                                                   APR_RWLOCK_SLOT_SIZE);
+    rwlock->slots_mask = nslots - 1;
+    rwlock->writer = 0;
+
+    if ((stat = pthread_mutex_init(&rwlock->mutex, NULL))) {
+        return stat;
+    }
+    if ((stat = pthread_cond_init(&rwlock->cond, NULL))) {
+        pthread_mutex_destroy(&rwlock->mutex);
+        return stat;
+    }
+    return APR_SUCCESS;
+}
+
+/* Wait for the current writer to release the lock, with the mutex held */
+static void brlock_wait_writer(apr_thread_rwlock_t *rwlock)
+{
+    while (apr_atomic_read32(&rwlock->writer)) {
+        pthread_cond_wait(&rwlock->cond, &rwlock->mutex);
+    }
+}
+
+/* Leave a reader slot.  The one emptying it may be the last reader a
+ * writer is waiting for, which it wakes up then; the fence pairs with the
+ * one of brlock_drained, under the mutex held by that writer.
+ */
+static APR_INLINE void brlock_leave(apr_thread_rwlock_t *rwlock,
+                                    apr_rwlock_slot_t *slot)
+{
+    if (!apr_atomic_dec32(&slot->readers)) {
+        brlock_fence();
+        if (apr_atomic_read32(&rwlock->writer) == 1) {
+            pthread_mutex_lock(&rwlock->mutex);
+            pthread_cond_broadcast(&rwlock->cond);
+            pthread_mutex_unlock(&rwlock->mutex);
+        }
+    }
+}
+
+/* Try to take the read lock; the increment of the reader count must be
+ * visible to the writer before we look for it (and vice versa in
+ * brlock_drained), hence the full fence.
+ */
+static APR_INLINE int brlock_enter(apr_thread_rwlock_t *rwlock,
+                                   apr_rwlock_slot_t *slot)
+{
+    apr_atomic_inc32(&slot->readers);
+    brlock_fence();
+    if (!apr_atomic_read32(&rwlock->writer)) {
+        return 1;
+    }
+    brlock_leave(rwlock, slot);
+    return 0;
+}
+
+static int brlock_drained(apr_thread_rwlock_t *rwlock)
+{
+    apr_uint32_t i;
+
+    brlock_fence();
+    for (i = 0; i <= rwlock->slots_mask; i++) {
+        if (apr_atomic_read32(&rwlock->slots[i].readers)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static apr_status_t brlock_rdlock(apr_thread_rwlock_t *rwlock)
+{
+    apr_rwlock_slot_t *slot;
+    apr_status_t stat;
+
+    slot = &rwlock->slots[brlock_reader_slot() & rwlock->slots_mask];
+    while (!brlock_enter(rwlock, slot)) {
+        if ((stat = pthread_mutex_lock(&rwlock->mutex))) {
+            return stat;
+        }
+        brlock_wait_writer(rwlock);
+        pthread_mutex_unlock(&rwlock->mutex);
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t brlock_tryrdlock(apr_thread_rwlock_t *rwlock)
+{
+    apr_rwlock_slot_t *slot;
+
+    slot = &rwlock->slots[brlock_reader_slot() & rwlock->slots_mask];
+    if (!brlock_enter(rwlock, slot)) {
+        return APR_EBUSY;
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t brlock_wrlock(apr_thread_rwlock_t *rwlock)
+{
+    apr_status_t stat;
+    int spins;
+
+    if ((stat = pthread_mutex_lock(&rwlock->mutex))) {
+        return stat;
+    }
+    brlock_wait_writer(rwlock);
+    apr_atomic_set32(&rwlock->writer, 1);
+    pthread_mutex_unlock(&rwlock->mutex);
+
+    /* New readers now back off, wait for the current ones to leave; they
+     * are usually quick, otherwise the last one wakes us up.
+     */
+    for (spins = 0; !brlock_drained(rwlock); spins++) {
+        if (spins < BRLOCK_WRITER_SPINS) {
+            apr_thread_yield();
+            continue;
+        }
+        pthread_mutex_lock(&rwlock->mutex);
+        while (!brlock_drained(rwlock)) {
+            pthread_cond_wait(&rwlock->cond, &rwlock->mutex);
+        }
+        pthread_mutex_unlock(&rwlock->mutex);
+        break;
+    }
+    apr_atomic_set32(&rwlock->writer, 2);
+    return APR_SUCCESS;
+}
+
+static apr_status_t brlock_trywrlock(apr_thread_rwlock_t *rwlock)
+{
+    apr_status_t stat;
+
+    if ((stat = pthread_mutex_lock(&rwlock->mutex))) {
+        return stat;
+    }
+    if (apr_atomic_read32(&rwlock->writer)) {
+        stat = APR_EBUSY;
+    }
+    else {
+        apr_atomic_set32(&rwlock->writer, 1);
+        if (brlock_drained(rwlock)) {
+            apr_atomic_set32(&rwlock->writer, 2);
+        }
+        else {
+            /* Readers which backed off meanwhile may be waiting */
+            apr_atomic_set32(&rwlock->writer, 0);
+            pthread_cond_broadcast(&rwlock->cond);
+            stat = APR_EBUSY;
+        }
+    }
+    pthread_mutex_unlock(&rwlock->mutex);
+    return stat;
+}
+
+static apr_status_t brlock_unlock(apr_thread_rwlock_t *rwlock)
+{
+    apr_status_t stat;
+
+    /* No reader can hold the lock while it is write locked, so the
+     * caller is the writer in this case.
+     */
+    if (apr_atomic_read32(&rwlock->writer) == 2) {
+        if ((stat = pthread_mutex_lock(&rwlock->mutex))) {
+            return stat;
+        }
+        apr_atomic_set32(&rwlock->writer, 0);
+        pthread_cond_broadcast(&rwlock->cond);
+        pthread_mutex_unlock(&rwlock->mutex);
+    }
+    else {
+        apr_rwlock_slot_t *slot;
+
+        slot = &rwlock->slots[brlock_reader_slot() & rwlock->slots_mask];
+        brlock_leave(rwlock, slot);
+    }
+    return APR_SUCCESS;
+}
+
+#endif /* APR_HAS_BIGREADER_RWLOCK */
+
 /* The rwlock must be initialized but not locked by any thread when
  * cleanup is called. */
 static apr_status_t thread_rwlock_cleanup(void *data)
@@ -28,6 +291,12 @@ static apr_status_t thread_rwlock_cleanup(void *data)
     apr_thread_rwlock_t *rwlock = (apr_thread_rwlock_t *)data;
     apr_status_t stat;
 
+#if APR_HAS_BIGREADER_RWLOCK
+    if (rwlock->slots) {
+        return brlock_cleanup(rwlock);
+    }
+#endif
+
     stat = pthread_rwlock_destroy(&rwlock->rwlock);
 #ifdef HAVE_ZOS_PTHREADS
     if (stat) {
@@ -39,17 +308,32 @@ static apr_status_t thread_rwlock_cleanup(void *data)
 
 APR_DECLARE(apr_status_t) apr_thread_rwlock_create(apr_thread_rwlock_t **rwlock,
                                                    apr_pool_t *pool)
+{
+    return apr_thread_rwlock_create_ex(rwlock, APR_THREAD_RWLOCK_DEFAULT, pool);
+}
+
+APR_DECLARE(apr_status_t) apr_thread_rwlock_create_ex(apr_thread_rwlock_t **rwlock,
+                                                      unsigned int flags,
+                                                      apr_pool_t *pool)
 {
     apr_thread_rwlock_t *new_rwlock;
     apr_status_t stat;
 
-    new_rwlock = apr_palloc(pool, sizeof(apr_thread_rwlock_t));
+    new_rwlock = apr_pcalloc(pool, sizeof(apr_thread_rwlock_t));
     new_rwlock->pool = pool;
 
+#if APR_HAS_BIGREADER_RWLOCK
+    if (flags & APR_THREAD_RWLOCK_BIGREADER) {
+        stat = brlock_init(new_rwlock);
+    }
+    else
+#endif
     if ((stat = pthread_rwlock_init(&new_rwlock->rwlock, NULL))) {
 #ifdef HAVE_ZOS_PTHREADS
         stat = errno;
 #endif
+    }
+    if (stat) {
         return stat;
     }
 
@@ -65,6 +349,12 @@ APR_DECLARE(apr_status_t) apr_thread_rwlock_rdlock(apr_thread_rwlock_t *rwlock)
 {
     apr_status_t stat;
 
+#if APR_HAS_BIGREADER_RWLOCK
+    if (rwlock->slots) {
+        return brlock_rdlock(rwlock);
+    }
+#endif
+
     stat = pthread_rwlock_rdlock(&rwlock->rwlock);
 #ifdef HAVE_ZOS_PTHREADS
     if (stat) {
@@ -78,6 +368,12 @@ APR_DECLARE(apr_status_t) apr_thread_rwlock_tryrdlock(apr_thread_rwlock_t *rwloc
 {
     apr_status_t stat;
 
+#if APR_HAS_BIGREADER_RWLOCK
+    if (rwlock->slots) {
+        return brlock_tryrdlock(rwlock);
+    }
+#endif
+
     stat = pthread_rwlock_tryrdlock(&rwlock->rwlock);
 #ifdef HAVE_ZOS_PTHREADS
     if (stat) {
@@ -94,6 +390,12 @@ APR_DECLARE(apr_status_t) apr_thread_rwlock_wrlock(apr_thread_rwlock_t *rwlock)
 {
     apr_status_t stat;
 
+#if APR_HAS_BIGREADER_RWLOCK
+    if (rwlock->slots) {
+        return brlock_wrlock(rwlock);
+    }
+#endif
+
     stat = pthread_rwlock_wrlock(&rwlock->rwlock);
 #ifdef HAVE_ZOS_PTHREADS
     if (stat) {
@@ -107,6 +409,12 @@ APR_DECLARE(apr_status_t) apr_thread_rwlock_trywrlock(apr_thread_rwlock_t *rwloc
 {
     apr_status_t stat;
 
+#if APR_HAS_BIGREADER_RWLOCK
+    if (rwlock->slots) {
+        return brlock_trywrlock(rwlock);
+    }
+#endif
+
     stat = pthread_rwlock_trywrlock(&rwlock->rwlock);
 #ifdef HAVE_ZOS_PTHREADS
     if (stat) {
@@ -123,6 +431,12 @@ APR_DECLARE(apr_status_t) apr_thread_rwlock_unlock(apr_thread_rwlock_t *rwlock)
 {
     apr_status_t stat;
 
+#if APR_HAS_BIGREADER_RWLOCK
+    if (rwlock->slots) {
+        return brlock_unlock(rwlock);
+    }
+#endif
+
     stat = pthread_rwlock_unlock(&rwlock->rwlock);
 #ifdef HAVE_ZOS_PTHREADS
     if (stat) {
@@ -145,6 +459,13 @@ APR_DECLARE(apr_status_t) apr_thread_rwlock_create(apr_thread_rwlock_t **rwlock,
     return APR_ENOTIMPL;
 }
 
+APR_DECLARE(apr_status_t) apr_thread_rwlock_create_ex(apr_thread_rwlock_t **rwlock,
+                                                      unsigned int flags,
+                                                      apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
 APR_DECLARE(apr_status_t) apr_thread_rwlock_rdlock(apr_thread_rwlock_t *rwlock)
 {
     return APR_ENOTIMPL;
@@ -57,6 +57,14 @@ APR_DECLARE(apr_status_t) apr_thread_mutex_create(apr_thread_mutex_t **mutex,
         (*mutex)->type = thread_mutex_nested_mutex;
         (*mutex)->handle = CreateMutex(NULL, FALSE, NULL);
     }
+    else if (flags & APR_THREAD_MUTEX_ADAPTIVE) {
+        /* Critical Sections spin before waiting on their event when
+         * given a spin count (ignored on uniprocessors).
+         */
+        InitializeCriticalSectionAndSpinCount(&(*mutex)->section, 4000);
+        (*mutex)->type = thread_mutex_critical_section;
+        (*mutex)->handle = NULL;
+    }
     else {
         /* Critical Sections are terrific, performance-wise, on NT.
          */
@@ -47,6 +47,22 @@
 
 #if APR_HAS_MMAP || defined(BEOS)
 
+#ifndef BEOS
+static long psize;
+
+static long mmap_pagesize(void)
+{
+#if defined(_SC_PAGESIZE)
+    if (psize == 0) {
+        psize = sysconf(_SC_PAGESIZE);
+        /* the page size should be a power of two */
+        assert(psize > 0 && (psize & (psize - 1)) == 0);
+    }
+#endif
+    return psize;
+}
+#endif
+
 static apr_status_t mmap_cleanup(void *themmap)
 {
     apr_mmap_t *mm = themmap;
@@ -86,9 +102,9 @@ APR_DECLARE(apr_status_t) apr_mmap_create(apr_mmap_t **new,
     area_id aid = -1;
     uint32 pages = 0;
 #else
-    static long psize;
     apr_off_t poffset = 0;
     apr_int32_t native_flags = 0;
+    int map_flags = MAP_SHARED;
 #endif
 
 #if APR_HAS_LARGE_FILES && defined(HAVE_MMAP64)
@@ -137,18 +153,19 @@ APR_DECLARE(apr_status_t) apr_mmap_create(apr_mmap_t **new,
         native_flags |= PROT_READ;
     }
 
-#if defined(_SC_PAGESIZE)
-    if (psize == 0) {
-        psize = sysconf(_SC_PAGESIZE);
-        /* the page size should be a power of two */
-        assert(psize > 0 && (psize & (psize - 1)) == 0);
+#ifdef MAP_POPULATE
+    if (flag & APR_MMAP_POPULATE) {
+        map_flags |= MAP_POPULATE;
     }
-    poffset = offset & (apr_off_t)(psize - 1);
-    (*new)->poffset = poffset;
 #endif
 
+    if (mmap_pagesize()) {
+        poffset = offset & (apr_off_t)(psize - 1);
+        (*new)->poffset = poffset;
+    }
+
     mm = mmap(NULL, size + poffset,
-              native_flags, MAP_SHARED,
+              native_flags, map_flags,
               file->filedes, offset - poffset);
 
     if (mm == (void *)-1) {
@@ -157,6 +174,12 @@ APR_DECLARE(apr_status_t) apr_mmap_create(apr_mmap_t **new,
         return errno;
     }
 
+#if !defined(MAP_POPULATE) && defined(HAVE_MADVISE) && defined(MADV_WILLNEED)
+    if (flag & APR_MMAP_POPULATE) {
+        madvise(mm, size + poffset, MADV_WILLNEED);
+    }
+#endif
+
     mm = (char *)mm + poffset;
 #endif
 
@@ -190,4 +213,64 @@ APR_DECLARE(apr_status_t) apr_mmap_delete(apr_mmap_t *mm)
     return apr_pool_cleanup_run(mm->cntxt, mm, mmap_cleanup);
 }
 
+APR_DECLARE(apr_status_t) apr_mmap_advise(apr_mmap_t *mm, apr_off_t offset,
+                                          apr_size_t len, apr_int32_t advice)
+{
+#if !defined(BEOS) && defined(HAVE_MADVISE)
+    long pagesize = mmap_pagesize();
+    int native_advice;
+    char *addr, *start;
+
+    if (offset < 0 || (apr_size_t)offset > mm->size) {
+        return APR_EINVAL;
+    }
+    if (len > mm->size - (apr_size_t)offset) {
+        len = mm->size - (apr_size_t)offset;
+    }
+
+    switch (advice) {
+    case APR_MMAP_ADVISE_NORMAL:
+        native_advice = MADV_NORMAL;
+        break;
+    case APR_MMAP_ADVISE_SEQUENTIAL:
+        native_advice = MADV_SEQUENTIAL;
+        break;
+    case APR_MMAP_ADVISE_RANDOM:
+        native_advice = MADV_RANDOM;
+        break;
+    case APR_MMAP_ADVISE_WILLNEED:
+        native_advice = MADV_WILLNEED;
+        break;
+    case APR_MMAP_ADVISE_DONTNEED:
+        native_advice = MADV_DONTNEED;
+        break;
+#ifdef MADV_HUGEPAGE
+    case APR_MMAP_ADVISE_HUGEPAGE:
+        native_advice = MADV_HUGEPAGE;
+        break;
+#endif
+    default:
+        return APR_ENOTIMPL;
+    }
+
+    if (len == 0) {
+        return APR_SUCCESS;
+    }
+
+    /* madvise() wants a page aligned address, the mapping starts at one
+     * before poffset */
+    addr = (char *)mm->mm + offset;
+    start = addr;
+    if (pagesize) {
+        start -= (apr_uintptr_t)addr & (apr_uintptr_t)(pagesize - 1);
+    }
+    if (madvise(start, len + (addr - start), native_advice) == -1) {
+        return errno;
+    }
+    return APR_SUCCESS;
+#else
+    return APR_ENOTIMPL;
+#endif
+}
+
 #endif
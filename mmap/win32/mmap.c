@@ -161,4 +161,13 @@ APR_DECLARE(apr_status_t) apr_mmap_delete(apr_mmap_t *mm)
     return apr_pool_cleanup_run(mm->cntxt, mm, mmap_cleanup);
 }
 
+APR_DECLARE(apr_status_t) apr_mmap_advise(apr_mmap_t *mm, apr_off_t offset,
+                                          apr_size_t len, apr_int32_t advice)
+{
+    if (offset < 0 || (apr_size_t)offset > mm->size) {
+        return APR_EINVAL;
+    }
+    return APR_ENOTIMPL;
+}
+
 #endif
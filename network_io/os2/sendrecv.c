@@ -103,6 +103,15 @@ APR_DECLARE(apr_status_t) apr_socket_recv(apr_socket_t *sock, char *buf,
     return rv == 0 ? APR_EOF : APR_SUCCESS;
 }
 
+/* No readv for sockets, fill the first buffer only */
+APR_DECLARE(apr_status_t) apr_socket_recvv(apr_socket_t *sock,
+                                           struct iovec *vec,
+                                           apr_int32_t nvec, apr_size_t *len)
+{
+    *len = vec[0].iov_len;
+    return apr_socket_recv(sock, vec[0].iov_base, len);
+}
+
 
 
 APR_DECLARE(apr_status_t) apr_socket_sendv(apr_socket_t *sock, 
@@ -171,3 +180,40 @@ APR_DECLARE(apr_status_t) apr_socket_wait(apr_socket_t *sock, apr_wait_type_t di
 
     return APR_SUCCESS;
 }
+
+APR_DECLARE(apr_status_t) apr_socket_splice(apr_socket_t *to,
+                                            apr_socket_t *from,
+                                            apr_size_t *len)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_socket_splice_file(apr_socket_t *to,
+                                                 apr_file_t *from,
+                                                 apr_size_t *len)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_socket_sendv_zerocopy(
+                                             apr_socket_t *sock,
+                                             const struct iovec *vec,
+                                             apr_int32_t nvec,
+                                             apr_size_t *len,
+                                             apr_socket_zerocopy_fn_t *done,
+                                             void *ctx)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_socket_zerocopy_reap(apr_socket_t *sock,
+                                                   apr_size_t *pending)
+{
+    if (pending) {
+        *pending = 0;
+    }
+    return APR_ENOTIMPL;
+}
@@ -17,10 +17,14 @@
 #include "apr_arch_networkio.h"
 #include "apr_support.h"
 
-#if APR_HAS_SENDFILE
+#if APR_HAS_SENDFILE || defined(HAVE_SPLICE)
 /* This file is needed to allow us access to the apr_file_t internals. */
 #include "apr_arch_file_io.h"
-#endif /* APR_HAS_SENDFILE */
+#endif /* APR_HAS_SENDFILE || HAVE_SPLICE */
+
+#ifdef HAVE_SPLICE
+#include <fcntl.h>
+#endif
 
 /* osreldate.h is only needed on FreeBSD for sendfile detection */
 #if defined(__FreeBSD__)
@@ -191,6 +195,238 @@ apr_status_t apr_socket_recvfrom(apr_sockaddr_t *from, apr_socket_t *sock,
     return APR_SUCCESS;
 }
 
+#if defined(HAVE_SENDMMSG) && defined(HAVE_RECVMMSG)
+
+/* How many datagrams go in one system call */
+#define MMSG_BATCH 64
+
+apr_status_t apr_socket_sendmmsg(apr_socket_t *sock, apr_socket_msg_t *msgs,
+                                 apr_size_t nmsgs, apr_int32_t flags,
+                                 apr_size_t *nsent)
+{
+    struct mmsghdr hdrs[MMSG_BATCH];
+    struct iovec iovs[MMSG_BATCH];
+    apr_size_t done = 0;
+
+    while (done < nmsgs) {
+        unsigned int i, n;
+        int rv;
+
+        n = nmsgs - done < MMSG_BATCH ? nmsgs - done : MMSG_BATCH;
+        memset(hdrs, 0, n * sizeof(hdrs[0]));
+        for (i = 0; i < n; i++) {
+            apr_socket_msg_t *msg = &msgs[done + i];
+
+            iovs[i].iov_base = msg->buf;
+            iovs[i].iov_len = msg->len;
+            hdrs[i].msg_hdr.msg_iov = &iovs[i];
+            hdrs[i].msg_hdr.msg_iovlen = 1;
+            if (msg->addr) {
+                hdrs[i].msg_hdr.msg_name = &msg->addr->sa;
+                hdrs[i].msg_hdr.msg_namelen = msg->addr->salen;
+            }
+        }
+
+        do {
+            rv = sendmmsg(sock->socketdes, hdrs, n, flags);
+        } while (rv == -1 && errno == EINTR);
+
+        if (rv == -1) {
+            apr_status_t arv;
+
+            if (done) {
+                /* The error is for the next call */
+                break;
+            }
+            if ((errno != EAGAIN && errno != EWOULDBLOCK)
+                    || sock->timeout <= 0) {
+                *nsent = 0;
+                return errno;
+            }
+            arv = apr_wait_for_io_or_timeout(NULL, sock, 0);
+            if (arv != APR_SUCCESS) {
+                *nsent = 0;
+                return arv;
+            }
+            continue;
+        }
+
+        for (i = 0; i < (unsigned int)rv; i++) {
+            msgs[done + i].len = hdrs[i].msg_len;
+        }
+        done += rv;
+        if ((unsigned int)rv < n) {
+            break;
+        }
+    }
+
+    *nsent = done;
+    return APR_SUCCESS;
+}
+
+apr_status_t apr_socket_recvmmsg(apr_socket_t *sock, apr_socket_msg_t *msgs,
+                                 apr_size_t nmsgs, apr_int32_t flags,
+                                 apr_size_t *nrecv)
+{
+    struct mmsghdr hdrs[MMSG_BATCH];
+    struct iovec iovs[MMSG_BATCH];
+#ifdef UDP_GRO
+    char ctrl[MMSG_BATCH][CMSG_SPACE(sizeof(int))];
+    int gro = apr_is_option_set(sock, APR_UDP_GRO);
+#endif
+    apr_size_t done = 0;
+
+    while (done < nmsgs) {
+        unsigned int i, n;
+        int rv;
+
+        n = nmsgs - done < MMSG_BATCH ? nmsgs - done : MMSG_BATCH;
+        memset(hdrs, 0, n * sizeof(hdrs[0]));
+        for (i = 0; i < n; i++) {
+            apr_socket_msg_t *msg = &msgs[done + i];
+
+            iovs[i].iov_base = msg->buf;
+            iovs[i].iov_len = msg->len;
+            hdrs[i].msg_hdr.msg_iov = &iovs[i];
+            hdrs[i].msg_hdr.msg_iovlen = 1;
+            if (msg->addr) {
+                hdrs[i].msg_hdr.msg_name = &msg->addr->sa;
+                hdrs[i].msg_hdr.msg_namelen = sizeof(msg->addr->sa);
+            }
+#ifdef UDP_GRO
+            if (gro) {
+                hdrs[i].msg_hdr.msg_control = ctrl[i];
+                hdrs[i].msg_hdr.msg_controllen = sizeof(ctrl[i]);
+            }
+#endif
+        }
+
+        /* Only wait for the first datagram */
+        do {
+            rv = recvmmsg(sock->socketdes, hdrs, n,
+                          flags | (done ? MSG_DONTWAIT : MSG_WAITFORONE),
+                          NULL);
+        } while (rv == -1 && errno == EINTR);
+
+        if (rv == -1) {
+            apr_status_t arv;
+
+            if (done) {
+                break;
+            }
+            if ((errno != EAGAIN && errno != EWOULDBLOCK)
+                    || sock->timeout <= 0) {
+                *nrecv = 0;
+                return errno;
+            }
+            arv = apr_wait_for_io_or_timeout(NULL, sock, 1);
+            if (arv != APR_SUCCESS) {
+                *nrecv = 0;
+                return arv;
+            }
+            continue;
+        }
+
+        for (i = 0; i < (unsigned int)rv; i++) {
+            apr_socket_msg_t *msg = &msgs[done + i];
+#ifdef UDP_GRO
+            struct cmsghdr *cmsg;
+#endif
+
+            msg->len = hdrs[i].msg_len;
+            msg->segment_size = 0;
+            if (msg->addr) {
+                msg->addr->salen = hdrs[i].msg_hdr.msg_namelen;
+                if (msg->addr->salen
+                        > APR_OFFSETOF(struct sockaddr_in, sin_port)) {
+                    apr_sockaddr_vars_set(msg->addr,
+                                          msg->addr->sa.sin.sin_family,
+                                          ntohs(msg->addr->sa.sin.sin_port));
+                }
+            }
+#ifdef UDP_GRO
+            if (!gro) {
+                continue;
+            }
+            for (cmsg = CMSG_FIRSTHDR(&hdrs[i].msg_hdr); cmsg;
+                 cmsg = CMSG_NXTHDR(&hdrs[i].msg_hdr, cmsg)) {
+                if (cmsg->cmsg_level == SOL_UDP
+                        && cmsg->cmsg_type == UDP_GRO) {
+                    int size;
+
+                    memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+                    msg->segment_size = size;
+                }
+            }
+#endif
+        }
+        done += rv;
+        if ((unsigned int)rv < n) {
+            break;
+        }
+    }
+
+    *nrecv = done;
+    return APR_SUCCESS;
+}
+
+#endif /* HAVE_SENDMMSG && HAVE_RECVMMSG */
+
+apr_status_t apr_socket_recvv(apr_socket_t *sock, struct iovec *vec,
+                              apr_int32_t nvec, apr_size_t *len)
+{
+#ifdef HAVE_READV
+    apr_ssize_t rv;
+    apr_status_t arv;
+    apr_size_t total = 0;
+    apr_int32_t i;
+
+    if (sock->options & APR_INCOMPLETE_READ) {
+        sock->options &= ~APR_INCOMPLETE_READ;
+        goto do_select;
+    }
+
+    do {
+        rv = readv(sock->socketdes, vec, nvec);
+    } while (rv == -1 && errno == EINTR);
+
+    while ((rv == -1) && (errno == EAGAIN || errno == EWOULDBLOCK)
+                      && (sock->timeout > 0)) {
+do_select:
+        arv = apr_wait_for_io_or_timeout(NULL, sock, 1);
+        if (arv != APR_SUCCESS) {
+            *len = 0;
+            return arv;
+        }
+        else {
+            do {
+                rv = readv(sock->socketdes, vec, nvec);
+            } while (rv == -1 && errno == EINTR);
+        }
+    }
+    if (rv == -1) {
+        (*len) = 0;
+        return errno;
+    }
+    if (sock->timeout > 0) {
+        for (i = 0; i < nvec; ++i) {
+            total += vec[i].iov_len;
+        }
+        if ((apr_size_t)rv < total) {
+            sock->options |= APR_INCOMPLETE_READ;
+        }
+    }
+    (*len) = rv;
+    if (rv == 0) {
+        return APR_EOF;
+    }
+    return APR_SUCCESS;
+#else
+    *len = vec[0].iov_len;
+    return apr_socket_recv(sock, vec[0].iov_base, len);
+#endif
+}
+
 apr_status_t apr_socket_sendv(apr_socket_t * sock, const struct iovec *vec,
                               apr_int32_t nvec, apr_size_t *len)
 {
@@ -1122,3 +1358,330 @@ apr_status_t apr_socket_sendfile(apr_socket_t *sock, apr_file_t *file,
 	  Tru64/OSF1 */
 
 #endif /* APR_HAS_SENDFILE */
+
+#ifdef HAVE_SPLICE
+
+/* What a pipe holds by default */
+#define SPLICE_MAX (64 * 1024)
+
+/* Send the data pending in the pipe of the socket */
+static apr_status_t splice_drain(apr_socket_t *to, apr_size_t *len)
+{
+    while (to->splice_pending) {
+        apr_ssize_t rv;
+
+        do {
+            rv = splice(to->splice_pipe[0], NULL, to->socketdes, NULL,
+                        to->splice_pending,
+                        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        } while (rv == -1 && errno == EINTR);
+
+        if (rv == -1) {
+            apr_status_t arv;
+
+            if ((errno != EAGAIN && errno != EWOULDBLOCK)
+                    || to->timeout == 0) {
+                return errno;
+            }
+            arv = apr_wait_for_io_or_timeout(NULL, to, 0);
+            if (arv != APR_SUCCESS) {
+                return arv;
+            }
+            continue;
+        }
+        to->splice_pending -= rv;
+        *len += rv;
+    }
+    return APR_SUCCESS;
+}
+
+/* Receive up to max bytes from fd into the (empty) pipe of the socket,
+ * waiting according to the timeout of the source */
+static apr_status_t splice_fill(apr_socket_t *to, int fd,
+                                apr_socket_t *sock, apr_file_t *file,
+                                apr_interval_time_t timeout, apr_size_t max)
+{
+    apr_ssize_t rv;
+
+    if (to->splice_pipe[0] == -1) {
+#ifdef HAVE_PIPE2
+        if (pipe2(to->splice_pipe, O_CLOEXEC) == -1) {
+            return errno;
+        }
+#else
+        if (pipe(to->splice_pipe) == -1) {
+            return errno;
+        }
+        fcntl(to->splice_pipe[0], F_SETFD, FD_CLOEXEC);
+        fcntl(to->splice_pipe[1], F_SETFD, FD_CLOEXEC);
+#endif
+    }
+
+    for (;;) {
+        do {
+            rv = splice(fd, NULL, to->splice_pipe[1], NULL, max,
+                        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        } while (rv == -1 && errno == EINTR);
+
+        if (rv > 0) {
+            to->splice_pending = rv;
+            return APR_SUCCESS;
+        }
+        if (rv == 0) {
+            return APR_EOF;
+        }
+        if (errno == EINVAL || errno == ENOSYS) {
+            /* The descriptors don't support splicing */
+            return APR_ENOTIMPL;
+        }
+        if ((errno != EAGAIN && errno != EWOULDBLOCK) || timeout == 0) {
+            return errno;
+        }
+        /* The pipe being empty, the source has nothing to read */
+        rv = apr_wait_for_io_or_timeout(file, sock, 1);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+    }
+}
+
+static apr_status_t socket_splice(apr_socket_t *to, int fd,
+                                  apr_socket_t *sock, apr_file_t *file,
+                                  apr_interval_time_t timeout,
+                                  apr_size_t *len)
+{
+    apr_size_t max = *len ? *len : SPLICE_MAX;
+    apr_status_t rv;
+
+    *len = 0;
+    rv = splice_drain(to, len);
+    if (rv != APR_SUCCESS || fd == -1) {
+        return rv;
+    }
+    rv = splice_fill(to, fd, sock, file, timeout, max);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    return splice_drain(to, len);
+}
+
+apr_status_t apr_socket_splice(apr_socket_t *to, apr_socket_t *from,
+                               apr_size_t *len)
+{
+    if (!from) {
+        return socket_splice(to, -1, NULL, NULL, 0, len);
+    }
+    return socket_splice(to, from->socketdes, from, NULL, from->timeout,
+                         len);
+}
+
+apr_status_t apr_socket_splice_file(apr_socket_t *to, apr_file_t *from,
+                                    apr_size_t *len)
+{
+    if (from->buffered) {
+        /* The buffered data would come after the spliced one */
+        *len = 0;
+        return APR_ENOTIMPL;
+    }
+    return socket_splice(to, from->filedes, NULL, from, from->timeout, len);
+}
+
+#else /* !HAVE_SPLICE */
+
+apr_status_t apr_socket_splice(apr_socket_t *to, apr_socket_t *from,
+                               apr_size_t *len)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+apr_status_t apr_socket_splice_file(apr_socket_t *to, apr_file_t *from,
+                                    apr_size_t *len)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+#endif /* HAVE_SPLICE */
+
+#ifdef HAVE_ZEROCOPY
+
+/* A zero-copy send waiting for the kernel to be done with its data */
+struct zerocopy_send_t {
+    struct zerocopy_send_t *next;
+    apr_uint32_t id;
+    apr_socket_zerocopy_fn_t *done;
+    void *ctx;
+};
+
+apr_status_t apr_socket_sendv_zerocopy(apr_socket_t *sock,
+                                       const struct iovec *vec,
+                                       apr_int32_t nvec, apr_size_t *len,
+                                       apr_socket_zerocopy_fn_t *done,
+                                       void *ctx)
+{
+    struct zerocopy_send_t *zs;
+    struct msghdr msg;
+    apr_ssize_t rv;
+
+    *len = 0;
+    if (!apr_is_option_set(sock, APR_SO_ZEROCOPY)) {
+        return APR_ENOTIMPL;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = (struct iovec *)vec;
+    msg.msg_iovlen = nvec;
+
+    do {
+        rv = sendmsg(sock->socketdes, &msg, MSG_ZEROCOPY);
+    } while (rv == -1 && errno == EINTR);
+
+    while ((rv == -1) && (errno == EAGAIN || errno == EWOULDBLOCK)
+                      && (sock->timeout > 0)) {
+        apr_status_t arv = apr_wait_for_io_or_timeout(NULL, sock, 0);
+        if (arv != APR_SUCCESS) {
+            return arv;
+        }
+        do {
+            rv = sendmsg(sock->socketdes, &msg, MSG_ZEROCOPY);
+        } while (rv == -1 && errno == EINTR);
+    }
+    if (rv == -1) {
+        return errno;
+    }
+    if (rv == 0) {
+        /* Nothing to complete */
+        return APR_SUCCESS;
+    }
+
+    /* Each send which went through takes the next id */
+    if (sock->zerocopy_free) {
+        zs = sock->zerocopy_free;
+        sock->zerocopy_free = zs->next;
+    }
+    else {
+        zs = apr_palloc(sock->pool, sizeof(*zs));
+    }
+    zs->next = NULL;
+    zs->id = sock->zerocopy_next++;
+    zs->done = done;
+    zs->ctx = ctx;
+    if (!sock->zerocopy_sends) {
+        sock->zerocopy_last = &sock->zerocopy_sends;
+    }
+    *sock->zerocopy_last = zs;
+    sock->zerocopy_last = &zs->next;
+    sock->zerocopy_pending++;
+
+    *len = rv;
+    return APR_SUCCESS;
+}
+
+/* Call the callbacks of the sends lo to hi (wrapping), in order */
+static void zerocopy_complete(apr_socket_t *sock, apr_uint32_t lo,
+                              apr_uint32_t hi, int copied)
+{
+    struct zerocopy_send_t **zp = &sock->zerocopy_sends, *zs;
+    struct zerocopy_send_t *completed = NULL, **last = &completed;
+
+    /* Unlinked first, so that the callbacks may send again */
+    while ((zs = *zp)) {
+        if ((apr_uint32_t)(zs->id - lo) <= (apr_uint32_t)(hi - lo)) {
+            *zp = zs->next;
+            zs->next = NULL;
+            *last = zs;
+            last = &zs->next;
+            sock->zerocopy_pending--;
+        }
+        else {
+            zp = &zs->next;
+        }
+    }
+    sock->zerocopy_last = zp;
+
+    while ((zs = completed)) {
+        apr_socket_zerocopy_fn_t *done = zs->done;
+        void *ctx = zs->ctx;
+
+        completed = zs->next;
+        zs->next = sock->zerocopy_free;
+        sock->zerocopy_free = zs;
+        done(ctx, copied);
+    }
+}
+
+apr_status_t apr_socket_zerocopy_reap(apr_socket_t *sock, apr_size_t *pending)
+{
+    apr_status_t status = APR_SUCCESS;
+
+    while (sock->zerocopy_pending) {
+        char control[128];
+        struct msghdr msg;
+        struct cmsghdr *cmsg;
+        apr_ssize_t rv;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        do {
+            rv = recvmsg(sock->socketdes, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+        } while (rv == -1 && errno == EINTR);
+
+        if (rv == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                status = errno;
+            }
+            break;
+        }
+
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            struct sock_extended_err serr;
+
+            if (!(cmsg->cmsg_level == SOL_IP
+                  && cmsg->cmsg_type == IP_RECVERR)
+#if APR_HAVE_IPV6 && defined(IPV6_RECVERR)
+                && !(cmsg->cmsg_level == SOL_IPV6
+                     && cmsg->cmsg_type == IPV6_RECVERR)
+#endif
+                ) {
+                continue;
+            }
+            memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+            if (serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                status = serr.ee_errno;
+                continue;
+            }
+            zerocopy_complete(sock, serr.ee_info, serr.ee_data,
+                              serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED);
+        }
+    }
+
+    if (pending) {
+        *pending = sock->zerocopy_pending;
+    }
+    return status;
+}
+
+#else /* !HAVE_ZEROCOPY */
+
+apr_status_t apr_socket_sendv_zerocopy(apr_socket_t *sock,
+                                       const struct iovec *vec,
+                                       apr_int32_t nvec, apr_size_t *len,
+                                       apr_socket_zerocopy_fn_t *done,
+                                       void *ctx)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+apr_status_t apr_socket_zerocopy_reap(apr_socket_t *sock, apr_size_t *pending)
+{
+    if (pending) {
+        *pending = 0;
+    }
+    return APR_ENOTIMPL;
+}
+
+#endif /* HAVE_ZEROCOPY */
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "apr_private.h"
 #include "apr_network_io.h"
 #include "apr_poll.h"
 
@@ -73,3 +74,77 @@ APR_DECLARE(apr_status_t) apr_socket_atreadeof(apr_socket_t *sock, int *atreadeo
     return APR_EGENERAL;
 }
 
+
+#if !defined(HAVE_SENDMMSG) || !defined(HAVE_RECVMMSG)
+
+APR_DECLARE(apr_status_t) apr_socket_sendmmsg(apr_socket_t *sock,
+                                              apr_socket_msg_t *msgs,
+                                              apr_size_t nmsgs,
+                                              apr_int32_t flags,
+                                              apr_size_t *nsent)
+{
+    apr_size_t i;
+    apr_status_t rv = APR_SUCCESS;
+
+    for (i = 0; i < nmsgs; i++) {
+        apr_socket_msg_t *msg = &msgs[i];
+
+        if (msg->addr) {
+            rv = apr_socket_sendto(sock, msg->addr, flags, msg->buf,
+                                   &msg->len);
+        }
+        else {
+            rv = apr_socket_send(sock, msg->buf, &msg->len);
+        }
+        if (rv != APR_SUCCESS) {
+            break;
+        }
+    }
+
+    *nsent = i;
+    /* The datagrams sent so far are reported, the error is for the next
+     * call */
+    return i ? APR_SUCCESS : rv;
+}
+
+APR_DECLARE(apr_status_t) apr_socket_recvmmsg(apr_socket_t *sock,
+                                              apr_socket_msg_t *msgs,
+                                              apr_size_t nmsgs,
+                                              apr_int32_t flags,
+                                              apr_size_t *nrecv)
+{
+    apr_size_t i;
+    apr_status_t rv = APR_SUCCESS;
+
+    for (i = 0; i < nmsgs; i++) {
+        apr_socket_msg_t *msg = &msgs[i];
+        apr_sockaddr_t unused, *from = msg->addr ? msg->addr : &unused;
+
+        if (i) {
+            /* Only wait for the first datagram */
+            apr_pollfd_t pfd;
+            apr_int32_t nfds;
+
+            pfd.reqevents = APR_POLLIN;
+            pfd.desc_type = APR_POLL_SOCKET;
+            pfd.desc.s = sock;
+            do {
+                rv = apr_poll(&pfd, 1, &nfds, 0);
+            } while (APR_STATUS_IS_EINTR(rv));
+            if (rv != APR_SUCCESS) {
+                break;
+            }
+        }
+
+        rv = apr_socket_recvfrom(from, sock, flags, msg->buf, &msg->len);
+        if (rv != APR_SUCCESS) {
+            break;
+        }
+        msg->segment_size = 0;
+    }
+
+    *nrecv = i;
+    return i ? APR_SUCCESS : rv;
+}
+
+#endif /* !HAVE_SENDMMSG || !HAVE_RECVMMSG */
@@ -35,11 +35,25 @@
 /* big enough for IPv4, IPv6 and optionally sun_path */
 static char generic_inaddr_any[GENERIC_INADDR_ANY_LEN] = {0};
 
+static void splice_pipe_close(apr_socket_t *sock)
+{
+#ifdef HAVE_SPLICE
+    if (sock->splice_pipe[0] != -1) {
+        close(sock->splice_pipe[0]);
+        close(sock->splice_pipe[1]);
+        sock->splice_pipe[0] = sock->splice_pipe[1] = -1;
+        sock->splice_pending = 0;
+    }
+#endif
+}
+
 static apr_status_t socket_cleanup(void *sock)
 {
     apr_socket_t *thesocket = sock;
     int sd = thesocket->socketdes;
 
+    splice_pipe_close(thesocket);
+
     /* Set socket descriptor to -1 before close(), so that there is no
      * chance of returning an already closed FD from apr_os_sock_get().
      */
@@ -65,6 +79,8 @@ static apr_status_t socket_cleanup(void *sock)
 static apr_status_t socket_child_cleanup(void *sock)
 {
     apr_socket_t *thesocket = sock;
+
+    splice_pipe_close(thesocket);
     if (close(thesocket->socketdes) == 0) {
         thesocket->socketdes = -1;
         return APR_SUCCESS;
@@ -100,6 +116,9 @@ static void alloc_socket(apr_socket_t **new, apr_pool_t *p)
                                                         sizeof(apr_sockaddr_t));
     (*new)->remote_addr->pool = p;
     (*new)->remote_addr_unknown = 1;
+#ifdef HAVE_SPLICE
+    (*new)->splice_pipe[0] = (*new)->splice_pipe[1] = -1;
+#endif
 #ifndef WAITIO_USES_POLL
     /* Create a pollset with room for one descriptor. */
     /* ### check return codes */
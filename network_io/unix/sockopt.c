@@ -342,6 +342,39 @@ apr_status_t apr_socket_opt_set(apr_socket_t *sock,
          * options, IP_BINDANY vs IPV6_BINDANY */
 #else
         return APR_ENOTIMPL;
+#endif
+        break;
+    case APR_UDP_SEGMENT:
+#if defined(UDP_SEGMENT)
+        if (setsockopt(sock->socketdes, SOL_UDP, UDP_SEGMENT,
+                       (void *)&on, sizeof(int)) == -1) {
+            return errno;
+        }
+        apr_set_option(sock, APR_UDP_SEGMENT, on);
+#else
+        return APR_ENOTIMPL;
+#endif
+        break;
+    case APR_UDP_GRO:
+#if defined(UDP_GRO)
+        if (setsockopt(sock->socketdes, SOL_UDP, UDP_GRO,
+                       (void *)&one, sizeof(int)) == -1) {
+            return errno;
+        }
+        apr_set_option(sock, APR_UDP_GRO, on);
+#else
+        return APR_ENOTIMPL;
+#endif
+        break;
+    case APR_SO_ZEROCOPY:
+#ifdef HAVE_ZEROCOPY
+        if (setsockopt(sock->socketdes, SOL_SOCKET, SO_ZEROCOPY,
+                       (void *)&one, sizeof(int)) == -1) {
+            return errno;
+        }
+        apr_set_option(sock, APR_SO_ZEROCOPY, on);
+#else
+        return APR_ENOTIMPL;
 #endif
         break;
     default:
@@ -459,3 +492,106 @@ APR_PERMS_SET_IMPLEMENT(socket)
     return APR_ENOTIMPL;
 #endif
 }
+
+#ifdef HAVE_KTLS
+
+/* Fill the crypto info of the kernel for the cipher C */
+#define KTLS_CRYPTO_INFO(ci, C, params, version) do {                       \
+    (ci).info.version = (version);                                          \
+    (ci).info.cipher_type = TLS_CIPHER_##C;                                 \
+    memcpy((ci).salt, (params)->iv, TLS_CIPHER_##C##_SALT_SIZE);            \
+    memcpy((ci).iv, (params)->iv + TLS_CIPHER_##C##_SALT_SIZE,              \
+           TLS_CIPHER_##C##_IV_SIZE);                                       \
+    memcpy((ci).key, (params)->key, TLS_CIPHER_##C##_KEY_SIZE);             \
+    if ((params)->rec_seq) {                                                \
+        memcpy((ci).rec_seq, (params)->rec_seq,                             \
+               TLS_CIPHER_##C##_REC_SEQ_SIZE);                              \
+    }                                                                       \
+} while (0)
+
+apr_status_t apr_socket_ktls_enable(apr_socket_t *sock, int direction,
+                                    const apr_socket_ktls_params_t *params)
+{
+    union {
+        struct tls12_crypto_info_aes_gcm_128 aes_gcm_128;
+        struct tls12_crypto_info_aes_gcm_256 aes_gcm_256;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        struct tls12_crypto_info_chacha20_poly1305 chacha20_poly1305;
+#endif
+    } ci;
+    apr_status_t rv = APR_SUCCESS;
+    socklen_t len;
+    int version;
+
+    if (direction != APR_SOCKET_KTLS_TX && direction != APR_SOCKET_KTLS_RX) {
+        return APR_EINVAL;
+    }
+    if (params->version == APR_SOCKET_KTLS_TLS12) {
+        version = TLS_1_2_VERSION;
+    }
+    else if (params->version == APR_SOCKET_KTLS_TLS13) {
+        version = TLS_1_3_VERSION;
+    }
+    else {
+        return APR_EINVAL;
+    }
+
+    memset(&ci, 0, sizeof(ci));
+    switch (params->cipher) {
+    case APR_SOCKET_KTLS_AES_GCM_128:
+        if (params->key_len != TLS_CIPHER_AES_GCM_128_KEY_SIZE) {
+            return APR_EINVAL;
+        }
+        KTLS_CRYPTO_INFO(ci.aes_gcm_128, AES_GCM_128, params, version);
+        len = sizeof(ci.aes_gcm_128);
+        break;
+    case APR_SOCKET_KTLS_AES_GCM_256:
+        if (params->key_len != TLS_CIPHER_AES_GCM_256_KEY_SIZE) {
+            return APR_EINVAL;
+        }
+        KTLS_CRYPTO_INFO(ci.aes_gcm_256, AES_GCM_256, params, version);
+        len = sizeof(ci.aes_gcm_256);
+        break;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+    case APR_SOCKET_KTLS_CHACHA20_POLY1305:
+        if (params->key_len != TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE) {
+            return APR_EINVAL;
+        }
+        KTLS_CRYPTO_INFO(ci.chacha20_poly1305, CHACHA20_POLY1305, params,
+                         version);
+        len = sizeof(ci.chacha20_poly1305);
+        break;
+#endif
+    default:
+        return APR_ENOTIMPL;
+    }
+
+    /* Attach the TLS layer, which the other direction may have done */
+    if (setsockopt(sock->socketdes, SOL_TCP, TCP_ULP, "tls",
+                   sizeof("tls")) == -1 && errno != EEXIST) {
+        rv = errno;
+        if (rv == ENOENT || rv == ENOPROTOOPT) {
+            /* The tls module is not there */
+            rv = APR_ENOTIMPL;
+        }
+    }
+    else if (setsockopt(sock->socketdes, SOL_TLS,
+                        direction == APR_SOCKET_KTLS_TX ? TLS_TX : TLS_RX,
+                        &ci, len) == -1) {
+        rv = errno;
+    }
+
+    /* Don't leave the key material on the stack */
+    apr_memzero_explicit(&ci, sizeof(ci));
+    return rv;
+}
+
+#else /* !HAVE_KTLS */
+
+apr_status_t apr_socket_ktls_enable(apr_socket_t *sock, int direction,
+                                    const apr_socket_ktls_params_t *params)
+{
+    return APR_ENOTIMPL;
+}
+
+#endif /* HAVE_KTLS */
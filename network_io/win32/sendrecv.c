@@ -87,6 +87,48 @@ APR_DECLARE(apr_status_t) apr_socket_recv(apr_socket_t *sock, char *buf,
 }
 
 
+APR_DECLARE(apr_status_t) apr_socket_recvv(apr_socket_t *sock,
+                                           struct iovec *vec,
+                                           apr_int32_t in_vec, apr_size_t *len)
+{
+    apr_ssize_t rv;
+    WSABUF *pWsaBuf;
+    int lasterror;
+    DWORD dwBytes = 0;
+    DWORD flags = 0;
+    apr_int32_t i, nvec;
+
+    /* The buffers larger than a DWORD are truncated, and it would take
+     * more than 4GB to fill them anyway */
+    nvec = (in_vec <= WSABUF_ON_HEAP) ? in_vec : WSABUF_ON_HEAP;
+    pWsaBuf = (nvec <= WSABUF_ON_STACK) ? _alloca(sizeof(WSABUF) * (nvec))
+                                        : malloc(sizeof(WSABUF) * (nvec));
+    if (!pWsaBuf)
+        return APR_ENOMEM;
+
+    for (i = 0; i < nvec; i++) {
+        pWsaBuf[i].buf = vec[i].iov_base;
+        pWsaBuf[i].len = (vec[i].iov_len > APR_DWORD_MAX) ? APR_DWORD_MAX
+                                                          : (DWORD)vec[i].iov_len;
+    }
+
+    rv = WSARecv(sock->socketdes, pWsaBuf, nvec, &dwBytes, &flags,
+                 NULL, NULL);
+    lasterror = (rv == SOCKET_ERROR) ? apr_get_netos_error() : APR_SUCCESS;
+
+    if (nvec > WSABUF_ON_STACK)
+        free(pWsaBuf);
+
+    if (rv == SOCKET_ERROR) {
+        *len = 0;
+        return lasterror;
+    }
+
+    *len = dwBytes;
+    return dwBytes == 0 ? APR_EOF : APR_SUCCESS;
+}
+
+
 APR_DECLARE(apr_status_t) apr_socket_sendv(apr_socket_t *sock,
                                            const struct iovec *vec,
                                            apr_int32_t in_vec, apr_size_t *nbytes)
@@ -496,3 +538,39 @@ APR_DECLARE(apr_status_t) apr_socket_wait(apr_socket_t *sock, apr_wait_type_t di
     return APR_SUCCESS;
 }
 
+APR_DECLARE(apr_status_t) apr_socket_splice(apr_socket_t *to,
+                                            apr_socket_t *from,
+                                            apr_size_t *len)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_socket_splice_file(apr_socket_t *to,
+                                                 apr_file_t *from,
+                                                 apr_size_t *len)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_socket_sendv_zerocopy(
+                                             apr_socket_t *sock,
+                                             const struct iovec *vec,
+                                             apr_int32_t nvec,
+                                             apr_size_t *len,
+                                             apr_socket_zerocopy_fn_t *done,
+                                             void *ctx)
+{
+    *len = 0;
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_socket_zerocopy_reap(apr_socket_t *sock,
+                                                   apr_size_t *pending)
+{
+    if (pending) {
+        *pending = 0;
+    }
+    return APR_ENOTIMPL;
+}
@@ -300,3 +300,10 @@ APR_DECLARE(apr_status_t) apr_gethostname(char *buf, int len,
     return APR_SUCCESS;
 }
 
+
+APR_DECLARE(apr_status_t) apr_socket_ktls_enable(
+                                    apr_socket_t *sock, int direction,
+                                    const apr_socket_ktls_params_t *params)
+{
+    return APR_ENOTIMPL;
+}
@@ -176,6 +176,11 @@ APR_DECLARE(apr_size_t) apr_shm_size_get(const apr_shm_t *m)
     return m->reqsize;
 }
 
+APR_DECLARE(apr_size_t) apr_shm_pagesize_get(const apr_shm_t *m)
+{
+    return B_PAGE_SIZE;
+}
+
 APR_PERMS_SET_ENOTIMPL(shm)
 
 APR_POOL_IMPLEMENT_ACCESSOR(shm)
@@ -135,6 +135,11 @@ APR_DECLARE(apr_size_t) apr_shm_size_get(const apr_shm_t *m)
     return size;
 }
 
+APR_DECLARE(apr_size_t) apr_shm_pagesize_get(const apr_shm_t *m)
+{
+    return 4096;
+}
+
 APR_PERMS_SET_ENOTIMPL(shm)
 
 APR_POOL_IMPLEMENT_ACCESSOR(shm)
@@ -141,10 +141,118 @@ static apr_status_t shm_cleanup_owner(void *m_)
     }
 }
 
-APR_DECLARE(apr_status_t) apr_shm_create(apr_shm_t **m,
-                                         apr_size_t reqsize, 
-                                         const char *filename,
-                                         apr_pool_t *pool)
+#if APR_USE_SHMEM_MMAP_ANON && defined(MAP_HUGETLB)
+/* The default huge page size, as reported by /proc/meminfo */
+static apr_size_t shm_hugepagesize(apr_pool_t *pool)
+{
+    apr_file_t *file;
+    char line[128];
+    apr_size_t size = 0;
+
+    if (apr_file_open(&file, "/proc/meminfo", APR_FOPEN_READ,
+                      APR_FPROT_OS_DEFAULT, pool) != APR_SUCCESS) {
+        return 0;
+    }
+    while (apr_file_gets(line, sizeof(line), file) == APR_SUCCESS) {
+        if (strncmp(line, "Hugepagesize:", 13) == 0) {
+            size = (apr_size_t)apr_atoi64(line + 13) * 1024;
+            break;
+        }
+    }
+    apr_file_close(file);
+
+    return size;
+}
+#endif
+
+#if defined(__linux__) && defined(SYS_mbind)
+/* From <linux/mempolicy.h> */
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED      1
+#endif
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE     3
+#endif
+#ifndef MPOL_F_MEMS_ALLOWED
+#define MPOL_F_MEMS_ALLOWED (1 << 2)
+#endif
+
+#define SHM_MAX_NUMNODES    1024
+#define SHM_LONG_BITS       (8 * sizeof(unsigned long))
+
+static void shm_numa_policy(apr_shm_t *m, apr_int32_t flags)
+{
+    unsigned long nodes[SHM_MAX_NUMNODES / SHM_LONG_BITS];
+
+    memset(nodes, 0, sizeof(nodes));
+    if (flags & APR_SHM_NUMA_INTERLEAVE) {
+        /* Interleave over the nodes this process may allocate from */
+        if (syscall(SYS_get_mempolicy, NULL, nodes, SHM_MAX_NUMNODES,
+                    NULL, MPOL_F_MEMS_ALLOWED) == 0) {
+            syscall(SYS_mbind, m->base, m->realsize, MPOL_INTERLEAVE,
+                    nodes, SHM_MAX_NUMNODES, 0);
+        }
+    }
+    else {
+        /* Preferring no node means the local one */
+        syscall(SYS_mbind, m->base, m->realsize, MPOL_PREFERRED,
+                nodes, SHM_MAX_NUMNODES, 0);
+    }
+}
+#endif
+
+/* Apply the placement and residency flags to a newly mapped segment;
+ * the NUMA policy is advisory, so failing to set it is not an error.
+ */
+static apr_status_t shm_setup(apr_shm_t *m, apr_int32_t flags)
+{
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+    if ((flags & APR_SHM_HUGEPAGES) && !m->pagesize) {
+        /* No hugetlb pages, ask for transparent ones */
+        madvise(m->base, m->realsize, MADV_HUGEPAGE);
+    }
+#endif
+#if defined(__linux__) && defined(SYS_mbind)
+    if (flags & (APR_SHM_NUMA_INTERLEAVE | APR_SHM_NUMA_LOCAL)) {
+        shm_numa_policy(m, flags);
+    }
+#endif
+
+    if (flags & APR_SHM_PREFAULT) {
+        apr_size_t pagesize = apr_shm_pagesize_get(m), off;
+        int done = 0;
+
+#if defined(HAVE_MADVISE) && defined(MADV_POPULATE_WRITE)
+        done = (madvise(m->base, m->realsize, MADV_POPULATE_WRITE) == 0);
+#endif
+        if (!done) {
+            /* Reading a shared page allocates it as writing would, without
+             * racing with the processes writing to an attached segment.
+             */
+            for (off = 0; off < m->realsize; off += pagesize) {
+                (void)((volatile char *)m->base)[off];
+            }
+        }
+    }
+
+    if (flags & APR_SHM_LOCK) {
+#ifdef HAVE_MLOCK
+        if (mlock(m->base, m->realsize) == -1) {
+            return errno;
+        }
+#else
+        return APR_ENOTIMPL;
+#endif
+    }
+
+    return APR_SUCCESS;
+}
+
+static apr_status_t shm_create(apr_shm_t **m,
+                               apr_size_t reqsize, 
+                               const char *filename,
+                               apr_pool_t *pool,
+                               apr_int32_t flags)
 {
     apr_shm_t *new_m;
     apr_status_t status;
@@ -168,7 +276,7 @@ APR_DECLARE(apr_status_t) apr_shm_create(apr_shm_t **m,
     /* Check if they want anonymous or name-based shared memory */
     if (filename == NULL) {
 #if APR_USE_SHMEM_MMAP_ZERO || APR_USE_SHMEM_MMAP_ANON
-        new_m = apr_palloc(pool, sizeof(apr_shm_t));
+        new_m = apr_pcalloc(pool, sizeof(apr_shm_t));
         new_m->pool = pool;
         new_m->reqsize = reqsize;
         new_m->realsize = reqsize + 
@@ -208,8 +316,28 @@ APR_DECLARE(apr_status_t) apr_shm_create(apr_shm_t **m,
         return APR_SUCCESS;
 
 #elif APR_USE_SHMEM_MMAP_ANON
-        new_m->base = mmap(NULL, new_m->realsize, PROT_READ|PROT_WRITE,
-                           MAP_ANON|MAP_SHARED, -1, 0);
+        new_m->base = (void *)MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if (flags & APR_SHM_HUGEPAGES) {
+            apr_size_t hugesize = shm_hugepagesize(pool);
+
+            if (hugesize) {
+                /* hugetlb mappings are unmapped by whole pages */
+                apr_size_t realsize = APR_ALIGN(new_m->realsize, hugesize);
+
+                new_m->base = mmap(NULL, realsize, PROT_READ|PROT_WRITE,
+                                   MAP_ANON|MAP_SHARED|MAP_HUGETLB, -1, 0);
+                if (new_m->base != (void *)MAP_FAILED) {
+                    new_m->realsize = realsize;
+                    new_m->pagesize = hugesize;
+                }
+            }
+        }
+#endif
+        if (new_m->base == (void *)MAP_FAILED) {
+            new_m->base = mmap(NULL, new_m->realsize, PROT_READ|PROT_WRITE,
+                               MAP_ANON|MAP_SHARED, -1, 0);
+        }
         if (new_m->base == (void *)MAP_FAILED) {
             return errno;
         }
@@ -226,7 +354,7 @@ APR_DECLARE(apr_status_t) apr_shm_create(apr_shm_t **m,
 
 #endif /* APR_USE_SHMEM_MMAP_ZERO */
 #elif APR_USE_SHMEM_SHMGET_ANON
-        new_m = apr_palloc(pool, sizeof(apr_shm_t));
+        new_m = apr_pcalloc(pool, sizeof(apr_shm_t));
         new_m->pool = pool;
         new_m->reqsize = reqsize;
         new_m->realsize = reqsize;
@@ -272,7 +400,7 @@ APR_DECLARE(apr_status_t) apr_shm_create(apr_shm_t **m,
 
     /* Name-based shared memory */
     else {
-        new_m = apr_palloc(pool, sizeof(apr_shm_t));
+        new_m = apr_pcalloc(pool, sizeof(apr_shm_t));
         new_m->pool = pool;
         new_m->reqsize = reqsize;
         new_m->filename = apr_pstrdup(pool, filename);
@@ -424,13 +552,30 @@ APR_DECLARE(apr_status_t) apr_shm_create(apr_shm_t **m,
     }
 }
 
+APR_DECLARE(apr_status_t) apr_shm_create(apr_shm_t **m,
+                                         apr_size_t reqsize, 
+                                         const char *filename,
+                                         apr_pool_t *pool)
+{
+    return shm_create(m, reqsize, filename, pool, 0);
+}
+
 APR_DECLARE(apr_status_t) apr_shm_create_ex(apr_shm_t **m, 
                                             apr_size_t reqsize, 
                                             const char *filename, 
                                             apr_pool_t *p,
                                             apr_int32_t flags)
 {
-    return apr_shm_create(m, reqsize, filename, p);
+    apr_status_t status;
+
+    status = shm_create(m, reqsize, filename, p, flags);
+    if (status == APR_SUCCESS) {
+        status = shm_setup(*m, flags);
+        if (status != APR_SUCCESS) {
+            apr_shm_destroy(*m);
+        }
+    }
+    return status;
 }
 
 APR_DECLARE(apr_status_t) apr_shm_remove(const char *filename,
@@ -549,7 +694,7 @@ APR_DECLARE(apr_status_t) apr_shm_attach(apr_shm_t **m,
         apr_file_t *file;   /* file where metadata is stored */
         apr_size_t nbytes;
 
-        new_m = apr_palloc(pool, sizeof(apr_shm_t));
+        new_m = apr_pcalloc(pool, sizeof(apr_shm_t));
         new_m->pool = pool;
         new_m->filename = apr_pstrdup(pool, filename);
 #if APR_USE_SHMEM_MMAP_SHM
@@ -622,7 +767,7 @@ APR_DECLARE(apr_status_t) apr_shm_attach(apr_shm_t **m,
         apr_file_t *file;   /* file where metadata is stored */
         apr_size_t nbytes;
 
-        new_m = apr_palloc(pool, sizeof(apr_shm_t));
+        new_m = apr_pcalloc(pool, sizeof(apr_shm_t));
 
         status = apr_file_open(&file, filename, 
                                APR_FOPEN_READ, APR_FPROT_OS_DEFAULT, pool);
@@ -672,7 +817,16 @@ APR_DECLARE(apr_status_t) apr_shm_attach_ex(apr_shm_t **m,
                                             apr_pool_t *pool,
                                             apr_int32_t flags)
 {
-    return apr_shm_attach(m, filename, pool);
+    apr_status_t status;
+
+    status = apr_shm_attach(m, filename, pool);
+    if (status == APR_SUCCESS) {
+        status = shm_setup(*m, flags & (APR_SHM_PREFAULT | APR_SHM_LOCK));
+        if (status != APR_SUCCESS) {
+            apr_shm_detach(*m);
+        }
+    }
+    return status;
 }
 
 APR_DECLARE(apr_status_t) apr_shm_detach(apr_shm_t *m)
@@ -692,6 +846,18 @@ APR_DECLARE(apr_size_t) apr_shm_size_get(const apr_shm_t *m)
     return m->reqsize;
 }
 
+APR_DECLARE(apr_size_t) apr_shm_pagesize_get(const apr_shm_t *m)
+{
+    if (m->pagesize) {
+        return m->pagesize;
+    }
+#if defined(_SC_PAGESIZE)
+    return sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+
 APR_PERMS_SET_IMPLEMENT(shm)
 {
 #if APR_USE_SHMEM_SHMGET || APR_USE_SHMEM_SHMGET_ANON
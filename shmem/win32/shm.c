@@ -368,6 +368,14 @@ APR_DECLARE(apr_size_t) apr_shm_size_get(const apr_shm_t *m)
     return m->length;
 }
 
+APR_DECLARE(apr_size_t) apr_shm_pagesize_get(const apr_shm_t *m)
+{
+    SYSTEM_INFO si;
+
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+}
+
 APR_PERMS_SET_ENOTIMPL(shm)
 
 APR_POOL_IMPLEMENT_ACCESSOR(shm)
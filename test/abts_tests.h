@@ -86,6 +86,9 @@ const struct testlist {
     {testxml},
     {testxlate},
     {testrmm},
+    {testshmhash},
+    {testshmstats},
+    {testrcu},
     {testdbm},
     {testqueue},
     {testreslist},
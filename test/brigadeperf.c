@@ -0,0 +1,263 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* brigadeperf.c
+ * This program measures the throughput of apr_brigade_split_line(),
+ * apr_brigade_split_boundary() and apr_brigade_split_boundary_ex() on a
+ * body of text lines cut in buckets, with the boundary at its end. The
+ * incremental search is fed one bucket at a time, as a body arriving from
+ * the network would be.
+ *
+ * To run,
+ *
+ *   ./brigadeperf [-s body size] [-b bucket size] [-B boundary] [-n rounds]
+ */
+
+#include "apr_buckets.h"
+#include "apr_errno.h"
+#include "apr_general.h"
+#include "apr_getopt.h"
+#include "apr_lib.h"
+#include "apr_strings.h"
+#include "apr_time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_SIZE      (16 * 1024 * 1024)
+#define DEFAULT_BUCKET    8000
+#define DEFAULT_BOUNDARY  "\r\n--apr-brigadeperf-boundary"
+#define DEFAULT_ROUNDS    5
+
+static apr_size_t size = DEFAULT_SIZE;
+static apr_size_t bucket = DEFAULT_BUCKET;
+static const char *boundary = DEFAULT_BOUNDARY;
+static int rounds = DEFAULT_ROUNDS;
+
+static char *body;
+static apr_size_t body_len;
+
+/* Linear congruential generator */
+static apr_uint32_t lcg(apr_uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+/* Lines of letters, dashes and CRs, so that the boundary nearly matches
+ * now and then, then the boundary */
+static void make_body(apr_pool_t *pool)
+{
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz--\r ";
+    apr_size_t blen = strlen(boundary), i;
+    apr_uint32_t seed = 1;
+
+    body_len = size + blen;
+    body = apr_palloc(pool, body_len);
+    for (i = 0; i < size; i++) {
+        body[i] = (lcg(&seed) % 80) ? chars[lcg(&seed) % (sizeof(chars) - 1)]
+                                    : '\n';
+    }
+    memcpy(body + size, boundary, blen);
+}
+
+static void fill_brigade(apr_bucket_brigade *bb, apr_size_t from,
+                         apr_size_t to)
+{
+    while (from < to) {
+        apr_size_t n = to - from < bucket ? to - from : bucket;
+
+        APR_BRIGADE_INSERT_TAIL(bb,
+                apr_bucket_immortal_create(body + from, n, bb->bucket_alloc));
+        from += n;
+    }
+}
+
+static void report(const char *what, apr_time_t elapsed)
+{
+    printf("%s\n", what);
+    printf("    microseconds: %" APR_INT64_T_FMT " usec\n", elapsed);
+    printf("    megabytes per second: %.1f\n",
+           (double)body_len * rounds * APR_USEC_PER_SEC
+           / (double)(elapsed + 1) / (1024 * 1024));
+}
+
+static apr_status_t test_split_line(apr_bucket_alloc_t *ba, apr_pool_t *pool)
+{
+    apr_bucket_brigade *bin = apr_brigade_create(pool, ba);
+    apr_bucket_brigade *bout = apr_brigade_create(pool, ba);
+    apr_time_t time_start;
+    apr_status_t rv;
+    int n;
+
+    time_start = apr_time_now();
+    for (n = 0; n < rounds; n++) {
+        fill_brigade(bin, 0, body_len);
+        while (!APR_BRIGADE_EMPTY(bin)) {
+            rv = apr_brigade_split_line(bout, bin, APR_BLOCK_READ,
+                                        HUGE_STRING_LEN);
+            if (rv != APR_SUCCESS) {
+                return rv;
+            }
+            apr_brigade_cleanup(bout);
+        }
+    }
+    report("apr_brigade_split_line", apr_time_now() - time_start);
+
+    return APR_SUCCESS;
+}
+
+static apr_status_t test_split_boundary(apr_bucket_alloc_t *ba,
+                                        apr_pool_t *pool)
+{
+    apr_bucket_brigade *bin = apr_brigade_create(pool, ba);
+    apr_bucket_brigade *bout = apr_brigade_create(pool, ba);
+    apr_time_t time_start;
+    apr_status_t rv;
+    int n;
+
+    time_start = apr_time_now();
+    for (n = 0; n < rounds; n++) {
+        fill_brigade(bin, 0, body_len);
+        rv = apr_brigade_split_boundary(bout, bin, APR_BLOCK_READ, boundary,
+                                        APR_BUCKETS_STRING, body_len);
+        if (rv != APR_SUCCESS) {
+            return rv == APR_INCOMPLETE ? APR_EGENERAL : rv;
+        }
+        apr_brigade_cleanup(bout);
+        apr_brigade_cleanup(bin);
+    }
+    report("apr_brigade_split_boundary (whole body)",
+           apr_time_now() - time_start);
+
+    return APR_SUCCESS;
+}
+
+static apr_status_t test_split_boundary_ex(apr_bucket_alloc_t *ba,
+                                           apr_pool_t *pool)
+{
+    apr_bucket_brigade *bin = apr_brigade_create(pool, ba);
+    apr_bucket_brigade *bout = apr_brigade_create(pool, ba);
+    apr_brigade_boundary_t *bd;
+    apr_time_t time_start;
+    apr_status_t rv;
+    int n;
+
+    rv = apr_brigade_boundary_create(&bd, boundary, APR_BUCKETS_STRING, pool);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+
+    time_start = apr_time_now();
+    for (n = 0; n < rounds; n++) {
+        apr_size_t from = 0;
+
+        apr_brigade_boundary_reset(bd);
+        rv = APR_INCOMPLETE;
+        while (rv == APR_INCOMPLETE && from < body_len) {
+            apr_size_t to = from + bucket < body_len ? from + bucket
+                                                     : body_len;
+
+            fill_brigade(bin, from, to);
+            from = to;
+            rv = apr_brigade_split_boundary_ex(bout, bin, APR_BLOCK_READ, bd,
+                                               body_len);
+            apr_brigade_cleanup(bout);
+        }
+        if (rv != APR_SUCCESS) {
+            return rv == APR_INCOMPLETE ? APR_EGENERAL : rv;
+        }
+        apr_brigade_cleanup(bin);
+    }
+    report("apr_brigade_split_boundary_ex (bucket by bucket)",
+           apr_time_now() - time_start);
+
+    return APR_SUCCESS;
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+    apr_bucket_alloc_t *ba;
+    apr_status_t rv;
+    char errmsg[200];
+    apr_getopt_t *opt;
+    char optchar;
+    const char *optarg;
+
+    printf("APR Brigade Split Performance Test\n==============\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+
+    if (apr_pool_create(&pool, NULL) != APR_SUCCESS)
+        exit(-1);
+
+    if ((rv = apr_getopt_init(&opt, pool, argc, argv)) != APR_SUCCESS) {
+        fprintf(stderr, "Could not set up to parse options: [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-1);
+    }
+
+    while ((rv = apr_getopt(opt, "s:b:B:n:", &optchar, &optarg))
+           == APR_SUCCESS) {
+        if (optchar == 's') {
+            size = (apr_size_t)apr_atoi64(optarg);
+        }
+        else if (optchar == 'b') {
+            bucket = (apr_size_t)apr_atoi64(optarg);
+        }
+        else if (optchar == 'B') {
+            boundary = optarg;
+        }
+        else if (optchar == 'n') {
+            rounds = atoi(optarg);
+        }
+    }
+
+    if (rv != APR_SUCCESS && rv != APR_EOF) {
+        fprintf(stderr, "Could not parse options: [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-1);
+    }
+    if (bucket < 1 || !boundary[0] || rounds < 1) {
+        fprintf(stderr, "Invalid options\n");
+        exit(-1);
+    }
+
+    make_body(pool);
+    ba = apr_bucket_alloc_create(pool);
+    printf("%" APR_SIZE_T_FMT " bytes in buckets of %" APR_SIZE_T_FMT
+           " bytes, %d rounds\n\n", body_len, bucket, rounds);
+
+    if ((rv = test_split_line(ba, pool)) != APR_SUCCESS) {
+        fprintf(stderr, "split line test failed : [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-2);
+    }
+    if ((rv = test_split_boundary(ba, pool)) != APR_SUCCESS) {
+        fprintf(stderr, "split boundary test failed : [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-3);
+    }
+    if ((rv = test_split_boundary_ex(ba, pool)) != APR_SUCCESS) {
+        fprintf(stderr, "incremental split boundary test failed : [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-4);
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* rmmperf.c
+ * This program measures the throughput of apr_rmm_malloc()/apr_rmm_free()
+ * in a shared memory segment used concurrently by several processes,
+ * serialized by an apr_proc_mutex_t.  Each child process first fills
+ * the segment with its share of blocks of random sizes, then replaces
+ * randomly chosen blocks with new ones.
+ *
+ * To run,
+ *
+ *   ./rmmperf [-p processes] [-b blocks per process] [-c operations]
+ */
+
+#include "apr_shm.h"
+#include "apr_rmm.h"
+#include "apr_anylock.h"
+#include "apr_proc_mutex.h"
+#include "apr_thread_proc.h"
+#include "apr_errno.h"
+#include "apr_general.h"
+#include "apr_getopt.h"
+#include "apr_strings.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !APR_HAS_SHARED_MEMORY || !APR_HAS_FORK
+int main(void)
+{
+    printf("This program won't work on this platform because there is no "
+           "support for shared memory or fork.\n");
+    return 0;
+}
+#else
+
+#define DEFAULT_PROCS     4
+#define DEFAULT_BLOCKS    25000
+#define DEFAULT_OPS       200000
+#define MAX_PROCS         64
+#define MIN_BLOCK_SIZE    16
+#define MAX_BLOCK_SIZE    512
+
+static int procs = DEFAULT_PROCS;
+static int blocks = DEFAULT_BLOCKS;
+static long ops = DEFAULT_OPS;
+
+static apr_proc_mutex_t *proc_lock;
+static apr_rmm_t *rmm;
+
+/* Linear congruential generator */
+static apr_uint32_t lcg(apr_uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+static apr_size_t random_size(apr_uint32_t *seed)
+{
+    return MIN_BLOCK_SIZE + lcg(seed) % (MAX_BLOCK_SIZE - MIN_BLOCK_SIZE);
+}
+
+static int run_child(int n, apr_pool_t *p)
+{
+    apr_rmm_off_t *off;
+    apr_uint32_t seed = n + 1;
+    long i;
+
+    if (apr_proc_mutex_child_init(&proc_lock, NULL, p) != APR_SUCCESS) {
+        return 1;
+    }
+
+    off = apr_pcalloc(p, blocks * sizeof(*off));
+    for (i = 0; i < blocks; i++) {
+        off[i] = apr_rmm_malloc(rmm, random_size(&seed));
+        if (!off[i]) {
+            fprintf(stderr, "child %d: out of memory after %ld blocks\n",
+                    n, i);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < ops; i++) {
+        int j = lcg(&seed) % blocks;
+        if (apr_rmm_free(rmm, off[j]) != APR_SUCCESS) {
+            fprintf(stderr, "child %d: apr_rmm_free() failed\n", n);
+            return 1;
+        }
+        off[j] = apr_rmm_malloc(rmm, random_size(&seed));
+        if (!off[j]) {
+            fprintf(stderr, "child %d: out of memory after %ld ops\n",
+                    n, i);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < blocks; i++) {
+        apr_rmm_free(rmm, off[i]);
+    }
+
+    return 0;
+}
+
+static apr_status_t test_rmm_procs(apr_pool_t *pool)
+{
+    apr_proc_t child[MAX_PROCS];
+    apr_anylock_t lock;
+    apr_shm_t *shm;
+    apr_size_t size;
+    apr_time_t time_start, time_stop;
+    apr_status_t rv;
+    int n, failed = 0;
+
+    size = (apr_size_t)procs * blocks * MAX_BLOCK_SIZE
+           + apr_rmm_overhead_get(procs * blocks);
+
+    printf("apr_rmm_t with %d processes, %d blocks each, %ld operations\n",
+           procs, blocks, ops);
+
+    rv = apr_shm_create(&shm, size, NULL, pool);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    rv = apr_proc_mutex_create(&proc_lock, NULL, APR_LOCK_DEFAULT, pool);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    lock.type = apr_anylock_procmutex;
+    lock.lock.pm = proc_lock;
+    rv = apr_rmm_init(&rmm, &lock, apr_shm_baseaddr_get(shm), size, pool);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+
+    fflush(stdout);
+    time_start = apr_time_now();
+    for (n = 0; n < procs; n++) {
+        rv = apr_proc_fork(&child[n], pool);
+        if (rv == APR_INCHILD) {
+            apr_initialize();
+            exit(run_child(n, pool));
+        }
+        else if (rv != APR_INPARENT) {
+            return rv;
+        }
+    }
+    for (n = 0; n < procs; n++) {
+        int code;
+        apr_exit_why_e why;
+
+        rv = apr_proc_wait(&child[n], &code, &why, APR_WAIT);
+        if (rv != APR_CHILD_DONE || why != APR_PROC_EXIT || code != 0) {
+            failed++;
+        }
+    }
+    time_stop = apr_time_now();
+
+    if (failed) {
+        printf("error: %d children failed\n", failed);
+    }
+    printf("    microseconds: %" APR_INT64_T_FMT " usec\n",
+           time_stop - time_start);
+    printf("    operations per second: %.0f\n",
+           (double)procs * (blocks * 2 + ops * 2) * APR_USEC_PER_SEC
+           / (double)(time_stop - time_start + 1));
+
+    apr_rmm_destroy(rmm);
+    apr_proc_mutex_destroy(proc_lock);
+    return apr_shm_destroy(shm);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+    apr_status_t rv;
+    char errmsg[200];
+    apr_getopt_t *opt;
+    char optchar;
+    const char *optarg;
+
+    printf("APR RMM Performance Test\n==============\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+
+    if (apr_pool_create(&pool, NULL) != APR_SUCCESS)
+        exit(-1);
+
+    if ((rv = apr_getopt_init(&opt, pool, argc, argv)) != APR_SUCCESS) {
+        fprintf(stderr, "Could not set up to parse options: [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-1);
+    }
+
+    while ((rv = apr_getopt(opt, "p:b:c:", &optchar, &optarg))
+           == APR_SUCCESS) {
+        if (optchar == 'p') {
+            procs = atoi(optarg);
+        }
+        else if (optchar == 'b') {
+            blocks = atoi(optarg);
+        }
+        else if (optchar == 'c') {
+            ops = atol(optarg);
+        }
+    }
+
+    if (rv != APR_SUCCESS && rv != APR_EOF) {
+        fprintf(stderr, "Could not parse options: [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-1);
+    }
+    if (procs < 1 || procs > MAX_PROCS || blocks < 1 || ops < 0) {
+        fprintf(stderr, "Invalid options\n");
+        exit(-1);
+    }
+
+    if ((rv = test_rmm_procs(pool)) != APR_SUCCESS) {
+        fprintf(stderr, "rmm test failed : [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-2);
+    }
+
+    return 0;
+}
+
+#endif /* !APR_HAS_SHARED_MEMORY || !APR_HAS_FORK */
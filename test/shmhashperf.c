@@ -0,0 +1,259 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* shmhashperf.c
+ * This program measures the throughput of apr_shm_hash_get() and
+ * apr_shm_hash_set() on a table used concurrently by several processes,
+ * first as is, then with every operation serialized by one
+ * apr_proc_mutex_t as a cache behind a single global lock would be.
+ *
+ * To run,
+ *
+ *   ./shmhashperf [-p processes] [-k keys] [-c operations] [-w write %]
+ */
+
+#include "apr_shm.h"
+#include "apr_shm_hash.h"
+#include "apr_proc_mutex.h"
+#include "apr_thread_proc.h"
+#include "apr_errno.h"
+#include "apr_general.h"
+#include "apr_getopt.h"
+#include "apr_strings.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !APR_HAS_SHARED_MEMORY || !APR_HAS_FORK
+int main(void)
+{
+    printf("This program won't work on this platform because there is no "
+           "support for shared memory or fork.\n");
+    return 0;
+}
+#else
+
+#define DEFAULT_PROCS     4
+#define DEFAULT_KEYS      10000
+#define DEFAULT_OPS       1000000
+#define DEFAULT_WRITES    10
+#define MAX_PROCS         64
+#define KEY_MAX           32
+#define VAL_MAX           128
+
+static int procs = DEFAULT_PROCS;
+static int keys = DEFAULT_KEYS;
+static long ops = DEFAULT_OPS;
+static int writes = DEFAULT_WRITES;
+
+static apr_shm_hash_t *hash;
+static apr_proc_mutex_t *proc_lock;
+
+/* Linear congruential generator */
+static apr_uint32_t lcg(apr_uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+static int run_child(int n, apr_pool_t *p)
+{
+    apr_uint32_t seed = n + 1;
+    char key[KEY_MAX], val[VAL_MAX];
+    apr_size_t vlen;
+    apr_status_t rv;
+    long i;
+
+    if (proc_lock
+            && apr_proc_mutex_child_init(&proc_lock, NULL, p) != APR_SUCCESS) {
+        return 1;
+    }
+    memset(val, n, sizeof(val));
+
+    for (i = 0; i < ops; i++) {
+        int k = lcg(&seed) % keys;
+        int w = (int)(lcg(&seed) % 100) < writes;
+
+        apr_snprintf(key, sizeof(key), "key-%d", k);
+        if (proc_lock) {
+            apr_proc_mutex_lock(proc_lock);
+        }
+        if (w) {
+            rv = apr_shm_hash_set(hash, key, APR_HASH_KEY_STRING,
+                                  val, sizeof(val), 0);
+        }
+        else {
+            vlen = sizeof(val);
+            rv = apr_shm_hash_get(hash, key, APR_HASH_KEY_STRING,
+                                  val, &vlen);
+            if (rv == APR_NOTFOUND) {
+                rv = APR_SUCCESS;
+            }
+        }
+        if (proc_lock) {
+            apr_proc_mutex_unlock(proc_lock);
+        }
+        if (rv != APR_SUCCESS) {
+            fprintf(stderr, "child %d: operation failed after %ld ops\n",
+                    n, i);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static apr_status_t test_shm_hash_procs(int locked, apr_pool_t *pool)
+{
+    apr_proc_t child[MAX_PROCS];
+    apr_shm_t *shm;
+    apr_time_t time_start, time_stop;
+    apr_status_t rv;
+    int n, failed = 0;
+    char key[KEY_MAX], val[VAL_MAX];
+
+    printf("apr_shm_hash_t%s with %d processes, %d keys, %ld operations, "
+           "%d%% writes\n", locked ? " (locked)" : "", procs, keys, ops,
+           writes);
+
+    /* Twice the keys, so that few entries get evicted */
+    rv = apr_shm_create(&shm, apr_shm_hash_size(2 * keys, KEY_MAX, VAL_MAX),
+                        NULL, pool);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    rv = apr_shm_hash_init(&hash, shm, KEY_MAX, VAL_MAX,
+                           APR_SHM_HASH_EVICT_LRU, pool);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    memset(val, 0, sizeof(val));
+    for (n = 0; n < keys; n++) {
+        apr_snprintf(key, sizeof(key), "key-%d", n);
+        apr_shm_hash_set(hash, key, APR_HASH_KEY_STRING, val, sizeof(val), 0);
+    }
+
+    proc_lock = NULL;
+    if (locked) {
+        rv = apr_proc_mutex_create(&proc_lock, NULL, APR_LOCK_DEFAULT, pool);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+    }
+
+    fflush(stdout);
+    time_start = apr_time_now();
+    for (n = 0; n < procs; n++) {
+        rv = apr_proc_fork(&child[n], pool);
+        if (rv == APR_INCHILD) {
+            apr_initialize();
+            exit(run_child(n, pool));
+        }
+        else if (rv != APR_INPARENT) {
+            return rv;
+        }
+    }
+    for (n = 0; n < procs; n++) {
+        int code;
+        apr_exit_why_e why;
+
+        rv = apr_proc_wait(&child[n], &code, &why, APR_WAIT);
+        if (rv != APR_CHILD_DONE || why != APR_PROC_EXIT || code != 0) {
+            failed++;
+        }
+    }
+    time_stop = apr_time_now();
+
+    if (failed) {
+        printf("error: %d children failed\n", failed);
+    }
+    printf("    microseconds: %" APR_INT64_T_FMT " usec\n",
+           time_stop - time_start);
+    printf("    operations per second: %.0f\n",
+           (double)procs * ops * APR_USEC_PER_SEC
+           / (double)(time_stop - time_start + 1));
+
+    if (proc_lock) {
+        apr_proc_mutex_destroy(proc_lock);
+    }
+    return apr_shm_destroy(shm);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+    apr_status_t rv;
+    char errmsg[200];
+    apr_getopt_t *opt;
+    char optchar;
+    const char *optarg;
+
+    printf("APR Shared Memory Hash Performance Test\n==============\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+
+    if (apr_pool_create(&pool, NULL) != APR_SUCCESS)
+        exit(-1);
+
+    if ((rv = apr_getopt_init(&opt, pool, argc, argv)) != APR_SUCCESS) {
+        fprintf(stderr, "Could not set up to parse options: [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-1);
+    }
+
+    while ((rv = apr_getopt(opt, "p:k:c:w:", &optchar, &optarg))
+           == APR_SUCCESS) {
+        if (optchar == 'p') {
+            procs = atoi(optarg);
+        }
+        else if (optchar == 'k') {
+            keys = atoi(optarg);
+        }
+        else if (optchar == 'c') {
+            ops = atol(optarg);
+        }
+        else if (optchar == 'w') {
+            writes = atoi(optarg);
+        }
+    }
+
+    if (rv != APR_SUCCESS && rv != APR_EOF) {
+        fprintf(stderr, "Could not parse options: [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-1);
+    }
+    if (procs < 1 || procs > MAX_PROCS || keys < 1 || ops < 0
+            || writes < 0 || writes > 100) {
+        fprintf(stderr, "Invalid options\n");
+        exit(-1);
+    }
+
+    if ((rv = test_shm_hash_procs(0, pool)) != APR_SUCCESS) {
+        fprintf(stderr, "shm hash test failed : [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-2);
+    }
+    if ((rv = test_shm_hash_procs(1, pool)) != APR_SUCCESS) {
+        fprintf(stderr, "shm hash (locked) test failed : [%d] %s\n",
+                rv, apr_strerror(rv, errmsg, sizeof errmsg));
+        exit(-3);
+    }
+
+    return 0;
+}
+
+#endif /* !APR_HAS_SHARED_MEMORY || !APR_HAS_FORK */
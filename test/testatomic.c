@@ -230,6 +230,50 @@ static void test_inc_neg1(abts_case *tc, void *data)
     ABTS_ASSERT(tc, str, y32 == 0);
 }
 
+static void test_bitops32(abts_case *tc, void *data)
+{
+    apr_uint32_t y32 = 0x0f0f;
+    apr_uint32_t rv;
+
+    rv = apr_atomic_or32(&y32, 0xf000);
+    ABTS_INT_EQUAL(tc, 0x0f0f, rv);
+    ABTS_INT_EQUAL(tc, 0xff0f, y32);
+
+    rv = apr_atomic_and32(&y32, 0x0ff0);
+    ABTS_INT_EQUAL(tc, 0xff0f, rv);
+    ABTS_INT_EQUAL(tc, 0x0f00, y32);
+
+    rv = apr_atomic_xor32(&y32, 0x0ff0);
+    ABTS_INT_EQUAL(tc, 0x0f00, rv);
+    ABTS_INT_EQUAL(tc, 0x00f0, y32);
+}
+
+static void test_ex32(abts_case *tc, void *data)
+{
+    apr_uint32_t y32;
+    apr_uint32_t rv;
+
+    apr_atomic_set32_ex(&y32, 2, APR_ATOMIC_RELEASE);
+    ABTS_INT_EQUAL(tc, 2, apr_atomic_read32_ex(&y32, APR_ATOMIC_ACQUIRE));
+
+    rv = apr_atomic_add32_ex(&y32, 3, APR_ATOMIC_RELAXED);
+    ABTS_INT_EQUAL(tc, 2, rv);
+    ABTS_INT_EQUAL(tc, 5, apr_atomic_read32_ex(&y32, APR_ATOMIC_RELAXED));
+
+    rv = apr_atomic_cas32_ex(&y32, 7, 2, APR_ATOMIC_ACQ_REL);
+    ABTS_INT_EQUAL(tc, 5, rv);
+    ABTS_INT_EQUAL(tc, 5, y32);
+    rv = apr_atomic_cas32_ex(&y32, 7, 5, APR_ATOMIC_RELEASE);
+    ABTS_INT_EQUAL(tc, 5, rv);
+    ABTS_INT_EQUAL(tc, 7, apr_atomic_read32_ex(&y32, APR_ATOMIC_SEQ_CST));
+
+    apr_atomic_fence(APR_ATOMIC_RELAXED);
+    apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+    apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_fence(APR_ATOMIC_ACQ_REL);
+    apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
 static void test_set64(abts_case *tc, void *data)
 {
     apr_uint64_t y64;
@@ -347,6 +391,66 @@ static void test_inc_neg164(abts_case *tc, void *data)
 }
 
 
+static void test_bitops64(abts_case *tc, void *data)
+{
+    apr_uint64_t y64 = APR_UINT64_C(0x0f0f00000000);
+    apr_uint64_t rv;
+
+    rv = apr_atomic_or64(&y64, APR_UINT64_C(0xf00000000000));
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0x0f0f00000000), rv);
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0xff0f00000000), y64);
+
+    rv = apr_atomic_and64(&y64, APR_UINT64_C(0x0ff000000000));
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0xff0f00000000), rv);
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0x0f0000000000), y64);
+
+    rv = apr_atomic_xor64(&y64, APR_UINT64_C(0x0ff000000001));
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0x0f0000000000), rv);
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0x00f000000001), y64);
+}
+
+static void test_ex64(abts_case *tc, void *data)
+{
+    apr_uint64_t y64;
+    apr_uint64_t rv;
+
+    apr_atomic_set64_ex(&y64, APR_UINT64_C(0x100000000), APR_ATOMIC_RELEASE);
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0x100000000),
+                      apr_atomic_read64_ex(&y64, APR_ATOMIC_ACQUIRE));
+
+    rv = apr_atomic_add64_ex(&y64, 3, APR_ATOMIC_RELAXED);
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0x100000000), rv);
+
+    rv = apr_atomic_cas64_ex(&y64, 7, 3, APR_ATOMIC_ACQUIRE);
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0x100000003), rv);
+    rv = apr_atomic_cas64_ex(&y64, 7, APR_UINT64_C(0x100000003),
+                             APR_ATOMIC_SEQ_CST);
+    ABTS_ULLONG_EQUAL(tc, APR_UINT64_C(0x100000003), rv);
+    ABTS_ULLONG_EQUAL(tc, 7, apr_atomic_read64_ex(&y64, APR_ATOMIC_RELAXED));
+}
+
+static void test_cas128(abts_case *tc, void *data)
+{
+    apr_atomic_uint128_t y128, cmp, with;
+
+    y128.lo = 1;
+    y128.hi = 2;
+
+    cmp.lo = 1;
+    cmp.hi = 3;
+    with.lo = 4;
+    with.hi = 5;
+    ABTS_INT_EQUAL(tc, 0, apr_atomic_cas128(&y128, &cmp, &with));
+    ABTS_ULLONG_EQUAL(tc, 1, cmp.lo);
+    ABTS_ULLONG_EQUAL(tc, 2, cmp.hi);
+    ABTS_ULLONG_EQUAL(tc, 1, y128.lo);
+    ABTS_ULLONG_EQUAL(tc, 2, y128.hi);
+
+    ABTS_TRUE(tc, apr_atomic_cas128(&y128, &cmp, &with) != 0);
+    ABTS_ULLONG_EQUAL(tc, 4, y128.lo);
+    ABTS_ULLONG_EQUAL(tc, 5, y128.hi);
+}
+
 #if APR_HAS_THREADS
 
 void *APR_THREAD_FUNC thread_func_mutex(apr_thread_t *thd, void *data);
@@ -876,6 +980,98 @@ static void test_atomics_busyloop_threaded64(abts_case *tc, void *data)
     ABTS_ASSERT(tc, "Failed creating threads", rv == APR_SUCCESS);
 }
 
+#define NUM_BITS_THREADS 8
+
+static volatile apr_uint32_t atomic_bits = 0;
+static volatile apr_atomic_uint128_t atomic_pair;
+
+/* Each thread owns one bit, which it sets and clears; any lost update
+ * shows as a bit in the wrong state, or a bit of another thread changed */
+static void *APR_THREAD_FUNC thread_func_bitops(apr_thread_t *thd, void *data)
+{
+    apr_uint32_t bit = 1u << (apr_uint32_t)(apr_uintptr_t)data;
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    for (i = 0; i < NUM_ITERATIONS; i++) {
+        if (apr_atomic_or32(&atomic_bits, bit) & bit) {
+            rv = APR_EGENERAL;
+        }
+        if (!(apr_atomic_xor32(&atomic_bits, bit) & bit)) {
+            rv = APR_EGENERAL;
+        }
+        apr_atomic_or32(&atomic_bits, bit);
+        if (!(apr_atomic_and32(&atomic_bits, ~bit) & bit)) {
+            rv = APR_EGENERAL;
+        }
+    }
+    apr_thread_exit(thd, rv);
+    return NULL;
+}
+
+static void test_atomics_threaded_bitops(abts_case *tc, void *data)
+{
+    apr_thread_t *t[NUM_BITS_THREADS];
+    apr_status_t rv;
+    int i;
+
+    for (i = 0; i < NUM_BITS_THREADS; i++) {
+        rv = apr_thread_create(&t[i], NULL, thread_func_bitops,
+                               (void *)(apr_uintptr_t)i, p);
+        APR_ASSERT_SUCCESS(tc, "Failed creating thread", rv);
+    }
+    for (i = 0; i < NUM_BITS_THREADS; i++) {
+        apr_status_t retval;
+
+        apr_thread_join(&retval, t[i]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, retval);
+    }
+    ABTS_INT_EQUAL(tc, 0, apr_atomic_read32(&atomic_bits));
+}
+
+/* Both halves are incremented together, so they must always be equal */
+static void *APR_THREAD_FUNC thread_func_cas128(apr_thread_t *thd, void *data)
+{
+    apr_atomic_uint128_t cmp, with;
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    cmp.lo = cmp.hi = 0;
+    for (i = 0; i < NUM_ITERATIONS; i++) {
+        do {
+            if (cmp.lo != cmp.hi) {
+                rv = APR_EGENERAL;
+            }
+            with.lo = cmp.lo + 1;
+            with.hi = cmp.hi + 1;
+        } while (!apr_atomic_cas128(&atomic_pair, &cmp, &with));
+        cmp = with;
+    }
+    apr_thread_exit(thd, rv);
+    return NULL;
+}
+
+static void test_atomics_threaded_cas128(abts_case *tc, void *data)
+{
+    apr_thread_t *t[NUM_THREADS];
+    apr_status_t rv;
+    int i;
+
+    atomic_pair.lo = atomic_pair.hi = 0;
+    for (i = 0; i < NUM_THREADS; i++) {
+        rv = apr_thread_create(&t[i], NULL, thread_func_cas128, NULL, p);
+        APR_ASSERT_SUCCESS(tc, "Failed creating thread", rv);
+    }
+    for (i = 0; i < NUM_THREADS; i++) {
+        apr_status_t retval;
+
+        apr_thread_join(&retval, t[i]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, retval);
+    }
+    ABTS_ULLONG_EQUAL(tc, NUM_THREADS * NUM_ITERATIONS, atomic_pair.lo);
+    ABTS_ULLONG_EQUAL(tc, NUM_THREADS * NUM_ITERATIONS, atomic_pair.hi);
+}
+
 static void *APR_THREAD_FUNC test_func_set64(apr_thread_t *thd, void *data)
 {
     int i;
@@ -937,6 +1133,8 @@ abts_suite *testatomic(abts_suite *suite)
     abts_run_test(suite, test_set_add_inc_sub, NULL);
     abts_run_test(suite, test_wrap_zero, NULL);
     abts_run_test(suite, test_inc_neg1, NULL);
+    abts_run_test(suite, test_bitops32, NULL);
+    abts_run_test(suite, test_ex32, NULL);
     abts_run_test(suite, test_set64, NULL);
     abts_run_test(suite, test_read64, NULL);
     abts_run_test(suite, test_dec64, NULL);
@@ -947,6 +1145,9 @@ abts_suite *testatomic(abts_suite *suite)
     abts_run_test(suite, test_set_add_inc_sub64, NULL);
     abts_run_test(suite, test_wrap_zero64, NULL);
     abts_run_test(suite, test_inc_neg164, NULL);
+    abts_run_test(suite, test_bitops64, NULL);
+    abts_run_test(suite, test_ex64, NULL);
+    abts_run_test(suite, test_cas128, NULL);
 
 #if APR_HAS_THREADS
     abts_run_test(suite, test_atomics_threaded, NULL);
@@ -954,6 +1155,8 @@ abts_suite *testatomic(abts_suite *suite)
     abts_run_test(suite, test_atomics_busyloop_threaded, NULL);
     abts_run_test(suite, test_atomics_busyloop_threaded64, NULL);
     abts_run_test(suite, test_atomics_threaded_setread64, NULL);
+    abts_run_test(suite, test_atomics_threaded_bitops, NULL);
+    abts_run_test(suite, test_atomics_threaded_cas128, NULL);
 #endif
 
     return suite;
@@ -18,6 +18,13 @@
 #include "testutil.h"
 #include "apr_buckets.h"
 #include "apr_strings.h"
+#include "apr_atomic.h"
+#include "apr_thread_proc.h"
+#include "apr_queue.h"
+#include "apr_poll.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 static void test_create(abts_case *tc, void *data)
 {
@@ -265,6 +272,80 @@ static void test_splitboundary(abts_case *tc, void *data)
     apr_bucket_alloc_destroy(ba);
 }
 
+static void test_splitboundary_ex(abts_case *tc, void *data)
+{
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_bucket_brigade *bin, *bout;
+    apr_brigade_boundary_t *bd;
+    const char *body = "ab--bou--bound rest";
+    apr_size_t i, len = strlen(body);
+    char *buf;
+    apr_status_t rv = APR_INCOMPLETE;
+
+    ABTS_INT_EQUAL(tc, APR_EINVAL,
+                   apr_brigade_boundary_create(&bd, "", APR_BUCKETS_STRING, p));
+    APR_ASSERT_SUCCESS(tc, "create boundary",
+                       apr_brigade_boundary_create(&bd, "--bound",
+                                                   APR_BUCKETS_STRING, p));
+
+    /* the body arrives one byte at a time */
+    bin = apr_brigade_create(p, ba);
+    bout = apr_brigade_create(p, ba);
+    for (i = 0; i < len && rv == APR_INCOMPLETE; i++) {
+        APR_BRIGADE_INSERT_TAIL(bin,
+                apr_bucket_immortal_create(body + i, 1, ba));
+        rv = apr_brigade_split_boundary_ex(bout, bin, APR_BLOCK_READ, bd,
+                                           100);
+        if (i == 6) {
+            ABTS_INT_EQUAL(tc, APR_INCOMPLETE, rv);
+            flatten_match(tc, "partial match passed", bout, "ab");
+            flatten_match(tc, "partial match held", bin, "--bou");
+        }
+    }
+    APR_ASSERT_SUCCESS(tc, "split boundary", rv);
+    ABTS_SIZE_EQUAL(tc, strlen("ab--bou--bound"), i);
+    flatten_match(tc, "split boundary", bout, "ab--bou");
+    flatten_match(tc, "remainder", bin, "");
+
+    apr_brigade_cleanup(bout);
+    apr_brigade_cleanup(bin);
+
+    /* a partial match cut by a metadata bucket is passed on */
+    apr_brigade_boundary_reset(bd);
+    APR_BRIGADE_INSERT_TAIL(bin,
+            apr_bucket_immortal_create("x--bo", 5, ba));
+    ABTS_INT_EQUAL(tc, APR_INCOMPLETE,
+                   apr_brigade_split_boundary_ex(bout, bin, APR_BLOCK_READ,
+                                                 bd, 100));
+    APR_BRIGADE_INSERT_TAIL(bin, apr_bucket_flush_create(ba));
+    ABTS_INT_EQUAL(tc, APR_INCOMPLETE,
+                   apr_brigade_split_boundary_ex(bout, bin, APR_BLOCK_READ,
+                                                 bd, 100));
+    flatten_match(tc, "metadata", bout, "x--bo");
+    ABTS_ASSERT(tc, "flush left in the input",
+                APR_BUCKET_IS_FLUSH(APR_BRIGADE_FIRST(bin)));
+
+    apr_brigade_cleanup(bout);
+    apr_brigade_cleanup(bin);
+
+    /* a boundary which nearly matches everywhere */
+    buf = apr_palloc(p, 5002);
+    memset(buf, 'a', 5000);
+    memcpy(buf + 5000, "b", 2);
+    APR_BRIGADE_INSERT_TAIL(bin, apr_bucket_immortal_create(buf, 5001, ba));
+
+    APR_ASSERT_SUCCESS(tc, "split boundary",
+                       apr_brigade_split_boundary(bout, bin, APR_BLOCK_READ,
+                                                  "aaab", APR_BUCKETS_STRING,
+                                                  10000));
+    flatten_match(tc, "split boundary", bout, apr_pstrndup(p, buf, 4997));
+    flatten_match(tc, "remainder", bin, "");
+
+    apr_brigade_destroy(bout);
+    apr_brigade_destroy(bin);
+    apr_bucket_alloc_destroy(ba);
+}
+
 /* Test that bucket E has content EDATA of length ELEN. */
 static void test_bucket_content(abts_case *tc,
                                 apr_bucket *e,
@@ -567,6 +648,899 @@ static void test_write_putstrs(abts_case *tc, void *data)
     apr_bucket_alloc_destroy(ba);
 }
 
+#define SEND_FNAME "brigadesend.bin"
+#define SEND_FSIZE (200 * 1024)
+
+static apr_status_t socket_pair(apr_socket_t **client, apr_socket_t **server)
+{
+    apr_socket_t *listener;
+    apr_sockaddr_t *sa;
+    apr_status_t rv;
+
+    if ((rv = apr_sockaddr_info_get(&sa, "127.0.0.1", APR_INET, 0, 0, p))
+        || (rv = apr_socket_create(&listener, APR_INET, SOCK_STREAM,
+                                   APR_PROTO_TCP, p))
+        || (rv = apr_socket_bind(listener, sa))
+        || (rv = apr_socket_listen(listener, 1))
+        || (rv = apr_socket_addr_get(&sa, APR_LOCAL, listener))
+        || (rv = apr_socket_create(client, APR_INET, SOCK_STREAM,
+                                   APR_PROTO_TCP, p))
+        || (rv = apr_socket_connect(*client, sa))
+        || (rv = apr_socket_accept(server, listener, p))) {
+        return rv;
+    }
+    return apr_socket_close(listener);
+}
+
+/* Receive what is available, up to the expected length */
+static void recv_some(apr_socket_t *sock, char *buf, apr_size_t *received,
+                      apr_size_t expected)
+{
+    while (*received < expected) {
+        apr_size_t len = expected - *received;
+
+        if (apr_socket_recv(sock, buf + *received, &len) != APR_SUCCESS) {
+            break;
+        }
+        *received += len;
+    }
+}
+
+static void test_brigade_send(abts_case *tc, void *data)
+{
+    apr_int32_t flags = (apr_int32_t)(apr_intptr_t)data;
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_bucket_brigade *bb = apr_brigade_create(p, ba);
+    apr_socket_t *client, *server;
+    apr_file_t *f;
+    char *expect, *buf;
+    apr_size_t len, sent, total = 0, received = 0;
+    apr_status_t rv;
+    int i;
+
+    rv = socket_pair(&client, &server);
+    APR_ASSERT_SUCCESS(tc, "Error connecting sockets", rv);
+    if (rv != APR_SUCCESS) {
+        return;
+    }
+    apr_socket_timeout_set(client, 0);
+    apr_socket_timeout_set(server, 0);
+
+    buf = apr_palloc(p, SEND_FSIZE);
+    for (i = 0; i < SEND_FSIZE; i++) {
+        buf[i] = 'a' + i % 26;
+    }
+    rv = apr_file_open(&f, SEND_FNAME, APR_FOPEN_CREATE | APR_FOPEN_TRUNCATE
+                       | APR_FOPEN_WRITE | APR_FOPEN_READ
+                       | APR_FOPEN_SENDFILE_ENABLED, APR_FPROT_OS_DEFAULT, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating the file", rv);
+    len = SEND_FSIZE;
+    apr_file_write_full(f, buf, len, NULL);
+
+    /* Headers, file, trailers, then more of the file; with metadata */
+    apr_brigade_puts(bb, NULL, NULL, "header ");
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_immortal_create("line\n", 5,
+                                                           ba));
+    apr_brigade_insert_file(bb, f, 10, SEND_FSIZE - 10, p);
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_flush_create(ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_pool_create("trailer", 7, p,
+                                                       ba));
+    apr_brigade_insert_file(bb, f, 0, 10, p);
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_eos_create(ba));
+
+    expect = apr_pstrcat(p, "header line\n",
+                         apr_pstrmemdup(p, buf + 10, SEND_FSIZE - 10),
+                         "trailer", apr_pstrmemdup(p, buf, 10), NULL);
+    len = strlen(expect);
+    buf = apr_palloc(p, len);
+
+    /* Nonblocking, so that the sender gets partial writes and EAGAIN */
+    while (!APR_BRIGADE_EMPTY(bb)) {
+        rv = apr_brigade_send(client, bb, flags, &sent);
+        ABTS_ASSERT(tc, "apr_brigade_send failed",
+                    rv == APR_SUCCESS || APR_STATUS_IS_EAGAIN(rv));
+        if (rv != APR_SUCCESS && !APR_STATUS_IS_EAGAIN(rv)) {
+            break;
+        }
+        total += sent;
+        recv_some(server, buf, &received, len);
+    }
+    ABTS_SIZE_EQUAL(tc, len, total);
+
+    apr_socket_timeout_set(server, apr_time_from_sec(5));
+    recv_some(server, buf, &received, len);
+    ABTS_SIZE_EQUAL(tc, len, received);
+    ABTS_ASSERT(tc, "received data differs", !memcmp(buf, expect, len));
+
+    apr_socket_close(client);
+    apr_socket_close(server);
+    apr_file_close(f);
+    apr_file_remove(SEND_FNAME, p);
+    apr_brigade_destroy(bb);
+    apr_bucket_alloc_destroy(ba);
+}
+
+static int zerocopy_freed;
+
+static void zerocopy_free(void *data)
+{
+    zerocopy_freed++;
+}
+
+#define ZEROCOPY_BUCKETS 4
+#define ZEROCOPY_BUCKET_SIZE (256 * 1024)
+
+static void test_brigade_zerocopy(abts_case *tc, void *data)
+{
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_bucket_brigade *bb = apr_brigade_create(p, ba);
+    apr_socket_t *client, *server;
+    apr_pollfd_t pfd;
+    apr_int32_t nfds;
+    char *expect, *buf;
+    apr_size_t len, sent, pending, total = 0, received = 0;
+    apr_status_t rv;
+    int i, tries;
+
+    rv = socket_pair(&client, &server);
+    APR_ASSERT_SUCCESS(tc, "Error connecting sockets", rv);
+    if (rv != APR_SUCCESS) {
+        return;
+    }
+    rv = apr_socket_opt_set(client, APR_SO_ZEROCOPY, 1);
+    if (rv != APR_SUCCESS) {
+        ABTS_NOT_IMPL(tc, "zero-copy sends not supported");
+        apr_socket_close(client);
+        apr_socket_close(server);
+        return;
+    }
+    apr_socket_timeout_set(client, 0);
+    apr_socket_timeout_set(server, 0);
+
+    len = ZEROCOPY_BUCKETS * ZEROCOPY_BUCKET_SIZE;
+    expect = apr_palloc(p, len);
+    for (i = 0; i < ZEROCOPY_BUCKETS; i++) {
+        memset(expect + i * ZEROCOPY_BUCKET_SIZE, 'a' + i,
+               ZEROCOPY_BUCKET_SIZE);
+        APR_BRIGADE_INSERT_TAIL(bb,
+                apr_bucket_heap_create(expect + i * ZEROCOPY_BUCKET_SIZE,
+                                       ZEROCOPY_BUCKET_SIZE, zerocopy_free,
+                                       ba));
+    }
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_flush_create(ba));
+    buf = apr_palloc(p, len);
+    zerocopy_freed = 0;
+
+    while (!APR_BRIGADE_EMPTY(bb)) {
+        rv = apr_brigade_send(client, bb, APR_BRIGADE_SEND_ZEROCOPY, &sent);
+        ABTS_ASSERT(tc, "apr_brigade_send failed",
+                    rv == APR_SUCCESS || APR_STATUS_IS_EAGAIN(rv));
+        if (rv != APR_SUCCESS && !APR_STATUS_IS_EAGAIN(rv)) {
+            break;
+        }
+        total += sent;
+        recv_some(server, buf, &received, len);
+    }
+    ABTS_SIZE_EQUAL(tc, len, total);
+
+    apr_socket_timeout_set(server, apr_time_from_sec(5));
+    recv_some(server, buf, &received, len);
+    ABTS_SIZE_EQUAL(tc, len, received);
+    ABTS_ASSERT(tc, "received data differs", !memcmp(buf, expect, len));
+
+    /* The completions are signaled as errors on the socket */
+    pfd.p = p;
+    pfd.desc_type = APR_POLL_SOCKET;
+    pfd.reqevents = APR_POLLERR;
+    pfd.desc.s = client;
+    for (tries = 0; tries < 50; tries++) {
+        rv = apr_socket_zerocopy_reap(client, &pending);
+        APR_ASSERT_SUCCESS(tc, "reap zero-copy sends", rv);
+        if (!pending) {
+            break;
+        }
+        apr_poll(&pfd, 1, &nfds, apr_time_from_msec(100));
+    }
+    ABTS_SIZE_EQUAL(tc, 0, pending);
+    ABTS_INT_EQUAL(tc, ZEROCOPY_BUCKETS, zerocopy_freed);
+
+    apr_socket_close(client);
+    apr_socket_close(server);
+    apr_brigade_destroy(bb);
+    apr_bucket_alloc_destroy(ba);
+}
+
+static void test_read_size(abts_case *tc, void *data)
+{
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_size_t size, chunk, min, max;
+
+    min = apr_bucket_alloc_aligned_floor(ba, APR_BUCKET_BUFF_SIZE);
+    max = apr_bucket_alloc_aligned_floor(ba, APR_BUCKET_READ_SIZE_MAX);
+
+    size = apr_bucket_alloc_read_size_get(ba, &chunk);
+    ABTS_SIZE_EQUAL(tc, min, size);
+    ABTS_SIZE_EQUAL(tc, size, chunk);
+
+    /* Grows while the reads fill the buffer, up to the max */
+    do {
+        apr_bucket_alloc_read_update(ba, size, size);
+        chunk = size;
+        size = apr_bucket_alloc_read_size_get(ba, NULL);
+        ABTS_ASSERT(tc, "read size should grow", size > chunk || size == max);
+    } while (size < max);
+    ABTS_SIZE_EQUAL(tc, max, size);
+    apr_bucket_alloc_read_update(ba, size, size);
+    ABTS_SIZE_EQUAL(tc, max, apr_bucket_alloc_read_size_get(ba, NULL));
+
+    /* Stays when mostly filled, shrinks when not, down to the min */
+    apr_bucket_alloc_read_update(ba, size, size - 1);
+    ABTS_SIZE_EQUAL(tc, max, apr_bucket_alloc_read_size_get(ba, NULL));
+    apr_bucket_alloc_read_update(ba, size, size / 2);
+    ABTS_ASSERT(tc, "read size should shrink",
+                apr_bucket_alloc_read_size_get(ba, NULL) < max);
+    do {
+        apr_bucket_alloc_read_update(ba, size, 0);
+        size = apr_bucket_alloc_read_size_get(ba, NULL);
+    } while (size > min);
+    ABTS_SIZE_EQUAL(tc, min, size);
+
+    /* Several buffers of the min size with readv */
+    apr_bucket_alloc_read_size_set(ba, APR_BUCKET_BUFF_SIZE,
+                                   4 * APR_BUCKET_BUFF_SIZE,
+                                   APR_BUCKET_READ_READV);
+    size = apr_bucket_alloc_read_size_get(ba, &chunk);
+    ABTS_SIZE_EQUAL(tc, min, chunk);
+    ABTS_SIZE_EQUAL(tc, chunk, size);
+    apr_bucket_alloc_read_update(ba, size, size);
+    apr_bucket_alloc_read_update(ba, size * 2, size * 2);
+    size = apr_bucket_alloc_read_size_get(ba, &chunk);
+    ABTS_SIZE_EQUAL(tc, chunk * 4, size);
+    ABTS_SIZE_EQUAL(tc, apr_bucket_alloc_aligned_floor(ba,
+                                                       4 * APR_BUCKET_BUFF_SIZE),
+                    apr_bucket_alloc_read_size_get(ba, NULL));
+
+    apr_bucket_alloc_destroy(ba);
+}
+
+#define READ_TOTAL (256 * 1024)
+
+static void test_socket_read(abts_case *tc, void *data)
+{
+    int flags = (int)(apr_intptr_t)data;
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_bucket_brigade *bb = apr_brigade_create(p, ba);
+    apr_socket_t *client, *server;
+    apr_size_t len, chunk, largest = 0, sent = 0, received = 0;
+    char *expect, *buf;
+    apr_status_t rv;
+    int i;
+
+    rv = socket_pair(&client, &server);
+    APR_ASSERT_SUCCESS(tc, "Error connecting sockets", rv);
+    if (rv != APR_SUCCESS) {
+        return;
+    }
+    apr_socket_timeout_set(client, 0);
+    apr_socket_timeout_set(server, apr_time_from_sec(5));
+    apr_bucket_alloc_read_size_set(ba, 0, 0, flags);
+    apr_bucket_alloc_read_size_get(ba, &chunk);
+
+    expect = apr_palloc(p, READ_TOTAL);
+    for (i = 0; i < READ_TOTAL; i++) {
+        expect[i] = 'a' + i % 26;
+    }
+    buf = apr_palloc(p, READ_TOTAL);
+
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_socket_create(server, ba));
+    for (;;) {
+        apr_bucket *e = APR_BRIGADE_FIRST(bb);
+        const char *str;
+
+        while (sent < READ_TOTAL) {
+            len = READ_TOTAL - sent;
+            rv = apr_socket_send(client, expect + sent, &len);
+            sent += len;
+            if (rv != APR_SUCCESS) {
+                break;
+            }
+        }
+        if (sent == READ_TOTAL && client) {
+            apr_socket_close(client);
+            client = NULL;
+        }
+
+        rv = apr_bucket_read(e, &str, &len, APR_BLOCK_READ);
+        APR_ASSERT_SUCCESS(tc, "Error reading the socket bucket", rv);
+        if (rv != APR_SUCCESS || len == 0) {
+            break;
+        }
+        ABTS_ASSERT(tc, "too much data", received + len <= READ_TOTAL);
+        if (received + len > READ_TOTAL) {
+            break;
+        }
+        if (flags & APR_BUCKET_READ_READV) {
+            ABTS_ASSERT(tc, "readv buffer too large", len <= chunk);
+        }
+        if (len > largest) {
+            largest = len;
+        }
+        memcpy(buf + received, str, len);
+        received += len;
+        apr_bucket_delete(e);
+    }
+    ABTS_SIZE_EQUAL(tc, READ_TOTAL, received);
+    ABTS_ASSERT(tc, "received data differs", !memcmp(buf, expect, received));
+    if (!(flags & APR_BUCKET_READ_READV)) {
+        ABTS_ASSERT(tc, "read size did not grow", largest > chunk);
+    }
+
+    if (client) {
+        apr_socket_close(client);
+    }
+    apr_socket_close(server);
+    apr_brigade_destroy(bb);
+    apr_bucket_alloc_destroy(ba);
+}
+
+#define SPLICE_TOTAL (1024 * 1024)
+
+static char *make_pattern(apr_size_t len)
+{
+    char *buf = apr_palloc(p, len);
+    apr_size_t i;
+
+    for (i = 0; i < len; i++) {
+        buf[i] = 'a' + i % 26;
+    }
+    return buf;
+}
+
+static void test_socket_splice(abts_case *tc, void *data)
+{
+    apr_socket_t *src_client, *src_server, *client, *server;
+    apr_size_t len, pushed = 0, received = 0;
+    char *expect, *buf;
+    apr_status_t rv;
+
+    rv = socket_pair(&src_client, &src_server);
+    APR_ASSERT_SUCCESS(tc, "Error connecting sockets", rv);
+    rv = socket_pair(&client, &server);
+    APR_ASSERT_SUCCESS(tc, "Error connecting sockets", rv);
+    if (rv != APR_SUCCESS) {
+        return;
+    }
+    expect = make_pattern(SPLICE_TOTAL);
+    buf = apr_palloc(p, SPLICE_TOTAL);
+
+    len = 0;
+    rv = apr_socket_splice(client, NULL, &len);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "apr_socket_splice");
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "Nothing should be pending", rv);
+    ABTS_SIZE_EQUAL(tc, 0, len);
+
+    /* A small send buffer so that the destination fills up quickly; a
+     * small receive window would stall the loopback on the persist timer */
+    apr_socket_opt_set(client, APR_SO_SNDBUF, 4096);
+    apr_socket_timeout_set(src_client, 0);
+    apr_socket_timeout_set(client, 0);
+    apr_socket_timeout_set(server, 0);
+
+    /* Until the destination is full, with data left pending */
+    do {
+        len = SPLICE_TOTAL - pushed;
+        apr_socket_send(src_client, expect + pushed, &len);
+        pushed += len;
+        len = 0;
+        rv = apr_socket_splice(client, src_server, &len);
+    } while (rv == APR_SUCCESS && pushed < SPLICE_TOTAL);
+    ABTS_ASSERT(tc, "apr_socket_splice failed",
+                rv == APR_SUCCESS || APR_STATUS_IS_EAGAIN(rv));
+    apr_socket_close(src_client);
+
+    /* Then receive, the pending data coming first */
+    do {
+        recv_some(server, buf, &received, pushed);
+        len = 0;
+        rv = apr_socket_splice(client, src_server, &len);
+    } while (rv == APR_SUCCESS || APR_STATUS_IS_EAGAIN(rv));
+    ABTS_INT_EQUAL(tc, APR_EOF, rv);
+
+    apr_socket_timeout_set(server, apr_time_from_sec(5));
+    recv_some(server, buf, &received, pushed);
+    ABTS_SIZE_EQUAL(tc, pushed, received);
+    ABTS_ASSERT(tc, "received data differs", !memcmp(buf, expect, received));
+
+    apr_socket_close(src_server);
+    apr_socket_close(client);
+    apr_socket_close(server);
+}
+
+static void test_brigade_splice(abts_case *tc, void *data)
+{
+    apr_int32_t flags = (apr_int32_t)(apr_intptr_t)data;
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_bucket_brigade *bb = apr_brigade_create(p, ba);
+    apr_socket_t *src_client, *src_server, *client, *server;
+    apr_file_t *in, *out;
+    apr_size_t len, sent, pushed = 0, total = 0, received = 0;
+    char *pattern, *expect, *buf;
+    apr_status_t rv;
+
+    rv = socket_pair(&src_client, &src_server);
+    APR_ASSERT_SUCCESS(tc, "Error connecting sockets", rv);
+    rv = socket_pair(&client, &server);
+    APR_ASSERT_SUCCESS(tc, "Error connecting sockets", rv);
+    if (rv != APR_SUCCESS) {
+        return;
+    }
+    rv = apr_file_pipe_create(&in, &out, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating a pipe", rv);
+    apr_file_puts("from the pipe\n", out);
+    apr_file_close(out);
+
+    apr_socket_timeout_set(src_client, 0);
+    apr_socket_timeout_set(src_server, 0);
+    apr_socket_timeout_set(client, 0);
+    apr_socket_timeout_set(server, 0);
+
+    pattern = make_pattern(SPLICE_TOTAL);
+    expect = apr_pstrcat(p, "header\n",
+                         apr_pstrmemdup(p, pattern, SPLICE_TOTAL),
+                         "from the pipe\n", "trailer\n", NULL);
+    len = strlen(expect);
+    buf = apr_palloc(p, len);
+
+    apr_brigade_puts(bb, NULL, NULL, "header\n");
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_socket_create(src_server, ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_flush_create(ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_pipe_create(in, ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_immortal_create("trailer\n", 8,
+                                                           ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_eos_create(ba));
+
+    /* Relay what the source has, until its end */
+    while (!APR_BRIGADE_EMPTY(bb)) {
+        if (src_client) {
+            apr_size_t n = SPLICE_TOTAL - pushed;
+
+            apr_socket_send(src_client, pattern + pushed, &n);
+            pushed += n;
+            if (pushed == SPLICE_TOTAL) {
+                apr_socket_close(src_client);
+                src_client = NULL;
+            }
+        }
+        rv = apr_brigade_send(client, bb, flags, &sent);
+        ABTS_ASSERT(tc, "apr_brigade_send failed",
+                    rv == APR_SUCCESS || APR_STATUS_IS_EAGAIN(rv));
+        if (rv != APR_SUCCESS && !APR_STATUS_IS_EAGAIN(rv)) {
+            break;
+        }
+        total += sent;
+        recv_some(server, buf, &received, len);
+    }
+    ABTS_SIZE_EQUAL(tc, len, total);
+
+    apr_socket_timeout_set(server, apr_time_from_sec(5));
+    recv_some(server, buf, &received, len);
+    ABTS_SIZE_EQUAL(tc, len, received);
+    ABTS_ASSERT(tc, "received data differs", !memcmp(buf, expect, len));
+
+    apr_socket_close(src_server);
+    apr_socket_close(client);
+    apr_socket_close(server);
+    apr_brigade_destroy(bb);
+    apr_bucket_alloc_destroy(ba);
+}
+
+static volatile apr_uint32_t sharedbuf_freed;
+
+static void sharedbuf_free(void *data)
+{
+    apr_atomic_inc32(&sharedbuf_freed);
+    free(data);
+}
+
+static void test_sharedbuf(abts_case *tc, void *data)
+{
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_bucket_alloc_t *ba2 = apr_bucket_alloc_create(p);
+    apr_bucket_brigade *bb = apr_brigade_create(p, ba);
+    apr_bucket_brigade *bb2 = apr_brigade_create(p, ba2);
+    apr_bucket *e, *c;
+    char *msg = strdup("shared message");
+    char buf[32];
+    apr_size_t len;
+    apr_status_t rv;
+
+    apr_atomic_set32(&sharedbuf_freed, 0);
+    e = apr_bucket_sharedbuf_create(msg, strlen(msg), sharedbuf_free, ba);
+    ABTS_PTR_NOTNULL(tc, e);
+    ABTS_ASSERT(tc, "not a SHAREDBUF bucket", APR_BUCKET_IS_SHAREDBUF(e));
+    APR_BRIGADE_INSERT_TAIL(bb, e);
+
+    /* Split and copied within an allocator, then to another one */
+    rv = apr_bucket_split(e, 6);
+    APR_ASSERT_SUCCESS(tc, "Error splitting the bucket", rv);
+    e = APR_BUCKET_NEXT(e);
+    rv = apr_bucket_copy(e, &c);
+    APR_ASSERT_SUCCESS(tc, "Error copying the bucket", rv);
+    APR_BRIGADE_INSERT_TAIL(bb, c);
+    rv = apr_bucket_sharedbuf_copy_to(e, ba2, &c);
+    APR_ASSERT_SUCCESS(tc, "Error copying the bucket to ba2", rv);
+    ABTS_PTR_EQUAL(tc, ba2, c->list);
+    APR_BRIGADE_INSERT_TAIL(bb2, c);
+
+    rv = apr_bucket_sharedbuf_copy_to(APR_BRIGADE_FIRST(bb2), ba, &c);
+    APR_ASSERT_SUCCESS(tc, "Error copying the bucket back", rv);
+    apr_bucket_destroy(c);
+    c = apr_bucket_immortal_create("x", 1, ba);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, apr_bucket_sharedbuf_copy_to(c, ba2, &e));
+    apr_bucket_destroy(c);
+
+    len = sizeof(buf);
+    apr_brigade_flatten(bb, buf, &len);
+    ABTS_STR_NEQUAL(tc, "shared message message", buf, len);
+    ABTS_SIZE_EQUAL(tc, 22, len);
+
+    /* The data lives as long as a bucket refers to it */
+    apr_brigade_destroy(bb);
+    apr_bucket_alloc_destroy(ba);
+    ABTS_INT_EQUAL(tc, 0, apr_atomic_read32(&sharedbuf_freed));
+    len = sizeof(buf);
+    apr_brigade_flatten(bb2, buf, &len);
+    ABTS_STR_NEQUAL(tc, " message", buf, len);
+    apr_brigade_cleanup(bb2);
+    ABTS_INT_EQUAL(tc, 1, apr_atomic_read32(&sharedbuf_freed));
+
+    /* A copy is made without free_func */
+    memcpy(buf, "copied", 7);
+    e = apr_bucket_sharedbuf_create(buf, 6, NULL, ba2);
+    buf[0] = 'X';
+    APR_BRIGADE_INSERT_TAIL(bb2, e);
+    len = sizeof(buf);
+    apr_brigade_flatten(bb2, buf, &len);
+    ABTS_STR_NEQUAL(tc, "copied", buf, len);
+
+    apr_brigade_destroy(bb2);
+    apr_bucket_alloc_destroy(ba2);
+}
+
+#if APR_HAS_THREADS
+
+#define SHAREDBUF_THREADS 4
+#define SHAREDBUF_LOOPS   2000
+
+/* Each thread fans the data out to its own brigades */
+static void *APR_THREAD_FUNC sharedbuf_thread(apr_thread_t *thd, void *data)
+{
+    apr_bucket *e = data;
+    apr_pool_t *pool;
+    apr_bucket_alloc_t *ba;
+    apr_bucket_brigade *bb;
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    apr_pool_create(&pool, NULL);
+    ba = apr_bucket_alloc_create(pool);
+    bb = apr_brigade_create(pool, ba);
+    for (i = 0; i < SHAREDBUF_LOOPS && rv == APR_SUCCESS; i++) {
+        apr_bucket *c;
+        const char *str;
+        apr_size_t len;
+
+        rv = apr_bucket_sharedbuf_copy_to(e, ba, &c);
+        if (rv == APR_SUCCESS) {
+            APR_BRIGADE_INSERT_TAIL(bb, c);
+            rv = apr_bucket_split(c, 1);
+        }
+        if (rv == APR_SUCCESS) {
+            rv = apr_bucket_read(APR_BRIGADE_LAST(bb), &str, &len,
+                                 APR_BLOCK_READ);
+        }
+        if (rv == APR_SUCCESS && (len != 13 || memcmp(str, "hared message",
+                                                       len))) {
+            rv = APR_EGENERAL;
+        }
+        if (i % 16 == 15) {
+            apr_brigade_cleanup(bb);
+        }
+    }
+    apr_pool_destroy(pool);
+    apr_bucket_destroy(e);
+
+    apr_thread_exit(thd, rv);
+    return NULL;
+}
+
+static void test_sharedbuf_threaded(abts_case *tc, void *data)
+{
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_bucket *source;
+    apr_thread_t *t[SHAREDBUF_THREADS];
+    apr_pool_t *pool[SHAREDBUF_THREADS];
+    apr_status_t rv;
+    int i;
+
+    apr_atomic_set32(&sharedbuf_freed, 0);
+    source = apr_bucket_sharedbuf_create(strdup("shared message"), 14,
+                                         sharedbuf_free, ba);
+    for (i = 0; i < SHAREDBUF_THREADS; i++) {
+        apr_bucket *e;
+
+        /* The thread gets a bucket of its own allocator */
+        apr_pool_create(&pool[i], p);
+        rv = apr_bucket_sharedbuf_copy_to(source,
+                                          apr_bucket_alloc_create(pool[i]),
+                                          &e);
+        APR_ASSERT_SUCCESS(tc, "Error copying the bucket", rv);
+        rv = apr_thread_create(&t[i], NULL, sharedbuf_thread, e, p);
+        APR_ASSERT_SUCCESS(tc, "Error creating a thread", rv);
+    }
+    apr_bucket_destroy(source);
+
+    for (i = 0; i < SHAREDBUF_THREADS; i++) {
+        apr_status_t retval;
+
+        apr_thread_join(&retval, t[i]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, retval);
+        apr_pool_destroy(pool[i]);
+    }
+    /* Freed once, by the last thread */
+    ABTS_INT_EQUAL(tc, 1, apr_atomic_read32(&sharedbuf_freed));
+    apr_bucket_alloc_destroy(ba);
+}
+
+#endif /* APR_HAS_THREADS */
+
+#if APR_HAS_THREADS
+
+#define HANDOFF_PRODUCERS 3
+#define HANDOFF_BUCKETS   2000
+
+static const char handoff_msg[] = "handed off between threads";
+
+typedef struct handoff_t {
+    apr_queue_t *queue;
+    apr_bucket_alloc_t *ba;
+} handoff_t;
+
+/* Creates buckets and hands them to the consumer */
+static void *APR_THREAD_FUNC handoff_producer(apr_thread_t *thd, void *data)
+{
+    handoff_t *handoff = data;
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    for (i = 0; i < HANDOFF_BUCKETS && rv == APR_SUCCESS; i++) {
+        apr_bucket *e;
+
+        if (i % 100 == 0) {
+            /* Larger than the small nodes */
+            apr_size_t len = 3 * APR_BUCKET_BUFF_SIZE;
+            char *big = apr_bucket_alloc(len, handoff->ba);
+
+            memset(big, 'x', len);
+            memcpy(big, handoff_msg, sizeof(handoff_msg));
+            e = apr_bucket_heap_create(big, len, apr_bucket_free, handoff->ba);
+        }
+        else {
+            e = apr_bucket_heap_create(handoff_msg, sizeof(handoff_msg),
+                                       NULL, handoff->ba);
+        }
+        do {
+            rv = apr_queue_push(handoff->queue, e);
+        } while (APR_STATUS_IS_EINTR(rv));
+    }
+
+    apr_thread_exit(thd, rv);
+    return NULL;
+}
+
+static void test_alloc_threadsafe(abts_case *tc, void *data)
+{
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create_threadsafe(p);
+    apr_bucket_brigade *bb = apr_brigade_create(p, ba);
+    apr_thread_t *t[HANDOFF_PRODUCERS];
+    handoff_t handoff;
+    apr_status_t rv;
+    int round, i, bad = 0;
+
+    rv = apr_queue_create(&handoff.queue, 64, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating a queue", rv);
+    handoff.ba = ba;
+
+    /* The second round adopts the caches of the first one's threads */
+    for (round = 0; round < 2; round++) {
+        for (i = 0; i < HANDOFF_PRODUCERS; i++) {
+            rv = apr_thread_create(&t[i], NULL, handoff_producer, &handoff,
+                                   p);
+            APR_ASSERT_SUCCESS(tc, "Error creating a thread", rv);
+        }
+
+        /* The consumer splits and frees what the producers allocated */
+        for (i = 0; i < HANDOFF_PRODUCERS * HANDOFF_BUCKETS; i++) {
+            apr_bucket *e;
+            const char *str;
+            apr_size_t len;
+            void *v;
+
+            do {
+                rv = apr_queue_pop(handoff.queue, &v);
+            } while (APR_STATUS_IS_EINTR(rv));
+            if (rv != APR_SUCCESS) {
+                APR_ASSERT_SUCCESS(tc, "Error popping a bucket", rv);
+                break;
+            }
+            e = v;
+            APR_BRIGADE_INSERT_TAIL(bb, e);
+            apr_bucket_split(e, 8);
+            apr_bucket_read(APR_BUCKET_NEXT(e), &str, &len, APR_BLOCK_READ);
+            if (memcmp(str, handoff_msg + 8, sizeof(handoff_msg) - 8)) {
+                bad++;
+            }
+            if (i % 8 == 7) {
+                apr_brigade_cleanup(bb);
+            }
+        }
+        ABTS_INT_EQUAL(tc, 0, bad);
+
+        for (i = 0; i < HANDOFF_PRODUCERS; i++) {
+            apr_status_t retval;
+
+            apr_thread_join(&retval, t[i]);
+            ABTS_INT_EQUAL(tc, APR_SUCCESS, retval);
+        }
+    }
+
+    apr_brigade_destroy(bb);
+    apr_bucket_alloc_destroy(ba);
+}
+
+#endif /* APR_HAS_THREADS */
+
+#define ZSTREAM_PART1 40000
+#define ZSTREAM_TOTAL 200000
+
+/* Text which compresses, though not to almost nothing */
+static char *make_text(apr_size_t len)
+{
+    char *buf = apr_palloc(p, len);
+    apr_uint32_t x = 1;
+    apr_size_t i;
+
+    for (i = 0; i < len; i++) {
+        x = x * 1103515245 + 12345;
+        buf[i] = 'a' + (x >> 16) % 16;
+    }
+    return buf;
+}
+
+static void test_zstream(abts_case *tc, void *data)
+{
+    apr_zstream_format_e format = (apr_zstream_format_e)(apr_intptr_t)data;
+    apr_bucket_alloc_t *ba = apr_bucket_alloc_create(p);
+    apr_bucket_brigade *bb = apr_brigade_create(p, ba);
+    apr_bucket_brigade *zbb = apr_brigade_create(p, ba);
+    apr_bucket_brigade *rest = apr_brigade_create(p, ba);
+    apr_bucket_brigade *out = apr_brigade_create(p, ba);
+    apr_brigade_zstream_t *zs;
+    apr_brigade_zstream_stats_t stats;
+    apr_bucket *e;
+    apr_off_t zlen, rest_len;
+    apr_size_t len;
+    char *text, *buf;
+    int nflush = 0;
+    apr_status_t rv;
+
+    rv = apr_brigade_zstream_compress_create(&zs, format,
+                                             APR_ZSTREAM_LEVEL_DEFAULT, ba, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "compression format not built");
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "Error creating a compressor", rv);
+
+    text = make_text(ZSTREAM_TOTAL);
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_immortal_create(text, 1000, ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_transient_create(text + 1000,
+                                                            ZSTREAM_PART1
+                                                            - 1000, ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_flush_create(ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_immortal_create(text
+                                                           + ZSTREAM_PART1,
+                                                           ZSTREAM_TOTAL
+                                                           - ZSTREAM_PART1,
+                                                           ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_eos_create(ba));
+
+    rv = apr_brigade_zstream_process(zs, zbb, bb, APR_BLOCK_READ);
+    APR_ASSERT_SUCCESS(tc, "Error compressing", rv);
+    ABTS_TRUE(tc, APR_BRIGADE_EMPTY(bb));
+    ABTS_TRUE(tc, APR_BUCKET_IS_EOS(APR_BRIGADE_LAST(zbb)));
+
+    /* Heap buckets of at most a buffer, and the FLUSH in order */
+    for (e = APR_BRIGADE_FIRST(zbb); e != APR_BRIGADE_SENTINEL(zbb);
+         e = APR_BUCKET_NEXT(e)) {
+        if (APR_BUCKET_IS_FLUSH(e)) {
+            nflush++;
+            apr_brigade_split_ex(zbb, APR_BUCKET_NEXT(e), rest);
+            break;
+        }
+        ABTS_TRUE(tc, APR_BUCKET_IS_HEAP(e));
+        ABTS_TRUE(tc, e->length <= APR_BUCKET_BUFF_SIZE);
+    }
+    ABTS_INT_EQUAL(tc, 1, nflush);
+
+    apr_brigade_length(zbb, 1, &zlen);
+    apr_brigade_length(rest, 1, &rest_len);
+    zlen += rest_len;
+    apr_brigade_zstream_stats_get(zs, &stats);
+    ABTS_INT_EQUAL(tc, ZSTREAM_TOTAL, (int)stats.bytes_in);
+    ABTS_INT_EQUAL(tc, (int)zlen, (int)stats.bytes_out);
+    ABTS_TRUE(tc, zlen < ZSTREAM_TOTAL);
+
+    /* What was flushed decompresses without the rest */
+    rv = apr_brigade_zstream_decompress_create(&zs, format, ba, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating a decompressor", rv);
+    rv = apr_brigade_zstream_process(zs, out, zbb, APR_BLOCK_READ);
+    APR_ASSERT_SUCCESS(tc, "Error decompressing the flushed part", rv);
+    ABTS_TRUE(tc, APR_BUCKET_IS_FLUSH(APR_BRIGADE_LAST(out)));
+    rv = apr_brigade_pflatten(out, &buf, &len, p);
+    ABTS_SIZE_EQUAL(tc, ZSTREAM_PART1, len);
+    ABTS_ASSERT(tc, "flushed data differs", !memcmp(buf, text, len));
+    apr_brigade_cleanup(out);
+
+    rv = apr_brigade_zstream_process(zs, out, rest, APR_BLOCK_READ);
+    APR_ASSERT_SUCCESS(tc, "Error decompressing the rest", rv);
+    ABTS_TRUE(tc, APR_BUCKET_IS_EOS(APR_BRIGADE_LAST(out)));
+    rv = apr_brigade_pflatten(out, &buf, &len, p);
+    ABTS_SIZE_EQUAL(tc, ZSTREAM_TOTAL - ZSTREAM_PART1, len);
+    ABTS_ASSERT(tc, "decompressed data differs",
+                !memcmp(buf, text + ZSTREAM_PART1, len));
+    apr_brigade_zstream_stats_get(zs, &stats);
+    ABTS_INT_EQUAL(tc, (int)zlen, (int)stats.bytes_in);
+    ABTS_INT_EQUAL(tc, ZSTREAM_TOTAL, (int)stats.bytes_out);
+    apr_brigade_cleanup(out);
+
+    /* A truncated stream, then a corrupt one */
+    rv = apr_brigade_zstream_compress_create(&zs, format, 1, ba, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating a compressor", rv);
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_immortal_create(text, 100, ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_eos_create(ba));
+    rv = apr_brigade_zstream_process(zs, zbb, bb, APR_BLOCK_READ);
+    APR_ASSERT_SUCCESS(tc, "Error compressing", rv);
+    apr_bucket_delete(APR_BRIGADE_LAST(zbb));
+    apr_brigade_pflatten(zbb, &buf, &len, p);
+    apr_brigade_cleanup(zbb);
+
+    rv = apr_brigade_zstream_decompress_create(&zs, format, ba, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating a decompressor", rv);
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_immortal_create(buf, len - 4, ba));
+    APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_eos_create(ba));
+    rv = apr_brigade_zstream_process(zs, out, bb, APR_BLOCK_READ);
+    ABTS_INT_EQUAL(tc, APR_EINCOMPLETE, rv);
+    ABTS_TRUE(tc, APR_BUCKET_IS_EOS(APR_BRIGADE_FIRST(bb)));
+    apr_brigade_cleanup(bb);
+    apr_brigade_cleanup(out);
+
+    rv = apr_brigade_zstream_decompress_create(&zs, format, ba, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating a decompressor", rv);
+    apr_brigade_puts(bb, NULL, NULL, "this is not compressed at all");
+    rv = apr_brigade_zstream_process(zs, out, bb, APR_BLOCK_READ);
+    ABTS_INT_EQUAL(tc, APR_BADCH, rv);
+
+    apr_brigade_destroy(bb);
+    apr_brigade_destroy(zbb);
+    apr_brigade_destroy(rest);
+    apr_brigade_destroy(out);
+    apr_bucket_alloc_destroy(ba);
+}
+
 abts_suite *testbuckets(abts_suite *suite)
 {
     suite = ADD_SUITE(suite);
@@ -578,6 +1552,7 @@ abts_suite *testbuckets(abts_suite *suite)
     abts_run_test(suite, test_bwrite, NULL);
     abts_run_test(suite, test_splitline, NULL);
     abts_run_test(suite, test_splitboundary, NULL);
+    abts_run_test(suite, test_splitboundary_ex, NULL);
     abts_run_test(suite, test_splits, NULL);
     abts_run_test(suite, test_insertfile, NULL);
     abts_run_test(suite, test_manyfile, NULL);
@@ -585,6 +1560,29 @@ abts_suite *testbuckets(abts_suite *suite)
     abts_run_test(suite, test_partition, NULL);
     abts_run_test(suite, test_write_split, NULL);
     abts_run_test(suite, test_write_putstrs, NULL);
+    abts_run_test(suite, test_brigade_send, (void *)0);
+    abts_run_test(suite, test_brigade_send,
+                  (void *)(apr_intptr_t)APR_BRIGADE_SEND_NOSENDFILE);
+    abts_run_test(suite, test_brigade_zerocopy, NULL);
+    abts_run_test(suite, test_read_size, NULL);
+    abts_run_test(suite, test_socket_read, (void *)0);
+    abts_run_test(suite, test_socket_read,
+                  (void *)(apr_intptr_t)APR_BUCKET_READ_READV);
+    abts_run_test(suite, test_socket_splice, NULL);
+    abts_run_test(suite, test_brigade_splice, (void *)0);
+    abts_run_test(suite, test_brigade_splice,
+                  (void *)(apr_intptr_t)APR_BRIGADE_SEND_NOSPLICE);
+    abts_run_test(suite, test_sharedbuf, NULL);
+    abts_run_test(suite, test_zstream,
+                  (void *)(apr_intptr_t)APR_ZSTREAM_DEFLATE);
+    abts_run_test(suite, test_zstream,
+                  (void *)(apr_intptr_t)APR_ZSTREAM_GZIP);
+    abts_run_test(suite, test_zstream,
+                  (void *)(apr_intptr_t)APR_ZSTREAM_ZSTD);
+#if APR_HAS_THREADS
+    abts_run_test(suite, test_sharedbuf_threaded, NULL);
+    abts_run_test(suite, test_alloc_threadsafe, NULL);
+#endif
 
     return suite;
 }
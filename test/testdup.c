@@ -184,6 +184,47 @@ static void test_dup2_readwrite(abts_case *tc, void *data)
     apr_file_close(saveerr);
 }
 
+static void test_dup2_mmap(abts_case *tc, void *data)
+{
+    apr_file_t *testfile = NULL;
+    apr_file_t *target = NULL;
+    apr_size_t txtlen = sizeof(TEST);
+    char buff[50];
+    apr_status_t rv;
+
+    rv = apr_file_open(&testfile, FILEPATH "testdup2.mmap.file",
+                       APR_FOPEN_WRITE | APR_FOPEN_CREATE | APR_FOPEN_TRUNCATE,
+                       APR_FPROT_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_file_write(testfile, TEST, &txtlen);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    apr_file_close(testfile);
+
+    rv = apr_file_open(&testfile, FILEPATH "testdup2.mmap.file",
+                       APR_FOPEN_READ | APR_FOPEN_MMAP_READ
+                       | APR_FOPEN_DELONCLOSE, APR_FPROT_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    /* An unbuffered target, which reads into a buffer once dup2()ed */
+    rv = apr_file_open(&target, FILEPATH "testdup2.target.file",
+                       APR_FOPEN_READ | APR_FOPEN_WRITE | APR_FOPEN_CREATE,
+                       APR_FPROT_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    rv = apr_file_dup2(target, testfile, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    txtlen = sizeof(buff);
+    rv = apr_file_read(target, buff, &txtlen);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_SIZE_EQUAL(tc, sizeof(TEST), txtlen);
+    ABTS_STR_EQUAL(tc, TEST, buff);
+
+    apr_file_close(target);
+    apr_file_close(testfile);
+    apr_file_remove(FILEPATH "testdup2.target.file", p);
+}
+
 abts_suite *testdup(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -192,6 +233,7 @@ abts_suite *testdup(abts_suite *suite)
     abts_run_test(suite, test_file_readwrite, NULL);
     abts_run_test(suite, test_dup2, NULL);
     abts_run_test(suite, test_dup2_readwrite, NULL);
+    abts_run_test(suite, test_dup2_mmap, NULL);
 
     return suite;
 }
@@ -2207,6 +2207,86 @@ static void test_read_buffered_seek(abts_case *tc, void *data)
     apr_file_remove(fname, p);
 }
 
+static void test_mmap_read(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_file_t *f, *fw;
+    const char *fname = "data/testtest_mmap_read.dat";
+    char line[64], expected[64];
+    apr_size_t nbytes;
+    apr_off_t off;
+    int i, nlines = 500000; /* about 6MB, more than one window */
+
+    apr_file_remove(fname, p);
+
+    rv = apr_file_open(&fw, fname, APR_FOPEN_CREATE | APR_FOPEN_WRITE
+                       | APR_FOPEN_BUFFERED, APR_FPROT_OS_DEFAULT, p);
+    APR_ASSERT_SUCCESS(tc, "open test file for writing", rv);
+    for (i = 0; i < nlines; i++) {
+        apr_file_printf(fw, "line %06d\n", i);
+    }
+    rv = apr_file_flush(fw);
+    APR_ASSERT_SUCCESS(tc, "write to file", rv);
+
+    rv = apr_file_open(&f, fname, APR_FOPEN_READ | APR_FOPEN_MMAP_READ,
+                       APR_FPROT_OS_DEFAULT, p);
+    APR_ASSERT_SUCCESS(tc, "open test file for mmap reading", rv);
+
+    for (i = 0; i < nlines; i++) {
+        rv = apr_file_gets(line, sizeof(line), f);
+        if (rv != APR_SUCCESS) {
+            break;
+        }
+        apr_snprintf(expected, sizeof(expected), "line %06d\n", i);
+        if (strcmp(line, expected) != 0) {
+            break;
+        }
+    }
+    ABTS_INT_EQUAL(tc, nlines, i);
+    rv = apr_file_gets(line, sizeof(line), f);
+    ABTS_INT_EQUAL(tc, APR_EOF, rv);
+
+    /* Seek back and read across the end of the first window */
+    off = 4 * 1024 * 1024 - 6;
+    rv = apr_file_seek(f, APR_SET, &off);
+    APR_ASSERT_SUCCESS(tc, "seek in the file", rv);
+    nbytes = 12;
+    rv = apr_file_read(f, line, &nbytes);
+    APR_ASSERT_SUCCESS(tc, "read across windows", rv);
+    ABTS_SIZE_EQUAL(tc, 12, nbytes);
+    off = 0;
+    rv = apr_file_seek(f, APR_CUR, &off);
+    APR_ASSERT_SUCCESS(tc, "get the file offset", rv);
+    ABTS_INT_EQUAL(tc, 4 * 1024 * 1024 + 6, (int)off);
+    /* Ends line 349524, starts line 349525 */
+    ABTS_TRUE(tc, memcmp(line, "4\nline 34952", 12) == 0);
+
+    /* Appended data is seen at the end of the file */
+    off = -12;
+    rv = apr_file_seek(f, APR_END, &off);
+    APR_ASSERT_SUCCESS(tc, "seek from the end", rv);
+    rv = apr_file_gets(line, sizeof(line), f);
+    APR_ASSERT_SUCCESS(tc, "read the last line", rv);
+    apr_snprintf(expected, sizeof(expected), "line %06d\n", nlines - 1);
+    ABTS_STR_EQUAL(tc, expected, line);
+    rv = apr_file_gets(line, sizeof(line), f);
+    ABTS_INT_EQUAL(tc, APR_EOF, rv);
+    apr_file_puts("appended\n", fw);
+    apr_file_flush(fw);
+    rv = apr_file_gets(line, sizeof(line), f);
+    APR_ASSERT_SUCCESS(tc, "read appended data", rv);
+    ABTS_STR_EQUAL(tc, "appended\n", line);
+
+    /* The mapped buffer is not writable */
+    nbytes = 1;
+    rv = apr_file_write(f, "x", &nbytes);
+    ABTS_TRUE(tc, rv != APR_SUCCESS);
+
+    apr_file_close(f);
+    apr_file_close(fw);
+    apr_file_remove(fname, p);
+}
+
 static void test_datasync_on_file(abts_case *tc, void *data)
 {
     apr_status_t rv;
@@ -2311,6 +2391,7 @@ abts_suite *testfile(abts_suite *suite)
     abts_run_test(suite, test_read_buffered_spanning_over_bufsize, NULL);
     abts_run_test(suite, test_single_byte_reads_buffered, NULL);
     abts_run_test(suite, test_read_buffered_seek, NULL);
+    abts_run_test(suite, test_mmap_read, NULL);
     abts_run_test(suite, test_datasync_on_file, NULL);
     abts_run_test(suite, test_datasync_on_stream, NULL);
 
@@ -17,6 +17,9 @@
 #include "testglobalmutex.h"
 #include "apr_thread_proc.h"
 #include "apr_global_mutex.h"
+#include "apr_global_lockset.h"
+#include "apr_shm.h"
+#include "apr_portable.h"
 #include "apr_strings.h"
 #include "apr_errno.h"
 #include "testutil.h"
@@ -67,8 +70,10 @@ static const char *mutexname(apr_lockmech_e mech)
     case APR_LOCK_SYSVSEM: return "sysvsem";
     case APR_LOCK_PROC_PTHREAD: return "proc_pthread";
     case APR_LOCK_POSIXSEM: return "posixsem";
+    case APR_LOCK_FUTEX: return "futex";
     case APR_LOCK_DEFAULT: return "default";
     case APR_LOCK_DEFAULT_TIMED: return "default_timed";
+    case APR_LOCK_DEFAULT_GLOBAL: return "default_global";
     default: return "unknown";
     }
 }
@@ -109,6 +114,155 @@ static void test_exclusive(abts_case *tc, void *data)
     }
 }
 
+#if !APR_PROC_MUTEX_IS_GLOBAL && APR_HAS_THREADS
+static void test_default_global(abts_case *tc, void *data)
+{
+    apr_global_mutex_t *global_lock;
+    apr_os_global_mutex_t osmutex;
+    apr_lockmech_e mech;
+    apr_status_t rv;
+
+    rv = apr_global_mutex_create(&global_lock, LOCKNAME,
+                                 APR_LOCK_DEFAULT_GLOBAL, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating mutex", rv);
+
+    mech = apr_global_mutex_mech(global_lock);
+    abts_log_message("lock mechanism is: ");
+    abts_log_message(mutexname(mech));
+
+    rv = apr_os_global_mutex_get(&osmutex, global_lock);
+    APR_ASSERT_SUCCESS(tc, "Error getting the os mutex", rv);
+    if (mech == APR_LOCK_FUTEX || mech == APR_LOCK_PROC_PTHREAD) {
+        ABTS_PTR_EQUAL(tc, NULL, osmutex.thread_mutex);
+    }
+#if APR_HAS_FUTEX_SERIALIZE || APR_HAS_PROC_PTHREAD_SERIALIZE
+    else {
+        abts_fail(tc, "no thread safe mechanism chosen", __LINE__);
+    }
+#endif
+
+    APR_ASSERT_SUCCESS(tc, "Error locking mutex",
+                       apr_global_mutex_lock(global_lock));
+    APR_ASSERT_SUCCESS(tc, "Error unlocking mutex",
+                       apr_global_mutex_unlock(global_lock));
+    APR_ASSERT_SUCCESS(tc, "Error destroying mutex",
+                       apr_global_mutex_destroy(global_lock));
+}
+#endif
+
+#if APR_HAS_FORK && APR_HAS_SHARED_MEMORY
+#define LOCKSET_STRIPES  8
+#define LOCKSET_CHILDREN 4
+#define LOCKSET_COUNTER  2000
+
+static void test_lockset(abts_case *tc, void *data)
+{
+    apr_lockmech_e mech = *(apr_lockmech_e *)data;
+    apr_global_lockset_t *lockset;
+    apr_global_lockset_stats_t stats;
+    apr_proc_t child[LOCKSET_CHILDREN];
+    volatile int *counters;
+    apr_shm_t *shm;
+    apr_status_t rv;
+    unsigned int i;
+    int n, total = 0;
+
+    rv = apr_global_lockset_create(&lockset, LOCKSET_STRIPES, LOCKNAME,
+                                   mech, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "global lockset mechanism not implemented");
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "Error creating lockset", rv);
+    ABTS_INT_EQUAL(tc, LOCKSET_STRIPES, apr_global_lockset_count(lockset));
+
+    rv = apr_shm_create(&shm, LOCKSET_STRIPES * sizeof(int), NULL, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "anonymous shared memory not implemented");
+        apr_global_lockset_destroy(lockset);
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "Error creating shared memory", rv);
+    counters = apr_shm_baseaddr_get(shm);
+    memset((void *)counters, 0, LOCKSET_STRIPES * sizeof(int));
+
+    for (n = 0; n < LOCKSET_CHILDREN; n++) {
+        rv = apr_proc_fork(&child[n], p);
+        if (rv == APR_INCHILD) {
+            int x;
+
+            apr_initialize();
+            if (apr_global_lockset_child_init(&lockset, LOCKNAME, p)) {
+                _exit(1);
+            }
+            for (x = 0; x < LOCKSET_COUNTER; x++) {
+                const char *key = apr_itoa(p, x);
+                unsigned int stripe;
+                int c;
+
+                stripe = apr_global_lockset_stripe(lockset, key,
+                                                   APR_HASH_KEY_STRING);
+                if (stripe >= LOCKSET_STRIPES
+                        || apr_global_lockset_lock(lockset, stripe)) {
+                    _exit(1);
+                }
+                c = counters[stripe];
+                if (!(x % 64)) {
+                    apr_sleep(1);
+                }
+                counters[stripe] = c + 1;
+                if (apr_global_lockset_unlock(lockset, stripe)) {
+                    _exit(1);
+                }
+            }
+            _exit(0);
+        }
+        ABTS_ASSERT(tc, "Error forking child", rv == APR_INPARENT);
+    }
+    for (n = 0; n < LOCKSET_CHILDREN; n++) {
+        ABTS_INT_EQUAL(tc, 0, wait_child(tc, &child[n]));
+    }
+
+    for (i = 0; i < LOCKSET_STRIPES; i++) {
+        rv = apr_global_lockset_stats_get(lockset, i, &stats);
+        APR_ASSERT_SUCCESS(tc, "Error getting stripe statistics", rv);
+        ABTS_INT_EQUAL(tc, counters[i], stats.acquired);
+        total += counters[i];
+    }
+    ABTS_INT_EQUAL(tc, LOCKSET_CHILDREN * LOCKSET_COUNTER, total);
+
+    /* A child can't take any stripe while the parent holds them all */
+    rv = apr_global_lockset_lock_all(lockset);
+    APR_ASSERT_SUCCESS(tc, "Error locking all the stripes", rv);
+    rv = apr_proc_fork(&child[0], p);
+    if (rv == APR_INCHILD) {
+        apr_initialize();
+        if (apr_global_lockset_child_init(&lockset, LOCKNAME, p)) {
+            _exit(1);
+        }
+        for (i = 0; i < LOCKSET_STRIPES; i++) {
+            if (!APR_STATUS_IS_EBUSY(apr_global_lockset_trylock(lockset, i))) {
+                _exit(2);
+            }
+        }
+        _exit(0);
+    }
+    ABTS_ASSERT(tc, "Error forking child", rv == APR_INPARENT);
+    ABTS_INT_EQUAL(tc, 0, wait_child(tc, &child[0]));
+    rv = apr_global_lockset_unlock_all(lockset);
+    APR_ASSERT_SUCCESS(tc, "Error unlocking all the stripes", rv);
+
+    rv = apr_global_lockset_stats_get(lockset, 0, &stats);
+    APR_ASSERT_SUCCESS(tc, "Error getting stripe statistics", rv);
+    ABTS_ASSERT(tc, "trylock contention not counted", stats.contended >= 1);
+
+    APR_ASSERT_SUCCESS(tc, "Error destroying lockset",
+                       apr_global_lockset_destroy(lockset));
+    APR_ASSERT_SUCCESS(tc, "Error destroying shared memory",
+                       apr_shm_destroy(shm));
+}
+#endif
+
 abts_suite *testglobalmutex(abts_suite *suite)
 {
     apr_lockmech_e mech = APR_LOCK_DEFAULT;
@@ -127,6 +281,10 @@ abts_suite *testglobalmutex(abts_suite *suite)
     mech = APR_LOCK_PROC_PTHREAD;
     abts_run_test(suite, test_exclusive, &mech);
 #endif
+#if APR_HAS_FUTEX_SERIALIZE
+    mech = APR_LOCK_FUTEX;
+    abts_run_test(suite, test_exclusive, &mech);
+#endif
 #if APR_HAS_FCNTL_SERIALIZE
     mech = APR_LOCK_FCNTL;
     abts_run_test(suite, test_exclusive, &mech);
@@ -137,6 +295,17 @@ abts_suite *testglobalmutex(abts_suite *suite)
 #endif
     mech = APR_LOCK_DEFAULT_TIMED;
     abts_run_test(suite, test_exclusive, &mech);
+    mech = APR_LOCK_DEFAULT_GLOBAL;
+    abts_run_test(suite, test_exclusive, &mech);
+#if !APR_PROC_MUTEX_IS_GLOBAL && APR_HAS_THREADS
+    abts_run_test(suite, test_default_global, NULL);
+#endif
+#if APR_HAS_FORK && APR_HAS_SHARED_MEMORY
+    mech = APR_LOCK_DEFAULT;
+    abts_run_test(suite, test_lockset, &mech);
+    mech = APR_LOCK_DEFAULT_GLOBAL;
+    abts_run_test(suite, test_lockset, &mech);
+#endif
 
     return suite;
 }
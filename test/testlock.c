@@ -210,8 +210,10 @@ static void test_thread_mutex(abts_case *tc, void *data)
 {
     apr_thread_t *t1, *t2, *t3, *t4;
     apr_status_t s1, s2, s3, s4;
+    unsigned int flags = data ? *(unsigned int *)data
+                              : APR_THREAD_MUTEX_DEFAULT;
 
-    s1 = apr_thread_mutex_create(&thread_mutex, APR_THREAD_MUTEX_DEFAULT, p);
+    s1 = apr_thread_mutex_create(&thread_mutex, flags, p);
     ABTS_INT_EQUAL(tc, APR_SUCCESS, s1);
     ABTS_PTR_NOTNULL(tc, thread_mutex);
 
@@ -271,8 +273,9 @@ static void test_thread_rwlock(abts_case *tc, void *data)
 {
     apr_thread_t *t1, *t2, *t3, *t4;
     apr_status_t s1, s2, s3, s4;
+    unsigned int flags = data ? *(unsigned int *)data : 0;
 
-    s1 = apr_thread_rwlock_create(&rwlock, p);
+    s1 = apr_thread_rwlock_create_ex(&rwlock, flags, p);
     if (s1 == APR_ENOTIMPL) {
         ABTS_NOT_IMPL(tc, "rwlocks not implemented");
         return;
@@ -302,6 +305,40 @@ static void test_thread_rwlock(abts_case *tc, void *data)
     apr_thread_rwlock_destroy(rwlock);
 }
 
+static void test_thread_rwlock_try(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    unsigned int flags = *(unsigned int *)data;
+
+    rv = apr_thread_rwlock_create_ex(&rwlock, flags, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "rwlocks not implemented");
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "rwlock_create", rv);
+
+    APR_ASSERT_SUCCESS(tc, "rdlock", apr_thread_rwlock_rdlock(rwlock));
+    APR_ASSERT_SUCCESS(tc, "tryrdlock",
+                       apr_thread_rwlock_tryrdlock(rwlock));
+    rv = apr_thread_rwlock_trywrlock(rwlock);
+    ABTS_TRUE(tc, APR_STATUS_IS_EBUSY(rv));
+    APR_ASSERT_SUCCESS(tc, "unlock", apr_thread_rwlock_unlock(rwlock));
+    APR_ASSERT_SUCCESS(tc, "unlock", apr_thread_rwlock_unlock(rwlock));
+
+    APR_ASSERT_SUCCESS(tc, "trywrlock", apr_thread_rwlock_trywrlock(rwlock));
+    rv = apr_thread_rwlock_tryrdlock(rwlock);
+    ABTS_TRUE(tc, APR_STATUS_IS_EBUSY(rv));
+    APR_ASSERT_SUCCESS(tc, "unlock", apr_thread_rwlock_unlock(rwlock));
+
+    APR_ASSERT_SUCCESS(tc, "wrlock", apr_thread_rwlock_wrlock(rwlock));
+    APR_ASSERT_SUCCESS(tc, "unlock", apr_thread_rwlock_unlock(rwlock));
+    APR_ASSERT_SUCCESS(tc, "tryrdlock",
+                       apr_thread_rwlock_tryrdlock(rwlock));
+    APR_ASSERT_SUCCESS(tc, "unlock", apr_thread_rwlock_unlock(rwlock));
+
+    APR_ASSERT_SUCCESS(tc, "rwlock_destroy", apr_thread_rwlock_destroy(rwlock));
+}
+
 static void test_cond(abts_case *tc, void *data)
 {
     apr_thread_t *p1, *p2, *p3, *p4, *c1;
@@ -472,8 +509,10 @@ static void test_thread_unnestedmutex(abts_case *tc, void *data)
 {
     apr_thread_mutex_t *m;
     apr_status_t rv;
+    unsigned int flags = data ? *(unsigned int *)data
+                              : APR_THREAD_MUTEX_UNNESTED;
 
-    rv = apr_thread_mutex_create(&m, APR_THREAD_MUTEX_UNNESTED, p);
+    rv = apr_thread_mutex_create(&m, flags, p);
     ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
     ABTS_PTR_NOTNULL(tc, m);
 
@@ -545,16 +584,29 @@ static void threads_not_impl(abts_case *tc, void *data)
 
 abts_suite *testlock(abts_suite *suite)
 {
+#if APR_HAS_THREADS
+    static unsigned int mutex_adaptive = APR_THREAD_MUTEX_ADAPTIVE;
+    static unsigned int mutex_unnested_adaptive = APR_THREAD_MUTEX_UNNESTED
+                                                | APR_THREAD_MUTEX_ADAPTIVE;
+    static unsigned int rwlock_default = APR_THREAD_RWLOCK_DEFAULT;
+    static unsigned int rwlock_bigreader = APR_THREAD_RWLOCK_BIGREADER;
+#endif
+
     suite = ADD_SUITE(suite)
 
 #if !APR_HAS_THREADS
     abts_run_test(suite, threads_not_impl, NULL);
 #else
     abts_run_test(suite, test_thread_mutex, NULL);
+    abts_run_test(suite, test_thread_mutex, &mutex_adaptive);
     abts_run_test(suite, test_thread_timedmutex, NULL);
     abts_run_test(suite, test_thread_nestedmutex, NULL);
     abts_run_test(suite, test_thread_unnestedmutex, NULL);
+    abts_run_test(suite, test_thread_unnestedmutex, &mutex_unnested_adaptive);
     abts_run_test(suite, test_thread_rwlock, NULL);
+    abts_run_test(suite, test_thread_rwlock, &rwlock_bigreader);
+    abts_run_test(suite, test_thread_rwlock_try, &rwlock_default);
+    abts_run_test(suite, test_thread_rwlock_try, &rwlock_bigreader);
     abts_run_test(suite, test_cond, NULL);
     abts_run_test(suite, test_timeoutcond, NULL);
     abts_run_test(suite, test_timeoutmutex, NULL);
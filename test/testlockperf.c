@@ -17,6 +17,8 @@
 #include "apr_thread_proc.h"
 #include "apr_thread_mutex.h"
 #include "apr_thread_rwlock.h"
+#include "apr_proc_mutex.h"
+#include "apr_shm.h"
 #include "apr_file_io.h"
 #include "apr_errno.h"
 #include "apr_general.h"
@@ -49,6 +51,9 @@ apr_status_t test_thread_mutex(int num_threads); /* apr_thread_mutex_t */
 static apr_thread_rwlock_t *thread_rwlock;
 void * APR_THREAD_FUNC thread_rwlock_func(apr_thread_t *thd, void *data);
 apr_status_t test_thread_rwlock(int num_threads); /* apr_thread_rwlock_t */
+static volatile long rwlock_data;
+static void * APR_THREAD_FUNC thread_rwlock_read_func(apr_thread_t *thd,
+                                                      void *data);
 
 int test_thread_mutex_nested(int num_threads);
 
@@ -84,6 +89,19 @@ void * APR_THREAD_FUNC thread_rwlock_func(apr_thread_t *thd, void *data)
     return NULL;
 }
 
+static void * APR_THREAD_FUNC thread_rwlock_read_func(apr_thread_t *thd,
+                                                      void *data)
+{
+    long i, sum = 0;
+
+    for (i = 0; i < max_counter; i++) {
+        apr_thread_rwlock_rdlock(thread_rwlock);
+        sum += rwlock_data;
+        apr_thread_rwlock_unlock(thread_rwlock);
+    }
+    return (void *)sum;
+}
+
 int test_thread_mutex(int num_threads)
 {
     apr_thread_t *t[MAX_THREADS];
@@ -132,6 +150,52 @@ int test_thread_mutex(int num_threads)
     return APR_SUCCESS;
 }
 
+static int test_thread_mutex_adaptive(int num_threads)
+{
+    apr_thread_t *t[MAX_THREADS];
+    apr_status_t s[MAX_THREADS];
+    apr_time_t time_start, time_stop;
+    int i;
+
+    mutex_counter = 0;
+
+    printf("apr_thread_mutex_t Tests\n");
+    printf("%-60s", "    Initializing the apr_thread_mutex_t (ADAPTIVE)");
+    s[0] = apr_thread_mutex_create(&thread_lock, APR_THREAD_MUTEX_ADAPTIVE,
+                                   pool);
+    if (s[0] != APR_SUCCESS) {
+        printf("Failed!\n");
+        return s[0];
+    }
+    printf("OK\n");
+
+    apr_thread_mutex_lock(thread_lock);
+    printf("    Starting %d threads    ", num_threads);
+    for (i = 0; i < num_threads; ++i) {
+        s[i] = apr_thread_create(&t[i], NULL, thread_mutex_func, NULL, pool);
+        if (s[i] != APR_SUCCESS) {
+            printf("Failed!\n");
+            return s[i];
+        }
+    }
+    printf("OK\n");
+
+    time_start = apr_time_now();
+    apr_thread_mutex_unlock(thread_lock);
+
+    for (i = 0; i < num_threads; ++i) {
+        apr_thread_join(&s[i], t[i]);
+    }
+
+    time_stop = apr_time_now();
+    printf("microseconds: %" APR_INT64_T_FMT " usec\n",
+           (time_stop - time_start));
+    if (mutex_counter != max_counter * num_threads)
+        printf("error: counter = %ld\n", mutex_counter);
+
+    return APR_SUCCESS;
+}
+
 int test_thread_mutex_nested(int num_threads)
 {
     apr_thread_t *t[MAX_THREADS];
@@ -279,6 +343,168 @@ int test_thread_rwlock(int num_threads)
     return APR_SUCCESS;
 }
 
+static int test_thread_rwlock_read(int num_threads, unsigned int flags)
+{
+    apr_thread_t *t[MAX_THREADS];
+    apr_status_t s[MAX_THREADS];
+    apr_time_t time_start, time_stop;
+    int i;
+
+    rwlock_data = 1;
+
+    printf("apr_thread_rwlock_t Read Scaling Tests\n");
+    printf("%-60s", (flags & APR_THREAD_RWLOCK_BIGREADER)
+                    ? "    Initializing the apr_thread_rwlock_t (BIGREADER)"
+                    : "    Initializing the apr_thread_rwlock_t (DEFAULT)");
+    s[0] = apr_thread_rwlock_create_ex(&thread_rwlock, flags, pool);
+    if (s[0] != APR_SUCCESS) {
+        printf("Failed!\n");
+        return s[0];
+    }
+    printf("OK\n");
+
+    apr_thread_rwlock_wrlock(thread_rwlock);
+    printf("    Starting %d reader threads    ", num_threads);
+    for (i = 0; i < num_threads; ++i) {
+        s[i] = apr_thread_create(&t[i], NULL, thread_rwlock_read_func, NULL,
+                                 pool);
+        if (s[i] != APR_SUCCESS) {
+            printf("Failed!\n");
+            return s[i];
+        }
+    }
+    printf("OK\n");
+
+    time_start = apr_time_now();
+    apr_thread_rwlock_unlock(thread_rwlock);
+
+    for (i = 0; i < num_threads; ++i) {
+        apr_thread_join(&s[i], t[i]);
+    }
+
+    time_stop = apr_time_now();
+    printf("microseconds: %" APR_INT64_T_FMT " usec, "
+           "reads per second: %.0f\n", (time_stop - time_start),
+           (double)max_counter * num_threads * APR_USEC_PER_SEC
+           / (double)(time_stop - time_start + 1));
+
+    apr_thread_rwlock_destroy(thread_rwlock);
+    return APR_SUCCESS;
+}
+
+#if APR_HAS_FORK && APR_HAS_SHARED_MEMORY
+
+#define MAX_PROCS 4
+
+static int test_proc_mutex(int num_procs, apr_lockmech_e mech)
+{
+    apr_proc_mutex_t *proc_lock;
+    apr_proc_t child[MAX_PROCS];
+    volatile long *counter;
+    apr_shm_t *shm;
+    apr_time_t time_start, time_stop;
+    apr_status_t rv;
+    int i, failed = 0;
+
+    printf("apr_proc_mutex_t Tests\n");
+    printf("%-60s", "    Initializing the apr_proc_mutex_t");
+    rv = apr_proc_mutex_create(&proc_lock, NULL, mech, pool);
+    if (rv == APR_ENOTIMPL) {
+        printf("Not Implemented\n");
+        return APR_SUCCESS;
+    }
+    if (rv != APR_SUCCESS) {
+        printf("Failed!\n");
+        return rv;
+    }
+    printf("OK\n");
+    printf("    Mechanism: %s%s\n", apr_proc_mutex_name(proc_lock),
+           mech == APR_LOCK_DEFAULT ? " (default)" : "");
+
+    rv = apr_shm_create(&shm, sizeof(*counter), NULL, pool);
+    if (rv != APR_SUCCESS) {
+        apr_proc_mutex_destroy(proc_lock);
+        return rv;
+    }
+    counter = apr_shm_baseaddr_get(shm);
+    *counter = 0;
+
+    apr_proc_mutex_lock(proc_lock);
+    printf("    Starting %d processes    ", num_procs);
+    fflush(stdout);
+    for (i = 0; i < num_procs; ++i) {
+        rv = apr_proc_fork(&child[i], pool);
+        if (rv == APR_INCHILD) {
+            long n;
+
+            apr_initialize();
+            if (apr_proc_mutex_child_init(&proc_lock, NULL, pool)) {
+                _exit(1);
+            }
+            for (n = 0; n < max_counter; n++) {
+                if (apr_proc_mutex_lock(proc_lock)) {
+                    _exit(1);
+                }
+                (*counter)++;
+                if (apr_proc_mutex_unlock(proc_lock)) {
+                    _exit(1);
+                }
+            }
+            _exit(0);
+        }
+        else if (rv != APR_INPARENT) {
+            printf("Failed!\n");
+            return rv;
+        }
+    }
+    printf("OK\n");
+
+    time_start = apr_time_now();
+    apr_proc_mutex_unlock(proc_lock);
+
+    for (i = 0; i < num_procs; ++i) {
+        int code;
+        apr_exit_why_e why;
+
+        rv = apr_proc_wait(&child[i], &code, &why, APR_WAIT);
+        if (rv != APR_CHILD_DONE || why != APR_PROC_EXIT || code != 0) {
+            failed++;
+        }
+    }
+
+    time_stop = apr_time_now();
+    printf("microseconds: %" APR_INT64_T_FMT " usec, "
+           "locks per second: %.0f\n", (time_stop - time_start),
+           (double)max_counter * num_procs * APR_USEC_PER_SEC
+           / (double)(time_stop - time_start + 1));
+    if (failed || *counter != max_counter * num_procs) {
+        printf("error: counter = %ld\n", *counter);
+        rv = APR_EGENERAL;
+    }
+    else {
+        rv = APR_SUCCESS;
+    }
+
+    apr_shm_destroy(shm);
+    apr_proc_mutex_destroy(proc_lock);
+    return rv;
+}
+
+static const apr_lockmech_e proc_mechs[] = {
+    APR_LOCK_DEFAULT
+#if APR_HAS_PROC_PTHREAD_SERIALIZE
+    ,APR_LOCK_PROC_PTHREAD
+#endif
+#if APR_HAS_SYSVSEM_SERIALIZE
+    ,APR_LOCK_SYSVSEM
+#endif
+#if APR_HAS_FUTEX_SERIALIZE
+    ,APR_LOCK_FUTEX
+#endif
+};
+
+#endif /* APR_HAS_FORK && APR_HAS_SHARED_MEMORY */
+
 int main(int argc, const char * const *argv)
 {
     apr_status_t rv;
@@ -329,6 +555,12 @@ int main(int argc, const char * const *argv)
             exit(-4);
         }
 
+        if ((rv = test_thread_mutex_adaptive(i)) != APR_SUCCESS) {
+            fprintf(stderr,"thread_mutex (ADAPTIVE) test failed : [%d] %s\n",
+                    rv, apr_strerror(rv, (char*)errmsg, 200));
+            exit(-9);
+        }
+
         if ((rv = test_thread_mutex_timed(i)) != APR_SUCCESS) {
             fprintf(stderr,"thread_mutex (TIMED) test failed : [%d] %s\n",
                     rv, apr_strerror(rv, (char*)errmsg, 200));
@@ -340,7 +572,35 @@ int main(int argc, const char * const *argv)
                     rv, apr_strerror(rv, (char*)errmsg, 200));
             exit(-6);
         }
+
+        if ((rv = test_thread_rwlock_read(i, APR_THREAD_RWLOCK_DEFAULT))
+                != APR_SUCCESS) {
+            fprintf(stderr,"thread_rwlock read test failed : [%d] %s\n",
+                    rv, apr_strerror(rv, (char*)errmsg, 200));
+            exit(-7);
+        }
+
+        if ((rv = test_thread_rwlock_read(i, APR_THREAD_RWLOCK_BIGREADER))
+                != APR_SUCCESS) {
+            fprintf(stderr,"thread_rwlock (BIGREADER) read test failed : "
+                    "[%d] %s\n", rv, apr_strerror(rv, (char*)errmsg, 200));
+            exit(-8);
+        }
+    }
+
+#if APR_HAS_FORK && APR_HAS_SHARED_MEMORY
+    for (i = 1; i <= MAX_PROCS; ++i) {
+        apr_size_t j;
+
+        for (j = 0; j < sizeof(proc_mechs) / sizeof(proc_mechs[0]); ++j) {
+            if ((rv = test_proc_mutex(i, proc_mechs[j])) != APR_SUCCESS) {
+                fprintf(stderr,"proc_mutex test failed : [%d] %s\n",
+                        rv, apr_strerror(rv, (char*)errmsg, 200));
+                exit(-10);
+            }
+        }
     }
+#endif
 
     return 0;
 }
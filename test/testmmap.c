@@ -174,6 +174,52 @@ static void test_mmap_offset(abts_case *tc, void *data)
     ABTS_STR_NEQUAL(tc, addr, thisfdata + 5, thisfsize - 5);
 }
 
+static void test_mmap_advise(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+
+    ABTS_PTR_NOTNULL(tc, themmap);
+    rv = apr_mmap_advise(themmap, 0, thisfsize, APR_MMAP_ADVISE_SEQUENTIAL);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "apr_mmap_advise");
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "Error advising sequential access", rv);
+
+    /* Neither the offset nor the length need to be aligned */
+    rv = apr_mmap_advise(themmap, 5, thisfsize, APR_MMAP_ADVISE_WILLNEED);
+    APR_ASSERT_SUCCESS(tc, "Error advising an unaligned range", rv);
+    rv = apr_mmap_advise(themmap, 0, 0, APR_MMAP_ADVISE_RANDOM);
+    APR_ASSERT_SUCCESS(tc, "Error advising an empty range", rv);
+    rv = apr_mmap_advise(themmap, thisfsize + 1, 1, APR_MMAP_ADVISE_NORMAL);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+
+    /* Dropped pages of a file mapping are read again */
+    rv = apr_mmap_advise(themmap, 0, thisfsize, APR_MMAP_ADVISE_DONTNEED);
+    APR_ASSERT_SUCCESS(tc, "Error advising the pages are not needed", rv);
+    ABTS_STR_NEQUAL(tc, themmap->mm, thisfdata, thisfsize);
+
+    rv = apr_mmap_advise(themmap, 0, thisfsize, APR_MMAP_ADVISE_NORMAL);
+    APR_ASSERT_SUCCESS(tc, "Error advising normal access", rv);
+}
+
+static void test_mmap_populate(abts_case *tc, void *data)
+{
+    apr_off_t *offset = data;
+    apr_mmap_t *mm = NULL;
+    apr_status_t rv;
+
+    rv = apr_mmap_create(&mm, thefile, *offset, thisfsize,
+                         APR_MMAP_READ | APR_MMAP_POPULATE, ptest);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_PTR_NOTNULL(tc, mm);
+    if (mm) {
+        ABTS_STR_NEQUAL(tc, mm->mm, thisfdata, thisfsize);
+        rv = apr_mmap_delete(mm);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+}
+
 #endif
 
 abts_suite *testmmap(abts_suite *suite)
@@ -193,7 +239,9 @@ abts_suite *testmmap(abts_suite *suite)
         abts_run_test(suite, test_mmap_create, &test_set[i].offset);
         abts_run_test(suite, test_mmap_contents, &test_set[i].offset);
         abts_run_test(suite, test_mmap_offset, &test_set[i].offset);
+        abts_run_test(suite, test_mmap_advise, &test_set[i].offset);
         abts_run_test(suite, test_mmap_delete, NULL);
+        abts_run_test(suite, test_mmap_populate, &test_set[i].offset);
         abts_run_test(suite, test_file_close, NULL);
         apr_pool_clear(ptest);
     }
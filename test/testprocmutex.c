@@ -240,6 +240,57 @@ static void proc_mutex(abts_case *tc, void *data)
     APR_ASSERT_SUCCESS(tc, "Error destroying shared memory block", rv);
 }
 
+#if APR_HAS_FUTEX_SERIALIZE
+/* Have a child die holding the mutex */
+static void futex_orphan(abts_case *tc)
+{
+    apr_proc_t child;
+    apr_status_t rv;
+
+    rv = apr_proc_fork(&child, p);
+    if (rv == APR_INCHILD) {
+        apr_initialize();
+        if (apr_proc_mutex_child_init(&proc_lock, NULL, p)
+                || apr_proc_mutex_lock(proc_lock)) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    ABTS_ASSERT(tc, "fork failed", rv == APR_INPARENT);
+    await_child(tc, &child);
+}
+
+static void proc_mutex_futex_recovery(abts_case *tc, void *data)
+{
+    apr_proc_mutex_stats_t stats;
+    apr_status_t rv;
+
+    rv = apr_proc_mutex_create(&proc_lock, NULL, APR_LOCK_FUTEX, p);
+    APR_ASSERT_SUCCESS(tc, "create the mutex", rv);
+
+    /* Polling with trylock gets the mutex back too */
+    futex_orphan(tc);
+    rv = apr_proc_mutex_trylock(proc_lock);
+    APR_ASSERT_SUCCESS(tc, "recover the mutex with trylock", rv);
+    rv = apr_proc_mutex_unlock(proc_lock);
+    APR_ASSERT_SUCCESS(tc, "unlock the recovered mutex", rv);
+
+    futex_orphan(tc);
+    rv = apr_proc_mutex_timedlock(proc_lock, apr_time_from_sec(5));
+    APR_ASSERT_SUCCESS(tc, "recover the mutex", rv);
+    rv = apr_proc_mutex_unlock(proc_lock);
+    APR_ASSERT_SUCCESS(tc, "unlock the recovered mutex", rv);
+
+    rv = apr_proc_mutex_stats_get(proc_lock, &stats);
+    APR_ASSERT_SUCCESS(tc, "get the statistics", rv);
+    ABTS_INT_EQUAL(tc, 4, stats.acquired); /* children included */
+    ABTS_INT_EQUAL(tc, 2, stats.contended);
+    ABTS_INT_EQUAL(tc, 2, stats.recovered);
+
+    rv = apr_proc_mutex_destroy(proc_lock);
+    APR_ASSERT_SUCCESS(tc, "destroy the mutex", rv);
+}
+#endif
 
 abts_suite *testprocmutex(abts_suite *suite)
 {
@@ -259,6 +310,9 @@ abts_suite *testprocmutex(abts_suite *suite)
 #endif
 #if APR_HAS_PROC_PTHREAD_SERIALIZE
         ,{APR_LOCK_PROC_PTHREAD, "proc_pthread"}
+#endif
+#if APR_HAS_FUTEX_SERIALIZE
+        ,{APR_LOCK_FUTEX, "futex"}
 #endif
         ,{APR_LOCK_DEFAULT_TIMED, "default_timed"}
     };
@@ -268,6 +322,9 @@ abts_suite *testprocmutex(abts_suite *suite)
     for (i = 0; i < sizeof(lockmechs) / sizeof(lockmechs[0]); i++) {
         abts_run_test(suite, proc_mutex, &lockmechs[i]);
     }
+#if APR_HAS_FUTEX_SERIALIZE
+    abts_run_test(suite, proc_mutex_futex_recovery, NULL);
+#endif
     return suite;
 }
 
@@ -0,0 +1,246 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_rcu.h"
+#include "apr_atomic.h"
+#include "apr_thread_proc.h"
+#include "apr_errno.h"
+#include "apr_general.h"
+#include "abts.h"
+#include "testutil.h"
+
+typedef struct config_t {
+    int alive;
+    int a, b;
+} config_t;
+
+static apr_status_t config_cleanup(void *data)
+{
+    config_t *config = data;
+
+    config->alive = 0;
+    return APR_SUCCESS;
+}
+
+/* The config lives in its own pool, and dies with it */
+static config_t *make_config(apr_pool_t **pool, int n)
+{
+    config_t *config;
+
+    apr_pool_create(pool, p);
+    config = apr_palloc(*pool, sizeof(*config));
+    config->alive = 1;
+    config->a = config->b = n;
+    apr_pool_cleanup_register(*pool, config, config_cleanup,
+                              apr_pool_cleanup_null);
+    return config;
+}
+
+static void test_seqlock(abts_case *tc, void *data)
+{
+    apr_seqlock_t *seqlock;
+    apr_uint32_t seq;
+    apr_status_t rv;
+
+    rv = apr_seqlock_create(&seqlock, p);
+    APR_ASSERT_SUCCESS(tc, "Error creating a seqlock", rv);
+
+    seq = apr_seqlock_read_begin(seqlock);
+    ABTS_INT_EQUAL(tc, 0, apr_seqlock_read_retry(seqlock, seq));
+
+    seq = apr_seqlock_read_begin(seqlock);
+    apr_seqlock_write_begin(seqlock);
+    apr_seqlock_write_end(seqlock);
+    ABTS_TRUE(tc, apr_seqlock_read_retry(seqlock, seq));
+
+    seq = apr_seqlock_read_begin(seqlock);
+    ABTS_INT_EQUAL(tc, 0, apr_seqlock_read_retry(seqlock, seq));
+}
+
+static void test_rcu_retire(abts_case *tc, void *data)
+{
+    apr_pool_t *rcu_pool, *pool1, *pool2;
+    apr_rcu_t *rcu;
+    apr_rcu_reader_t *reader;
+    config_t *config1, *config2, *cur;
+    void *volatile shared;
+    apr_status_t rv;
+
+    apr_pool_create(&rcu_pool, p);
+    rv = apr_rcu_create(&rcu, rcu_pool);
+    APR_ASSERT_SUCCESS(tc, "Error creating an rcu domain", rv);
+    rv = apr_rcu_reader_register(&reader, rcu, rcu_pool);
+    APR_ASSERT_SUCCESS(tc, "Error registering a reader", rv);
+
+    config1 = make_config(&pool1, 1);
+    config2 = make_config(&pool2, 2);
+    shared = config1;
+
+    /* The reader in its critical section keeps the old config alive */
+    apr_rcu_read_lock(reader);
+    cur = apr_rcu_dereference(&shared);
+    ABTS_PTR_EQUAL(tc, config1, cur);
+    ABTS_PTR_EQUAL(tc, config1, apr_rcu_publish(rcu, &shared, config2,
+                                                pool1));
+    ABTS_INT_EQUAL(tc, 1, cur->alive);
+
+    apr_rcu_quiescent(reader);
+    cur = apr_rcu_dereference(&shared);
+    ABTS_PTR_EQUAL(tc, config2, cur);
+    apr_rcu_read_unlock(reader);
+
+    rv = apr_rcu_synchronize(rcu);
+    APR_ASSERT_SUCCESS(tc, "Error synchronizing", rv);
+    ABTS_INT_EQUAL(tc, 0, config1->alive);
+
+    /* Outside of critical sections, retiring destroys at once */
+    rv = apr_rcu_retire(rcu, pool2);
+    APR_ASSERT_SUCCESS(tc, "Error retiring a pool", rv);
+    ABTS_INT_EQUAL(tc, 0, config2->alive);
+
+    /* Pending pools are destroyed with the domain */
+    config1 = make_config(&pool1, 3);
+    apr_rcu_read_lock(reader);
+    apr_rcu_retire(rcu, pool1);
+    ABTS_INT_EQUAL(tc, 1, config1->alive);
+    apr_pool_destroy(rcu_pool);
+    ABTS_INT_EQUAL(tc, 0, config1->alive);
+}
+
+#if APR_HAS_THREADS
+
+#define NUM_READERS     4
+#define NUM_UPDATES     2000
+
+static volatile apr_uint32_t done;
+static void *volatile shared_config;
+static apr_rcu_t *shared_rcu;
+static apr_seqlock_t *shared_seqlock;
+static config_t seq_config;
+
+static void *APR_THREAD_FUNC rcu_reader(apr_thread_t *thd, void *data)
+{
+    apr_rcu_reader_t *reader;
+    apr_status_t rv = APR_SUCCESS;
+    apr_pool_t *pool;
+    int i = 0;
+
+    apr_pool_create(&pool, NULL);
+    apr_rcu_reader_register(&reader, shared_rcu, pool);
+    apr_rcu_read_lock(reader);
+    while (!apr_atomic_read32(&done)) {
+        config_t *config = apr_rcu_dereference(&shared_config);
+
+        if (!config->alive || config->a != config->b) {
+            rv = APR_EGENERAL;
+        }
+        if (++i % 16 == 0) {
+            apr_rcu_quiescent(reader);
+        }
+    }
+    apr_rcu_read_unlock(reader);
+    apr_pool_destroy(pool);
+
+    apr_thread_exit(thd, rv);
+    return NULL;
+}
+
+static void *APR_THREAD_FUNC seqlock_reader(apr_thread_t *thd, void *data)
+{
+    apr_status_t rv = APR_SUCCESS;
+
+    while (!apr_atomic_read32(&done)) {
+        apr_uint32_t seq;
+        int a, b;
+
+        do {
+            seq = apr_seqlock_read_begin(shared_seqlock);
+            a = seq_config.a;
+            b = seq_config.b;
+        } while (apr_seqlock_read_retry(shared_seqlock, seq));
+        if (a != b) {
+            rv = APR_EGENERAL;
+        }
+    }
+
+    apr_thread_exit(thd, rv);
+    return NULL;
+}
+
+static void test_threaded(abts_case *tc, void *data)
+{
+    apr_thread_t *t[2 * NUM_READERS];
+    apr_pool_t *rcu_pool, *pool, *old_pool;
+    apr_status_t rv;
+    int i;
+
+    apr_pool_create(&rcu_pool, p);
+    apr_rcu_create(&shared_rcu, rcu_pool);
+    apr_seqlock_create(&shared_seqlock, rcu_pool);
+    shared_config = make_config(&old_pool, 0);
+    apr_atomic_set32(&done, 0);
+
+    for (i = 0; i < NUM_READERS; i++) {
+        rv = apr_thread_create(&t[2 * i], NULL, rcu_reader, NULL, p);
+        APR_ASSERT_SUCCESS(tc, "Error creating a thread", rv);
+        rv = apr_thread_create(&t[2 * i + 1], NULL, seqlock_reader, NULL, p);
+        APR_ASSERT_SUCCESS(tc, "Error creating a thread", rv);
+    }
+
+    for (i = 1; i <= NUM_UPDATES; i++) {
+        config_t *config = make_config(&pool, i);
+
+        apr_rcu_publish(shared_rcu, &shared_config, config, old_pool);
+        old_pool = pool;
+
+        apr_seqlock_write_begin(shared_seqlock);
+        seq_config.a = i;
+        apr_thread_yield();
+        seq_config.b = i;
+        apr_seqlock_write_end(shared_seqlock);
+
+        if (i % 100 == 0) {
+            apr_thread_yield();
+        }
+    }
+    apr_atomic_set32(&done, 1);
+
+    for (i = 0; i < 2 * NUM_READERS; i++) {
+        apr_status_t retval;
+
+        apr_thread_join(&retval, t[i]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, retval);
+    }
+
+    apr_rcu_synchronize(shared_rcu);
+    apr_pool_destroy(old_pool);
+    apr_pool_destroy(rcu_pool);
+}
+
+#endif /* APR_HAS_THREADS */
+
+abts_suite *testrcu(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite);
+
+    abts_run_test(suite, test_seqlock, NULL);
+    abts_run_test(suite, test_rcu_retire, NULL);
+#if APR_HAS_THREADS
+    abts_run_test(suite, test_threaded, NULL);
+#endif
+
+    return suite;
+}
@@ -35,11 +35,13 @@
 #define RESLIST_SMAX 10
 #define RESLIST_HMAX 20
 #define RESLIST_TTL  APR_TIME_C(3500) /* 3.5 ms */
+#define MAINTAINER_TTL  APR_TIME_C(100000) /* 100 ms */
 #define CONSUMER_THREADS 25
 #define CONSUMER_ITERATIONS 100
 #define CONSTRUCT_SLEEP_TIME  APR_TIME_C(2500) /* 2.5 ms */
 #define DESTRUCT_SLEEP_TIME   APR_TIME_C(1000) /* 1.0 ms */
 #define WORK_DELAY_SLEEP_TIME APR_TIME_C(1500) /* 1.5 ms */
+#define TEST_AFFINITY 0x100 /* not an acquire flag, enables affinity */
 
 typedef struct {
     apr_interval_time_t sleep_upon_construct;
@@ -221,7 +223,8 @@ static void test_reslist(abts_case *tc, void *data)
     my_parameters_t *params;
     apr_thread_pool_t *thrp;
     my_thread_info_t thread_info[CONSUMER_THREADS];
-    int acquire_flags = (int)(apr_uintptr_t)data;
+    int acquire_flags = (int)(apr_uintptr_t)data & APR_RESLIST_ACQUIRE_MASK;
+    int affinity = (int)(apr_uintptr_t)data & TEST_AFFINITY;
 
     rv = apr_thread_pool_create(&thrp, CONSUMER_THREADS/2, CONSUMER_THREADS, p);
     ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
@@ -238,6 +241,11 @@ static void test_reslist(abts_case *tc, void *data)
                             params, p);
     ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
 
+    if (affinity) {
+        rv = apr_reslist_affinity_set(rl, 1);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+
     for (i = 0; i < CONSUMER_THREADS; i++) {
         thread_info[i].tid = i;
         thread_info[i].tc = tc;
@@ -299,6 +307,130 @@ static void test_reslist_no_ttl(abts_case *tc, void *data)
     ABTS_INT_EQUAL(tc, params->d_count, 1);
 }
 
+static void test_reslist_affinity(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_reslist_t *rl;
+    my_parameters_t *params;
+    my_resource_t *res, *res2;
+
+    params = apr_pcalloc(p, sizeof(*params));
+
+    rv = apr_reslist_create(&rl, /*no min*/0, /*smax*/0, /*max*/2,
+                            RESLIST_TTL, my_constructor, my_destructor,
+                            params, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_reslist_affinity_set(rl, 1);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    rv = apr_reslist_acquire(rl, (void **)&res);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, 0, res->id);
+    rv = apr_reslist_acquire(rl, (void **)&res2);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, 1, res2->id);
+    ABTS_INT_EQUAL(tc, 2, apr_reslist_acquired_count(rl));
+
+    /* The last one released is cached for this thread */
+    rv = apr_reslist_release(rl, res);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_reslist_release(rl, res2);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, 0, apr_reslist_acquired_count(rl));
+
+    rv = apr_reslist_acquire(rl, (void **)&res);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_PTR_EQUAL(tc, res2, res);
+    ABTS_INT_EQUAL(tc, 2, params->c_count);
+
+    /* Expired resources are not handed back */
+    rv = apr_reslist_release(rl, res);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    apr_sleep(RESLIST_TTL * 2);
+    rv = apr_reslist_acquire(rl, (void **)&res);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, 3, params->c_count);
+    ABTS_INT_EQUAL(tc, 2, params->d_count);
+    ABTS_INT_EQUAL(tc, 2, res->id);
+
+    rv = apr_reslist_release(rl, res);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    rv = apr_reslist_destroy(rl);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, params->c_count, params->d_count);
+}
+
+static void test_reslist_maintainer(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_reslist_t *rl;
+    apr_reslist_stats_t stats;
+    apr_thread_pool_t *thrp;
+    my_parameters_t *params;
+    my_resource_t *res[2];
+    apr_uint32_t count;
+    int i;
+
+    params = apr_pcalloc(p, sizeof(*params));
+    params->sleep_upon_construct = CONSTRUCT_SLEEP_TIME;
+
+    rv = apr_thread_pool_create(&thrp, 1, 1, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    rv = apr_reslist_create(&rl, /*min*/2, /*smax*/2, /*max*/8, MAINTAINER_TTL,
+                            my_constructor, my_destructor, params, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, 2, params->c_count);
+
+    rv = apr_reslist_maintainer_set(rl, thrp, 0);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    /* Taking the idle resources has the maintainer replenish them */
+    for (i = 0; i < 2; i++) {
+        rv = apr_reslist_acquire(rl, (void **)&res[i]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+    for (i = 0; i < 100; i++) {
+        apr_reslist_stats_get(rl, &stats);
+        if (stats.constructed == 4) {
+            break;
+        }
+        apr_sleep(CONSTRUCT_SLEEP_TIME);
+    }
+    ABTS_INT_EQUAL(tc, 4, stats.constructed);
+    ABTS_INT_EQUAL(tc, 2, stats.maintained);
+    ABTS_INT_EQUAL(tc, 0, stats.failed);
+    ABTS_TRUE(tc, stats.max >= CONSTRUCT_SLEEP_TIME);
+    ABTS_TRUE(tc, stats.total >= 4 * CONSTRUCT_SLEEP_TIME);
+    for (count = 0, i = 0; i < APR_RESLIST_LATENCY_SLOTS; i++) {
+        count += stats.latency[i];
+    }
+    ABTS_INT_EQUAL(tc, 4, count);
+
+    /* Now run it periodically, the resources above smax must expire */
+    rv = apr_reslist_maintainer_set(rl, thrp, MAINTAINER_TTL);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    for (i = 0; i < 2; i++) {
+        rv = apr_reslist_release(rl, res[i]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+    for (i = 0; i < 100 && params->d_count < 2; i++) {
+        apr_sleep(MAINTAINER_TTL / 10);
+    }
+    rv = apr_reslist_maintainer_set(rl, NULL, 0);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, 2, params->d_count);
+    ABTS_INT_EQUAL(tc, 4, params->c_count);
+
+    rv = apr_reslist_destroy(rl);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, params->c_count, params->d_count);
+
+    rv = apr_thread_pool_destroy(thrp);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+}
+
 #endif /* APR_HAS_THREADS */
 
 abts_suite *testreslist(abts_suite *suite)
@@ -311,6 +443,11 @@ abts_suite *testreslist(abts_suite *suite)
     abts_run_test(suite, test_reslist,
                   (void*)(apr_uintptr_t)APR_RESLIST_ACQUIRE_FIFO);
     abts_run_test(suite, test_reslist_no_ttl, NULL);
+    abts_run_test(suite, test_reslist,
+                  (void*)(apr_uintptr_t)(APR_RESLIST_ACQUIRE_LIFO
+                                         | TEST_AFFINITY));
+    abts_run_test(suite, test_reslist_affinity, NULL);
+    abts_run_test(suite, test_reslist_maintainer, NULL);
 #endif
 
     return suite;
@@ -177,6 +177,100 @@ static void test_rmm(abts_case *tc, void *data)
     apr_pool_destroy(pool);
 }
 
+#define MANY_COUNT 2000
+#define MANY_MAX_SIZE 300
+
+static void test_rmm_many(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_pool_t *pool;
+    apr_shm_t *shm;
+    apr_rmm_t *rmm;
+    apr_size_t size, total;
+    apr_rmm_off_t *off;
+    apr_uint32_t seed = 1;
+    int i, j, round;
+
+    rv = apr_pool_create(&pool, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    total = MANY_COUNT * MANY_MAX_SIZE;
+    size = total + apr_rmm_overhead_get(MANY_COUNT + 1);
+    rv = apr_shm_create(&shm, size, NULL, pool);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+
+    rv = apr_rmm_init(&rmm, NULL, apr_shm_baseaddr_get(shm), size, pool);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    off = apr_pcalloc(pool, MANY_COUNT * sizeof(apr_rmm_off_t));
+    for (round = 0; round < 4; round++) {
+        /* Allocate blocks of random sizes, tagging each of them */
+        for (i = 0; i < MANY_COUNT; i++) {
+            seed = seed * 1103515245 + 12345;
+            off[i] = apr_rmm_malloc(rmm, 1 + (seed >> 8) % MANY_MAX_SIZE);
+            ABTS_TRUE(tc, off[i] != 0);
+            if (off[i]) {
+                *(int *)apr_rmm_addr_get(rmm, off[i]) = i;
+            }
+        }
+
+        /* Free half of them, in a scattered order, and reallocate */
+        for (i = 0; i < MANY_COUNT; i += 2) {
+            j = (i * 7 + round) % MANY_COUNT;
+            rv = apr_rmm_free(rmm, off[j]);
+            ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+            off[j] = apr_rmm_malloc(rmm, 1 + (i % MANY_MAX_SIZE));
+            ABTS_TRUE(tc, off[j] != 0);
+            if (off[j]) {
+                *(int *)apr_rmm_addr_get(rmm, off[j]) = j;
+            }
+        }
+
+        for (i = 0; i < MANY_COUNT; i++) {
+            ABTS_INT_EQUAL(tc, i, *(int *)apr_rmm_addr_get(rmm, off[i]));
+        }
+
+        /* Double frees are caught */
+        rv = apr_rmm_free(rmm, off[0]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        rv = apr_rmm_free(rmm, off[0]);
+        ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+        off[0] = 0;
+
+        /* Free everything in a scattered order */
+        for (i = 1; i < MANY_COUNT; i++) {
+            j = (int)(((apr_uint64_t)i * 1237) % MANY_COUNT);
+            if (off[j]) {
+                rv = apr_rmm_free(rmm, off[j]);
+                ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+                off[j] = 0;
+            }
+        }
+        for (i = 1; i < MANY_COUNT; i++) {
+            if (off[i]) {
+                rv = apr_rmm_free(rmm, off[i]);
+                ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+            }
+        }
+
+        /* Everything was coalesced back into one block */
+        off[0] = apr_rmm_malloc(rmm, total);
+        ABTS_TRUE(tc, off[0] != 0);
+        rv = apr_rmm_free(rmm, off[0]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+
+    rv = apr_rmm_destroy(rmm);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    rv = apr_shm_destroy(shm);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    apr_pool_destroy(pool);
+}
+
 #endif /* APR_HAS_SHARED_MEMORY */
 
 abts_suite *testrmm(abts_suite *suite)
@@ -185,6 +279,7 @@ abts_suite *testrmm(abts_suite *suite)
 
 #if APR_HAS_SHARED_MEMORY
     abts_run_test(suite, test_rmm, NULL);
+    abts_run_test(suite, test_rmm_many, NULL);
 #endif
 
     return suite;
@@ -78,6 +78,65 @@ static void test_shm_allocate(abts_case *tc, void *data)
     APR_ASSERT_SUCCESS(tc, "Error destroying shared memory block", rv);
 }
 
+static void test_create_ex_flags(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_shm_t *shm = NULL;
+    apr_size_t pagesize;
+
+    rv = apr_shm_create_ex(&shm, SHARED_SIZE, NULL, p,
+                           APR_SHM_HUGEPAGES | APR_SHM_PREFAULT
+                           | APR_SHM_NUMA_INTERLEAVE);
+    APR_ASSERT_SUCCESS(tc, "Error allocating shared memory block", rv);
+    ABTS_PTR_NOTNULL(tc, shm);
+    ABTS_SIZE_EQUAL(tc, SHARED_SIZE, apr_shm_size_get(shm));
+
+    /* Whatever backs the segment, its pages are a power of two */
+    pagesize = apr_shm_pagesize_get(shm);
+    ABTS_TRUE(tc, pagesize >= 512);
+    ABTS_TRUE(tc, (pagesize & (pagesize - 1)) == 0);
+
+    boxes = apr_shm_baseaddr_get(shm);
+    ABTS_PTR_NOTNULL(tc, boxes);
+    memset(boxes, 0, SHARED_SIZE);
+
+    rv = apr_shm_destroy(shm);
+    APR_ASSERT_SUCCESS(tc, "Error destroying shared memory block", rv);
+
+    rv = apr_shm_create_ex(&shm, SHARED_SIZE, SHARED_FILENAME, p,
+                           APR_SHM_HUGEPAGES | APR_SHM_PREFAULT);
+    if (rv == APR_SUCCESS) {
+        apr_shm_t *shm2 = NULL;
+
+        rv = apr_shm_attach_ex(&shm2, SHARED_FILENAME, p, APR_SHM_PREFAULT);
+        APR_ASSERT_SUCCESS(tc, "Error attaching to shared memory block", rv);
+        if (rv == APR_SUCCESS) {
+            ABTS_SIZE_EQUAL(tc, SHARED_SIZE, apr_shm_size_get(shm2));
+            rv = apr_shm_detach(shm2);
+            APR_ASSERT_SUCCESS(tc, "Error detaching from shared memory", rv);
+        }
+        rv = apr_shm_destroy(shm);
+        APR_ASSERT_SUCCESS(tc, "Error destroying shared memory block", rv);
+    }
+    else if (!APR_STATUS_IS_ENOTIMPL(rv)) {
+        APR_ASSERT_SUCCESS(tc, "Error allocating shared memory block", rv);
+    }
+
+    /* Locking may exceed RLIMIT_MEMLOCK, but must not fail otherwise */
+    rv = apr_shm_create_ex(&shm, SHARED_SIZE, NULL, p,
+                           APR_SHM_LOCK | APR_SHM_NUMA_LOCAL);
+    if (rv == APR_SUCCESS) {
+        boxes = apr_shm_baseaddr_get(shm);
+        memset(boxes, 0, SHARED_SIZE);
+        rv = apr_shm_destroy(shm);
+        APR_ASSERT_SUCCESS(tc, "Error destroying shared memory block", rv);
+    }
+    else if (!APR_STATUS_IS_ENOMEM(rv) && !APR_STATUS_IS_ENOTIMPL(rv)
+             && rv != APR_FROM_OS_ERROR(EPERM)) {
+        APR_ASSERT_SUCCESS(tc, "Error locking shared memory block", rv);
+    }
+}
+
 #if APR_HAS_FORK
 static void test_anon(abts_case *tc, void *data)
 {
@@ -295,6 +354,7 @@ abts_suite *testshm(abts_suite *suite)
     abts_run_test(suite, test_anon_create, NULL);
     abts_run_test(suite, test_check_size, NULL);
     abts_run_test(suite, test_shm_allocate, NULL);
+    abts_run_test(suite, test_create_ex_flags, NULL);
 #if APR_HAS_FORK
     abts_run_test(suite, test_anon, NULL);
 #endif
@@ -0,0 +1,387 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_shm.h"
+#include "apr_shm_hash.h"
+#include "apr_thread_proc.h"
+#include "apr_errno.h"
+#include "apr_general.h"
+#include "apr_strings.h"
+#include "apr_time.h"
+#include "abts.h"
+#include "testutil.h"
+
+#if APR_HAS_SHARED_MEMORY
+
+#define KEY_MAX 32
+#define VAL_MAX 64
+#define SHARED_FILENAME "data/apr.testshmhash.shm"
+
+static apr_shm_hash_t *make_hash(abts_case *tc, apr_uint32_t capacity,
+                                 int flags, apr_pool_t *pool)
+{
+    apr_shm_hash_t *hash;
+    apr_shm_t *shm;
+    apr_status_t rv;
+
+    rv = apr_shm_create(&shm, apr_shm_hash_size(capacity, KEY_MAX, VAL_MAX),
+                        NULL, pool);
+    APR_ASSERT_SUCCESS(tc, "Error creating shared memory", rv);
+    if (rv != APR_SUCCESS) {
+        return NULL;
+    }
+
+    rv = apr_shm_hash_init(&hash, shm, KEY_MAX, VAL_MAX, flags, pool);
+    APR_ASSERT_SUCCESS(tc, "Error initializing the hash table", rv);
+    if (rv != APR_SUCCESS) {
+        return NULL;
+    }
+    ABTS_TRUE(tc, apr_shm_hash_capacity(hash) >= capacity);
+    return hash;
+}
+
+static int has_key(apr_shm_hash_t *hash, const char *key)
+{
+    char val[VAL_MAX];
+    apr_size_t vlen = sizeof(val);
+
+    return apr_shm_hash_get(hash, key, APR_HASH_KEY_STRING,
+                            val, &vlen) == APR_SUCCESS;
+}
+
+static void test_basic(abts_case *tc, void *data)
+{
+    apr_shm_hash_t *hash;
+    char val[VAL_MAX];
+    apr_size_t vlen;
+    apr_status_t rv;
+
+    hash = make_hash(tc, 64, APR_SHM_HASH_EVICT_NONE, p);
+    if (!hash) {
+        return;
+    }
+
+    vlen = sizeof(val);
+    rv = apr_shm_hash_get(hash, "foo", APR_HASH_KEY_STRING, val, &vlen);
+    ABTS_INT_EQUAL(tc, APR_NOTFOUND, rv);
+
+    rv = apr_shm_hash_set(hash, "foo", APR_HASH_KEY_STRING, "bar", 4, 0);
+    APR_ASSERT_SUCCESS(tc, "Error setting foo", rv);
+    rv = apr_shm_hash_set(hash, "baz", 3, "quux", 5, 0);
+    APR_ASSERT_SUCCESS(tc, "Error setting baz", rv);
+    ABTS_INT_EQUAL(tc, 2, apr_shm_hash_count(hash));
+
+    vlen = sizeof(val);
+    rv = apr_shm_hash_get(hash, "foo", APR_HASH_KEY_STRING, val, &vlen);
+    APR_ASSERT_SUCCESS(tc, "Error getting foo", rv);
+    ABTS_SIZE_EQUAL(tc, 4, vlen);
+    ABTS_STR_EQUAL(tc, "bar", val);
+
+    /* Replace */
+    rv = apr_shm_hash_set(hash, "foo", APR_HASH_KEY_STRING, "barbar", 7, 0);
+    APR_ASSERT_SUCCESS(tc, "Error replacing foo", rv);
+    ABTS_INT_EQUAL(tc, 2, apr_shm_hash_count(hash));
+    vlen = sizeof(val);
+    rv = apr_shm_hash_get(hash, "foo", APR_HASH_KEY_STRING, val, &vlen);
+    APR_ASSERT_SUCCESS(tc, "Error getting foo", rv);
+    ABTS_STR_EQUAL(tc, "barbar", val);
+
+    /* Buffer too small */
+    vlen = 2;
+    rv = apr_shm_hash_get(hash, "baz", 3, val, &vlen);
+    ABTS_INT_EQUAL(tc, APR_ENOSPC, rv);
+    ABTS_SIZE_EQUAL(tc, 5, vlen);
+
+    /* Invalid keys and values */
+    rv = apr_shm_hash_set(hash, "", 0, "x", 1, 0);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+    rv = apr_shm_hash_set(hash, "x", 1, val, VAL_MAX + 1, 0);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+
+    rv = apr_shm_hash_delete(hash, "foo", APR_HASH_KEY_STRING);
+    APR_ASSERT_SUCCESS(tc, "Error deleting foo", rv);
+    rv = apr_shm_hash_delete(hash, "foo", APR_HASH_KEY_STRING);
+    ABTS_INT_EQUAL(tc, APR_NOTFOUND, rv);
+    ABTS_INT_EQUAL(tc, 0, has_key(hash, "foo"));
+    ABTS_INT_EQUAL(tc, 1, has_key(hash, "baz"));
+    ABTS_INT_EQUAL(tc, 1, apr_shm_hash_count(hash));
+}
+
+/* With a single bucket, every key competes for the same slots */
+static void fill_bucket(abts_case *tc, apr_shm_hash_t *hash,
+                        apr_interval_time_t ttl)
+{
+    int i;
+
+    for (i = 0; i < APR_SHM_HASH_BUCKET_SIZE; i++) {
+        const char *key = apr_itoa(p, i);
+        apr_status_t rv = apr_shm_hash_set(hash, key, APR_HASH_KEY_STRING,
+                                           key, strlen(key) + 1,
+                                           i ? 0 : ttl);
+        APR_ASSERT_SUCCESS(tc, "Error filling the bucket", rv);
+    }
+}
+
+static void test_full(abts_case *tc, void *data)
+{
+    apr_shm_hash_t *hash;
+    apr_status_t rv;
+
+    hash = make_hash(tc, APR_SHM_HASH_BUCKET_SIZE, APR_SHM_HASH_EVICT_NONE, p);
+    if (!hash) {
+        return;
+    }
+    ABTS_INT_EQUAL(tc, APR_SHM_HASH_BUCKET_SIZE, apr_shm_hash_capacity(hash));
+
+    fill_bucket(tc, hash, 0);
+    rv = apr_shm_hash_set(hash, "new", APR_HASH_KEY_STRING, "x", 1, 0);
+    ABTS_INT_EQUAL(tc, APR_ENOSPC, rv);
+
+    /* Replacing an existing key still works */
+    rv = apr_shm_hash_set(hash, "1", APR_HASH_KEY_STRING, "x", 1, 0);
+    APR_ASSERT_SUCCESS(tc, "Error replacing a key", rv);
+}
+
+static void test_lru(abts_case *tc, void *data)
+{
+    apr_shm_hash_t *hash;
+    apr_status_t rv;
+
+    hash = make_hash(tc, APR_SHM_HASH_BUCKET_SIZE, APR_SHM_HASH_EVICT_LRU, p);
+    if (!hash) {
+        return;
+    }
+
+    fill_bucket(tc, hash, 0);
+    ABTS_INT_EQUAL(tc, 1, has_key(hash, "0"));
+
+    rv = apr_shm_hash_set(hash, "new", APR_HASH_KEY_STRING, "x", 1, 0);
+    APR_ASSERT_SUCCESS(tc, "Error evicting", rv);
+    ABTS_INT_EQUAL(tc, 1, has_key(hash, "0"));
+    ABTS_INT_EQUAL(tc, 0, has_key(hash, "1"));
+    ABTS_INT_EQUAL(tc, 1, has_key(hash, "new"));
+    ABTS_INT_EQUAL(tc, APR_SHM_HASH_BUCKET_SIZE, apr_shm_hash_count(hash));
+}
+
+static void test_clock(abts_case *tc, void *data)
+{
+    apr_shm_hash_t *hash;
+    apr_status_t rv;
+
+    hash = make_hash(tc, APR_SHM_HASH_BUCKET_SIZE, APR_SHM_HASH_EVICT_CLOCK,
+                     p);
+    if (!hash) {
+        return;
+    }
+
+    /* All referenced: the hand clears them and comes back to the first */
+    fill_bucket(tc, hash, 0);
+    rv = apr_shm_hash_set(hash, "new", APR_HASH_KEY_STRING, "x", 1, 0);
+    APR_ASSERT_SUCCESS(tc, "Error evicting", rv);
+    ABTS_INT_EQUAL(tc, 0, has_key(hash, "0"));
+
+    /* "1" is referenced again, so the next one goes */
+    ABTS_INT_EQUAL(tc, 1, has_key(hash, "1"));
+    rv = apr_shm_hash_set(hash, "newer", APR_HASH_KEY_STRING, "x", 1, 0);
+    APR_ASSERT_SUCCESS(tc, "Error evicting", rv);
+    ABTS_INT_EQUAL(tc, 1, has_key(hash, "1"));
+    ABTS_INT_EQUAL(tc, 0, has_key(hash, "2"));
+    ABTS_INT_EQUAL(tc, 1, has_key(hash, "newer"));
+}
+
+static void test_expire(abts_case *tc, void *data)
+{
+    apr_shm_hash_t *hash;
+    apr_uint32_t expired;
+    apr_status_t rv;
+
+    hash = make_hash(tc, APR_SHM_HASH_BUCKET_SIZE, APR_SHM_HASH_EVICT_NONE, p);
+    if (!hash) {
+        return;
+    }
+
+    /* "0" expires, and its slot is reused although there's no eviction */
+    fill_bucket(tc, hash, 1000);
+    apr_sleep(10000);
+    ABTS_INT_EQUAL(tc, 0, has_key(hash, "0"));
+    ABTS_INT_EQUAL(tc, APR_SHM_HASH_BUCKET_SIZE, apr_shm_hash_count(hash));
+    rv = apr_shm_hash_set(hash, "new", APR_HASH_KEY_STRING, "x", 1, 0);
+    APR_ASSERT_SUCCESS(tc, "Error reusing an expired entry", rv);
+
+    rv = apr_shm_hash_set(hash, "new", APR_HASH_KEY_STRING, "x", 1, 1000);
+    APR_ASSERT_SUCCESS(tc, "Error setting a ttl", rv);
+    apr_sleep(10000);
+    rv = apr_shm_hash_expire(hash, &expired);
+    APR_ASSERT_SUCCESS(tc, "Error expiring", rv);
+    ABTS_INT_EQUAL(tc, 1, expired);
+    ABTS_INT_EQUAL(tc, APR_SHM_HASH_BUCKET_SIZE - 1,
+                   apr_shm_hash_count(hash));
+}
+
+static void test_attach(abts_case *tc, void *data)
+{
+    apr_shm_hash_t *hash, *hash2;
+    apr_shm_t *shm, *shm2;
+    char val[VAL_MAX];
+    apr_size_t vlen = sizeof(val);
+    apr_status_t rv;
+
+    apr_shm_remove(SHARED_FILENAME, p);
+    rv = apr_shm_create(&shm, apr_shm_hash_size(64, KEY_MAX, VAL_MAX),
+                        SHARED_FILENAME, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "name-based shared memory");
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "Error creating shared memory", rv);
+
+    rv = apr_shm_hash_attach(&hash, shm, p);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+
+    rv = apr_shm_hash_init(&hash, shm, KEY_MAX, VAL_MAX,
+                           APR_SHM_HASH_EVICT_LRU, p);
+    APR_ASSERT_SUCCESS(tc, "Error initializing the hash table", rv);
+    rv = apr_shm_hash_set(hash, "foo", APR_HASH_KEY_STRING, "bar", 4, 0);
+    APR_ASSERT_SUCCESS(tc, "Error setting foo", rv);
+
+    /* A second mapping, most likely at another address */
+    rv = apr_shm_attach(&shm2, SHARED_FILENAME, p);
+    APR_ASSERT_SUCCESS(tc, "Error attaching shared memory", rv);
+    rv = apr_shm_hash_attach(&hash2, shm2, p);
+    APR_ASSERT_SUCCESS(tc, "Error attaching the hash table", rv);
+    ABTS_INT_EQUAL(tc, apr_shm_hash_capacity(hash),
+                   apr_shm_hash_capacity(hash2));
+
+    rv = apr_shm_hash_get(hash2, "foo", APR_HASH_KEY_STRING, val, &vlen);
+    APR_ASSERT_SUCCESS(tc, "Error getting foo", rv);
+    ABTS_STR_EQUAL(tc, "bar", val);
+
+    APR_ASSERT_SUCCESS(tc, "Error detaching shared memory",
+                       apr_shm_detach(shm2));
+    APR_ASSERT_SUCCESS(tc, "Error destroying shared memory",
+                       apr_shm_destroy(shm));
+}
+
+#if APR_HAS_FORK
+
+#define CHILDREN 4
+#define CHILD_KEYS 200
+#define CHILD_LOOPS 2000
+
+/* Children store their own keys and all hammer one shared key, whose value
+ * is made of two copies of the same number: a torn read would show them
+ * different.
+ */
+static int run_child(apr_shm_hash_t *hash, int n)
+{
+    apr_uint32_t pair[2];
+    apr_size_t vlen;
+    int i;
+
+    for (i = 0; i < CHILD_KEYS; i++) {
+        const char *key = apr_psprintf(p, "%d-%d", n, i);
+        if (apr_shm_hash_set(hash, key, APR_HASH_KEY_STRING,
+                             key, strlen(key) + 1, 0)) {
+            return 1;
+        }
+    }
+    for (i = 0; i < CHILD_LOOPS; i++) {
+        if (i % 2) {
+            pair[0] = pair[1] = n * CHILD_LOOPS + i;
+            if (apr_shm_hash_set(hash, "shared", APR_HASH_KEY_STRING,
+                                 pair, sizeof(pair), 0)) {
+                return 2;
+            }
+        }
+        else {
+            vlen = sizeof(pair);
+            if (apr_shm_hash_get(hash, "shared", APR_HASH_KEY_STRING,
+                                 pair, &vlen) == APR_SUCCESS
+                    && (vlen != sizeof(pair) || pair[0] != pair[1])) {
+                return 3;
+            }
+        }
+    }
+    return 0;
+}
+
+static void test_multiproc(abts_case *tc, void *data)
+{
+    apr_shm_hash_t *hash;
+    apr_proc_t child[CHILDREN];
+    int n, i;
+
+    /* Large enough for no bucket to overflow */
+    hash = make_hash(tc, 8192, APR_SHM_HASH_EVICT_NONE, p);
+    if (!hash) {
+        return;
+    }
+
+    for (n = 0; n < CHILDREN; n++) {
+        apr_status_t rv = apr_proc_fork(&child[n], p);
+        if (rv == APR_INCHILD) {
+            apr_initialize();
+            _exit(run_child(hash, n));
+        }
+        ABTS_ASSERT(tc, "Error forking child", rv == APR_INPARENT);
+    }
+    for (n = 0; n < CHILDREN; n++) {
+        apr_exit_why_e why;
+        int code;
+
+        apr_proc_wait(&child[n], &code, &why, APR_WAIT);
+        ABTS_INT_EQUAL(tc, APR_PROC_EXIT, why);
+        ABTS_INT_EQUAL(tc, 0, code);
+    }
+
+    ABTS_INT_EQUAL(tc, CHILDREN * CHILD_KEYS + 1, apr_shm_hash_count(hash));
+    for (n = 0; n < CHILDREN; n++) {
+        for (i = 0; i < CHILD_KEYS; i++) {
+            const char *key = apr_psprintf(p, "%d-%d", n, i);
+            char val[VAL_MAX];
+            apr_size_t vlen = sizeof(val);
+            apr_status_t rv;
+
+            rv = apr_shm_hash_get(hash, key, APR_HASH_KEY_STRING,
+                                  val, &vlen);
+            APR_ASSERT_SUCCESS(tc, "Error getting a child's key", rv);
+            ABTS_STR_EQUAL(tc, key, val);
+        }
+    }
+}
+
+#endif /* APR_HAS_FORK */
+
+#endif /* APR_HAS_SHARED_MEMORY */
+
+abts_suite *testshmhash(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite);
+
+#if APR_HAS_SHARED_MEMORY
+    abts_run_test(suite, test_basic, NULL);
+    abts_run_test(suite, test_full, NULL);
+    abts_run_test(suite, test_lru, NULL);
+    abts_run_test(suite, test_clock, NULL);
+    abts_run_test(suite, test_expire, NULL);
+    abts_run_test(suite, test_attach, NULL);
+#if APR_HAS_FORK
+    abts_run_test(suite, test_multiproc, NULL);
+#endif
+#endif
+
+    return suite;
+}
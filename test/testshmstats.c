@@ -0,0 +1,277 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_shm.h"
+#include "apr_shm_stats.h"
+#include "apr_thread_proc.h"
+#include "apr_errno.h"
+#include "apr_general.h"
+#include "apr_strings.h"
+#include "abts.h"
+#include "testutil.h"
+
+#if APR_HAS_SHARED_MEMORY
+
+#define NSLOTS 4
+
+static const apr_int64_t latency_bounds[] = { 10, 100, 1000 };
+#define NBOUNDS (sizeof(latency_bounds) / sizeof(latency_bounds[0]))
+
+static apr_shm_stats_t *make_stats(abts_case *tc, apr_pool_t *pool)
+{
+    apr_shm_stats_t *stats;
+    apr_shm_t *shm;
+    apr_status_t rv;
+
+    rv = apr_shm_create(&shm, apr_shm_stats_size(NSLOTS, 4, 8), NULL, pool);
+    APR_ASSERT_SUCCESS(tc, "Error creating shared memory", rv);
+    if (rv != APR_SUCCESS) {
+        return NULL;
+    }
+
+    rv = apr_shm_stats_attach(&stats, shm, pool);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+
+    rv = apr_shm_stats_create(&stats, shm, NSLOTS, 4, 8, pool);
+    APR_ASSERT_SUCCESS(tc, "Error creating the statistics", rv);
+    return rv == APR_SUCCESS ? stats : NULL;
+}
+
+static void test_define(abts_case *tc, void *data)
+{
+    apr_shm_stats_t *stats;
+    unsigned int id, id2, nbounds;
+    const char *name;
+    apr_int64_t bounds[2] = { 5, 5 };
+    apr_status_t rv;
+
+    stats = make_stats(tc, p);
+    if (!stats) {
+        return;
+    }
+
+    rv = apr_shm_stats_counter_define(stats, "requests", &id);
+    APR_ASSERT_SUCCESS(tc, "Error defining a counter", rv);
+    rv = apr_shm_stats_histogram_define(stats, "latency", latency_bounds,
+                                        NBOUNDS, &id2);
+    APR_ASSERT_SUCCESS(tc, "Error defining a histogram", rv);
+    ABTS_TRUE(tc, id != id2);
+    ABTS_INT_EQUAL(tc, 2, apr_shm_stats_count(stats));
+
+    /* Defining again finds the same metric */
+    rv = apr_shm_stats_counter_define(stats, "requests", &id2);
+    APR_ASSERT_SUCCESS(tc, "Error redefining a counter", rv);
+    ABTS_INT_EQUAL(tc, id, id2);
+    rv = apr_shm_stats_histogram_define(stats, "requests", latency_bounds,
+                                        NBOUNDS, &id2);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+
+    rv = apr_shm_stats_lookup(stats, "latency", &id2);
+    APR_ASSERT_SUCCESS(tc, "Error looking up a histogram", rv);
+    rv = apr_shm_stats_info_get(stats, id2, &name, &nbounds);
+    APR_ASSERT_SUCCESS(tc, "Error getting the metric info", rv);
+    ABTS_STR_EQUAL(tc, "latency", name);
+    ABTS_INT_EQUAL(tc, NBOUNDS, nbounds);
+    rv = apr_shm_stats_lookup(stats, "nope", &id2);
+    ABTS_INT_EQUAL(tc, APR_NOTFOUND, rv);
+
+    /* Bounds must increase, and the cells are limited */
+    rv = apr_shm_stats_histogram_define(stats, "bad", bounds, 2, &id2);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+    rv = apr_shm_stats_histogram_define(stats, "big", latency_bounds,
+                                        NBOUNDS, &id2);
+    ABTS_INT_EQUAL(tc, APR_ENOSPC, rv);
+}
+
+static void test_slots(abts_case *tc, void *data)
+{
+    apr_shm_stats_t *stats;
+    apr_shm_stats_slot_t *slot[NSLOTS + 1];
+    apr_uint64_t value, counts[NBOUNDS + 1];
+    apr_int64_t sum;
+    unsigned int requests, latency;
+    apr_status_t rv;
+    int i;
+
+    stats = make_stats(tc, p);
+    if (!stats) {
+        return;
+    }
+    apr_shm_stats_counter_define(stats, "requests", &requests);
+    apr_shm_stats_histogram_define(stats, "latency", latency_bounds,
+                                   NBOUNDS, &latency);
+
+    for (i = 0; i < NSLOTS; i++) {
+        rv = apr_shm_stats_slot_acquire(&slot[i], stats,
+                                        i ? 0 : APR_SHM_STATS_SLOT_ATOMIC, p);
+        APR_ASSERT_SUCCESS(tc, "Error acquiring a slot", rv);
+        apr_shm_stats_add(slot[i], requests, i + 1);
+    }
+    rv = apr_shm_stats_slot_acquire(&slot[NSLOTS], stats, 0, p);
+    ABTS_INT_EQUAL(tc, APR_ENOSPC, rv);
+
+    apr_shm_stats_record(slot[0], latency, 1);
+    apr_shm_stats_record(slot[1], latency, 10);
+    apr_shm_stats_record(slot[2], latency, 11);
+    apr_shm_stats_record(slot[3], latency, 5000);
+
+    rv = apr_shm_stats_counter_get(stats, requests, &value);
+    APR_ASSERT_SUCCESS(tc, "Error reading a counter", rv);
+    ABTS_INT_EQUAL(tc, 10, (int)value);
+
+    rv = apr_shm_stats_histogram_get(stats, latency, counts, &sum);
+    APR_ASSERT_SUCCESS(tc, "Error reading a histogram", rv);
+    ABTS_INT_EQUAL(tc, 2, (int)counts[0]);
+    ABTS_INT_EQUAL(tc, 1, (int)counts[1]);
+    ABTS_INT_EQUAL(tc, 0, (int)counts[2]);
+    ABTS_INT_EQUAL(tc, 1, (int)counts[3]);
+    ABTS_INT_EQUAL(tc, 5022, (int)sum);
+
+    rv = apr_shm_stats_counter_get(stats, latency, &value);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+
+    /* A released slot keeps its values for the next owner */
+    rv = apr_shm_stats_slot_release(slot[3]);
+    APR_ASSERT_SUCCESS(tc, "Error releasing a slot", rv);
+    rv = apr_shm_stats_slot_acquire(&slot[3], stats, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Error reacquiring a slot", rv);
+    apr_shm_stats_add(slot[3], requests, 1);
+    apr_shm_stats_counter_get(stats, requests, &value);
+    ABTS_INT_EQUAL(tc, 11, (int)value);
+}
+
+#if APR_HAS_FORK
+
+#define CHILD_LOOPS 10000
+
+static void test_multiproc(abts_case *tc, void *data)
+{
+    apr_shm_stats_t *stats;
+    apr_proc_t child[NSLOTS];
+    apr_uint64_t value, counts[NBOUNDS + 1];
+    unsigned int requests, latency;
+    int n;
+
+    stats = make_stats(tc, p);
+    if (!stats) {
+        return;
+    }
+    apr_shm_stats_counter_define(stats, "requests", &requests);
+    apr_shm_stats_histogram_define(stats, "latency", latency_bounds,
+                                   NBOUNDS, &latency);
+
+    for (n = 0; n < NSLOTS; n++) {
+        apr_status_t rv = apr_proc_fork(&child[n], p);
+        if (rv == APR_INCHILD) {
+            apr_shm_stats_slot_t *slot;
+            int i;
+
+            apr_initialize();
+            if (apr_shm_stats_slot_acquire(&slot, stats, 0, p)) {
+                _exit(1);
+            }
+            for (i = 0; i < CHILD_LOOPS; i++) {
+                apr_shm_stats_add(slot, requests, 1);
+                apr_shm_stats_record(slot, latency, i % 2000);
+            }
+            _exit(0);
+        }
+        ABTS_ASSERT(tc, "Error forking child", rv == APR_INPARENT);
+    }
+    for (n = 0; n < NSLOTS; n++) {
+        apr_exit_why_e why;
+        int code;
+
+        apr_proc_wait(&child[n], &code, &why, APR_WAIT);
+        ABTS_INT_EQUAL(tc, APR_PROC_EXIT, why);
+        ABTS_INT_EQUAL(tc, 0, code);
+    }
+
+    apr_shm_stats_counter_get(stats, requests, &value);
+    ABTS_INT_EQUAL(tc, NSLOTS * CHILD_LOOPS, (int)value);
+    apr_shm_stats_histogram_get(stats, latency, counts, NULL);
+    ABTS_INT_EQUAL(tc, NSLOTS * CHILD_LOOPS / 2000 * 11, (int)counts[0]);
+    ABTS_INT_EQUAL(tc, NSLOTS * CHILD_LOOPS,
+                   (int)(counts[0] + counts[1] + counts[2] + counts[3]));
+}
+
+static void test_reclaim(abts_case *tc, void *data)
+{
+    apr_shm_stats_t *stats;
+    apr_shm_stats_slot_t *slot[NSLOTS + 1];
+    apr_proc_t child;
+    apr_exit_why_e why;
+    apr_uint64_t value;
+    unsigned int requests;
+    apr_status_t rv;
+    int i, code;
+
+    stats = make_stats(tc, p);
+    if (!stats) {
+        return;
+    }
+    apr_shm_stats_counter_define(stats, "requests", &requests);
+
+    for (i = 0; i < NSLOTS - 1; i++) {
+        rv = apr_shm_stats_slot_acquire(&slot[i], stats, 0, p);
+        APR_ASSERT_SUCCESS(tc, "Error acquiring a slot", rv);
+    }
+
+    /* The child takes the last slot and exits without releasing it */
+    rv = apr_proc_fork(&child, p);
+    if (rv == APR_INCHILD) {
+        apr_initialize();
+        if (apr_shm_stats_slot_acquire(&slot[0], stats, 0, p)) {
+            _exit(1);
+        }
+        apr_shm_stats_add(slot[0], requests, 5);
+        _exit(0);
+    }
+    ABTS_ASSERT(tc, "Error forking child", rv == APR_INPARENT);
+    apr_proc_wait(&child, &code, &why, APR_WAIT);
+    ABTS_INT_EQUAL(tc, APR_PROC_EXIT, why);
+    ABTS_INT_EQUAL(tc, 0, code);
+
+    rv = apr_shm_stats_slot_acquire(&slot[NSLOTS - 1], stats, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Error reclaiming the slot of the child", rv);
+    apr_shm_stats_add(slot[NSLOTS - 1], requests, 1);
+    apr_shm_stats_counter_get(stats, requests, &value);
+    ABTS_INT_EQUAL(tc, 6, (int)value);
+
+    /* The owners of the other slots are alive */
+    rv = apr_shm_stats_slot_acquire(&slot[NSLOTS], stats, 0, p);
+    ABTS_INT_EQUAL(tc, APR_ENOSPC, rv);
+}
+
+#endif /* APR_HAS_FORK */
+
+#endif /* APR_HAS_SHARED_MEMORY */
+
+abts_suite *testshmstats(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite);
+
+#if APR_HAS_SHARED_MEMORY
+    abts_run_test(suite, test_define, NULL);
+    abts_run_test(suite, test_slots, NULL);
+#if APR_HAS_FORK
+    abts_run_test(suite, test_multiproc, NULL);
+    abts_run_test(suite, test_reclaim, NULL);
+#endif
+#endif
+
+    return suite;
+}
@@ -192,6 +192,267 @@ static void sendto_receivefrom6(abts_case *tc, void *data)
 }
 #endif
 
+static void mmsg_sockets(abts_case *tc, apr_socket_t **sock,
+                         apr_socket_t **sock2, apr_sockaddr_t **to,
+                         apr_port_t port)
+{
+    apr_sockaddr_t *from;
+
+    APR_ASSERT_SUCCESS(tc, "create socket",
+                       apr_socket_create(sock, APR_INET, SOCK_DGRAM, 0, p));
+    APR_ASSERT_SUCCESS(tc, "create socket2",
+                       apr_socket_create(sock2, APR_INET, SOCK_DGRAM, 0, p));
+    APR_ASSERT_SUCCESS(tc, "get address",
+                       apr_sockaddr_info_get(to, "127.0.0.1", APR_INET, port,
+                                             0, p));
+    APR_ASSERT_SUCCESS(tc, "get address",
+                       apr_sockaddr_info_get(&from, "127.0.0.1", APR_INET,
+                                             port + 1, 0, p));
+    apr_socket_opt_set(*sock, APR_SO_REUSEADDR, 1);
+    apr_socket_opt_set(*sock2, APR_SO_REUSEADDR, 1);
+    APR_ASSERT_SUCCESS(tc, "bind socket", apr_socket_bind(*sock, *to));
+    APR_ASSERT_SUCCESS(tc, "bind socket2", apr_socket_bind(*sock2, from));
+    APR_ASSERT_SUCCESS(tc, "set timeout",
+                       apr_socket_timeout_set(*sock, apr_time_from_sec(5)));
+}
+
+#define MMSG_COUNT 100
+
+static void sendmmsg_recvmmsg(abts_case *tc, void *data)
+{
+    apr_socket_t *sock, *sock2;
+    apr_sockaddr_t *to;
+    apr_socket_msg_t msgs[MMSG_COUNT];
+    char bufs[MMSG_COUNT][STRLEN];
+    apr_size_t i, n, total = 0;
+    char *ip_addr;
+
+    mmsg_sockets(tc, &sock, &sock2, &to, 7773);
+
+    for (i = 0; i < MMSG_COUNT; i++) {
+        msgs[i].addr = to;
+        msgs[i].buf = apr_psprintf(p, "datagram %" APR_SIZE_T_FMT, i);
+        msgs[i].len = strlen(msgs[i].buf);
+    }
+    APR_ASSERT_SUCCESS(tc, "send datagrams",
+                       apr_socket_sendmmsg(sock2, msgs, MMSG_COUNT, 0, &n));
+    ABTS_SIZE_EQUAL(tc, MMSG_COUNT, n);
+
+    /* they may arrive in several batches */
+    while (total < MMSG_COUNT) {
+        for (i = 0; i < MMSG_COUNT - total; i++) {
+            msgs[i].buf = bufs[i];
+            msgs[i].len = sizeof(bufs[i]) - 1;
+            apr_sockaddr_info_get(&msgs[i].addr, "127.1.2.3", APR_INET,
+                                  4242, 0, p);
+        }
+        APR_ASSERT_SUCCESS(tc, "receive datagrams",
+                           apr_socket_recvmmsg(sock, msgs, MMSG_COUNT - total,
+                                               0, &n));
+        ABTS_ASSERT(tc, "datagrams received", n > 0);
+        if (n == 0) {
+            break;
+        }
+        for (i = 0; i < n; i++) {
+            bufs[i][msgs[i].len] = '\0';
+            ABTS_STR_EQUAL(tc, apr_psprintf(p, "datagram %" APR_SIZE_T_FMT,
+                                            total + i), bufs[i]);
+            apr_sockaddr_ip_get(&ip_addr, msgs[i].addr);
+            ABTS_STR_EQUAL(tc, "127.0.0.1", ip_addr);
+            ABTS_INT_EQUAL(tc, 7774, msgs[i].addr->port);
+            ABTS_SIZE_EQUAL(tc, 0, msgs[i].segment_size);
+        }
+        total += n;
+    }
+
+    /* nothing left, and no waiting without a timeout */
+    apr_socket_timeout_set(sock, 0);
+    msgs[0].buf = bufs[0];
+    msgs[0].len = sizeof(bufs[0]);
+    ABTS_ASSERT(tc, "nothing to receive",
+                APR_STATUS_IS_EAGAIN(apr_socket_recvmmsg(sock, msgs, 1, 0,
+                                                         &n)));
+    ABTS_SIZE_EQUAL(tc, 0, n);
+
+    apr_socket_close(sock);
+    apr_socket_close(sock2);
+}
+
+static void udp_segment_offload(abts_case *tc, void *data)
+{
+    apr_socket_t *sock, *sock2;
+    apr_sockaddr_t *to;
+    apr_socket_msg_t msgs[4];
+    char sendbuf[400], bufs[4][sizeof(sendbuf)];
+    apr_size_t i, n, total = 0;
+    apr_status_t rv;
+    int gro = (data != NULL);
+
+    mmsg_sockets(tc, &sock, &sock2, &to, gro ? 7777 : 7775);
+
+    rv = apr_socket_opt_set(sock2, APR_UDP_SEGMENT, 100);
+    if (rv == APR_SUCCESS && gro) {
+        rv = apr_socket_opt_set(sock, APR_UDP_GRO, 1);
+    }
+    if (rv != APR_SUCCESS) {
+        ABTS_NOT_IMPL(tc, "UDP segmentation offload not supported");
+        apr_socket_close(sock);
+        apr_socket_close(sock2);
+        return;
+    }
+
+    /* cut into four datagrams, which may be coalesced back */
+    memset(sendbuf, 'x', sizeof(sendbuf));
+    msgs[0].addr = to;
+    msgs[0].buf = sendbuf;
+    msgs[0].len = sizeof(sendbuf);
+    APR_ASSERT_SUCCESS(tc, "send datagrams",
+                       apr_socket_sendmmsg(sock2, msgs, 1, 0, &n));
+    ABTS_SIZE_EQUAL(tc, 1, n);
+    ABTS_SIZE_EQUAL(tc, sizeof(sendbuf), msgs[0].len);
+
+    while (total < sizeof(sendbuf)) {
+        for (i = 0; i < 4; i++) {
+            msgs[i].addr = NULL;
+            msgs[i].buf = bufs[i];
+            msgs[i].len = sizeof(bufs[i]);
+        }
+        APR_ASSERT_SUCCESS(tc, "receive datagrams",
+                           apr_socket_recvmmsg(sock, msgs, 4, 0, &n));
+        if (n == 0) {
+            break;
+        }
+        for (i = 0; i < n; i++) {
+            if (msgs[i].segment_size) {
+                ABTS_SIZE_EQUAL(tc, 100, msgs[i].segment_size);
+            }
+            else {
+                ABTS_SIZE_EQUAL(tc, 100, msgs[i].len);
+            }
+            total += msgs[i].len;
+        }
+    }
+    ABTS_SIZE_EQUAL(tc, sizeof(sendbuf), total);
+
+    apr_socket_close(sock);
+    apr_socket_close(sock2);
+}
+
+static apr_status_t tcp_pair(apr_socket_t **client, apr_socket_t **server)
+{
+    apr_socket_t *listener;
+    apr_sockaddr_t *sa;
+    apr_status_t rv;
+
+    if ((rv = apr_sockaddr_info_get(&sa, "127.0.0.1", APR_INET, 0, 0, p))
+        || (rv = apr_socket_create(&listener, APR_INET, SOCK_STREAM,
+                                   APR_PROTO_TCP, p))
+        || (rv = apr_socket_bind(listener, sa))
+        || (rv = apr_socket_listen(listener, 1))
+        || (rv = apr_socket_addr_get(&sa, APR_LOCAL, listener))
+        || (rv = apr_socket_create(client, APR_INET, SOCK_STREAM,
+                                   APR_PROTO_TCP, p))
+        || (rv = apr_socket_connect(*client, sa))
+        || (rv = apr_socket_accept(server, listener, p))) {
+        return rv;
+    }
+    return apr_socket_close(listener);
+}
+
+static void recv_full(abts_case *tc, apr_socket_t *sock, char *buf,
+                      apr_size_t len)
+{
+    apr_size_t received = 0;
+
+    while (received < len) {
+        apr_size_t n = len - received;
+
+        APR_ASSERT_SUCCESS(tc, "receive", apr_socket_recv(sock,
+                                                          buf + received,
+                                                          &n));
+        if (n == 0) {
+            break;
+        }
+        received += n;
+    }
+    ABTS_SIZE_EQUAL(tc, len, received);
+}
+
+/* TLS 1.2 with AES-128-GCM and made up keys, both ends in the kernel */
+static void ktls_loopback(abts_case *tc, void *data)
+{
+    static const unsigned char key[16] = "0123456789abcdef";
+    static const unsigned char iv[12] = "salt-nonce-!";
+    static const unsigned char rec_seq[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    static const char msg1[] = "hello, kernel TLS";
+    static const char msg2[] = "second record";
+    apr_socket_ktls_params_t params, bad;
+    apr_socket_t *client, *server;
+    char buf[128];
+    apr_size_t len;
+    apr_status_t rv;
+
+    rv = tcp_pair(&client, &server);
+    APR_ASSERT_SUCCESS(tc, "connect sockets", rv);
+    if (rv != APR_SUCCESS) {
+        return;
+    }
+    apr_socket_timeout_set(server, apr_time_from_sec(5));
+
+    params.version = APR_SOCKET_KTLS_TLS12;
+    params.cipher = APR_SOCKET_KTLS_AES_GCM_128;
+    params.key = key;
+    params.key_len = sizeof(key);
+    params.iv = iv;
+    params.rec_seq = NULL;
+
+    bad = params;
+    bad.key_len = 32;
+    rv = apr_socket_ktls_enable(client, APR_SOCKET_KTLS_TX, &bad);
+    ABTS_ASSERT(tc, "key length checked",
+                rv == APR_EINVAL || rv == APR_ENOTIMPL);
+    rv = apr_socket_ktls_enable(client, 3, &params);
+    ABTS_ASSERT(tc, "direction checked",
+                rv == APR_EINVAL || rv == APR_ENOTIMPL);
+
+    rv = apr_socket_ktls_enable(client, APR_SOCKET_KTLS_TX, &params);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "kernel TLS not supported");
+        apr_socket_close(client);
+        apr_socket_close(server);
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "enable kernel TLS sending", rv);
+
+    /* The first record as it goes on the wire: header, explicit nonce,
+     * ciphertext and tag */
+    len = sizeof(msg1) - 1;
+    APR_ASSERT_SUCCESS(tc, "send", apr_socket_send(client, msg1, &len));
+    len = 5 + 8 + (sizeof(msg1) - 1) + 16;
+    recv_full(tc, server, buf, len);
+    ABTS_INT_EQUAL(tc, 0x17, (unsigned char)buf[0]);
+    ABTS_INT_EQUAL(tc, 0x03, buf[1]);
+    ABTS_INT_EQUAL(tc, 0x03, buf[2]);
+    ABTS_SIZE_EQUAL(tc, len - 5,
+                    ((unsigned char)buf[3] << 8) | (unsigned char)buf[4]);
+    ABTS_ASSERT(tc, "data encrypted",
+                memcmp(buf + 5 + 8, msg1, sizeof(msg1) - 1) != 0);
+
+    /* The next records are decrypted by the kernel of the peer */
+    params.rec_seq = rec_seq;
+    rv = apr_socket_ktls_enable(server, APR_SOCKET_KTLS_RX, &params);
+    APR_ASSERT_SUCCESS(tc, "enable kernel TLS receiving", rv);
+
+    len = sizeof(msg2) - 1;
+    APR_ASSERT_SUCCESS(tc, "send", apr_socket_send(client, msg2, &len));
+    recv_full(tc, server, buf, sizeof(msg2) - 1);
+    buf[sizeof(msg2) - 1] = '\0';
+    ABTS_STR_EQUAL(tc, msg2, buf);
+
+    apr_socket_close(client);
+    apr_socket_close(server);
+}
+
 static void socket_userdata(abts_case *tc, void *data)
 {
     apr_socket_t *sock1, *sock2;
@@ -233,6 +494,12 @@ abts_suite *testsockets(abts_suite *suite)
     abts_run_test(suite, sendto_receivefrom6, NULL);
 #endif
 
+    abts_run_test(suite, sendmmsg_recvmmsg, NULL);
+    abts_run_test(suite, udp_segment_offload, NULL);
+    abts_run_test(suite, udp_segment_offload, (void *)1);
+
+    abts_run_test(suite, ktls_loopback, NULL);
+
     abts_run_test(suite, socket_userdata, NULL);
     
     return suite;
@@ -130,6 +130,9 @@ abts_suite *testqueue(abts_suite *suite);
 abts_suite *testxml(abts_suite *suite);
 abts_suite *testxlate(abts_suite *suite);
 abts_suite *testrmm(abts_suite *suite);
+abts_suite *testshmhash(abts_suite *suite);
+abts_suite *testshmstats(abts_suite *suite);
+abts_suite *testrcu(abts_suite *suite);
 abts_suite *testdbm(abts_suite *suite);
 abts_suite *testlfsabi(abts_suite *suite);
 abts_suite *testskiplist(abts_suite *suite);
@@ -0,0 +1,276 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_global_lockset.h"
+#include "apr_atomic.h"
+#include "apr_hash.h"
+#include "apr_shm.h"
+#include "apr_strings.h"
+#include "apr_errno.h"
+
+#define APR_WANT_MEMFUNC
+#include "apr_want.h"
+
+/* Keep the statistics of the stripes in distinct cache lines, so that
+ * processes working on different stripes don't bounce them.
+ */
+#define LOCKSET_STATS_SIZE 64
+
+typedef union lockset_stats_t {
+    apr_global_lockset_stats_t s;
+    char pad[LOCKSET_STATS_SIZE];
+} lockset_stats_t;
+
+struct apr_global_lockset_t {
+    apr_pool_t *pool;
+    unsigned int nlocks;
+    apr_global_mutex_t **locks;
+    lockset_stats_t *stats;
+#if APR_HAS_SHARED_MEMORY
+    apr_shm_t *shm;
+#endif
+};
+
+static const char *stripe_fname(const char *fname, unsigned int i,
+                                apr_pool_t *pool)
+{
+    return fname ? apr_psprintf(pool, "%s.%u", fname, i) : NULL;
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_create(
+                                              apr_global_lockset_t **lockset,
+                                              unsigned int nlocks,
+                                              const char *fname,
+                                              apr_lockmech_e mech,
+                                              apr_pool_t *pool)
+{
+    apr_global_lockset_t *ls;
+    apr_size_t size;
+    apr_status_t rv;
+    unsigned int i;
+
+    if (!nlocks) {
+        return APR_EINVAL;
+    }
+
+    ls = apr_pcalloc(pool, sizeof(*ls));
+    ls->pool = pool;
+    ls->nlocks = nlocks;
+    ls->locks = apr_pcalloc(pool, nlocks * sizeof(*ls->locks));
+
+    size = nlocks * sizeof(lockset_stats_t);
+#if APR_HAS_SHARED_MEMORY
+    rv = apr_shm_create(&ls->shm, size, NULL, pool);
+    if (rv == APR_SUCCESS) {
+        ls->stats = apr_shm_baseaddr_get(ls->shm);
+        memset(ls->stats, 0, size);
+    }
+    else if (rv != APR_ENOTIMPL) {
+        return rv;
+    }
+    else
+#endif
+    {
+        ls->stats = apr_pcalloc(pool, size);
+    }
+
+    for (i = 0; i < nlocks; i++) {
+        rv = apr_global_mutex_create(&ls->locks[i],
+                                     stripe_fname(fname, i, pool),
+                                     mech, pool);
+        if (rv != APR_SUCCESS) {
+            ls->nlocks = i;
+            apr_global_lockset_destroy(ls);
+            return rv;
+        }
+    }
+
+    *lockset = ls;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_child_init(
+                                              apr_global_lockset_t **lockset,
+                                              const char *fname,
+                                              apr_pool_t *pool)
+{
+    apr_global_lockset_t *ls = *lockset;
+    apr_status_t rv;
+    unsigned int i;
+
+    for (i = 0; i < ls->nlocks; i++) {
+        rv = apr_global_mutex_child_init(&ls->locks[i],
+                                         stripe_fname(fname, i, pool), pool);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+    }
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(unsigned int) apr_global_lockset_count(
+                                              apr_global_lockset_t *lockset)
+{
+    return lockset->nlocks;
+}
+
+APR_DECLARE(unsigned int) apr_global_lockset_stripe(
+                                              apr_global_lockset_t *lockset,
+                                              const void *key,
+                                              apr_ssize_t klen)
+{
+    unsigned int hash = apr_hashfunc_default(key, &klen);
+
+    /* times33 leaves the low bits poorly mixed for short keys */
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+
+    return hash % lockset->nlocks;
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_lock(
+                                              apr_global_lockset_t *lockset,
+                                              unsigned int stripe)
+{
+    apr_status_t rv;
+
+    if (stripe >= lockset->nlocks) {
+        return APR_EINVAL;
+    }
+
+    rv = apr_global_mutex_trylock(lockset->locks[stripe]);
+    if (rv != APR_SUCCESS) {
+        if (APR_STATUS_IS_EBUSY(rv)) {
+            apr_atomic_inc32(&lockset->stats[stripe].s.contended);
+        }
+        else if (rv != APR_ENOTIMPL) {
+            return rv;
+        }
+        rv = apr_global_mutex_lock(lockset->locks[stripe]);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+    }
+
+    /* Only the holder of the stripe updates it */
+    lockset->stats[stripe].s.acquired++;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_trylock(
+                                              apr_global_lockset_t *lockset,
+                                              unsigned int stripe)
+{
+    apr_status_t rv;
+
+    if (stripe >= lockset->nlocks) {
+        return APR_EINVAL;
+    }
+
+    rv = apr_global_mutex_trylock(lockset->locks[stripe]);
+    if (rv == APR_SUCCESS) {
+        lockset->stats[stripe].s.acquired++;
+    }
+    else if (APR_STATUS_IS_EBUSY(rv)) {
+        apr_atomic_inc32(&lockset->stats[stripe].s.contended);
+    }
+    return rv;
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_unlock(
+                                              apr_global_lockset_t *lockset,
+                                              unsigned int stripe)
+{
+    if (stripe >= lockset->nlocks) {
+        return APR_EINVAL;
+    }
+    return apr_global_mutex_unlock(lockset->locks[stripe]);
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_lock_all(
+                                              apr_global_lockset_t *lockset)
+{
+    apr_status_t rv;
+    unsigned int i;
+
+    for (i = 0; i < lockset->nlocks; i++) {
+        rv = apr_global_lockset_lock(lockset, i);
+        if (rv != APR_SUCCESS) {
+            while (i--) {
+                (void)apr_global_mutex_unlock(lockset->locks[i]);
+            }
+            return rv;
+        }
+    }
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_unlock_all(
+                                              apr_global_lockset_t *lockset)
+{
+    apr_status_t rv, rv2 = APR_SUCCESS;
+    unsigned int i = lockset->nlocks;
+
+    while (i--) {
+        rv = apr_global_mutex_unlock(lockset->locks[i]);
+        if (rv != APR_SUCCESS) {
+            rv2 = rv;
+        }
+    }
+    return rv2;
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_stats_get(
+                                              apr_global_lockset_t *lockset,
+                                              unsigned int stripe,
+                                              apr_global_lockset_stats_t *stats)
+{
+    if (stripe >= lockset->nlocks) {
+        return APR_EINVAL;
+    }
+    stats->acquired = lockset->stats[stripe].s.acquired;
+    stats->contended = apr_atomic_read32(&lockset->stats[stripe].s.contended);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_global_lockset_destroy(
+                                              apr_global_lockset_t *lockset)
+{
+    apr_status_t rv, rv2 = APR_SUCCESS;
+    unsigned int i;
+
+    for (i = 0; i < lockset->nlocks; i++) {
+        if (lockset->locks[i]) {
+            rv = apr_global_mutex_destroy(lockset->locks[i]);
+            if (rv != APR_SUCCESS) {
+                rv2 = rv;
+            }
+            lockset->locks[i] = NULL;
+        }
+    }
+#if APR_HAS_SHARED_MEMORY
+    if (lockset->shm) {
+        rv = apr_shm_destroy(lockset->shm);
+        if (rv != APR_SUCCESS) {
+            rv2 = rv;
+        }
+        lockset->shm = NULL;
+    }
+#endif
+    return rv2;
+}
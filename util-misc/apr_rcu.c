@@ -0,0 +1,344 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_rcu.h"
+#include "apr_atomic.h"
+#include "apr_thread_mutex.h"
+#include "apr_thread_proc.h"
+#include "apr_errno.h"
+
+/* Readers announce in which epoch of the domain they entered their
+ * critical section (zero when they are out of it), each in its own cache
+ * line. Retiring a pool starts a new epoch, and the pool can be destroyed
+ * once no reader is left in an earlier epoch: those which entered later
+ * could only see the data published before the pool was retired.
+ */
+
+#define RCU_ALIGN 64
+
+struct apr_seqlock_t {
+    volatile apr_uint32_t seq;      /* odd while a writer is in progress */
+};
+
+struct apr_rcu_reader_t {
+    volatile apr_uint64_t epoch;
+    char pad[RCU_ALIGN - sizeof(apr_uint64_t)];
+    apr_rcu_t *rcu;
+    apr_pool_t *pool;
+    apr_rcu_reader_t *next;
+    apr_rcu_reader_t **prevp;
+};
+
+typedef struct rcu_retired_t rcu_retired_t;
+struct rcu_retired_t {
+    rcu_retired_t *next;
+    apr_pool_t *pool;
+    apr_uint64_t epoch;
+};
+
+struct apr_rcu_t {
+    apr_pool_t *pool;
+    volatile apr_uint64_t epoch;
+#if APR_HAS_THREADS
+    apr_thread_mutex_t *lock;       /* protects the lists below */
+#endif
+    apr_rcu_reader_t *readers;
+    rcu_retired_t *retired;         /* by increasing epoch */
+    rcu_retired_t **retired_tail;
+    rcu_retired_t *free;
+};
+
+#if APR_HAS_THREADS
+#define RCU_LOCK(rcu)   apr_thread_mutex_lock((rcu)->lock)
+#define RCU_UNLOCK(rcu) apr_thread_mutex_unlock((rcu)->lock)
+#define RCU_YIELD()     apr_thread_yield()
+#else
+#define RCU_LOCK(rcu)
+#define RCU_UNLOCK(rcu)
+#define RCU_YIELD()
+#endif
+
+APR_DECLARE(apr_status_t) apr_seqlock_create(apr_seqlock_t **seqlock,
+                                             apr_pool_t *pool)
+{
+    *seqlock = apr_pcalloc(pool, sizeof(apr_seqlock_t));
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_uint32_t) apr_seqlock_read_begin(apr_seqlock_t *seqlock)
+{
+    apr_uint32_t seq;
+
+    while ((seq = apr_atomic_read32_ex(&seqlock->seq,
+                                       APR_ATOMIC_ACQUIRE)) & 1) {
+        RCU_YIELD();
+    }
+    return seq;
+}
+
+APR_DECLARE(int) apr_seqlock_read_retry(apr_seqlock_t *seqlock,
+                                        apr_uint32_t seq)
+{
+    /* The reads of the data complete before the sequence is checked */
+    apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+    return apr_atomic_read32_ex(&seqlock->seq, APR_ATOMIC_RELAXED) != seq;
+}
+
+APR_DECLARE(void) apr_seqlock_write_begin(apr_seqlock_t *seqlock)
+{
+    for (;;) {
+        apr_uint32_t seq = apr_atomic_read32_ex(&seqlock->seq,
+                                                APR_ATOMIC_RELAXED);
+        if (!(seq & 1) && apr_atomic_cas32_ex(&seqlock->seq, seq + 1, seq,
+                                              APR_ATOMIC_ACQUIRE) == seq) {
+            break;
+        }
+        RCU_YIELD();
+    }
+    /* The odd sequence is visible before any write of the data */
+    apr_atomic_fence(APR_ATOMIC_RELEASE);
+}
+
+APR_DECLARE(void) apr_seqlock_write_end(apr_seqlock_t *seqlock)
+{
+    apr_atomic_add32_ex(&seqlock->seq, 1, APR_ATOMIC_RELEASE);
+}
+
+static void rcu_destroy_retired(rcu_retired_t *r)
+{
+    for (; r; r = r->next) {
+        apr_pool_destroy(r->pool);
+    }
+}
+
+static apr_status_t rcu_cleanup(void *data)
+{
+    apr_rcu_t *rcu = data;
+    apr_rcu_reader_t *reader;
+
+    for (reader = rcu->readers; reader; reader = reader->next) {
+        reader->rcu = NULL;
+    }
+    rcu->readers = NULL;
+
+    rcu_destroy_retired(rcu->retired);
+    rcu->retired = NULL;
+    rcu->retired_tail = &rcu->retired;
+
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_rcu_create(apr_rcu_t **rcu, apr_pool_t *pool)
+{
+    apr_rcu_t *new_rcu;
+
+    new_rcu = apr_pcalloc(pool, sizeof(apr_rcu_t));
+    new_rcu->pool = pool;
+    new_rcu->epoch = 1;
+    new_rcu->retired_tail = &new_rcu->retired;
+#if APR_HAS_THREADS
+    {
+        apr_status_t rv = apr_thread_mutex_create(&new_rcu->lock,
+                                                  APR_THREAD_MUTEX_DEFAULT,
+                                                  pool);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+    }
+#endif
+
+    /* Before the subpools, which may be retired ones */
+    apr_pool_pre_cleanup_register(pool, new_rcu, rcu_cleanup);
+
+    *rcu = new_rcu;
+    return APR_SUCCESS;
+}
+
+static apr_status_t rcu_reader_cleanup(void *data)
+{
+    apr_rcu_reader_t *reader = data;
+    apr_rcu_t *rcu = reader->rcu;
+
+    if (rcu) {
+        RCU_LOCK(rcu);
+        if (reader->next) {
+            reader->next->prevp = reader->prevp;
+        }
+        *reader->prevp = reader->next;
+        RCU_UNLOCK(rcu);
+        reader->rcu = NULL;
+    }
+
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_rcu_reader_register(apr_rcu_reader_t **reader,
+                                                  apr_rcu_t *rcu,
+                                                  apr_pool_t *pool)
+{
+    apr_rcu_reader_t *new_reader;
+    char *mem;
+
+    /* Aligned, so that no other reader shares the cache line */
+    mem = apr_pcalloc(pool, sizeof(apr_rcu_reader_t) + RCU_ALIGN);
+    new_reader = (apr_rcu_reader_t *)APR_ALIGN((apr_uintptr_t)mem, RCU_ALIGN);
+    new_reader->rcu = rcu;
+    new_reader->pool = pool;
+
+    RCU_LOCK(rcu);
+    new_reader->next = rcu->readers;
+    if (rcu->readers) {
+        rcu->readers->prevp = &new_reader->next;
+    }
+    new_reader->prevp = &rcu->readers;
+    rcu->readers = new_reader;
+    RCU_UNLOCK(rcu);
+
+    apr_pool_cleanup_register(pool, new_reader, rcu_reader_cleanup,
+                              apr_pool_cleanup_null);
+
+    *reader = new_reader;
+    return APR_SUCCESS;
+}
+
+static APR_INLINE void rcu_reader_enter(apr_rcu_reader_t *reader)
+{
+    apr_uint64_t epoch = apr_atomic_read64_ex(&reader->rcu->epoch,
+                                              APR_ATOMIC_ACQUIRE);
+
+    /* The reads of the previous critical section complete before the
+     * announcement, which is visible before the reads of the next one */
+    apr_atomic_set64_ex(&reader->epoch, epoch, APR_ATOMIC_RELEASE);
+    apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(void) apr_rcu_read_lock(apr_rcu_reader_t *reader)
+{
+    rcu_reader_enter(reader);
+}
+
+APR_DECLARE(void) apr_rcu_read_unlock(apr_rcu_reader_t *reader)
+{
+    apr_atomic_set64_ex(&reader->epoch, 0, APR_ATOMIC_RELEASE);
+}
+
+APR_DECLARE(void) apr_rcu_quiescent(apr_rcu_reader_t *reader)
+{
+    rcu_reader_enter(reader);
+}
+
+APR_DECLARE(void *) apr_rcu_dereference(void *volatile *ptr)
+{
+    void *val = *ptr;
+
+    apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+    return val;
+}
+
+/* The oldest epoch in which a reader may still be, the lock held */
+static apr_uint64_t rcu_oldest_epoch(apr_rcu_t *rcu)
+{
+    apr_uint64_t oldest = apr_atomic_read64(&rcu->epoch);
+    apr_rcu_reader_t *reader;
+
+    apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    for (reader = rcu->readers; reader; reader = reader->next) {
+        apr_uint64_t epoch = apr_atomic_read64_ex(&reader->epoch,
+                                                  APR_ATOMIC_ACQUIRE);
+        if (epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+/* Destroy the retired pools which no reader can use anymore, and return
+ * the oldest epoch of the readers */
+static apr_uint64_t rcu_reclaim(apr_rcu_t *rcu)
+{
+    rcu_retired_t *done = NULL, **done_tail = &done, *r;
+    apr_uint64_t oldest;
+
+    RCU_LOCK(rcu);
+    oldest = rcu_oldest_epoch(rcu);
+    while ((r = rcu->retired) && r->epoch <= oldest) {
+        rcu->retired = r->next;
+        *done_tail = r;
+        done_tail = &r->next;
+    }
+    if (!rcu->retired) {
+        rcu->retired_tail = &rcu->retired;
+    }
+    *done_tail = NULL;
+    RCU_UNLOCK(rcu);
+
+    if (done) {
+        /* Outside of the lock, the cleanups of the pools may use it */
+        rcu_destroy_retired(done);
+
+        RCU_LOCK(rcu);
+        *done_tail = rcu->free;
+        rcu->free = done;
+        RCU_UNLOCK(rcu);
+    }
+
+    return oldest;
+}
+
+APR_DECLARE(apr_status_t) apr_rcu_retire(apr_rcu_t *rcu, apr_pool_t *pool)
+{
+    rcu_retired_t *r;
+
+    RCU_LOCK(rcu);
+    if ((r = rcu->free)) {
+        rcu->free = r->next;
+    }
+    else {
+        r = apr_palloc(rcu->pool, sizeof(*r));
+    }
+    r->next = NULL;
+    r->pool = pool;
+    /* The readers entering the new epoch see what was published before */
+    r->epoch = apr_atomic_add64(&rcu->epoch, 1) + 1;
+    *rcu->retired_tail = r;
+    rcu->retired_tail = &r->next;
+    RCU_UNLOCK(rcu);
+
+    rcu_reclaim(rcu);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(void *) apr_rcu_publish(apr_rcu_t *rcu, void *volatile *ptr,
+                                    void *val, apr_pool_t *old_pool)
+{
+    void *old = apr_atomic_xchgptr(ptr, val);
+
+    if (old_pool) {
+        apr_rcu_retire(rcu, old_pool);
+    }
+    return old;
+}
+
+APR_DECLARE(apr_status_t) apr_rcu_synchronize(apr_rcu_t *rcu)
+{
+    apr_uint64_t epoch = apr_atomic_add64(&rcu->epoch, 1) + 1;
+
+    while (rcu_reclaim(rcu) < epoch) {
+        RCU_YIELD();
+    }
+    return APR_SUCCESS;
+}
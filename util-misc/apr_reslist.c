@@ -22,6 +22,8 @@
 #include "apr_strings.h"
 #include "apr_thread_mutex.h"
 #include "apr_thread_cond.h"
+#include "apr_thread_proc.h"
+#include "apr_atomic.h"
 #include "apr_ring.h"
 
 /**
@@ -40,6 +42,28 @@ typedef struct apr_res_t apr_res_t;
 APR_RING_HEAD(apr_resring_t, apr_res_t);
 typedef struct apr_resring_t apr_resring_t;
 
+#if APR_HAS_THREADS
+/**
+ * A per-thread affinity slot, holding the resource most recently
+ * released by its owning thread.  The resource is handed over with
+ * atomic operations only, so that the owner can get it back without
+ * taking the list lock, while any other thread may still steal it.
+ */
+struct apr_res_slot_t {
+    void *volatile opaque; /* parked resource, or NULL */
+    apr_time_t freed;      /* written by the owning thread only */
+    apr_reslist_t *reslist;
+    APR_RING_ENTRY(apr_res_slot_t) link;
+};
+typedef struct apr_res_slot_t apr_res_slot_t;
+
+/**
+ * A ring of affinity slots.
+ */
+APR_RING_HEAD(apr_slotring_t, apr_res_slot_t);
+typedef struct apr_slotring_t apr_slotring_t;
+#endif
+
 struct apr_reslist_t {
     apr_pool_t *pool; /* the pool used in constructor and destructor calls */
     int ntotal;     /* total number of resources managed by this list */
@@ -57,7 +81,17 @@ struct apr_reslist_t {
 #if APR_HAS_THREADS
     apr_thread_mutex_t *listlock;
     apr_thread_cond_t *avail;
+    int affinity;   /* per-thread affinity cache enabled */
+    apr_threadkey_t *slotkey;   /* the calling thread's apr_res_slot_t */
+    apr_slotring_t slot_list;   /* slots of live threads */
+    apr_slotring_t slot_free;   /* slots left by exited threads */
+    volatile apr_uint32_t ncached;  /* resources parked in slots */
+    volatile apr_uint32_t nwaiters; /* threads blocked in acquire */
+    apr_thread_pool_t *maintainer;  /* runs the maintenance, if set */
+    apr_interval_time_t interval;   /* of the periodic maintenance */
+    volatile apr_uint32_t kicked;   /* maintenance task pending */
 #endif
+    apr_reslist_stats_t stats; /* constructor calls statistics */
 };
 
 /**
@@ -135,9 +169,33 @@ static apr_status_t create_resource(apr_reslist_t *reslist, apr_res_t **ret_res)
     apr_status_t rv;
     apr_res_t *res;
 
+    apr_time_t start;
+    apr_interval_time_t elapsed;
+    int slot;
+
     res = get_container(reslist);
 
+    start = apr_time_now();
     rv = reslist->constructor(&res->opaque, reslist->params, reslist->pool);
+    elapsed = apr_time_now() - start;
+
+    /* Account the call in the latency histogram */
+    if (rv == APR_SUCCESS) {
+        reslist->stats.constructed++;
+    }
+    else {
+        reslist->stats.failed++;
+    }
+    reslist->stats.total += elapsed;
+    if (reslist->stats.max < elapsed) {
+        reslist->stats.max = elapsed;
+    }
+    for (slot = 0; slot < APR_RESLIST_LATENCY_SLOTS - 1; slot++) {
+        if (elapsed < (APR_INT64_C(1) << slot)) {
+            break;
+        }
+    }
+    reslist->stats.latency[slot]++;
 
     *ret_res = res;
     return rv;
@@ -152,6 +210,186 @@ static apr_status_t destroy_resource(apr_reslist_t *reslist, apr_res_t *res)
     return reslist->destructor(res->opaque, reslist->params, reslist->pool);
 }
 
+#if APR_HAS_THREADS
+/**
+ * Park a released resource in the given thread slot.  Returns nonzero
+ * if the resource now sits in the slot, zero if the caller has to put
+ * it back to the shared list.
+ */
+static int park_resource(apr_reslist_t *reslist, apr_res_slot_t *slot,
+                         void *resource)
+{
+    if (slot->opaque) {
+        return 0;
+    }
+    if (reslist->ttl) {
+        slot->freed = apr_time_now();
+    }
+    apr_atomic_inc32(&reslist->ncached);
+    if (apr_atomic_casptr(&slot->opaque, resource, NULL) != NULL) {
+        apr_atomic_dec32(&reslist->ncached);
+        return 0;
+    }
+    /* Someone is blocked waiting for a resource and may have scanned
+     * the slots before we parked this one, hand it over through the
+     * shared list so that the waiter gets signaled.
+     */
+    if (apr_atomic_read32(&reslist->nwaiters)) {
+        if (apr_atomic_casptr(&slot->opaque, NULL, resource) != resource) {
+            /* already stolen */
+            return 1;
+        }
+        apr_atomic_dec32(&reslist->ncached);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Take the resource parked in a slot, if any.
+ */
+static void *unpark_resource(apr_reslist_t *reslist, apr_res_slot_t *slot)
+{
+    void *opaque = apr_atomic_xchgptr(&slot->opaque, NULL);
+    if (opaque) {
+        apr_atomic_dec32(&reslist->ncached);
+    }
+    return opaque;
+}
+
+/**
+ * Steal a resource parked by any thread.
+ * Assumes: that the reslist is locked.
+ */
+static void *steal_resource(apr_reslist_t *reslist)
+{
+    apr_res_slot_t *slot;
+    void *opaque;
+
+    if (!apr_atomic_read32(&reslist->ncached)) {
+        return NULL;
+    }
+    for (slot = APR_RING_FIRST(&reslist->slot_list);
+         slot != APR_RING_SENTINEL(&reslist->slot_list, apr_res_slot_t, link);
+         slot = APR_RING_NEXT(slot, link)) {
+        opaque = unpark_resource(reslist, slot);
+        if (opaque) {
+            return opaque;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Get the calling thread's slot, creating it if asked to.
+ */
+static apr_res_slot_t *get_slot(apr_reslist_t *reslist, int create)
+{
+    apr_res_slot_t *slot = NULL;
+
+    apr_threadkey_private_get((void **)&slot, reslist->slotkey);
+    if (slot || !create) {
+        return slot;
+    }
+
+    apr_thread_mutex_lock(reslist->listlock);
+    apr_pool_owner_set(reslist->pool, 0);
+    if (!APR_RING_EMPTY(&reslist->slot_free, apr_res_slot_t, link)) {
+        slot = APR_RING_FIRST(&reslist->slot_free);
+        APR_RING_REMOVE(slot, link);
+    }
+    else {
+        slot = apr_pcalloc(reslist->pool, sizeof(*slot));
+        slot->reslist = reslist;
+    }
+    if (apr_threadkey_private_set(slot, reslist->slotkey) == APR_SUCCESS) {
+        APR_RING_INSERT_TAIL(&reslist->slot_list, slot, apr_res_slot_t, link);
+    }
+    else {
+        APR_RING_INSERT_TAIL(&reslist->slot_free, slot, apr_res_slot_t, link);
+        slot = NULL;
+    }
+    apr_thread_mutex_unlock(reslist->listlock);
+
+    return slot;
+}
+
+/**
+ * Thread exit handler, gives the resource parked by the exiting
+ * thread back to the shared list and recycles its slot.
+ */
+static void slot_cleanup(void *data)
+{
+    apr_res_slot_t *slot = data;
+    apr_reslist_t *reslist = slot->reslist;
+    void *opaque;
+
+    apr_thread_mutex_lock(reslist->listlock);
+    apr_pool_owner_set(reslist->pool, 0);
+    opaque = unpark_resource(reslist, slot);
+    if (opaque) {
+        apr_res_t *res = get_container(reslist);
+        res->opaque = opaque;
+        push_resource(reslist, res, 0);
+    }
+    APR_RING_REMOVE(slot, link);
+    APR_RING_INSERT_TAIL(&reslist->slot_free, slot, apr_res_slot_t, link);
+    apr_thread_mutex_unlock(reslist->listlock);
+}
+
+/**
+ * Move all the parked resources to the shared list.
+ * Assumes: that the reslist is locked.
+ */
+static void flush_slots(apr_reslist_t *reslist)
+{
+    apr_res_t *res;
+    void *opaque;
+
+    while ((opaque = steal_resource(reslist)) != NULL) {
+        res = get_container(reslist);
+        res->opaque = opaque;
+        push_resource(reslist, res, 0);
+    }
+}
+
+/**
+ * Destroy the parked resources which have been idle for longer than
+ * the ttl, as long as we are above the soft maximum.
+ * Assumes: that the reslist is locked.
+ */
+static apr_status_t expire_slots(apr_reslist_t *reslist, apr_time_t now)
+{
+    apr_res_slot_t *slot;
+    apr_status_t rv = APR_SUCCESS;
+    void *opaque;
+
+    for (slot = APR_RING_FIRST(&reslist->slot_list);
+         slot != APR_RING_SENTINEL(&reslist->slot_list, apr_res_slot_t, link);
+         slot = APR_RING_NEXT(slot, link)) {
+        if (reslist->nidle + (int)apr_atomic_read32(&reslist->ncached)
+                <= reslist->smax) {
+            break;
+        }
+        opaque = slot->opaque;
+        if (!opaque || now - slot->freed < reslist->ttl) {
+            continue;
+        }
+        if (apr_atomic_casptr(&slot->opaque, NULL, opaque) != opaque) {
+            /* the owner took it back meanwhile */
+            continue;
+        }
+        apr_atomic_dec32(&reslist->ncached);
+        reslist->ntotal--;
+        rv = reslist->destructor(opaque, reslist->params, reslist->pool);
+        if (rv != APR_SUCCESS) {
+            break;
+        }
+    }
+    return rv;
+}
+#endif /* APR_HAS_THREADS */
+
 static apr_status_t reslist_cleanup(void *data_)
 {
     apr_status_t rv = APR_SUCCESS;
@@ -159,8 +397,17 @@ static apr_status_t reslist_cleanup(void *data_)
     apr_res_t *res;
 
 #if APR_HAS_THREADS
+    if (rl->maintainer) {
+        apr_reslist_maintainer_set(rl, NULL, 0);
+    }
+
     apr_thread_mutex_lock(rl->listlock);
     apr_pool_owner_set(rl->pool, 0);
+    if (rl->affinity) {
+        rl->affinity = 0;
+        flush_slots(rl);
+        apr_threadkey_private_delete(rl->slotkey);
+    }
 #endif
 
     while (rl->nidle > 0) {
@@ -187,13 +434,64 @@ static apr_status_t reslist_cleanup(void *data_)
     return rv;
 }
 
+/**
+ * Destroy the idle resources which have exceeded their ttl, as long
+ * as we are above the soft maximum.
+ * Assumes: that the reslist is locked.
+ */
+static apr_status_t expire_resources(apr_reslist_t *reslist)
+{
+    apr_time_t now;
+    apr_status_t rv;
+    apr_res_t *res;
+
+    if (!reslist->ttl) {
+        return APR_SUCCESS;
+    }
+
+    /* Check if we need to expire old resources */
+    now = apr_time_now();
+    while (reslist->nidle > 0 &&
+#if APR_HAS_THREADS
+           reslist->nidle + (int)apr_atomic_read32(&reslist->ncached)
+#else
+           reslist->nidle
+#endif
+               > reslist->smax) {
+        /* Peek at the oldest resource in the list */
+        res = APR_RING_LAST(&reslist->avail_list);
+        if (now - res->freed < reslist->ttl) {
+            /* If this entry is too young, none of the others
+             * will be ready to be expired either, so we are done. */
+            break;
+        }
+        /* this res is expired - kill it */
+        APR_RING_REMOVE(res, link);
+        reslist->nidle--;
+        reslist->ntotal--;
+        rv = destroy_resource(reslist, res);
+        free_container(reslist, res);
+        if (rv != APR_SUCCESS) {
+            return rv;
+        }
+    }
+
+#if APR_HAS_THREADS
+    /* The same applies to the resources parked by threads. */
+    if (reslist->affinity) {
+        return expire_slots(reslist, now);
+    }
+#endif
+
+    return APR_SUCCESS;
+}
+
 /**
  * Perform routine maintenance on the resource list. This call
  * may instantiate new resources or expire old resources.
  */
 static apr_status_t reslist_maintain(apr_reslist_t *reslist)
 {
-    apr_time_t now;
     apr_status_t rv;
     apr_res_t *res;
     int created_one = 0;
@@ -222,27 +520,7 @@ static apr_status_t reslist_maintain(apr_reslist_t *reslist)
     }
 
     /* Check if we need to expire old resources */
-    now = apr_time_now();
-    while (reslist->nidle > reslist->smax && reslist->nidle > 0) {
-        /* Peek at the oldest resource in the list */
-        res = APR_RING_LAST(&reslist->avail_list);
-        if (now - res->freed < reslist->ttl) {
-            /* If this entry is too young, none of the others
-             * will be ready to be expired either, so we are done. */
-            break;
-        }
-        /* this res is expired - kill it */
-        APR_RING_REMOVE(res, link);
-        reslist->nidle--;
-        reslist->ntotal--;
-        rv = destroy_resource(reslist, res);
-        free_container(reslist, res);
-        if (rv != APR_SUCCESS) {
-            return rv;
-        }
-    }
-
-    return APR_SUCCESS;
+    return expire_resources(reslist);
 }
 
 APR_DECLARE(apr_status_t) apr_reslist_maintain(apr_reslist_t *reslist)
@@ -260,6 +538,85 @@ APR_DECLARE(apr_status_t) apr_reslist_maintain(apr_reslist_t *reslist)
     return rv;
 }
 
+#if APR_HAS_THREADS
+static void * APR_THREAD_FUNC maintainer_timer(apr_thread_t *thd, void *data);
+
+/**
+ * Run the maintenance on behalf of the maintainer thread pool.  The
+ * constructor allocates from the list pool, so it is called with the list
+ * locked like in apr_reslist_acquire(), but the resources are created one
+ * at a time so that the lock is never held for longer than a single
+ * constructor call.
+ */
+static void maintainer_run(apr_reslist_t *reslist, int periodic)
+{
+    apr_status_t rv;
+    apr_res_t *res;
+
+    apr_thread_mutex_lock(reslist->listlock);
+    apr_pool_owner_set(reslist->pool, 0);
+    apr_atomic_set32(&reslist->kicked, 0);
+
+    while (reslist->maintainer && reslist->nidle < reslist->min
+           && reslist->ntotal < reslist->hmax) {
+        rv = create_resource(reslist, &res);
+        reslist->stats.maintained++;
+        if (rv != APR_SUCCESS) {
+            /* retry on the next run */
+            free_container(reslist, res);
+            break;
+        }
+        push_resource(reslist, res, 1);
+
+        /* Let the others in before the next constructor call. */
+        apr_thread_mutex_unlock(reslist->listlock);
+        apr_thread_mutex_lock(reslist->listlock);
+        apr_pool_owner_set(reslist->pool, 0);
+    }
+
+    if (reslist->maintainer) {
+        expire_resources(reslist);
+        if (periodic) {
+            apr_thread_pool_schedule(reslist->maintainer, maintainer_timer,
+                                     reslist, reslist->interval, reslist);
+        }
+    }
+
+    apr_thread_mutex_unlock(reslist->listlock);
+}
+
+static void * APR_THREAD_FUNC maintainer_timer(apr_thread_t *thd, void *data)
+{
+    maintainer_run(data, 1);
+    return NULL;
+}
+
+static void * APR_THREAD_FUNC maintainer_task(apr_thread_t *thd, void *data)
+{
+    maintainer_run(data, 0);
+    return NULL;
+}
+
+/**
+ * Have the maintainer replenish (or expire, if it does not run
+ * periodically) the resources, if needed.
+ * Assumes: that the reslist is locked.
+ */
+static void maintainer_kick(apr_reslist_t *reslist)
+{
+    if ((reslist->nidle < reslist->min && reslist->ntotal < reslist->hmax)
+        || (!reslist->interval && reslist->ttl
+            && reslist->nidle > reslist->smax)) {
+        if (apr_atomic_cas32(&reslist->kicked, 1, 0) == 0
+            && apr_thread_pool_push(reslist->maintainer, maintainer_task,
+                                    reslist, APR_THREAD_TASK_PRIORITY_NORMAL,
+                                    reslist) != APR_SUCCESS) {
+            apr_atomic_set32(&reslist->kicked, 0);
+        }
+    }
+}
+#endif /* APR_HAS_THREADS */
+
 APR_DECLARE(apr_status_t) apr_reslist_create(apr_reslist_t **reslist,
                                              int min, int smax, int hmax,
                                              apr_interval_time_t ttl,
@@ -303,6 +660,9 @@ APR_DECLARE(apr_status_t) apr_reslist_create(apr_reslist_t **reslist,
     APR_RING_INIT(&rl->free_list, apr_res_t, link);
 
 #if APR_HAS_THREADS
+    APR_RING_INIT(&rl->slot_list, apr_res_slot_t, link);
+    APR_RING_INIT(&rl->slot_free, apr_res_slot_t, link);
+
     rv = apr_thread_mutex_create(&rl->listlock, APR_THREAD_MUTEX_DEFAULT,
                                  pool);
     if (rv != APR_SUCCESS) {
@@ -348,8 +708,36 @@ static apr_status_t reslist_acquire(apr_reslist_t *reslist,
     fifo = flags & APR_RESLIST_ACQUIRE_FIFO;
 
 #if APR_HAS_THREADS
-    apr_thread_mutex_lock(reslist->listlock);
-    apr_pool_owner_set(reslist->pool, 0);
+    /* Get back the resource this thread released last, if it's not
+     * expired, without touching the shared list. */
+    if (reslist->affinity) {
+        apr_res_slot_t *slot = get_slot(reslist, 0);
+        void *opaque = slot ? unpark_resource(reslist, slot) : NULL;
+        if (opaque) {
+            if (!reslist->ttl
+                    || apr_time_now() - slot->freed < reslist->ttl) {
+                *resource = opaque;
+                return APR_SUCCESS;
+            }
+            apr_thread_mutex_lock(reslist->listlock);
+            apr_pool_owner_set(reslist->pool, 0);
+            reslist->ntotal--;
+            rv = reslist->destructor(opaque, reslist->params, reslist->pool);
+            if (rv != APR_SUCCESS) {
+                apr_thread_cond_signal(reslist->avail);
+                apr_thread_mutex_unlock(reslist->listlock);
+                return rv;
+            }
+        }
+        else {
+            apr_thread_mutex_lock(reslist->listlock);
+            apr_pool_owner_set(reslist->pool, 0);
+        }
+    }
+    else {
+        apr_thread_mutex_lock(reslist->listlock);
+        apr_pool_owner_set(reslist->pool, 0);
+    }
 #endif
     /* If there are expired resources in the available list, kill
      * them right away. */
@@ -383,6 +771,9 @@ static apr_status_t reslist_acquire(apr_reslist_t *reslist,
         *resource = res->opaque;
         free_container(reslist, res);
 #if APR_HAS_THREADS
+        if (reslist->maintainer) {
+            maintainer_kick(reslist);
+        }
         apr_thread_mutex_unlock(reslist->listlock);
 #endif
         return APR_SUCCESS;
@@ -391,15 +782,32 @@ static apr_status_t reslist_acquire(apr_reslist_t *reslist,
      * a new one, or something becomes free. */
     while (reslist->ntotal >= reslist->hmax && reslist->nidle <= 0) {
 #if APR_HAS_THREADS
-        if (reslist->timeout) {
-            if ((rv = apr_thread_cond_timedwait(reslist->avail, 
-                reslist->listlock, reslist->timeout)) != APR_SUCCESS) {
+        if (reslist->affinity) {
+            /* Take one parked by another thread rather than waiting,
+             * releasing threads won't park while we are waiting. */
+            void *opaque;
+            apr_atomic_inc32(&reslist->nwaiters);
+            opaque = steal_resource(reslist);
+            if (opaque) {
+                apr_atomic_dec32(&reslist->nwaiters);
+                *resource = opaque;
                 apr_thread_mutex_unlock(reslist->listlock);
-                return rv;
+                return APR_SUCCESS;
             }
         }
+        if (reslist->timeout) {
+            rv = apr_thread_cond_timedwait(reslist->avail, reslist->listlock,
+                                           reslist->timeout);
+        }
         else {
-            apr_thread_cond_wait(reslist->avail, reslist->listlock);
+            rv = apr_thread_cond_wait(reslist->avail, reslist->listlock);
+        }
+        if (reslist->affinity) {
+            apr_atomic_dec32(&reslist->nwaiters);
+        }
+        if (rv != APR_SUCCESS && reslist->timeout) {
+            apr_thread_mutex_unlock(reslist->listlock);
+            return rv;
         }
 #else
         return APR_EAGAIN;
@@ -412,6 +820,9 @@ static apr_status_t reslist_acquire(apr_reslist_t *reslist,
         *resource = res->opaque;
         free_container(reslist, res);
 #if APR_HAS_THREADS
+        if (reslist->maintainer) {
+            maintainer_kick(reslist);
+        }
         apr_thread_mutex_unlock(reslist->listlock);
 #endif
         return APR_SUCCESS;
@@ -450,14 +861,44 @@ APR_DECLARE(apr_status_t) apr_reslist_release(apr_reslist_t *reslist,
 {
     apr_status_t rv;
     apr_res_t *res;
-
 #if APR_HAS_THREADS
+    void *prev = NULL;
+
+    /* Keep the resource for this thread's next acquire, and move the
+     * one it kept so far to the shared list. */
+    if (reslist->affinity) {
+        apr_res_slot_t *slot = get_slot(reslist, 1);
+        if (slot) {
+            prev = unpark_resource(reslist, slot);
+            if (park_resource(reslist, slot, resource)) {
+                if (!prev) {
+                    return APR_SUCCESS;
+                }
+                resource = prev;
+                prev = NULL;
+            }
+        }
+    }
+
     apr_thread_mutex_lock(reslist->listlock);
     apr_pool_owner_set(reslist->pool, 0);
+    if (prev) {
+        res = get_container(reslist);
+        res->opaque = prev;
+        push_resource(reslist, res, 0);
+    }
 #endif
     res = get_container(reslist);
     res->opaque = resource;
     push_resource(reslist, res, 0);
+#if APR_HAS_THREADS
+    if (reslist->maintainer) {
+        /* Don't have the caller wait for the constructors */
+        maintainer_kick(reslist);
+        rv = APR_SUCCESS;
+    }
+    else
+#endif
     rv = reslist_maintain(reslist);
 #if APR_HAS_THREADS
     apr_thread_mutex_unlock(reslist->listlock);
@@ -471,6 +912,92 @@ APR_DECLARE(void) apr_reslist_timeout_set(apr_reslist_t *reslist,
     reslist->timeout = timeout;
 }
 
+APR_DECLARE(apr_status_t) apr_reslist_affinity_set(apr_reslist_t *reslist,
+                                                   int on)
+{
+#if APR_HAS_THREADS
+    apr_status_t rv = APR_SUCCESS;
+
+    apr_thread_mutex_lock(reslist->listlock);
+    apr_pool_owner_set(reslist->pool, 0);
+    if (on && !reslist->affinity) {
+        rv = apr_threadkey_private_create(&reslist->slotkey, slot_cleanup,
+                                          reslist->pool);
+        if (rv == APR_SUCCESS) {
+            reslist->affinity = 1;
+        }
+    }
+    else if (!on && reslist->affinity) {
+        reslist->affinity = 0;
+        flush_slots(reslist);
+        rv = apr_threadkey_private_delete(reslist->slotkey);
+        APR_RING_CONCAT(&reslist->slot_free, &reslist->slot_list,
+                        apr_res_slot_t, link);
+    }
+    apr_thread_mutex_unlock(reslist->listlock);
+
+    return rv;
+#else
+    return on ? APR_ENOTIMPL : APR_SUCCESS;
+#endif
+}
+
+#if APR_HAS_THREADS
+APR_DECLARE(apr_status_t) apr_reslist_maintainer_set(apr_reslist_t *reslist,
+                                                     apr_thread_pool_t *tp,
+                                                     apr_interval_time_t interval)
+{
+    apr_thread_pool_t *prev;
+    apr_status_t rv = APR_SUCCESS;
+
+    if (interval < 0) {
+        return APR_EINVAL;
+    }
+
+    /* Stop the current maintainer, its running task won't reschedule. */
+    apr_thread_mutex_lock(reslist->listlock);
+    apr_pool_owner_set(reslist->pool, 0);
+    prev = reslist->maintainer;
+    reslist->maintainer = NULL;
+    apr_thread_mutex_unlock(reslist->listlock);
+    if (prev) {
+        apr_thread_pool_tasks_cancel(prev, reslist);
+    }
+
+    if (tp) {
+        apr_thread_mutex_lock(reslist->listlock);
+        apr_pool_owner_set(reslist->pool, 0);
+        reslist->maintainer = tp;
+        reslist->interval = interval;
+        apr_atomic_set32(&reslist->kicked, 1);
+        rv = apr_thread_pool_push(tp, interval ? maintainer_timer
+                                               : maintainer_task,
+                                  reslist, APR_THREAD_TASK_PRIORITY_NORMAL,
+                                  reslist);
+        if (rv != APR_SUCCESS) {
+            reslist->maintainer = NULL;
+            apr_atomic_set32(&reslist->kicked, 0);
+        }
+        apr_thread_mutex_unlock(reslist->listlock);
+    }
+
+    return rv;
+}
+#endif
+
+APR_DECLARE(void) apr_reslist_stats_get(apr_reslist_t *reslist,
+                                        apr_reslist_stats_t *stats)
+{
+#if APR_HAS_THREADS
+    apr_thread_mutex_lock(reslist->listlock);
+    apr_pool_owner_set(reslist->pool, 0);
+#endif
+    *stats = reslist->stats;
+#if APR_HAS_THREADS
+    apr_thread_mutex_unlock(reslist->listlock);
+#endif
+}
+
 APR_DECLARE(apr_uint32_t) apr_reslist_acquired_count(apr_reslist_t *reslist)
 {
     apr_uint32_t count;
@@ -481,6 +1008,7 @@ APR_DECLARE(apr_uint32_t) apr_reslist_acquired_count(apr_reslist_t *reslist)
 #endif
     count = reslist->ntotal - reslist->nidle;
 #if APR_HAS_THREADS
+    count -= apr_atomic_read32(&reslist->ncached);
     apr_thread_mutex_unlock(reslist->listlock);
 #endif
 
@@ -498,6 +1026,9 @@ APR_DECLARE(apr_status_t) apr_reslist_invalidate(apr_reslist_t *reslist,
     ret = reslist->destructor(resource, reslist->params, reslist->pool);
     reslist->ntotal--;
 #if APR_HAS_THREADS
+    if (reslist->maintainer) {
+        maintainer_kick(reslist);
+    }
     apr_thread_cond_signal(reslist->avail);
     apr_thread_mutex_unlock(reslist->listlock);
 #endif
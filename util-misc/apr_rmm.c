@@ -20,52 +20,83 @@
 #include "apr_lib.h"
 #include "apr_strings.h"
 
-/* The RMM region is made up of two doubly-linked-list of blocks; the
- * list of used blocks, and the list of free blocks (either list may
- * be empty).  The base pointer, rmm->base, points at the beginning of
- * the shmem region in use.  Each block is addressable by an
- * apr_rmm_off_t value, which represents the offset from the base
+/* The RMM region is made up of physically contiguous blocks, each of
+ * them either on the list of used blocks or on one of the segregated
+ * lists of free blocks.  The base pointer, rmm->base, points at the
+ * beginning of the shmem region in use.  Each block is addressable by
+ * an apr_rmm_off_t value, which represents the offset from the base
  * pointer.  The term "address" is used here to mean such a value; an
- * "offset from rmm->base".
+ * "offset from rmm->base".  Since nothing but addresses are stored in
+ * the region, it can be attached by other processes at any base.
  *
  * The RMM region contains exactly one "rmm_hdr_block_t" structure,
  * the "header block", which is always stored at the base pointer.
  * The firstused field in this structure is the address of the first
- * block in the "used blocks" list; the firstfree field is the address
- * of the first block in the "free blocks" list.
+ * block in the "used blocks" list; the firstfree array holds the
+ * address of the first block of each "free blocks" list, and the
+ * freemap bitmap tells which of them are not empty.
  *
  * Each block is prefixed by an "rmm_block_t" structure, followed by
- * the caller-usable region represented by the block.  The next and
- * prev fields of the structure are zero if the block is at the end or
- * beginning of the linked-list respectively, or otherwise hold the
- * address of the next and previous blocks in the list.  ("address 0",
- * i.e. rmm->base is *not* a valid address for a block, since the
+ * the caller-usable region represented by the block.  The size field
+ * is the size of the whole block, with the RMM_BLOCK_FREE bit set if
+ * the block is free, and the prevsize field is the size of the block
+ * physically preceding it (zero for the first block), so that free
+ * blocks can be coalesced with their neighbours in constant time.
+ * The next and prev fields of the structure are zero if the block is
+ * at the end or beginning of its list respectively, or otherwise hold
+ * the address of the next and previous blocks in the list.  ("address
+ * 0", i.e. rmm->base is *not* a valid address for a block, since the
  * header block is always stored at that address).
  *
- * At creation, the RMM region is initialized to hold a single block
- * on the free list representing the entire available shm segment
- * (minus header block); subsequent allocation and deallocation of
- * blocks involves splitting blocks and coalescing adjacent blocks,
- * and switching them between the free and used lists as
- * appropriate. */
+ * Free blocks are segregated by size classes: each power of two is
+ * split in RMM_SL_COUNT lists of equally sized ranges.  An allocation
+ * looks at a few blocks of its own class first, then takes the first
+ * block of the next non-empty class, which is guaranteed to fit, and
+ * only scans its whole class when all the larger ones are empty.
+ *
+ * At creation, the RMM region is initialized to hold a single free
+ * block representing the entire available shm segment (minus header
+ * block); subsequent allocation and deallocation of blocks involves
+ * splitting blocks and coalescing adjacent blocks, and switching them
+ * between the free and used lists as appropriate. */
 
 typedef struct rmm_block_t {
     apr_size_t size;
+    apr_size_t prevsize;
     apr_rmm_off_t prev;
     apr_rmm_off_t next;
 } rmm_block_t;
 
+#define RMM_BLOCK_FREE ((apr_size_t)1)
+
+#define RMM_SL_LOG2  2
+#define RMM_SL_COUNT (1 << RMM_SL_LOG2)
+#define RMM_FL_MIN   4
+#define RMM_FL_COUNT 32
+#define RMM_LISTS    (RMM_FL_COUNT * RMM_SL_COUNT)
+#define RMM_MAP_BITS 32
+#define RMM_MAP_SIZE (RMM_LISTS / RMM_MAP_BITS)
+
+/* How many blocks of its own class an allocation looks at before
+ * falling back to the larger classes. */
+#define RMM_SCAN_MAX 8
+
 /* Always at our apr_rmm_off(0):
  */
 typedef struct rmm_hdr_block_t {
     apr_size_t abssize;
     apr_rmm_off_t /* rmm_block_t */ firstused;
-    apr_rmm_off_t /* rmm_block_t */ firstfree;
+    apr_uint32_t freemap[RMM_MAP_SIZE];
+    apr_rmm_off_t /* rmm_block_t */ firstfree[RMM_LISTS];
 } rmm_hdr_block_t;
 
 #define RMM_HDR_BLOCK_SIZE (APR_ALIGN_DEFAULT(sizeof(rmm_hdr_block_t)))
 #define RMM_BLOCK_SIZE (APR_ALIGN_DEFAULT(sizeof(rmm_block_t)))
 
+#define RMM_BLOCK(rmm, off) ((rmm_block_t*)((char*)(rmm)->base + (off)))
+#define RMM_BLOCK_SIZE_OF(blk) ((blk)->size & ~RMM_BLOCK_FREE)
+#define RMM_BLOCK_IS_FREE(blk) ((blk)->size & RMM_BLOCK_FREE)
+
 struct apr_rmm_t {
     apr_pool_t *p;
     rmm_hdr_block_t *base;
@@ -73,141 +104,234 @@ struct apr_rmm_t {
     apr_anylock_t lock;
 };
 
-static apr_rmm_off_t find_block_by_offset(apr_rmm_t *rmm, apr_rmm_off_t next, 
-                                          apr_rmm_off_t find, int includes)
+static int highest_bit(apr_size_t size)
 {
-    apr_rmm_off_t prev = 0;
-
-    while (next) {
-        struct rmm_block_t *blk = (rmm_block_t*)((char*)rmm->base + next);
+#if defined(__GNUC__) && (__GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4))
+    return (int)(sizeof(unsigned long long) * 8) - 1
+           - __builtin_clzll((unsigned long long)size);
+#else
+    int bit = 0;
+    while (size >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
 
-        if (find == next)
-            return next;
+static int lowest_bit(apr_uint32_t map)
+{
+#if defined(__GNUC__) && (__GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4))
+    return __builtin_ctz(map);
+#else
+    int bit = 0;
+    while (!(map & 1)) {
+        map >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
 
-        /* Overshot? */
-        if (find < next)
-            return includes ? prev : 0;
+/* Index of the free list holding the blocks of the given size */
+static int free_list_of_size(apr_size_t size)
+{
+    int fl = highest_bit(size);
+    int sl;
 
-        prev = next;
-        next = blk->next;
+    if (fl < RMM_FL_MIN + RMM_SL_LOG2) {
+        return 0;
     }
-    return includes ? prev : 0;
+    sl = (int)(size >> (fl - RMM_SL_LOG2)) & (RMM_SL_COUNT - 1);
+    fl -= RMM_FL_MIN + RMM_SL_LOG2 - 1;
+    if (fl >= RMM_FL_COUNT) {
+        return RMM_LISTS - 1;
+    }
+    return fl * RMM_SL_COUNT + sl;
 }
 
-static apr_rmm_off_t find_block_of_size(apr_rmm_t *rmm, apr_size_t size)
+/* Index of the first non-empty free list from the given one, or -1 */
+static int find_free_list(apr_rmm_t *rmm, int list)
 {
-    apr_rmm_off_t next = rmm->base->firstfree;
-    apr_rmm_off_t best = 0;
-    apr_rmm_off_t bestsize = 0;
+    int i = list / RMM_MAP_BITS;
+    apr_uint32_t map;
 
-    while (next) {
-        struct rmm_block_t *blk = (rmm_block_t*)((char*)rmm->base + next);
-
-        if (blk->size == size)
-            return next;
-
-        if (blk->size >= size) {
-            /* XXX: sub optimal algorithm 
-             * We need the most thorough best-fit logic, since we can
-             * never grow our rmm, we are SOL when we hit the wall.
-             */
-            if (!bestsize || (blk->size < bestsize)) {
-                bestsize = blk->size;
-                best = next;
-            }
+    map = rmm->base->freemap[i] & (~(apr_uint32_t)0 << (list % RMM_MAP_BITS));
+    while (!map) {
+        if (++i == RMM_MAP_SIZE) {
+            return -1;
         }
-
-        next = blk->next;
+        map = rmm->base->freemap[i];
     }
+    return i * RMM_MAP_BITS + lowest_bit(map);
+}
 
-    if (bestsize > RMM_BLOCK_SIZE + size) {
-        struct rmm_block_t *blk = (rmm_block_t*)((char*)rmm->base + best);
-        struct rmm_block_t *new = (rmm_block_t*)((char*)rmm->base + best + size);
+static void insert_free(apr_rmm_t *rmm, apr_rmm_off_t this)
+{
+    struct rmm_block_t *blk = RMM_BLOCK(rmm, this);
+    int list = free_list_of_size(RMM_BLOCK_SIZE_OF(blk));
 
-        new->size = blk->size - size;
-        new->next = blk->next;
-        new->prev = best;
+    blk->size |= RMM_BLOCK_FREE;
+    blk->prev = 0;
+    blk->next = rmm->base->firstfree[list];
+    if (blk->next) {
+        RMM_BLOCK(rmm, blk->next)->prev = this;
+    }
+    rmm->base->firstfree[list] = this;
+    rmm->base->freemap[list / RMM_MAP_BITS] |= 1u << (list % RMM_MAP_BITS);
+}
 
-        blk->size = size;
-        blk->next = best + size;
+static void remove_free(apr_rmm_t *rmm, apr_rmm_off_t this)
+{
+    struct rmm_block_t *blk = RMM_BLOCK(rmm, this);
+    int list = free_list_of_size(RMM_BLOCK_SIZE_OF(blk));
 
-        if (new->next) {
-            blk = (rmm_block_t*)((char*)rmm->base + new->next);
-            blk->prev = best + size;
+    if (blk->prev) {
+        RMM_BLOCK(rmm, blk->prev)->next = blk->next;
+    }
+    else {
+        rmm->base->firstfree[list] = blk->next;
+        if (!blk->next) {
+            rmm->base->freemap[list / RMM_MAP_BITS] &=
+                ~(1u << (list % RMM_MAP_BITS));
         }
     }
+    if (blk->next) {
+        RMM_BLOCK(rmm, blk->next)->prev = blk->prev;
+    }
+    blk->size &= ~RMM_BLOCK_FREE;
+    blk->prev = blk->next = 0;
+}
 
-    return best;
+static void insert_used(apr_rmm_t *rmm, apr_rmm_off_t this)
+{
+    struct rmm_block_t *blk = RMM_BLOCK(rmm, this);
+
+    blk->prev = 0;
+    blk->next = rmm->base->firstused;
+    if (blk->next) {
+        RMM_BLOCK(rmm, blk->next)->prev = this;
+    }
+    rmm->base->firstused = this;
 }
 
-static void move_block(apr_rmm_t *rmm, apr_rmm_off_t this, int free)
-{   
-    struct rmm_block_t *blk = (rmm_block_t*)((char*)rmm->base + this);
+static void remove_used(apr_rmm_t *rmm, apr_rmm_off_t this)
+{
+    struct rmm_block_t *blk = RMM_BLOCK(rmm, this);
 
-    /* close the gap */
     if (blk->prev) {
-        struct rmm_block_t *prev = (rmm_block_t*)((char*)rmm->base + blk->prev);
-        prev->next = blk->next;
+        RMM_BLOCK(rmm, blk->prev)->next = blk->next;
     }
     else {
-        if (free) {
-            rmm->base->firstused = blk->next;
-        }
-        else {
-            rmm->base->firstfree = blk->next;
-        }
+        rmm->base->firstused = blk->next;
     }
     if (blk->next) {
-        struct rmm_block_t *next = (rmm_block_t*)((char*)rmm->base + blk->next);
-        next->prev = blk->prev;
+        RMM_BLOCK(rmm, blk->next)->prev = blk->prev;
+    }
+}
+
+/* Address of the block physically following the given one, or 0 */
+static apr_rmm_off_t next_block(apr_rmm_t *rmm, apr_rmm_off_t this)
+{
+    apr_rmm_off_t next = this + RMM_BLOCK_SIZE_OF(RMM_BLOCK(rmm, this));
+
+    if (next + RMM_BLOCK_SIZE > rmm->base->abssize) {
+        return 0;
     }
+    return next;
+}
+
+static apr_rmm_off_t find_block_of_size(apr_rmm_t *rmm, apr_size_t size)
+{
+    int list = free_list_of_size(size);
+    int larger = find_free_list(rmm, list + 1 < RMM_LISTS ? list + 1 : list);
+    apr_rmm_off_t next = rmm->base->firstfree[list];
+    apr_rmm_off_t best = 0;
+    apr_size_t bestsize = 0;
+    int scan = 0;
+
+    /* Every block of the larger lists fits (but the last list is
+     * unbounded), so only look at a few blocks of our own list if
+     * there are some. */
+    while (next) {
+        struct rmm_block_t *blk = RMM_BLOCK(rmm, next);
+        apr_size_t blksize = RMM_BLOCK_SIZE_OF(blk);
 
-    /* now find it in the other list, pushing it to the head if required */
-    if (free) {
-        blk->prev = find_block_by_offset(rmm, rmm->base->firstfree, this, 1);
-        if (!blk->prev) {
-            blk->next = rmm->base->firstfree;
-            rmm->base->firstfree = this;
+        if (blksize == size) {
+            best = next;
+            bestsize = blksize;
+            break;
         }
-    }
-    else {
-        blk->prev = find_block_by_offset(rmm, rmm->base->firstused, this, 1);
-        if (!blk->prev) {
-            blk->next = rmm->base->firstused;
-            rmm->base->firstused = this;
+        if (blksize > size && (!bestsize || blksize < bestsize)) {
+            bestsize = blksize;
+            best = next;
+        }
+        if (++scan >= RMM_SCAN_MAX && larger > list) {
+            break;
         }
+        next = blk->next;
     }
 
-    /* and open it up */
-    if (blk->prev) {
-        struct rmm_block_t *prev = (rmm_block_t*)((char*)rmm->base + blk->prev);
-        if (free && (blk->prev + prev->size == this)) {
-            /* Collapse us into our predecessor */
-            prev->size += blk->size;
-            this = blk->prev;
-            blk = prev;
-        }
-        else {
-            blk->next = prev->next;
-            prev->next = this;
-        }
+    if (!best && larger > list) {
+        best = rmm->base->firstfree[larger];
+        bestsize = RMM_BLOCK_SIZE_OF(RMM_BLOCK(rmm, best));
+    }
+    if (!best) {
+        return 0;
     }
 
-    if (blk->next) {
-        struct rmm_block_t *next = (rmm_block_t*)((char*)rmm->base + blk->next);
-        if (free && (this + blk->size == blk->next)) {
-            /* Collapse us into our successor */
-            blk->size += next->size;
-            blk->next = next->next;
-            if (blk->next) {
-                next = (rmm_block_t*)((char*)rmm->base + blk->next);
-                next->prev = this;
-            }
+    remove_free(rmm, best);
+
+    if (bestsize > RMM_BLOCK_SIZE + size) {
+        struct rmm_block_t *blk = RMM_BLOCK(rmm, best);
+        struct rmm_block_t *new = RMM_BLOCK(rmm, best + size);
+        apr_rmm_off_t after;
+
+        new->size = bestsize - size;
+        new->prevsize = size;
+        blk->size = size;
+
+        after = next_block(rmm, best + size);
+        if (after) {
+            RMM_BLOCK(rmm, after)->prevsize = new->size;
         }
-        else {
-            next->prev = this;
+        insert_free(rmm, best + size);
+    }
+
+    return best;
+}
+
+static void free_block(apr_rmm_t *rmm, apr_rmm_off_t this)
+{
+    struct rmm_block_t *blk = RMM_BLOCK(rmm, this);
+    apr_size_t size = RMM_BLOCK_SIZE_OF(blk);
+    apr_rmm_off_t next;
+
+    remove_used(rmm, this);
+
+    /* Collapse our successor into us */
+    next = next_block(rmm, this);
+    if (next && RMM_BLOCK_IS_FREE(RMM_BLOCK(rmm, next))) {
+        remove_free(rmm, next);
+        size += RMM_BLOCK(rmm, next)->size;
+    }
+
+    /* Collapse us into our predecessor */
+    if (blk->prevsize) {
+        apr_rmm_off_t prev = this - blk->prevsize;
+        if (RMM_BLOCK_IS_FREE(RMM_BLOCK(rmm, prev))) {
+            remove_free(rmm, prev);
+            size += RMM_BLOCK(rmm, prev)->size;
+            this = prev;
+            blk = RMM_BLOCK(rmm, prev);
         }
     }
+
+    blk->size = size;
+    next = next_block(rmm, this);
+    if (next) {
+        RMM_BLOCK(rmm, next)->prevsize = size;
+    }
+    insert_free(rmm, this);
 }
 
 APR_DECLARE(apr_status_t) apr_rmm_init(apr_rmm_t **rmm, apr_anylock_t *lock, 
@@ -232,15 +356,15 @@ APR_DECLARE(apr_status_t) apr_rmm_init(apr_rmm_t **rmm, apr_anylock_t *lock,
     (*rmm)->size = size;
     (*rmm)->lock = *lock;
 
+    memset((*rmm)->base, 0, RMM_HDR_BLOCK_SIZE);
     (*rmm)->base->abssize = size;
-    (*rmm)->base->firstused = 0;
-    (*rmm)->base->firstfree = RMM_HDR_BLOCK_SIZE;
 
-    blk = (rmm_block_t *)((char*)base + (*rmm)->base->firstfree);
+    blk = RMM_BLOCK(*rmm, RMM_HDR_BLOCK_SIZE);
 
-    blk->size = size - (*rmm)->base->firstfree;
-    blk->prev = 0;
-    blk->next = 0;
+    /* Keep the block sizes aligned, the low bit is the free flag */
+    blk->size = (size - RMM_HDR_BLOCK_SIZE) & ~(APR_ALIGN_DEFAULT(1) - 1);
+    blk->prevsize = 0;
+    insert_free(*rmm, RMM_HDR_BLOCK_SIZE);
 
     return APR_ANYLOCK_UNLOCK(lock);
 }
@@ -249,6 +373,7 @@ APR_DECLARE(apr_status_t) apr_rmm_destroy(apr_rmm_t *rmm)
 {
     apr_status_t rv;
     rmm_block_t *blk;
+    int i;
 
     if ((rv = APR_ANYLOCK_LOCK(&rmm->lock)) != APR_SUCCESS) {
         return rv;
@@ -263,15 +388,16 @@ APR_DECLARE(apr_status_t) apr_rmm_destroy(apr_rmm_t *rmm)
         } while (this);
         rmm->base->firstused = 0;
     }
-    if (rmm->base->firstfree) {
-        apr_rmm_off_t this = rmm->base->firstfree;
-        do {
+    for (i = 0; i < RMM_LISTS; i++) {
+        apr_rmm_off_t this = rmm->base->firstfree[i];
+        while (this) {
             blk = (rmm_block_t *)((char*)rmm->base + this);
             this = blk->next;
             blk->next = blk->prev = 0;
-        } while (this);
-        rmm->base->firstfree = 0;
+        }
+        rmm->base->firstfree[i] = 0;
     }
+    memset(rmm->base->freemap, 0, sizeof(rmm->base->freemap));
     rmm->base->abssize = 0;
     rmm->size = 0;
 
@@ -319,7 +445,7 @@ APR_DECLARE(apr_rmm_off_t) apr_rmm_malloc(apr_rmm_t *rmm, apr_size_t reqsize)
     this = find_block_of_size(rmm, size);
 
     if (this) {
-        move_block(rmm, this, 0);
+        insert_used(rmm, this);
         this += RMM_BLOCK_SIZE;
     }
 
@@ -342,7 +468,7 @@ APR_DECLARE(apr_rmm_off_t) apr_rmm_calloc(apr_rmm_t *rmm, apr_size_t reqsize)
     this = find_block_of_size(rmm, size);
 
     if (this) {
-        move_block(rmm, this, 0);
+        insert_used(rmm, this);
         this += RMM_BLOCK_SIZE;
         memset((char*)rmm->base + this, 0, size - RMM_BLOCK_SIZE);
     }
@@ -374,7 +500,7 @@ APR_DECLARE(apr_rmm_off_t) apr_rmm_realloc(apr_rmm_t *rmm, void *entity,
     }
 
     blk = (rmm_block_t*)((char*)rmm->base + old - RMM_BLOCK_SIZE);
-    oldsize = blk->size;
+    oldsize = RMM_BLOCK_SIZE_OF(blk) - RMM_BLOCK_SIZE;
 
     memcpy(apr_rmm_addr_get(rmm, this),
            apr_rmm_addr_get(rmm, old), oldsize < size ? oldsize : size);
@@ -402,6 +528,10 @@ APR_DECLARE(apr_status_t) apr_rmm_free(apr_rmm_t *rmm, apr_rmm_off_t this)
     if ((rv = APR_ANYLOCK_LOCK(&rmm->lock)) != APR_SUCCESS) {
         return rv;
     }
+    if (RMM_BLOCK_IS_FREE(blk)) {
+        APR_ANYLOCK_UNLOCK(&rmm->lock);
+        return APR_EINVAL;
+    }
     if (blk->prev) {
         struct rmm_block_t *prev = (rmm_block_t*)((char*)rmm->base + blk->prev);
         if (prev->next != this) {
@@ -426,7 +556,7 @@ APR_DECLARE(apr_status_t) apr_rmm_free(apr_rmm_t *rmm, apr_rmm_off_t this)
 
     /* Ok, it remained [apparently] sane, so unlink it
      */
-    move_block(rmm, this, 1);
+    free_block(rmm, this);
     
     return APR_ANYLOCK_UNLOCK(&rmm->lock);
 }
@@ -0,0 +1,537 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_private.h"
+#include "apr_general.h"
+#include "apr_shm_hash.h"
+#include "apr_atomic.h"
+#include "apr_thread_proc.h"
+#include "apr_errno.h"
+#include "apr_shm_private.h"
+
+#define APR_WANT_MEMFUNC
+#include "apr_want.h"
+
+/* The segment starts with a header, followed by the buckets.  Each bucket
+ * has an owner word, taken by writers with a compare-and-swap from zero to
+ * their pid, a sequence made odd by the writer holding the bucket, and the
+ * fixed size slots of its entries, each with the key and value inline.
+ * Readers copy what they need and check that the sequence did not change.
+ * Since the owner word is taken first, a held bucket always tells who
+ * holds it, so if that writer dies the others waiting on the bucket can
+ * notice and take it over.
+ *
+ * Nothing in the segment is a pointer, so it can be mapped anywhere.
+ */
+
+#define SHM_HASH_MAGIC      0x48534841 /* "AHSH" */
+#define SHM_HASH_ALIGN      64
+#define SHM_HASH_SPIN       1000
+#define SHM_HASH_LRU_FRESH  (APR_SHM_HASH_BUCKET_SIZE / 2)
+
+typedef struct shm_hash_header_t {
+    apr_uint32_t magic;
+    apr_uint32_t nbuckets;
+    apr_uint32_t key_max;
+    apr_uint32_t val_max;
+    apr_uint32_t slot_size;
+    apr_uint32_t bucket_size;
+    apr_uint32_t flags;
+    volatile apr_uint32_t count;
+} shm_hash_header_t;
+
+#define SHM_HASH_HEADER_SIZE \
+    APR_ALIGN(sizeof(shm_hash_header_t), SHM_HASH_ALIGN)
+
+typedef struct shm_hash_bucket_t {
+    volatile apr_uint32_t seq;
+    volatile apr_uint32_t tick;     /* LRU clock */
+    apr_uint32_t hand;              /* CLOCK hand */
+    volatile apr_uint32_t owner;    /* pid of the writer, zero if none */
+} shm_hash_bucket_t;
+
+typedef struct shm_hash_slot_t {
+    apr_uint32_t hash;
+    apr_uint32_t klen;              /* zero when the slot is free */
+    apr_uint32_t vlen;
+    volatile apr_uint32_t used;     /* LRU tick or CLOCK reference bit */
+    apr_time_t expires;
+    /* followed by the key (key_max bytes) and the value (val_max bytes) */
+} shm_hash_slot_t;
+
+#define SLOT_KEY(s)         ((char *)(s) + sizeof(shm_hash_slot_t))
+
+struct apr_shm_hash_t {
+    apr_pool_t *pool;
+    shm_hash_header_t *header;
+    char *buckets;
+    apr_uint32_t nbuckets;
+    apr_uint32_t key_max;
+    apr_uint32_t val_max;
+    apr_uint32_t slot_size;
+    apr_uint32_t bucket_size;
+    int flags;
+};
+
+/* Orders the copy of an entry before the second read of the sequence */
+#if HAVE__ATOMIC_BUILTINS
+#define shm_hash_read_barrier() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#elif HAVE_ATOMIC_BUILTINS
+#define shm_hash_read_barrier() __sync_synchronize()
+#else
+static volatile apr_uint32_t shm_hash_barrier;
+#define shm_hash_read_barrier() \
+    ((void)apr_atomic_cas32(&shm_hash_barrier, 0, 0))
+#endif
+
+static APR_INLINE apr_size_t slot_size(apr_size_t key_max, apr_size_t val_max)
+{
+    return APR_ALIGN_DEFAULT(sizeof(shm_hash_slot_t) + key_max + val_max);
+}
+
+static APR_INLINE apr_size_t bucket_size(apr_size_t key_max,
+                                         apr_size_t val_max)
+{
+    return APR_ALIGN(sizeof(shm_hash_bucket_t)
+                     + APR_SHM_HASH_BUCKET_SIZE * slot_size(key_max, val_max),
+                     SHM_HASH_ALIGN);
+}
+
+static APR_INLINE shm_hash_bucket_t *get_bucket(apr_shm_hash_t *hash,
+                                                apr_uint32_t h)
+{
+    return (shm_hash_bucket_t *)(hash->buckets
+                                 + (apr_size_t)(h % hash->nbuckets)
+                                   * hash->bucket_size);
+}
+
+static APR_INLINE shm_hash_slot_t *get_slot(apr_shm_hash_t *hash,
+                                            shm_hash_bucket_t *bucket,
+                                            int i)
+{
+    return (shm_hash_slot_t *)((char *)bucket + sizeof(shm_hash_bucket_t)
+                               + (apr_size_t)i * hash->slot_size);
+}
+
+static apr_uint32_t hash_key(const void *key, apr_ssize_t *klen)
+{
+    apr_uint32_t h = apr_hashfunc_default(key, klen);
+
+    /* times33 leaves the low bits poorly mixed for short keys */
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h;
+}
+
+/* Give the writer holding a bucket a chance to run, returns whether it
+ * was given one
+ */
+static APR_INLINE int shm_hash_relax(int *spins)
+{
+    if (++*spins == SHM_HASH_SPIN) {
+#if APR_HAS_THREADS
+        apr_thread_yield();
+#else
+        apr_sleep(0);
+#endif
+        *spins = 0;
+        return 1;
+    }
+    return 0;
+}
+
+/* Takes over a bucket whose writer died holding it, if the caller is the
+ * first one to notice, and drops its entries since any could be half
+ * written.  Returns whether the bucket is now held by the caller.
+ */
+static int bucket_recover(apr_shm_hash_t *hash, shm_hash_bucket_t *bucket)
+{
+    apr_uint32_t owner = apr_atomic_read32(&bucket->owner);
+    int i;
+
+    if (!owner || !apr_shm_owner_dead(owner)
+            || apr_atomic_cas32(&bucket->owner, apr_shm_owner_self(),
+                                owner) != owner) {
+        return 0;
+    }
+    /* The writer may have died before making the sequence odd */
+    if (!(apr_atomic_read32(&bucket->seq) & 1)) {
+        apr_atomic_inc32(&bucket->seq);
+    }
+
+    for (i = 0; i < APR_SHM_HASH_BUCKET_SIZE; i++) {
+        shm_hash_slot_t *slot = get_slot(hash, bucket, i);
+        if (slot->klen) {
+            slot->klen = 0;
+            apr_atomic_dec32(&hash->header->count);
+        }
+        slot->used = 0;
+    }
+    bucket->tick = 0;
+    bucket->hand = 0;
+    return 1;
+}
+
+static void bucket_lock(apr_shm_hash_t *hash, shm_hash_bucket_t *bucket)
+{
+    apr_uint32_t self = apr_shm_owner_self();
+    int spins = 0;
+
+    for (;;) {
+        if (!apr_atomic_read32(&bucket->owner)) {
+            if (apr_atomic_cas32(&bucket->owner, self, 0) == 0) {
+                apr_atomic_inc32(&bucket->seq);
+                return;
+            }
+        }
+        else if (shm_hash_relax(&spins) && bucket_recover(hash, bucket)) {
+            return;
+        }
+    }
+}
+
+static APR_INLINE void bucket_unlock(shm_hash_bucket_t *bucket)
+{
+    apr_atomic_inc32(&bucket->seq);
+    apr_atomic_set32(&bucket->owner, 0);
+}
+
+static shm_hash_slot_t *find_slot(apr_shm_hash_t *hash,
+                                  shm_hash_bucket_t *bucket,
+                                  const void *key, apr_size_t klen,
+                                  apr_uint32_t h)
+{
+    int i;
+
+    for (i = 0; i < APR_SHM_HASH_BUCKET_SIZE; i++) {
+        shm_hash_slot_t *slot = get_slot(hash, bucket, i);
+        if (slot->hash == h && slot->klen == klen
+                && !memcmp(SLOT_KEY(slot), key, klen)) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static APR_INLINE int slot_expired(shm_hash_slot_t *slot, apr_time_t now)
+{
+    return slot->expires && slot->expires <= now;
+}
+
+/* Called with the bucket locked, when the key is not there */
+static shm_hash_slot_t *alloc_slot(apr_shm_hash_t *hash,
+                                   shm_hash_bucket_t *bucket,
+                                   apr_time_t now)
+{
+    shm_hash_slot_t *slot, *victim = NULL;
+    int i;
+
+    for (i = 0; i < APR_SHM_HASH_BUCKET_SIZE; i++) {
+        slot = get_slot(hash, bucket, i);
+        if (!slot->klen) {
+            apr_atomic_inc32(&hash->header->count);
+            return slot;
+        }
+        if (!victim && slot_expired(slot, now)) {
+            victim = slot;
+        }
+    }
+    if (victim) {
+        return victim;
+    }
+
+    switch (hash->flags) {
+    case APR_SHM_HASH_EVICT_LRU: {
+        apr_uint32_t tick = bucket->tick, age = 0;
+
+        for (i = 0; i < APR_SHM_HASH_BUCKET_SIZE; i++) {
+            slot = get_slot(hash, bucket, i);
+            if (!victim || tick - slot->used > age) {
+                victim = slot;
+                age = tick - slot->used;
+            }
+        }
+        break;
+    }
+    case APR_SHM_HASH_EVICT_CLOCK:
+        /* Two rounds at most: the first one clears the reference bits */
+        for (i = 0; i < 2 * APR_SHM_HASH_BUCKET_SIZE; i++) {
+            slot = get_slot(hash, bucket, bucket->hand);
+            bucket->hand = (bucket->hand + 1) % APR_SHM_HASH_BUCKET_SIZE;
+            if (!slot->used) {
+                victim = slot;
+                break;
+            }
+            slot->used = 0;
+        }
+        break;
+    }
+    return victim;
+}
+
+static APR_INLINE void touch_slot(apr_shm_hash_t *hash,
+                                  shm_hash_bucket_t *bucket,
+                                  shm_hash_slot_t *slot)
+{
+    /* Only a slot that aged is moved up, so that the hot entries are read
+     * without writing to the bucket
+     */
+    if (hash->flags == APR_SHM_HASH_EVICT_LRU) {
+        if (bucket->tick - slot->used >= SHM_HASH_LRU_FRESH) {
+            slot->used = apr_atomic_inc32(&bucket->tick) + 1;
+        }
+    }
+    else if (hash->flags == APR_SHM_HASH_EVICT_CLOCK && !slot->used) {
+        slot->used = 1;
+    }
+}
+
+APR_DECLARE(apr_size_t) apr_shm_hash_size(apr_uint32_t capacity,
+                                          apr_size_t key_max,
+                                          apr_size_t val_max)
+{
+    apr_size_t nbuckets = (capacity + APR_SHM_HASH_BUCKET_SIZE - 1)
+                          / APR_SHM_HASH_BUCKET_SIZE;
+
+    if (!nbuckets) {
+        nbuckets = 1;
+    }
+    return SHM_HASH_HEADER_SIZE + nbuckets * bucket_size(key_max, val_max);
+}
+
+static void shm_hash_setup(apr_shm_hash_t *hash, shm_hash_header_t *header)
+{
+    hash->header = header;
+    hash->buckets = (char *)header + SHM_HASH_HEADER_SIZE;
+    hash->nbuckets = header->nbuckets;
+    hash->key_max = header->key_max;
+    hash->val_max = header->val_max;
+    hash->slot_size = header->slot_size;
+    hash->bucket_size = header->bucket_size;
+    hash->flags = header->flags;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_hash_init(apr_shm_hash_t **hash,
+                                            apr_shm_t *shm,
+                                            apr_size_t key_max,
+                                            apr_size_t val_max,
+                                            int flags,
+                                            apr_pool_t *pool)
+{
+    shm_hash_header_t *header = apr_shm_baseaddr_get(shm);
+    apr_size_t size = apr_shm_size_get(shm);
+
+    if (!key_max || key_max > APR_UINT16_MAX || val_max > APR_INT32_MAX / 2
+            || (flags != APR_SHM_HASH_EVICT_NONE
+                && flags != APR_SHM_HASH_EVICT_LRU
+                && flags != APR_SHM_HASH_EVICT_CLOCK)
+            || size < apr_shm_hash_size(1, key_max, val_max)) {
+        return APR_EINVAL;
+    }
+
+    memset(header, 0, size);
+    header->nbuckets = (apr_uint32_t)((size - SHM_HASH_HEADER_SIZE)
+                                      / bucket_size(key_max, val_max));
+    header->key_max = (apr_uint32_t)key_max;
+    header->val_max = (apr_uint32_t)val_max;
+    header->slot_size = (apr_uint32_t)slot_size(key_max, val_max);
+    header->bucket_size = (apr_uint32_t)bucket_size(key_max, val_max);
+    header->flags = flags;
+    apr_atomic_set32(&header->magic, SHM_HASH_MAGIC);
+
+    *hash = apr_pcalloc(pool, sizeof(**hash));
+    (*hash)->pool = pool;
+    shm_hash_setup(*hash, header);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_hash_attach(apr_shm_hash_t **hash,
+                                              apr_shm_t *shm,
+                                              apr_pool_t *pool)
+{
+    shm_hash_header_t *header = apr_shm_baseaddr_get(shm);
+    apr_size_t size = apr_shm_size_get(shm);
+
+    if (size < SHM_HASH_HEADER_SIZE
+            || apr_atomic_read32(&header->magic) != SHM_HASH_MAGIC
+            || header->bucket_size != bucket_size(header->key_max,
+                                                  header->val_max)
+            || size < SHM_HASH_HEADER_SIZE
+                      + (apr_size_t)header->nbuckets * header->bucket_size) {
+        return APR_EINVAL;
+    }
+
+    *hash = apr_pcalloc(pool, sizeof(**hash));
+    (*hash)->pool = pool;
+    shm_hash_setup(*hash, header);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_hash_get(apr_shm_hash_t *hash,
+                                           const void *key, apr_ssize_t klen,
+                                           void *val, apr_size_t *vlen)
+{
+    apr_uint32_t h = hash_key(key, &klen);
+    shm_hash_bucket_t *bucket = get_bucket(hash, h);
+    shm_hash_slot_t *slot;
+    apr_size_t len = 0;
+    apr_time_t expires = 0;
+    apr_uint32_t seq;
+    int spins = 0;
+
+    if (!klen || klen > (apr_ssize_t)hash->key_max) {
+        return APR_NOTFOUND;
+    }
+
+    for (;;) {
+        seq = apr_atomic_read32(&bucket->seq);
+        if (seq & 1) {
+            if (shm_hash_relax(&spins) && bucket_recover(hash, bucket)) {
+                bucket_unlock(bucket);
+            }
+            continue;
+        }
+
+        slot = find_slot(hash, bucket, key, klen, h);
+        if (slot) {
+            len = slot->vlen;
+            expires = slot->expires;
+            memcpy(val, SLOT_KEY(slot) + hash->key_max,
+                   len < *vlen ? len : *vlen);
+        }
+
+        shm_hash_read_barrier();
+        if (apr_atomic_read32(&bucket->seq) == seq) {
+            break;
+        }
+    }
+
+    if (!slot || (expires && expires <= apr_time_now())) {
+        return APR_NOTFOUND;
+    }
+    touch_slot(hash, bucket, slot);
+
+    if (len > *vlen) {
+        *vlen = len;
+        return APR_ENOSPC;
+    }
+    *vlen = len;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_hash_set(apr_shm_hash_t *hash,
+                                           const void *key, apr_ssize_t klen,
+                                           const void *val, apr_size_t vlen,
+                                           apr_interval_time_t ttl)
+{
+    apr_uint32_t h = hash_key(key, &klen);
+    shm_hash_bucket_t *bucket = get_bucket(hash, h);
+    shm_hash_slot_t *slot;
+    apr_time_t now = apr_time_now();
+
+    if (!klen || klen > (apr_ssize_t)hash->key_max || vlen > hash->val_max) {
+        return APR_EINVAL;
+    }
+
+    bucket_lock(hash, bucket);
+
+    slot = find_slot(hash, bucket, key, klen, h);
+    if (!slot) {
+        slot = alloc_slot(hash, bucket, now);
+        if (!slot) {
+            bucket_unlock(bucket);
+            return APR_ENOSPC;
+        }
+        slot->hash = h;
+        slot->klen = (apr_uint32_t)klen;
+        memcpy(SLOT_KEY(slot), key, klen);
+    }
+    slot->vlen = (apr_uint32_t)vlen;
+    memcpy(SLOT_KEY(slot) + hash->key_max, val, vlen);
+    slot->expires = ttl > 0 ? now + ttl : 0;
+    if (hash->flags == APR_SHM_HASH_EVICT_LRU) {
+        slot->used = apr_atomic_inc32(&bucket->tick) + 1;
+    }
+    else {
+        slot->used = 1;
+    }
+
+    bucket_unlock(bucket);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_hash_delete(apr_shm_hash_t *hash,
+                                              const void *key,
+                                              apr_ssize_t klen)
+{
+    apr_uint32_t h = hash_key(key, &klen);
+    shm_hash_bucket_t *bucket = get_bucket(hash, h);
+    shm_hash_slot_t *slot;
+
+    if (!klen || klen > (apr_ssize_t)hash->key_max) {
+        return APR_NOTFOUND;
+    }
+
+    bucket_lock(hash, bucket);
+    slot = find_slot(hash, bucket, key, klen, h);
+    if (slot) {
+        slot->klen = 0;
+        apr_atomic_dec32(&hash->header->count);
+    }
+    bucket_unlock(bucket);
+
+    return slot ? APR_SUCCESS : APR_NOTFOUND;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_hash_expire(apr_shm_hash_t *hash,
+                                              apr_uint32_t *expired)
+{
+    apr_time_t now = apr_time_now();
+    apr_uint32_t b, n = 0;
+    int i;
+
+    for (b = 0; b < hash->nbuckets; b++) {
+        shm_hash_bucket_t *bucket = get_bucket(hash, b);
+
+        bucket_lock(hash, bucket);
+        for (i = 0; i < APR_SHM_HASH_BUCKET_SIZE; i++) {
+            shm_hash_slot_t *slot = get_slot(hash, bucket, i);
+            if (slot->klen && slot_expired(slot, now)) {
+                slot->klen = 0;
+                apr_atomic_dec32(&hash->header->count);
+                n++;
+            }
+        }
+        bucket_unlock(bucket);
+    }
+
+    if (expired) {
+        *expired = n;
+    }
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_uint32_t) apr_shm_hash_count(apr_shm_hash_t *hash)
+{
+    return apr_atomic_read32(&hash->header->count);
+}
+
+APR_DECLARE(apr_uint32_t) apr_shm_hash_capacity(apr_shm_hash_t *hash)
+{
+    return hash->nbuckets * APR_SHM_HASH_BUCKET_SIZE;
+}
@@ -0,0 +1,475 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_general.h"
+#include "apr_shm_stats.h"
+#include "apr_atomic.h"
+#include "apr_strings.h"
+#include "apr_thread_proc.h"
+#include "apr_errno.h"
+#include "apr_shm_private.h"
+
+#define APR_WANT_MEMFUNC
+#define APR_WANT_STRFUNC
+#include "apr_want.h"
+
+/* The segment holds, in this order:
+ *  - the header,
+ *  - the descriptors of the metrics,
+ *  - the histogram bounds, indexed like the cells of the histograms,
+ *  - the ownership words of the slots, the pid of the process using each
+ *    slot or zero,
+ *  - the slots, each with a copy of all the cells and aligned on a cache
+ *    line so that slots never share one.
+ * Nothing is a pointer, so the segment can be mapped anywhere.
+ */
+
+#define SHM_STATS_MAGIC     0x53545441 /* "ATTS" */
+#define SHM_STATS_ALIGN     64
+#define SHM_STATS_SPIN      100
+
+typedef struct shm_stats_header_t {
+    apr_uint32_t magic;
+    apr_uint32_t nslots;
+    apr_uint32_t max_metrics;
+    apr_uint32_t max_cells;
+    volatile apr_uint32_t nmetrics;
+    apr_uint32_t ncells;
+    volatile apr_uint32_t lock;     /* pid of the definer, or zero */
+    apr_uint32_t unused;
+} shm_stats_header_t;
+
+typedef struct shm_stats_metric_t {
+    char name[APR_SHM_STATS_NAME_MAX];
+    apr_uint32_t cell;
+    apr_uint32_t nbounds;           /* zero for a counter */
+    apr_uint32_t unused[2];
+} shm_stats_metric_t;
+
+struct apr_shm_stats_t {
+    apr_pool_t *pool;
+    shm_stats_header_t *header;
+    shm_stats_metric_t *metrics;
+    apr_int64_t *bounds;
+    volatile apr_uint32_t *owners;
+    char *slots;
+    apr_size_t slot_size;
+};
+
+struct apr_shm_stats_slot_t {
+    apr_pool_t *pool;
+    apr_shm_stats_t *stats;
+    apr_uint64_t *cells;
+    unsigned int index;
+    int flags;
+};
+
+#define SHM_STATS_HEADER_SIZE \
+    APR_ALIGN(sizeof(shm_stats_header_t), SHM_STATS_ALIGN)
+
+static apr_size_t metrics_size(apr_uint32_t max_metrics)
+{
+    return APR_ALIGN(max_metrics * sizeof(shm_stats_metric_t),
+                     SHM_STATS_ALIGN);
+}
+
+static apr_size_t bounds_size(apr_uint32_t max_cells)
+{
+    return APR_ALIGN(max_cells * sizeof(apr_int64_t), SHM_STATS_ALIGN);
+}
+
+static apr_size_t owners_size(apr_uint32_t nslots)
+{
+    return APR_ALIGN(nslots * sizeof(apr_uint32_t), SHM_STATS_ALIGN);
+}
+
+static apr_size_t slot_size(apr_uint32_t max_cells)
+{
+    return APR_ALIGN(max_cells * sizeof(apr_uint64_t), SHM_STATS_ALIGN);
+}
+
+APR_DECLARE(apr_size_t) apr_shm_stats_size(unsigned int nslots,
+                                           unsigned int max_metrics,
+                                           unsigned int max_cells)
+{
+    return SHM_STATS_HEADER_SIZE + metrics_size(max_metrics)
+           + bounds_size(max_cells) + owners_size(nslots)
+           + nslots * slot_size(max_cells);
+}
+
+static void shm_stats_setup(apr_shm_stats_t *stats,
+                            shm_stats_header_t *header)
+{
+    char *base = (char *)header + SHM_STATS_HEADER_SIZE;
+
+    stats->header = header;
+    stats->metrics = (shm_stats_metric_t *)base;
+    base += metrics_size(header->max_metrics);
+    stats->bounds = (apr_int64_t *)base;
+    base += bounds_size(header->max_cells);
+    stats->owners = (apr_uint32_t *)base;
+    base += owners_size(header->nslots);
+    stats->slots = base;
+    stats->slot_size = slot_size(header->max_cells);
+}
+
+static APR_INLINE apr_uint64_t *slot_cells(apr_shm_stats_t *stats,
+                                           unsigned int i)
+{
+    return (apr_uint64_t *)(stats->slots + i * stats->slot_size);
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_create(apr_shm_stats_t **stats,
+                                               apr_shm_t *shm,
+                                               unsigned int nslots,
+                                               unsigned int max_metrics,
+                                               unsigned int max_cells,
+                                               apr_pool_t *pool)
+{
+    shm_stats_header_t *header = apr_shm_baseaddr_get(shm);
+    apr_size_t size = apr_shm_stats_size(nslots, max_metrics, max_cells);
+
+    if (!nslots || !max_metrics || !max_cells
+            || apr_shm_size_get(shm) < size) {
+        return APR_EINVAL;
+    }
+
+    memset(header, 0, size);
+    header->nslots = nslots;
+    header->max_metrics = max_metrics;
+    header->max_cells = max_cells;
+    apr_atomic_set32(&header->magic, SHM_STATS_MAGIC);
+
+    *stats = apr_pcalloc(pool, sizeof(**stats));
+    (*stats)->pool = pool;
+    shm_stats_setup(*stats, header);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_attach(apr_shm_stats_t **stats,
+                                               apr_shm_t *shm,
+                                               apr_pool_t *pool)
+{
+    shm_stats_header_t *header = apr_shm_baseaddr_get(shm);
+    apr_size_t size = apr_shm_size_get(shm);
+
+    if (size < SHM_STATS_HEADER_SIZE
+            || apr_atomic_read32(&header->magic) != SHM_STATS_MAGIC
+            || size < apr_shm_stats_size(header->nslots,
+                                         header->max_metrics,
+                                         header->max_cells)) {
+        return APR_EINVAL;
+    }
+
+    *stats = apr_pcalloc(pool, sizeof(**stats));
+    (*stats)->pool = pool;
+    shm_stats_setup(*stats, header);
+    return APR_SUCCESS;
+}
+
+/* Serializes the definitions of the metrics.  A definer which died holding
+ * the lock published nothing (nmetrics is bumped last), so the lock is just
+ * taken over then, like the slots.
+ */
+static void shm_stats_lock(shm_stats_header_t *header)
+{
+    apr_uint32_t self = apr_shm_owner_self(), owner;
+    int spins = 0;
+
+    while ((owner = apr_atomic_cas32(&header->lock, self, 0)) != 0) {
+        if (++spins == SHM_STATS_SPIN) {
+            if (apr_shm_owner_dead(owner)
+                    && apr_atomic_cas32(&header->lock, self, owner) == owner) {
+                return;
+            }
+            spins = 0;
+        }
+#if APR_HAS_THREADS
+        apr_thread_yield();
+#else
+        apr_sleep(0);
+#endif
+    }
+}
+
+static void shm_stats_unlock(shm_stats_header_t *header)
+{
+    apr_atomic_set32(&header->lock, 0);
+}
+
+static int find_metric(apr_shm_stats_t *stats, const char *name)
+{
+    apr_uint32_t i, n = apr_atomic_read32(&stats->header->nmetrics);
+
+    for (i = 0; i < n; i++) {
+        if (!strcmp(stats->metrics[i].name, name)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static apr_status_t define_metric(apr_shm_stats_t *stats, const char *name,
+                                  const apr_int64_t *bounds,
+                                  unsigned int nbounds, unsigned int *id)
+{
+    shm_stats_header_t *header = stats->header;
+    shm_stats_metric_t *metric;
+    apr_uint32_t ncells = nbounds ? nbounds + 2 : 1;
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    if (strlen(name) >= APR_SHM_STATS_NAME_MAX) {
+        return APR_EINVAL;
+    }
+
+    shm_stats_lock(header);
+
+    i = find_metric(stats, name);
+    if (i >= 0) {
+        metric = &stats->metrics[i];
+        if (metric->nbounds != nbounds
+                || (nbounds && memcmp(&stats->bounds[metric->cell], bounds,
+                                      nbounds * sizeof(*bounds)))) {
+            rv = APR_EINVAL;
+        }
+        *id = i;
+    }
+    else if (header->nmetrics == header->max_metrics
+             || header->max_cells - header->ncells < ncells) {
+        rv = APR_ENOSPC;
+    }
+    else {
+        metric = &stats->metrics[header->nmetrics];
+        apr_cpystrn(metric->name, name, sizeof(metric->name));
+        metric->cell = header->ncells;
+        metric->nbounds = nbounds;
+        if (nbounds) {
+            memcpy(&stats->bounds[metric->cell], bounds,
+                   nbounds * sizeof(*bounds));
+        }
+        header->ncells += ncells;
+        *id = header->nmetrics;
+
+        /* Publish the metric to the lock-free readers */
+        apr_atomic_inc32(&header->nmetrics);
+    }
+
+    shm_stats_unlock(header);
+    return rv;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_counter_define(apr_shm_stats_t *stats,
+                                                       const char *name,
+                                                       unsigned int *id)
+{
+    return define_metric(stats, name, NULL, 0, id);
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_histogram_define(
+                                                       apr_shm_stats_t *stats,
+                                                       const char *name,
+                                                       const apr_int64_t *bounds,
+                                                       unsigned int nbounds,
+                                                       unsigned int *id)
+{
+    unsigned int i;
+
+    if (!nbounds) {
+        return APR_EINVAL;
+    }
+    for (i = 1; i < nbounds; i++) {
+        if (bounds[i] <= bounds[i - 1]) {
+            return APR_EINVAL;
+        }
+    }
+    return define_metric(stats, name, bounds, nbounds, id);
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_lookup(apr_shm_stats_t *stats,
+                                               const char *name,
+                                               unsigned int *id)
+{
+    int i = find_metric(stats, name);
+
+    if (i < 0) {
+        return APR_NOTFOUND;
+    }
+    *id = i;
+    return APR_SUCCESS;
+}
+
+static apr_status_t slot_cleanup(void *data)
+{
+    apr_shm_stats_slot_t *slot = data;
+
+    apr_atomic_set32(&slot->stats->owners[slot->index], 0);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_slot_acquire(
+                                                apr_shm_stats_slot_t **slot,
+                                                apr_shm_stats_t *stats,
+                                                int flags,
+                                                apr_pool_t *pool)
+{
+    apr_uint32_t self = apr_shm_owner_self(), owner, i;
+
+    for (i = 0; i < stats->header->nslots; i++) {
+        if (!stats->owners[i]
+                && apr_atomic_cas32(&stats->owners[i], self, 0) == 0) {
+            break;
+        }
+    }
+    if (i == stats->header->nslots) {
+        /* Take over the slot of a process which exited without releasing
+         * it, its values included */
+        for (i = 0; i < stats->header->nslots; i++) {
+            owner = apr_atomic_read32(&stats->owners[i]);
+            if (owner && apr_shm_owner_dead(owner)
+                    && apr_atomic_cas32(&stats->owners[i], self,
+                                        owner) == owner) {
+                break;
+            }
+        }
+        if (i == stats->header->nslots) {
+            return APR_ENOSPC;
+        }
+    }
+
+    *slot = apr_palloc(pool, sizeof(**slot));
+    (*slot)->pool = pool;
+    (*slot)->stats = stats;
+    (*slot)->cells = slot_cells(stats, i);
+    (*slot)->index = i;
+    (*slot)->flags = flags;
+    apr_pool_cleanup_register(pool, *slot, slot_cleanup,
+                              apr_pool_cleanup_null);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_slot_release(
+                                                apr_shm_stats_slot_t *slot)
+{
+    return apr_pool_cleanup_run(slot->pool, slot, slot_cleanup);
+}
+
+static APR_INLINE void cell_add(apr_shm_stats_slot_t *slot, apr_uint32_t cell,
+                                apr_uint64_t delta)
+{
+    if (slot->flags & APR_SHM_STATS_SLOT_ATOMIC) {
+        apr_atomic_add64(&slot->cells[cell], delta);
+    }
+    else {
+        slot->cells[cell] += delta;
+    }
+}
+
+APR_DECLARE(void) apr_shm_stats_add(apr_shm_stats_slot_t *slot,
+                                    unsigned int id, apr_uint64_t delta)
+{
+    cell_add(slot, slot->stats->metrics[id].cell, delta);
+}
+
+APR_DECLARE(void) apr_shm_stats_record(apr_shm_stats_slot_t *slot,
+                                       unsigned int id, apr_int64_t value)
+{
+    shm_stats_metric_t *metric = &slot->stats->metrics[id];
+    const apr_int64_t *bounds = &slot->stats->bounds[metric->cell];
+    apr_uint32_t lo = 0, hi = metric->nbounds;
+
+    /* First bound not below the value, or the overflow bucket */
+    while (lo < hi) {
+        apr_uint32_t mid = (lo + hi) / 2;
+        if (bounds[mid] < value) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    cell_add(slot, metric->cell + lo, 1);
+    cell_add(slot, metric->cell + metric->nbounds + 1, (apr_uint64_t)value);
+}
+
+static apr_uint64_t cell_sum(apr_shm_stats_t *stats, apr_uint32_t cell)
+{
+    apr_uint64_t sum = 0;
+    apr_uint32_t i;
+
+    for (i = 0; i < stats->header->nslots; i++) {
+        sum += apr_atomic_read64(&slot_cells(stats, i)[cell]);
+    }
+    return sum;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_counter_get(apr_shm_stats_t *stats,
+                                                    unsigned int id,
+                                                    apr_uint64_t *value)
+{
+    if (id >= apr_atomic_read32(&stats->header->nmetrics)
+            || stats->metrics[id].nbounds) {
+        return APR_EINVAL;
+    }
+    *value = cell_sum(stats, stats->metrics[id].cell);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_histogram_get(apr_shm_stats_t *stats,
+                                                      unsigned int id,
+                                                      apr_uint64_t *counts,
+                                                      apr_int64_t *sum)
+{
+    shm_stats_metric_t *metric;
+    apr_uint32_t i;
+
+    if (id >= apr_atomic_read32(&stats->header->nmetrics)
+            || !stats->metrics[id].nbounds) {
+        return APR_EINVAL;
+    }
+    metric = &stats->metrics[id];
+
+    for (i = 0; i <= metric->nbounds; i++) {
+        counts[i] = cell_sum(stats, metric->cell + i);
+    }
+    if (sum) {
+        *sum = (apr_int64_t)cell_sum(stats, metric->cell + i);
+    }
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(unsigned int) apr_shm_stats_count(apr_shm_stats_t *stats)
+{
+    return apr_atomic_read32(&stats->header->nmetrics);
+}
+
+APR_DECLARE(apr_status_t) apr_shm_stats_info_get(apr_shm_stats_t *stats,
+                                                 unsigned int id,
+                                                 const char **name,
+                                                 unsigned int *nbounds)
+{
+    if (id >= apr_atomic_read32(&stats->header->nmetrics)) {
+        return APR_EINVAL;
+    }
+    if (name) {
+        *name = stats->metrics[id].name;
+    }
+    if (nbounds) {
+        *nbounds = stats->metrics[id].nbounds;
+    }
+    return APR_SUCCESS;
+}